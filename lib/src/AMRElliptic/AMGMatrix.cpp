@@ -0,0 +1,429 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+#include <algorithm>
+
+#include "AMGMatrix.H"
+#include "SPMD.H"
+#include "MayDay.H"
+#include "CH_Timer.H"
+#include "NamespaceHeader.H"
+
+#ifdef CH_MPI
+static const int s_amgTag = 4217;
+#endif
+
+// the address of the first element, or NULL if there is none
+template <class T>
+static inline T* firstOf(Vector<T>& a_v)
+{
+  return (a_v.size() > 0) ? &a_v[0] : NULL;
+}
+
+template <class T>
+static inline const T* firstOf(const Vector<T>& a_v)
+{
+  return (a_v.size() > 0) ? &a_v[0] : NULL;
+}
+
+// the rank owning global index a_i under the partition a_starts
+static inline int owner(const Vector<long long>& a_starts, long long a_i)
+{
+  const std::vector<long long>& starts = a_starts.constStdVector();
+  return (std::upper_bound(starts.begin(), starts.end(), a_i) - starts.begin()) - 1;
+}
+
+static inline bool entryLess(const AMGEntry& a_a, const AMGEntry& a_b)
+{
+  return (a_a.m_row < a_b.m_row) || (a_a.m_row == a_b.m_row && a_a.m_col < a_b.m_col);
+}
+
+AMGMatrix::AMGMatrix()
+  :m_rank(0),
+   m_numRanks(1),
+   m_numRows(0),
+   m_numLocalCols(0)
+{
+}
+
+AMGMatrix::~AMGMatrix()
+{
+}
+
+void AMGMatrix::define(const Vector<long long>& a_rowStarts,
+                       const Vector<long long>& a_colStarts,
+                       const Vector<int>&       a_rowPtr,
+                       const Vector<long long>& a_cols,
+                       const Vector<Real>&      a_vals)
+{
+  CH_TIME("AMGMatrix::define");
+
+  m_rank = 0;
+  m_numRanks = 1;
+#ifdef CH_MPI
+  MPI_Comm_rank(Chombo_MPI::comm, &m_rank);
+  MPI_Comm_size(Chombo_MPI::comm, &m_numRanks);
+#endif
+  CH_assert(a_rowStarts.size() == m_numRanks + 1);
+  CH_assert(a_colStarts.size() == m_numRanks + 1);
+
+  m_rowStarts = a_rowStarts;
+  m_colStarts = a_colStarts;
+  m_numRows = a_rowStarts[m_rank+1] - a_rowStarts[m_rank];
+  m_numLocalCols = a_colStarts[m_rank+1] - a_colStarts[m_rank];
+  CH_assert(a_rowPtr.size() == m_numRows + 1);
+
+  const long long colBegin = a_colStarts[m_rank];
+  const long long colEnd   = a_colStarts[m_rank+1];
+  const int nnz = a_rowPtr[m_numRows];
+
+  // the halo: columns owned elsewhere, sorted
+  std::vector<long long> halo;
+  for (int k = 0; k < nnz; k++)
+    {
+      if (a_cols[k] < colBegin || a_cols[k] >= colEnd)
+        {
+          halo.push_back(a_cols[k]);
+        }
+    }
+  std::sort(halo.begin(), halo.end());
+  halo.erase(std::unique(halo.begin(), halo.end()), halo.end());
+  m_halo = Vector<long long>(halo);
+
+  m_rowPtr = a_rowPtr;
+  m_vals = a_vals;
+  m_cols.resize(nnz);
+  for (int k = 0; k < nnz; k++)
+    {
+      if (a_cols[k] >= colBegin && a_cols[k] < colEnd)
+        {
+          m_cols[k] = a_cols[k] - colBegin;
+        }
+      else
+        {
+          m_cols[k] = m_numLocalCols
+            + (std::lower_bound(halo.begin(), halo.end(), a_cols[k]) - halo.begin());
+        }
+    }
+
+  // whom the halo comes from
+  m_recvProcs.resize(0);
+  m_recvOffsets.resize(0);
+  Vector<int> recvCounts(m_numRanks, 0);
+  for (int h = 0; h < m_halo.size(); h++)
+    {
+      int proc = owner(m_colStarts, m_halo[h]);
+      if (m_recvProcs.size() == 0 || m_recvProcs.back() != proc)
+        {
+          m_recvProcs.push_back(proc);
+          m_recvOffsets.push_back(h);
+        }
+      recvCounts[proc]++;
+    }
+  m_recvOffsets.push_back(m_halo.size());
+
+  // and whom this rank sends its columns to
+  m_sendProcs.resize(0);
+  m_sendOffsets.resize(0);
+  m_sendIndex.resize(0);
+#ifdef CH_MPI
+  Vector<int> sendCounts(m_numRanks, 0);
+  MPI_Alltoall(&recvCounts[0], 1, MPI_INT, &sendCounts[0], 1, MPI_INT, Chombo_MPI::comm);
+
+  Vector<int> sendDispls(m_numRanks, 0), recvDispls(m_numRanks, 0);
+  int numSend = 0;
+  for (int p = 0; p < m_numRanks; p++)
+    {
+      sendDispls[p] = numSend;
+      numSend += sendCounts[p];
+      if (p > 0)
+        {
+          recvDispls[p] = recvDispls[p-1] + recvCounts[p-1];
+        }
+    }
+  Vector<long long> requested(numSend);
+  MPI_Alltoallv(firstOf(m_halo), &recvCounts[0], &recvDispls[0], MPI_LONG_LONG,
+                firstOf(requested), &sendCounts[0], &sendDispls[0], MPI_LONG_LONG,
+                Chombo_MPI::comm);
+
+  m_sendIndex.resize(numSend);
+  for (int k = 0; k < numSend; k++)
+    {
+      CH_assert(requested[k] >= colBegin && requested[k] < colEnd);
+      m_sendIndex[k] = requested[k] - colBegin;
+    }
+  for (int p = 0; p < m_numRanks; p++)
+    {
+      if (sendCounts[p] > 0)
+        {
+          m_sendProcs.push_back(p);
+          m_sendOffsets.push_back(sendDispls[p]);
+        }
+    }
+#endif
+  m_sendOffsets.push_back(m_sendIndex.size());
+}
+
+void AMGMatrix::assemble(Vector<int>&             a_rowPtr,
+                         Vector<long long>&       a_cols,
+                         Vector<Real>&            a_vals,
+                         const Vector<long long>& a_rowStarts,
+                         const Vector<AMGEntry>&  a_entries)
+{
+  CH_TIME("AMGMatrix::assemble");
+
+  int rank = 0;
+  std::vector<AMGEntry> entries;
+#ifdef CH_MPI
+  int numRanks;
+  MPI_Comm_rank(Chombo_MPI::comm, &rank);
+  MPI_Comm_size(Chombo_MPI::comm, &numRanks);
+
+  // sort the entries by owner, and send them there
+  Vector<int> sendCounts(numRanks, 0), recvCounts(numRanks, 0);
+  Vector<int> sendDispls(numRanks, 0), recvDispls(numRanks, 0);
+  Vector<int> entryOwner(a_entries.size());
+  for (int k = 0; k < a_entries.size(); k++)
+    {
+      entryOwner[k] = owner(a_rowStarts, a_entries[k].m_row);
+      sendCounts[entryOwner[k]] += sizeof(AMGEntry);
+    }
+  MPI_Alltoall(&sendCounts[0], 1, MPI_INT, &recvCounts[0], 1, MPI_INT, Chombo_MPI::comm);
+  int numRecv = 0;
+  for (int p = 0; p < numRanks; p++)
+    {
+      recvDispls[p] = numRecv;
+      numRecv += recvCounts[p];
+      if (p > 0)
+        {
+          sendDispls[p] = sendDispls[p-1] + sendCounts[p-1];
+        }
+    }
+  Vector<AMGEntry> sendBuf(a_entries.size());
+  Vector<int> fill(sendDispls);
+  for (int k = 0; k < a_entries.size(); k++)
+    {
+      sendBuf[fill[entryOwner[k]]/sizeof(AMGEntry)] = a_entries[k];
+      fill[entryOwner[k]] += sizeof(AMGEntry);
+    }
+  entries.resize(numRecv/sizeof(AMGEntry));
+  MPI_Alltoallv(firstOf(sendBuf), &sendCounts[0], &sendDispls[0], MPI_BYTE,
+                entries.size() > 0 ? &entries[0] : NULL,
+                &recvCounts[0], &recvDispls[0], MPI_BYTE, Chombo_MPI::comm);
+#else
+  entries = a_entries.constStdVector();
+#endif
+
+  std::sort(entries.begin(), entries.end(), entryLess);
+
+  const long long rowBegin = a_rowStarts[rank];
+  const int numRows = a_rowStarts[rank+1] - rowBegin;
+  a_rowPtr.resize(numRows + 1);
+  a_cols.resize(0);
+  a_vals.resize(0);
+  int row = 0;
+  a_rowPtr[0] = 0;
+  for (int k = 0; k < entries.size(); k++)
+    {
+      int entryRow = entries[k].m_row - rowBegin;
+      CH_assert(entryRow >= row && entryRow < numRows);
+      while (row < entryRow)
+        {
+          row++;
+          a_rowPtr[row] = a_cols.size();
+        }
+      if (a_cols.size() > a_rowPtr[row] && a_cols.back() == entries[k].m_col)
+        {
+          a_vals.back() += entries[k].m_val;
+        }
+      else
+        {
+          a_cols.push_back(entries[k].m_col);
+          a_vals.push_back(entries[k].m_val);
+        }
+    }
+  while (row < numRows)
+    {
+      row++;
+      a_rowPtr[row] = a_cols.size();
+    }
+}
+
+void AMGMatrix::exchange(void*              a_recv,
+                         const Vector<int>& a_recvOffsets,
+                         const void*        a_send,
+                         const Vector<int>& a_sendOffsets,
+                         int                a_bytes) const
+{
+#ifdef CH_MPI
+  CH_TIME("AMGMatrix::exchange");
+  int numRecv = m_recvProcs.size();
+  int numSend = m_sendProcs.size();
+  Vector<MPI_Request> requests(numRecv + numSend);
+  for (int i = 0; i < numRecv; i++)
+    {
+      MPI_Irecv((char*)a_recv + (size_t)a_recvOffsets[i]*a_bytes,
+                (a_recvOffsets[i+1] - a_recvOffsets[i])*a_bytes, MPI_BYTE,
+                m_recvProcs[i], s_amgTag, Chombo_MPI::comm, &requests[i]);
+    }
+  for (int i = 0; i < numSend; i++)
+    {
+      MPI_Isend((char*)a_send + (size_t)a_sendOffsets[i]*a_bytes,
+                (a_sendOffsets[i+1] - a_sendOffsets[i])*a_bytes, MPI_BYTE,
+                m_sendProcs[i], s_amgTag, Chombo_MPI::comm, &requests[numRecv + i]);
+    }
+  if (numRecv + numSend > 0)
+    {
+      MPI_Waitall(numRecv + numSend, &requests[0], MPI_STATUSES_IGNORE);
+    }
+#endif
+}
+
+void AMGMatrix::gatherHalo(Vector<Real>& a_halo, const Vector<Real>& a_x) const
+{
+  a_halo.resize(m_halo.size());
+  Vector<Real> sendBuf(m_sendIndex.size());
+  for (int k = 0; k < m_sendIndex.size(); k++)
+    {
+      sendBuf[k] = a_x[m_sendIndex[k]];
+    }
+  exchange(firstOf(a_halo), m_recvOffsets, firstOf(sendBuf), m_sendOffsets, sizeof(Real));
+}
+
+void AMGMatrix::apply(Vector<Real>& a_y, const Vector<Real>& a_x) const
+{
+  CH_TIME("AMGMatrix::apply");
+  CH_assert(a_x.size() == m_numLocalCols);
+
+  Vector<Real> halo;
+  gatherHalo(halo, a_x);
+
+  a_y.resize(m_numRows);
+  const int*  cols = firstOf(m_cols);
+  const Real* vals = firstOf(m_vals);
+  const Real* x = firstOf(a_x);
+  const Real* h = firstOf(halo);
+  Real* y = firstOf(a_y);
+  const int* rowPtr = &m_rowPtr[0];
+  const int numLocalCols = m_numLocalCols;
+#pragma omp parallel for
+  for (int i = 0; i < m_numRows; i++)
+    {
+      Real sum = 0;
+      for (int k = rowPtr[i]; k < rowPtr[i+1]; k++)
+        {
+          int c = cols[k];
+          sum += vals[k]*((c < numLocalCols) ? x[c] : h[c - numLocalCols]);
+        }
+      y[i] = sum;
+    }
+}
+
+void AMGMatrix::residual(Vector<Real>& a_r, const Vector<Real>& a_x, const Vector<Real>& a_b) const
+{
+  apply(a_r, a_x);
+  Real* r = firstOf(a_r);
+  const Real* b = firstOf(a_b);
+#pragma omp parallel for
+  for (int i = 0; i < m_numRows; i++)
+    {
+      r[i] = b[i] - r[i];
+    }
+}
+
+void AMGMatrix::gatherHaloRows(Vector<int>&       a_rowPtr,
+                               Vector<long long>& a_cols,
+                               Vector<Real>&      a_vals,
+                               const AMGMatrix&   a_B) const
+{
+  CH_TIME("AMGMatrix::gatherHaloRows");
+  CH_assert(a_B.numRows() == m_numLocalCols);
+
+  // the lengths of the rows first
+  int numSend = m_sendIndex.size();
+  Vector<int> sendLengths(numSend);
+  Vector<int> sendOffsets(m_sendProcs.size() + 1, 0);
+  for (int k = 0; k < numSend; k++)
+    {
+      int row = m_sendIndex[k];
+      sendLengths[k] = a_B.rowBegin(row+1) - a_B.rowBegin(row);
+    }
+  Vector<int> recvLengths(m_halo.size());
+  exchange(firstOf(recvLengths), m_recvOffsets, firstOf(sendLengths), m_sendOffsets, sizeof(int));
+
+  // then the rows themselves
+  Vector<long long> sendCols;
+  Vector<Real> sendVals;
+  for (int i = 0; i < m_sendProcs.size(); i++)
+    {
+      for (int k = m_sendOffsets[i]; k < m_sendOffsets[i+1]; k++)
+        {
+          int row = m_sendIndex[k];
+          for (int e = a_B.rowBegin(row); e < a_B.rowBegin(row+1); e++)
+            {
+              sendCols.push_back(a_B.globalCol(a_B.col(e)));
+              sendVals.push_back(a_B.value(e));
+            }
+        }
+      sendOffsets[i+1] = sendCols.size();
+    }
+
+  a_rowPtr.resize(m_halo.size() + 1);
+  a_rowPtr[0] = 0;
+  for (int h = 0; h < m_halo.size(); h++)
+    {
+      a_rowPtr[h+1] = a_rowPtr[h] + recvLengths[h];
+    }
+  Vector<int> recvOffsets(m_recvProcs.size() + 1);
+  for (int i = 0; i <= m_recvProcs.size(); i++)
+    {
+      recvOffsets[i] = a_rowPtr[m_recvOffsets[i]];
+    }
+  a_cols.resize(a_rowPtr[m_halo.size()]);
+  a_vals.resize(a_rowPtr[m_halo.size()]);
+  exchange(firstOf(a_cols), recvOffsets, firstOf(sendCols), sendOffsets, sizeof(long long));
+  exchange(firstOf(a_vals), recvOffsets, firstOf(sendVals), sendOffsets, sizeof(Real));
+}
+
+void AMGMatrix::gatherAll(Vector<AMGEntry>& a_entries) const
+{
+  CH_TIME("AMGMatrix::gatherAll");
+
+  Vector<AMGEntry> local;
+  for (int i = 0; i < m_numRows; i++)
+    {
+      for (int k = m_rowPtr[i]; k < m_rowPtr[i+1]; k++)
+        {
+          AMGEntry entry;
+          entry.m_row = m_rowStarts[m_rank] + i;
+          entry.m_col = globalCol(m_cols[k]);
+          entry.m_val = m_vals[k];
+          local.push_back(entry);
+        }
+    }
+#ifdef CH_MPI
+  int localBytes = local.size()*sizeof(AMGEntry);
+  Vector<int> counts(m_numRanks), displs(m_numRanks, 0);
+  MPI_Allgather(&localBytes, 1, MPI_INT, &counts[0], 1, MPI_INT, Chombo_MPI::comm);
+  int totalBytes = counts[0];
+  for (int p = 1; p < m_numRanks; p++)
+    {
+      displs[p] = displs[p-1] + counts[p-1];
+      totalBytes += counts[p];
+    }
+  a_entries.resize(totalBytes/sizeof(AMGEntry));
+  MPI_Allgatherv(firstOf(local), localBytes, MPI_BYTE,
+                 firstOf(a_entries), &counts[0], &displs[0], MPI_BYTE, Chombo_MPI::comm);
+#else
+  a_entries = local;
+#endif
+}
+
+#include "NamespaceFooter.H"
@@ -0,0 +1,944 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+#include <cmath>
+#include <map>
+
+#include "AMGSolver.H"
+#include "BoxIterator.H"
+#include "Misc.H"
+#include "SPMD.H"
+#include "MayDay.H"
+#include "parstream.H"
+#include "CH_Timer.H"
+#include "NamespaceHeader.H"
+
+// this rank and the number of ranks of Chombo_MPI::comm
+static void commRank(int& a_rank, int& a_numRanks)
+{
+  a_rank = 0;
+  a_numRanks = 1;
+#ifdef CH_MPI
+  MPI_Comm_rank(Chombo_MPI::comm, &a_rank);
+  MPI_Comm_size(Chombo_MPI::comm, &a_numRanks);
+#endif
+}
+
+// a_starts[p] = sum of a_count over the ranks before p
+static void partition(Vector<long long>& a_starts, long long a_count)
+{
+  int rank, numRanks;
+  commRank(rank, numRanks);
+  Vector<long long> counts(numRanks, a_count);
+#ifdef CH_MPI
+  MPI_Allgather(&a_count, 1, MPI_LONG_LONG, &counts[0], 1, MPI_LONG_LONG, Chombo_MPI::comm);
+#endif
+  a_starts.resize(numRanks + 1);
+  a_starts[0] = 0;
+  for (int p = 0; p < numRanks; p++)
+    {
+      a_starts[p+1] = a_starts[p] + counts[p];
+    }
+}
+
+// the dot product of the vectors of which a_x and a_y hold the rows of
+// this rank
+static Real dot(const Vector<Real>& a_x, const Vector<Real>& a_y)
+{
+  Real sum = 0;
+  for (int i = 0; i < a_x.size(); i++)
+    {
+      sum += a_x[i]*a_y[i];
+    }
+#ifdef CH_MPI
+  Real localSum = sum;
+  MPI_Allreduce(&localSum, &sum, 1, MPI_CH_REAL, MPI_SUM, Chombo_MPI::comm);
+#endif
+  return sum;
+}
+
+// a_i mod 3, in 0..2
+static inline int mod3(int a_i)
+{
+  return ((a_i % 3) + 3) % 3;
+}
+
+// the rows of A B on this rank, with global columns
+static void multiply(Vector<int>&       a_rowPtr,
+                     Vector<long long>& a_cols,
+                     Vector<Real>&      a_vals,
+                     const AMGMatrix&   a_A,
+                     const AMGMatrix&   a_B)
+{
+  CH_TIME("AMGSolver::multiply");
+
+  Vector<int> haloPtr;
+  Vector<long long> haloCols;
+  Vector<Real> haloVals;
+  a_A.gatherHaloRows(haloPtr, haloCols, haloVals, a_B);
+
+  a_rowPtr.resize(a_A.numRows() + 1);
+  a_rowPtr[0] = 0;
+  a_cols.resize(0);
+  a_vals.resize(0);
+  const int numLocal = a_A.numLocalCols();
+  for (int i = 0; i < a_A.numRows(); i++)
+    {
+      std::map<long long, Real> row;
+      for (int e = a_A.rowBegin(i); e < a_A.rowBegin(i+1); e++)
+        {
+          int c = a_A.col(e);
+          Real v = a_A.value(e);
+          if (c < numLocal)
+            {
+              for (int f = a_B.rowBegin(c); f < a_B.rowBegin(c+1); f++)
+                {
+                  row[a_B.globalCol(a_B.col(f))] += v*a_B.value(f);
+                }
+            }
+          else
+            {
+              int h = c - numLocal;
+              for (int f = haloPtr[h]; f < haloPtr[h+1]; f++)
+                {
+                  row[haloCols[f]] += v*haloVals[f];
+                }
+            }
+        }
+      for (std::map<long long, Real>::const_iterator it = row.begin(); it != row.end(); ++it)
+        {
+          if (it->second != 0)
+            {
+              a_cols.push_back(it->first);
+              a_vals.push_back(it->second);
+            }
+        }
+      a_rowPtr[i+1] = a_cols.size();
+    }
+}
+
+AMGSolver::AMGSolver()
+  :m_homogeneous(false),
+   m_op(NULL),
+   m_imax(40),
+   m_verbosity(3),
+   m_eps(1.0E-6),
+   m_reps(1.0E-12),
+   m_convergenceMetric(-1.0),
+   m_exitStatus(-1),
+   m_normType(2),
+   m_numSmooth(2),
+   m_strength(0.08),
+   m_maxCoarse(64),
+   m_maxLevels(20),
+   m_maxDirect(2000),
+   m_isSetup(false),
+   m_nComp(0)
+{
+}
+
+AMGSolver::~AMGSolver()
+{
+  clearHierarchy();
+  m_op = NULL;
+}
+
+void AMGSolver::define(LinearOp<LevelData<FArrayBox> >* a_operator, bool a_homogeneous)
+{
+  m_homogeneous = a_homogeneous;
+  m_op = a_operator;
+  reset();
+
+  // watch for changes to the operator's coefficients
+  MGLevelOp<LevelData<FArrayBox> >* mgOp =
+    dynamic_cast<MGLevelOp<LevelData<FArrayBox> >*>(a_operator);
+  if (observee() != mgOp)
+    {
+      if (observee() != NULL)
+        {
+          observee()->removeObserver(this);
+        }
+      if (mgOp != NULL)
+        {
+          mgOp->addObserver(this);
+        }
+    }
+}
+
+void AMGSolver::setConvergenceMetrics(Real a_metric,
+                                      Real a_tolerance)
+{
+  m_convergenceMetric = a_metric;
+  m_eps = a_tolerance;
+}
+
+void AMGSolver::reset()
+{
+  m_isSetup = false;
+}
+
+void AMGSolver::operatorChanged(const MGLevelOp<LevelData<FArrayBox> >& a_operator)
+{
+  reset();
+}
+
+void AMGSolver::clearHierarchy()
+{
+  for (int l = 0; l < m_A.size(); l++)
+    {
+      delete m_A[l];
+    }
+  for (int l = 0; l < m_P.size(); l++)
+    {
+      delete m_P[l];
+      delete m_R[l];
+    }
+  m_A.resize(0);
+  m_P.resize(0);
+  m_R.resize(0);
+  m_invDiag.resize(0);
+  m_omega.resize(0);
+  m_lu.resize(0);
+  m_pivot.resize(0);
+  m_isSetup = false;
+}
+
+void AMGSolver::setup(const LevelData<FArrayBox>& a_phi, const LevelData<FArrayBox>& a_rhs)
+{
+  CH_TIME("AMGSolver::setup");
+  CH_assert(m_op != NULL);
+
+  clearHierarchy();
+  m_grids = a_rhs.disjointBoxLayout();
+  m_nComp = a_rhs.nComp();
+
+  assembleOperator(a_phi, a_rhs);
+  defineSmoother();
+  while (m_A.size() < m_maxLevels && m_A.back()->numGlobalRows() > m_maxCoarse)
+    {
+      if (!coarsen())
+        {
+          break;
+        }
+    }
+  factorCoarsest();
+  m_isSetup = true;
+
+  if (m_verbosity >= 4)
+    {
+      pout() << "      AMG:: " << m_A.size() << " levels, rows";
+      for (int l = 0; l < m_A.size(); l++)
+        {
+          pout() << " " << m_A[l]->numGlobalRows();
+        }
+      pout() << ((m_lu.size() > 0) ? ", direct" : ", smoothed")
+             << " coarsest solve\n";
+    }
+}
+
+void AMGSolver::assembleOperator(const LevelData<FArrayBox>& a_phi,
+                                 const LevelData<FArrayBox>& a_rhs)
+{
+  CH_TIME("AMGSolver::assembleOperator");
+
+  int rank, numRanks;
+  commRank(rank, numRanks);
+  const ProblemDomain& domain = m_grids.physDomain();
+  const Box& domainBox = domain.domainBox();
+
+  long long numNodes = 0;
+  for (DataIterator dit = m_grids.dataIterator(); dit.ok(); ++dit)
+    {
+      numNodes += m_grids[dit].numPts();
+    }
+  Vector<long long> nodeStarts;
+  partition(nodeStarts, numNodes);
+  Vector<long long> rowStarts(nodeStarts.size());
+  for (int p = 0; p < nodeStarts.size(); p++)
+    {
+      rowStarts[p] = m_nComp*nodeStarts[p];
+    }
+
+  // the global node ids of the cells, and of their neighbors up to two
+  // cells away; -1 outside the domain
+  LevelData<FArrayBox> gid(m_grids, 1, 2*IntVect::Unit);
+  long long node = nodeStarts[rank];
+  for (DataIterator dit = m_grids.dataIterator(); dit.ok(); ++dit)
+    {
+      gid[dit].setVal(-1.0);
+      for (BoxIterator bit(m_grids[dit]); bit.ok(); ++bit)
+        {
+          gid[dit](bit()) = node++;
+        }
+    }
+  gid.exchange();
+
+  LevelData<FArrayBox> x, y;
+  m_op->create(x, a_phi);
+  m_op->create(y, a_rhs);
+
+  // apply the operator to the indicator of the cells of each color and
+  // component; the cell of the color a cell couples to is its neighbor of
+  // that color, or, where that one is outside the domain, the cell of the
+  // color two cells in from it
+  Vector<AMGEntry> entries;
+  Box colors(IntVect::Zero, 2*IntVect::Unit);
+  for (BoxIterator cit(colors); cit.ok(); ++cit)
+    {
+      const IntVect& color = cit();
+      for (int icomp = 0; icomp < m_nComp; icomp++)
+        {
+          m_op->setToZero(x);
+          for (DataIterator dit = m_grids.dataIterator(); dit.ok(); ++dit)
+            {
+              for (BoxIterator bit(m_grids[dit]); bit.ok(); ++bit)
+                {
+                  const IntVect& iv = bit();
+                  if (D_TERM(mod3(iv[0]) == color[0],
+                             && mod3(iv[1]) == color[1],
+                             && mod3(iv[2]) == color[2]))
+                    {
+                      x[dit](iv, icomp) = 1.0;
+                    }
+                }
+            }
+          m_op->applyOp(y, x, true);
+
+          long long row = rowStarts[rank];
+          for (DataIterator dit = m_grids.dataIterator(); dit.ok(); ++dit)
+            {
+              const FArrayBox& yFab = y[dit];
+              const FArrayBox& gidFab = gid[dit];
+              for (BoxIterator bit(m_grids[dit]); bit.ok(); ++bit, row += m_nComp)
+                {
+                  const IntVect& iv = bit();
+                  IntVect jv;
+                  for (int idir = 0; idir < SpaceDim; idir++)
+                    {
+                      int shift = mod3(color[idir] - iv[idir]);
+                      if (shift == 2)
+                        {
+                          shift = -1;
+                        }
+                      jv[idir] = iv[idir] + shift;
+                      if (!domain.isPeriodic(idir) &&
+                          (jv[idir] < domainBox.smallEnd(idir) || jv[idir] > domainBox.bigEnd(idir)))
+                        {
+                          jv[idir] = iv[idir] - 2*shift;
+                        }
+                    }
+                  Real col = gidFab(jv);
+                  for (int jcomp = 0; jcomp < m_nComp; jcomp++)
+                    {
+                      Real val = yFab(iv, jcomp);
+                      if (val != 0)
+                        {
+                          if (col < 0)
+                            {
+                              MayDay::Error("AMGSolver: operator stencil is too wide to assemble");
+                            }
+                          AMGEntry entry;
+                          entry.m_row = row + jcomp;
+                          entry.m_col = m_nComp*(long long)col + icomp;
+                          entry.m_val = val;
+                          entries.push_back(entry);
+                        }
+                    }
+                }
+            }
+        }
+    }
+  m_op->clear(x);
+  m_op->clear(y);
+
+  Vector<int> rowPtr;
+  Vector<long long> cols;
+  Vector<Real> vals;
+  AMGMatrix::assemble(rowPtr, cols, vals, rowStarts, entries);
+  AMGMatrix* A = new AMGMatrix();
+  A->define(rowStarts, rowStarts, rowPtr, cols, vals);
+  m_A.push_back(A);
+}
+
+void AMGSolver::defineSmoother()
+{
+  const AMGMatrix& A = *m_A.back();
+  Vector<Real> invDiag(A.numRows(), 0.0);
+
+  // Gershgorin bound on the spectral radius of D^-1 A
+  Real rho = 0;
+  for (int i = 0; i < A.numRows(); i++)
+    {
+      Real diag = 0;
+      Real rowSum = 0;
+      for (int e = A.rowBegin(i); e < A.rowBegin(i+1); e++)
+        {
+          if (A.col(e) == i)
+            {
+              diag = A.value(e);
+            }
+          rowSum += Abs(A.value(e));
+        }
+      if (diag != 0)
+        {
+          invDiag[i] = 1.0/diag;
+          rho = Max(rho, rowSum/Abs(diag));
+        }
+    }
+#ifdef CH_MPI
+  Real localRho = rho;
+  MPI_Allreduce(&localRho, &rho, 1, MPI_CH_REAL, MPI_MAX, Chombo_MPI::comm);
+#endif
+
+  m_invDiag.push_back(invDiag);
+  m_omega.push_back((rho > 0) ? 4.0/(3.0*rho) : 0.0);
+}
+
+bool AMGSolver::coarsen()
+{
+  CH_TIME("AMGSolver::coarsen");
+
+  int rank, numRanks;
+  commRank(rank, numRanks);
+  const int level = m_A.size() - 1;
+  const AMGMatrix& A = *m_A[level];
+  const int blockSize = m_nComp;
+  const int numNodes = A.numRows()/blockSize;
+  const int numLocal = A.numLocalCols();
+
+  // squared norms of the blocks coupling the nodes of this rank; the
+  // aggregates do not cross ranks
+  Vector<std::map<int, Real> > coupling(numNodes);
+  for (int i = 0; i < A.numRows(); i++)
+    {
+      for (int e = A.rowBegin(i); e < A.rowBegin(i+1); e++)
+        {
+          if (A.col(e) < numLocal)
+            {
+              coupling[i/blockSize][A.col(e)/blockSize] += A.value(e)*A.value(e);
+            }
+        }
+    }
+  Vector<Real> diagNorm(numNodes, 0.0);
+  for (int n = 0; n < numNodes; n++)
+    {
+      diagNorm[n] = sqrt(coupling[n][n]);
+    }
+  Vector<Vector<int> > strong(numNodes);
+  for (int n = 0; n < numNodes; n++)
+    {
+      for (std::map<int, Real>::const_iterator it = coupling[n].begin(); it != coupling[n].end(); ++it)
+        {
+          int j = it->first;
+          if (j != n && sqrt(it->second) > m_strength*sqrt(diagNorm[n]*diagNorm[j]))
+            {
+              strong[n].push_back(j);
+            }
+        }
+    }
+
+  // a node with no aggregated strong neighbors roots an aggregate of
+  // itself and them
+  Vector<int> agg(numNodes, -1);
+  int numAgg = 0;
+  for (int n = 0; n < numNodes; n++)
+    {
+      if (agg[n] >= 0 || strong[n].size() == 0)
+        {
+          continue;
+        }
+      bool isFree = true;
+      for (int k = 0; k < strong[n].size(); k++)
+        {
+          isFree = isFree && (agg[strong[n][k]] < 0);
+        }
+      if (isFree)
+        {
+          agg[n] = numAgg;
+          for (int k = 0; k < strong[n].size(); k++)
+            {
+              agg[strong[n][k]] = numAgg;
+            }
+          numAgg++;
+        }
+    }
+  // the others join the aggregate they are most strongly coupled to
+  Vector<int> rootAgg(agg);
+  for (int n = 0; n < numNodes; n++)
+    {
+      if (agg[n] >= 0)
+        {
+          continue;
+        }
+      Real best = 0;
+      for (int k = 0; k < strong[n].size(); k++)
+        {
+          int j = strong[n][k];
+          if (rootAgg[j] >= 0 && coupling[n][j] > best)
+            {
+              best = coupling[n][j];
+              agg[n] = rootAgg[j];
+            }
+        }
+    }
+  // and what is left makes aggregates of its own
+  for (int n = 0; n < numNodes; n++)
+    {
+      if (agg[n] >= 0)
+        {
+          continue;
+        }
+      agg[n] = numAgg;
+      for (int k = 0; k < strong[n].size(); k++)
+        {
+          if (agg[strong[n][k]] < 0)
+            {
+              agg[strong[n][k]] = numAgg;
+            }
+        }
+      numAgg++;
+    }
+
+  Vector<long long> aggStarts;
+  partition(aggStarts, numAgg);
+  Vector<long long> coarseStarts(aggStarts.size());
+  for (int p = 0; p < aggStarts.size(); p++)
+    {
+      coarseStarts[p] = blockSize*aggStarts[p];
+    }
+  if (coarseStarts[numRanks] > 0.8*A.numGlobalRows())
+    {
+      return false;
+    }
+
+  // P = (I - omega D^-1 A) P_0, with P_0 the piecewise constant
+  // interpolation from the aggregates, component by component
+  Vector<Real> coarseRow(A.numRows());
+  for (int i = 0; i < A.numRows(); i++)
+    {
+      coarseRow[i] = blockSize*(aggStarts[rank] + agg[i/blockSize]) + i%blockSize;
+    }
+  Vector<Real> haloCoarseRow;
+  A.gatherHalo(haloCoarseRow, coarseRow);
+
+  const Real omega = m_omega[level];
+  const Vector<Real>& invDiag = m_invDiag[level];
+  Vector<int> rowPtr(A.numRows() + 1, 0);
+  Vector<long long> cols;
+  Vector<Real> vals;
+  for (int i = 0; i < A.numRows(); i++)
+    {
+      std::map<long long, Real> row;
+      row[(long long)coarseRow[i]] += 1.0;
+      for (int e = A.rowBegin(i); e < A.rowBegin(i+1); e++)
+        {
+          int c = A.col(e);
+          Real coarse = (c < numLocal) ? coarseRow[c] : haloCoarseRow[c - numLocal];
+          row[(long long)coarse] -= omega*invDiag[i]*A.value(e);
+        }
+      for (std::map<long long, Real>::const_iterator it = row.begin(); it != row.end(); ++it)
+        {
+          if (it->second != 0)
+            {
+              cols.push_back(it->first);
+              vals.push_back(it->second);
+            }
+        }
+      rowPtr[i+1] = cols.size();
+    }
+  AMGMatrix* P = new AMGMatrix();
+  P->define(A.rowStarts(), coarseStarts, rowPtr, cols, vals);
+
+  // R = P^T
+  Vector<AMGEntry> entries;
+  for (int i = 0; i < P->numRows(); i++)
+    {
+      for (int e = P->rowBegin(i); e < P->rowBegin(i+1); e++)
+        {
+          AMGEntry entry;
+          entry.m_row = P->globalCol(P->col(e));
+          entry.m_col = A.rowStarts()[rank] + i;
+          entry.m_val = P->value(e);
+          entries.push_back(entry);
+        }
+    }
+  AMGMatrix::assemble(rowPtr, cols, vals, coarseStarts, entries);
+  AMGMatrix* R = new AMGMatrix();
+  R->define(coarseStarts, A.rowStarts(), rowPtr, cols, vals);
+
+  // the Galerkin product R (A P)
+  multiply(rowPtr, cols, vals, A, *P);
+  AMGMatrix AP;
+  AP.define(A.rowStarts(), coarseStarts, rowPtr, cols, vals);
+  multiply(rowPtr, cols, vals, *R, AP);
+  AMGMatrix* coarseA = new AMGMatrix();
+  coarseA->define(coarseStarts, coarseStarts, rowPtr, cols, vals);
+
+  m_P.push_back(P);
+  m_R.push_back(R);
+  m_A.push_back(coarseA);
+  defineSmoother();
+  return true;
+}
+
+void AMGSolver::factorCoarsest()
+{
+  CH_TIME("AMGSolver::factorCoarsest");
+
+  m_lu.resize(0);
+  m_pivot.resize(0);
+  const AMGMatrix& A = *m_A.back();
+  const long long n = A.numGlobalRows();
+  if (n > m_maxDirect)
+    {
+      return;
+    }
+
+  // every rank factors the whole matrix
+  Vector<AMGEntry> entries;
+  A.gatherAll(entries);
+  m_lu.resize(n*n, 0.0);
+  m_pivot.resize(n);
+  Real scale = 0;
+  for (int k = 0; k < entries.size(); k++)
+    {
+      m_lu[entries[k].m_row*n + entries[k].m_col] += entries[k].m_val;
+      scale = Max(scale, Abs(entries[k].m_val));
+    }
+
+  for (int k = 0; k < n; k++)
+    {
+      int p = k;
+      for (int i = k+1; i < n; i++)
+        {
+          if (Abs(m_lu[i*n + k]) > Abs(m_lu[p*n + k]))
+            {
+              p = i;
+            }
+        }
+      m_pivot[k] = p;
+      if (p != k)
+        {
+          for (int j = 0; j < n; j++)
+            {
+              Real tmp = m_lu[k*n + j];
+              m_lu[k*n + j] = m_lu[p*n + j];
+              m_lu[p*n + j] = tmp;
+            }
+        }
+      Real pivot = m_lu[k*n + k];
+      if (Abs(pivot) <= 1.0e-13*scale)
+        {
+          // singular, as for Neumann or periodic boundary conditions:
+          // that unknown of the solution is set to zero
+          m_lu[k*n + k] = 0;
+          for (int i = k+1; i < n; i++)
+            {
+              m_lu[i*n + k] = 0;
+            }
+          continue;
+        }
+      for (int i = k+1; i < n; i++)
+        {
+          Real factor = m_lu[i*n + k]/pivot;
+          m_lu[i*n + k] = factor;
+          if (factor != 0)
+            {
+              for (int j = k+1; j < n; j++)
+                {
+                  m_lu[i*n + j] -= factor*m_lu[k*n + j];
+                }
+            }
+        }
+    }
+}
+
+void AMGSolver::solveCoarsest(Vector<Real>& a_x, const Vector<Real>& a_b)
+{
+  CH_TIME("AMGSolver::solveCoarsest");
+
+  const int level = m_A.size() - 1;
+  if (m_lu.size() == 0)
+    {
+      smooth(level, a_x, a_b, 10*m_numSmooth);
+      return;
+    }
+
+  const AMGMatrix& A = *m_A[level];
+  const int n = A.numGlobalRows();
+  int rank, numRanks;
+  commRank(rank, numRanks);
+  const Vector<long long>& starts = A.rowStarts();
+
+  Vector<Real> x(n);
+#ifdef CH_MPI
+  Vector<int> counts(numRanks), displs(numRanks);
+  for (int p = 0; p < numRanks; p++)
+    {
+      counts[p] = starts[p+1] - starts[p];
+      displs[p] = starts[p];
+    }
+  MPI_Allgatherv((void*)(a_b.size() > 0 ? &a_b[0] : NULL), counts[rank], MPI_CH_REAL,
+                 &x[0], &counts[0], &displs[0], MPI_CH_REAL, Chombo_MPI::comm);
+#else
+  x = a_b;
+#endif
+
+  for (int k = 0; k < n; k++)
+    {
+      if (m_pivot[k] != k)
+        {
+          Real tmp = x[k];
+          x[k] = x[m_pivot[k]];
+          x[m_pivot[k]] = tmp;
+        }
+    }
+  for (int i = 1; i < n; i++)
+    {
+      for (int j = 0; j < i; j++)
+        {
+          x[i] -= m_lu[i*n + j]*x[j];
+        }
+    }
+  for (int i = n-1; i >= 0; i--)
+    {
+      if (m_lu[i*n + i] == 0)
+        {
+          x[i] = 0;
+          continue;
+        }
+      for (int j = i+1; j < n; j++)
+        {
+          x[i] -= m_lu[i*n + j]*x[j];
+        }
+      x[i] /= m_lu[i*n + i];
+    }
+
+  for (int i = 0; i < A.numRows(); i++)
+    {
+      a_x[i] = x[starts[rank] + i];
+    }
+}
+
+void AMGSolver::smooth(int a_level, Vector<Real>& a_x, const Vector<Real>& a_b, int a_numSweeps)
+{
+  const AMGMatrix& A = *m_A[a_level];
+  const Real omega = m_omega[a_level];
+  const Vector<Real>& invDiag = m_invDiag[a_level];
+  Vector<Real> r;
+  for (int isweep = 0; isweep < a_numSweeps; isweep++)
+    {
+      A.residual(r, a_x, a_b);
+      const int numRows = A.numRows();
+#pragma omp parallel for
+      for (int i = 0; i < numRows; i++)
+        {
+          a_x[i] += omega*invDiag[i]*r[i];
+        }
+    }
+}
+
+void AMGSolver::vCycle(int a_level, Vector<Real>& a_x, const Vector<Real>& a_b)
+{
+  if (a_level == m_A.size() - 1)
+    {
+      solveCoarsest(a_x, a_b);
+      return;
+    }
+
+  smooth(a_level, a_x, a_b, m_numSmooth);
+
+  Vector<Real> r, coarseB, correction;
+  m_A[a_level]->residual(r, a_x, a_b);
+  m_R[a_level]->apply(coarseB, r);
+  Vector<Real> coarseX(coarseB.size(), 0.0);
+  vCycle(a_level+1, coarseX, coarseB);
+  m_P[a_level]->apply(correction, coarseX);
+  for (int i = 0; i < a_x.size(); i++)
+    {
+      a_x[i] += correction[i];
+    }
+
+  smooth(a_level, a_x, a_b, m_numSmooth);
+}
+
+void AMGSolver::precondition(Vector<Real>& a_z, const Vector<Real>& a_r)
+{
+  a_z.resize(a_r.size());
+  for (int i = 0; i < a_z.size(); i++)
+    {
+      a_z[i] = 0;
+    }
+  vCycle(0, a_z, a_r);
+}
+
+void AMGSolver::toVector(Vector<Real>& a_x, const LevelData<FArrayBox>& a_data) const
+{
+  a_x.resize(m_A[0]->numRows());
+  int i = 0;
+  for (DataIterator dit = m_grids.dataIterator(); dit.ok(); ++dit)
+    {
+      const FArrayBox& fab = a_data[dit];
+      for (BoxIterator bit(m_grids[dit]); bit.ok(); ++bit)
+        {
+          for (int icomp = 0; icomp < m_nComp; icomp++)
+            {
+              a_x[i++] = fab(bit(), icomp);
+            }
+        }
+    }
+}
+
+void AMGSolver::fromVector(LevelData<FArrayBox>& a_data, const Vector<Real>& a_x) const
+{
+  int i = 0;
+  for (DataIterator dit = m_grids.dataIterator(); dit.ok(); ++dit)
+    {
+      FArrayBox& fab = a_data[dit];
+      for (BoxIterator bit(m_grids[dit]); bit.ok(); ++bit)
+        {
+          for (int icomp = 0; icomp < m_nComp; icomp++)
+            {
+              fab(bit(), icomp) = a_x[i++];
+            }
+        }
+    }
+}
+
+void AMGSolver::solve(LevelData<FArrayBox>& a_phi, const LevelData<FArrayBox>& a_rhs)
+{
+  CH_TIMERS("AMGSolver::solve");
+
+  CH_TIMER("AMGSolver::solve::Setup",timeSetup);
+  CH_TIMER("AMGSolver::solve::MainLoop",timeMainLoop);
+
+  CH_assert(m_op != NULL);
+
+  CH_START(timeSetup);
+  if (!m_isSetup || !(a_rhs.disjointBoxLayout() == m_grids) || a_rhs.nComp() != m_nComp)
+    {
+      setup(a_phi, a_rhs);
+    }
+  CH_STOP(timeSetup);
+
+  LevelData<FArrayBox> res, cor;
+  m_op->create(res, a_rhs);
+  m_op->create(cor, a_phi);
+  m_op->setToZero(cor);
+
+  m_op->residual(res, a_phi, a_rhs, m_homogeneous);
+
+  Real initial_norm = m_op->norm(res, m_normType);
+  Real initial_rnorm = initial_norm;
+  Real norm = initial_norm;
+
+  if (m_verbosity >= 5)
+    {
+      pout() << "      AMG:: initial Residual norm = "
+             << initial_norm << "\n";
+    }
+
+  // if a convergence metric has been supplied, replace initial residual
+  // with the supplied convergence metric...
+  if (m_convergenceMetric > 0)
+    {
+      initial_norm = m_convergenceMetric;
+    }
+
+  // BiCGStab on A e = r, in the numbering of the matrix, right
+  // preconditioned by a V-cycle
+  CH_START(timeMainLoop);
+  const AMGMatrix& A = *m_A[0];
+  Vector<Real> r, x;
+  toVector(r, res);
+  x.resize(r.size(), 0.0);
+  Vector<Real> rhat(r);
+  Vector<Real> p(r.size(), 0.0), v(r.size(), 0.0);
+  Vector<Real> phat, shat, t;
+  Real rho = 1, alpha = 1, omega = 1;
+  m_exitStatus = -1;
+  int i = 0;
+  while (m_exitStatus == -1)
+    {
+      if (norm <= m_eps*initial_norm || norm <= m_reps*initial_rnorm)
+        {
+          m_exitStatus = 1;
+          break;
+        }
+      if (i == m_imax)
+        {
+          m_exitStatus = 3;
+          break;
+        }
+
+      Real rhoNew = dot(rhat, r);
+      if (rhoNew == 0.0 || omega == 0.0)
+        {
+          m_exitStatus = 2;
+          break;
+        }
+      Real beta = (rhoNew/rho)*(alpha/omega);
+      for (int k = 0; k < p.size(); k++)
+        {
+          p[k] = r[k] + beta*(p[k] - omega*v[k]);
+        }
+      precondition(phat, p);
+      A.apply(v, phat);
+      Real denom = dot(rhat, v);
+      if (denom == 0.0)
+        {
+          m_exitStatus = 2;
+          break;
+        }
+      alpha = rhoNew/denom;
+
+      // r becomes s = r - alpha v
+      for (int k = 0; k < r.size(); k++)
+        {
+          x[k] += alpha*phat[k];
+          r[k] -= alpha*v[k];
+        }
+      precondition(shat, r);
+      A.apply(t, shat);
+      Real tt = dot(t, t);
+      omega = (tt > 0) ? dot(t, r)/tt : 0.0;
+      for (int k = 0; k < r.size(); k++)
+        {
+          x[k] += omega*shat[k];
+          r[k] -= omega*t[k];
+        }
+      rho = rhoNew;
+
+      fromVector(res, r);
+      norm = m_op->norm(res, m_normType);
+      i++;
+
+      if (m_verbosity >= 4)
+        {
+          pout() << "      AMG::     iteration = "  << i
+                 << ", error norm = " << norm << "\n";
+        }
+    }
+  CH_STOP(timeMainLoop);
+
+  fromVector(cor, x);
+  m_op->incr(a_phi, cor, 1.0);
+
+  if (m_verbosity >= 4)
+    {
+      pout() << "      AMG:: " << i << " iterations, final Residual norm = "
+             << norm << "\n";
+    }
+
+  m_op->clear(res);
+  m_op->clear(cor);
+}
+
+#include "NamespaceFooter.H"
@@ -13,13 +13,17 @@
 #include "AverageF_F.H"
 #include "InterpF_F.H"
 #include "LayoutIterator.H"
+#include "TiledDataIterator.H"
 #include "FineInterp.H"
 #include "CoarseAverage.H"
+#include "BRMeshRefine.H"
+#include "LoadBalance.H"
 #include "CH_OpenMP.H"
 #include "AMRMultiGrid.H"
 #include "Misc.H"
 
 #include "AMRPoissonOp.H"
+#include "AMRPoissonOpKernels.H"
 #include "AMRPoissonOpF_F.H"
 #include "CCProjectorF_F.H"
 #include "MACProjectorF_F.H"
@@ -28,8 +32,12 @@
 
 int AMRPoissonOp::s_exchangeMode = 1; // 1: no overlap (default); 0: ...
 //int AMRPoissonOp::s_relaxMode = 0;
-int AMRPoissonOp::s_relaxMode = 1; // 1: GSRB; 4: Jacobi
+int AMRPoissonOp::s_relaxMode = 1; // 1: GSRB; 4: Jacobi; 6: deep GSRB; 7: Chebyshev
+int AMRPoissonOp::s_deepSweeps = 2;
+int AMRPoissonOp::s_kernelMode = 0; // 0: Fortran (default); 1: C++
+bool AMRPoissonOp::s_fusedVCycle = false;
 int AMRPoissonOp::s_maxCoarse = 2;
+int AMRPoissonOp::s_agglomerateCells = 0; // 0: off
 
 // ---------------------------------------------------------
 static void
@@ -55,6 +63,20 @@ amrpgetMultiColors(Vector<IntVect>& a_colors)
 #endif
 }
 
+// ---------------------------------------------------------
+AMRPoissonOp::~AMRPoissonOp()
+{
+#ifdef CH_MPI
+  // operators can outlive MPI, in which case there is nothing left to free
+  int finalized = 0;
+  MPI_Finalized(&finalized);
+  if (!finalized && m_agglomeratedComm != MPI_COMM_NULL)
+    {
+      MPI_Comm_free(&m_agglomeratedComm);
+    }
+#endif
+}
+
 // ---------------------------------------------------------
 /** full define function for AMRLevelOp with both coarser and finer levels */
 void AMRPoissonOp::define(const DisjointBoxLayout& a_grids,
@@ -85,6 +107,7 @@ void AMRPoissonOp::define(const DisjointBoxLayout& a_grids,
                           fineDomain,
                           m_refToFiner,
                           1 /* ncomp*/);
+      m_gridsFiner = a_gridsFiner;
     }
 }
 
@@ -116,6 +139,7 @@ void AMRPoissonOp::define(const DisjointBoxLayout& a_grids,
                       fineDomain,
                       m_refToFiner,
                       1 /* ncomp*/);
+  m_gridsFiner = a_gridsFiner;
 }
 
 // ---------------------------------------------------------
@@ -140,6 +164,7 @@ void AMRPoissonOp::define(const DisjointBoxLayout& a_grids,
 
   m_interpWithCoarser.define(a_grids, &a_coarse, a_dxLevel,
                              m_refToCoarser, 1, m_domain);
+  m_gridsCoarser = a_coarse;
 }
 
 // ---------------------------------------------------------
@@ -172,6 +197,12 @@ void AMRPoissonOp::define(const DisjointBoxLayout& a_grids,
   // m_exchangeCopier.trimEdges(a_grids, IntVect::Unit);
 
   m_cfregion = a_cfregion;
+
+  // the AMR define functions set the others
+  m_grids        = a_grids;
+  m_gridsCoarser = DisjointBoxLayout();
+  m_gridsFiner   = DisjointBoxLayout();
+  m_numCompsCF   = 1;
 }
 
 // ---------------------------------------------------------
@@ -256,16 +287,28 @@ void AMRPoissonOp::residualI(LevelData<FArrayBox>&       a_lhs,
       }
   }
 
-  for (dit.begin(); dit.ok(); ++dit)
+  TiledDataIterator tit(dbl);
+  int ntile = tit.size();
+#pragma omp parallel for
+  for (int itile = 0; itile < ntile; itile++)
     {
-      const Box& region = dbl[dit];
-      FORT_OPERATORLAPRES(CHF_FRA(a_lhs[dit]),
-                          CHF_CONST_FRA(phi[dit]),
-                          CHF_CONST_FRA(a_rhs[dit]),
-                          CHF_BOX(region),
-                          CHF_CONST_REAL(m_dx),
-                          CHF_CONST_REAL(m_alpha),
-                          CHF_CONST_REAL(m_beta));
+      const DataIndex& d = tit[itile];
+      const Box& region = tit.tile(itile);
+      if (s_kernelMode == 1)
+        {
+          AMRPoissonOpKernels::residual(a_lhs[d], phi[d], a_rhs[d], region,
+                                        m_dx, m_alpha, m_beta);
+        }
+      else
+        {
+          FORT_OPERATORLAPRES(CHF_FRA(a_lhs[d]),
+                              CHF_CONST_FRA(phi[d]),
+                              CHF_CONST_FRA(a_rhs[d]),
+                              CHF_BOX(region),
+                              CHF_CONST_REAL(m_dx),
+                              CHF_CONST_REAL(m_alpha),
+                              CHF_CONST_REAL(m_beta));
+        }
     }
 }
 
@@ -288,14 +331,18 @@ void AMRPoissonOp::preCond(LevelData<FArrayBox>&       a_phi,
   Real mult = 1.0 / (m_alpha - 2.0*SpaceDim * m_beta / (m_dx*m_dx));
 
   // don't need to use a Copier -- plain copy will do
-  DataIterator dit = a_phi.dataIterator();
-  int nbox = dit.size();
+  TiledDataIterator tit(a_phi.disjointBoxLayout(), a_phi.ghostVect());
+  int ntile = tit.size();
+  int ncomp = a_phi.nComp();
 
 #pragma omp parallel for 
-    for(int ibox=0; ibox<nbox; ibox++)
+    for(int itile=0; itile<ntile; itile++)
       {
-      a_phi[dit[ibox]].copy(a_rhs[dit[ibox]]);
-      a_phi[dit[ibox]] *= mult;
+      const DataIndex& d = tit[itile];
+      const Box& region = tit.tile(itile);
+      Box rhsRegion = region & a_rhs[d].box();
+      if (!rhsRegion.isEmpty()) a_phi[d].copy(a_rhs[d], rhsRegion);
+      a_phi[d].mult(mult, region, 0, ncomp);
       }
  //end pragma
   relax(a_phi, a_rhs, 2);
@@ -340,15 +387,18 @@ void AMRPoissonOp::applyOpI(LevelData<FArrayBox>&       a_lhs,
       }
   }// end pragma
 
+  TiledDataIterator tit(dbl);
+  int ntile = tit.size();
 #pragma omp parallel 
   {
 #pragma omp for 
-    for (int ibox=0;ibox<nbox; ibox++)
+    for (int itile=0;itile<ntile; itile++)
       {
-      const Box& region = dbl[dit[ibox]];
+      const DataIndex& d = tit[itile];
+      const Box& region = tit.tile(itile);
 
-      FORT_OPERATORLAP(CHF_FRA(a_lhs[dit[ibox]]),
-                       CHF_CONST_FRA(phi[dit[ibox]]),
+      FORT_OPERATORLAP(CHF_FRA(a_lhs[d]),
+                       CHF_CONST_FRA(phi[d]),
                        CHF_BOX(region),
                        CHF_CONST_REAL(m_dx),
                        CHF_CONST_REAL(m_alpha),
@@ -364,18 +414,19 @@ void AMRPoissonOp::applyOpNoBoundary(LevelData<FArrayBox>&       a_lhs,
 
   LevelData<FArrayBox>& phi = (LevelData<FArrayBox>&)a_phi;
   const DisjointBoxLayout& dbl = a_lhs.disjointBoxLayout();
-  DataIterator dit = phi.dataIterator();
-  int nbox=dit.size();
+  TiledDataIterator tit(dbl);
+  int ntile = tit.size();
   phi.exchange(phi.interval(), m_exchangeCopier);
 
 #pragma omp parallel 
   {
 #pragma omp for 
-    for (int ibox = 0; ibox < nbox; ibox++)
+    for (int itile = 0; itile < ntile; itile++)
     {
-      const Box& region = dbl[dit[ibox]];
-      FORT_OPERATORLAP(CHF_FRA(a_lhs[dit[ibox]]),
-                       CHF_CONST_FRA(phi[dit[ibox]]),
+      const DataIndex& d = tit[itile];
+      const Box& region = tit.tile(itile);
+      FORT_OPERATORLAP(CHF_FRA(a_lhs[d]),
+                       CHF_CONST_FRA(phi[d]),
                        CHF_BOX(region),
                        CHF_CONST_REAL(m_dx),
                        CHF_CONST_REAL(m_alpha),
@@ -494,6 +545,25 @@ void AMRPoissonOp::mDotProduct(const LevelData<FArrayBox>& a_1,
   m_levelOps.mDotProduct(a_1, a_sz, a_2, a_mdots);
 }
 
+// ---------------------------------------------------------
+void AMRPoissonOp::mDotProductStart(const int a_sz,
+                                    const LevelData<FArrayBox>* const a_1[],
+                                    const LevelData<FArrayBox>* const a_2[],
+                                    Real a_dots[])
+{
+  CH_TIME("AMRPoissonOp::mDotProductStart");
+
+  m_levelOps.mDotProductStart(a_sz, a_1, a_2, a_dots);
+}
+
+// ---------------------------------------------------------
+void AMRPoissonOp::mDotProductWait()
+{
+  CH_TIME("AMRPoissonOp::mDotProductWait");
+
+  m_levelOps.mDotProductWait();
+}
+
 // ---------------------------------------------------------
 void AMRPoissonOp::incr( LevelData<FArrayBox>&       a_lhs,
                          const LevelData<FArrayBox>& a_x,
@@ -548,6 +618,24 @@ Real AMRPoissonOp::localMaxNorm(const LevelData<FArrayBox>& a_x)
   return localMax;
 }
 
+// ---------------------------------------------------------
+void AMRPoissonOp::localMaxNorms(Vector<Real>&               a_norms,
+                                 const LevelData<FArrayBox>& a_x)
+{
+  CH_TIME("AMRPoissonOp::localMaxNorms");
+
+  int nComp=a_x.nComp();
+  a_norms.resize(nComp);
+  a_norms.assign(0.0);
+  for (DataIterator dit=a_x.dataIterator(); dit.ok(); ++dit)
+    {
+      for (int icomp = 0; icomp < nComp; icomp++)
+        {
+          a_norms[icomp] = Max(a_norms[icomp], a_x[dit].norm(a_x.box(dit()), 0, icomp, 1));
+        }
+    }
+}
+
 // ---------------------------------------------------------
 void AMRPoissonOp::setToZero(LevelData<FArrayBox>& a_lhs)
 {
@@ -563,6 +651,20 @@ void AMRPoissonOp::relax(LevelData<FArrayBox>&       a_e,
 {
   CH_TIME("AMRPoissonOp::relax");
 
+  if (s_relaxMode == 6)
+    {
+      for (int i = 0; i < a_iterations; i += s_deepSweeps)
+        {
+          levelGSRBDeep(a_e, a_residual, Min(s_deepSweeps, a_iterations - i));
+        }
+      return;
+    }
+  if (s_relaxMode == 7)
+    {
+      levelChebyshev(a_e, a_residual, a_iterations);
+      return;
+    }
+
   for (int i = 0; i < a_iterations; i++)
     {
       switch (s_relaxMode)
@@ -601,6 +703,12 @@ void AMRPoissonOp::createCoarser(LevelData<FArrayBox>&       a_coarse,
   // CH_assert(!a_ghosted);
   IntVect ghost = a_fine.ghostVect();
 
+  if (m_agglomeratedMGrids.size() > 0)
+    {
+      a_coarse.define(m_agglomeratedMGrids, a_fine.nComp(), ghost);
+      return;
+    }
+
   CH_assert(a_fine.disjointBoxLayout().coarsenable(2));
   if (m_coarsenedMGrids.size() == 0)
     coarsen(m_coarsenedMGrids, a_fine.disjointBoxLayout(), 2); //multigrid, so coarsen by 2
@@ -614,6 +722,18 @@ void AMRPoissonOp::restrictResidual(LevelData<FArrayBox>&       a_resCoarse,
 {
   CH_TIME("AMRPoissonOp::restrictResidual");
 
+  if (m_agglomeratedMGrids.size() > 0 &&
+      a_resCoarse.disjointBoxLayout() == m_agglomeratedMGrids)
+    {
+      // restrict onto the coarsened grids of this level, then move the
+      // result to the ranks of the coarser one
+      LevelData<FArrayBox>& scratch =
+        agglomerateScratch(a_phiFine.disjointBoxLayout(), a_resCoarse.nComp());
+      restrictResidual(scratch, a_phiFine, a_rhsFine);
+      scratch.copyTo(a_resCoarse, m_toAgglomerated);
+      return;
+    }
+
   homogeneousCFInterp(a_phiFine);
 
   if (s_exchangeMode == 0)
@@ -633,24 +753,33 @@ void AMRPoissonOp::restrictResidual(LevelData<FArrayBox>&       a_resCoarse,
       {
 	FArrayBox& phi = a_phiFine[dit[ibox]];
 	m_bc(phi, dblFine[dit[ibox]], m_domain, m_dx, true);
+	a_resCoarse[dit[ibox]].setVal(0.0);
       }
   }//end pragma
 
+  // tiles are even-sized, so no two of them restrict into the same coarse cell
+  TiledDataIterator tit(dblFine);
+  int ntile = tit.size();
 #pragma omp parallel 
   {
 #pragma omp for 
-    for(int ibox = 0; ibox < nbox; ibox++)
+    for(int itile = 0; itile < ntile; itile++)
       {
-	FArrayBox&       phi = a_phiFine[dit[ibox]];
-	const FArrayBox& rhs = a_rhsFine[dit[ibox]];
-	FArrayBox&       res = a_resCoarse[dit[ibox]];
+	const DataIndex& d = tit[itile];
+	FArrayBox&       phi = a_phiFine[d];
+	const FArrayBox& rhs = a_rhsFine[d];
+	FArrayBox&       res = a_resCoarse[d];
 	
-	Box region = dblFine[dit[ibox]];
-	const IntVect& iv = region.smallEnd();
+	const Box& region = tit.tile(itile);
+	const IntVect& iv = dblFine[d].smallEnd();
 	IntVect civ = coarsen(iv, 2);
 	
-	res.setVal(0.0);
-	
+	if (s_kernelMode == 1)
+	  {
+	    AMRPoissonOpKernels::restrictResidual(res, phi, rhs, region,
+	                                          m_dx, m_alpha, m_beta);
+	    continue;
+	  }
 	FORT_RESTRICTRES(CHF_FRA_SHIFT(res, civ),
 			 CHF_CONST_FRA_SHIFT(phi, iv),
 			 CHF_CONST_FRA_SHIFT(rhs, iv),
@@ -667,21 +796,32 @@ void AMRPoissonOp::prolongIncrement(LevelData<FArrayBox>&       a_phiThisLevel,
                                     const LevelData<FArrayBox>& a_correctCoarse)
 {
   CH_TIME("AMRPoissonOp::prolongIncrement");
+
+  if (m_agglomeratedMGrids.size() > 0 &&
+      a_correctCoarse.disjointBoxLayout() == m_agglomeratedMGrids)
+    {
+      LevelData<FArrayBox>& scratch =
+        agglomerateScratch(a_phiThisLevel.disjointBoxLayout(), a_correctCoarse.nComp());
+      a_correctCoarse.copyTo(scratch, m_fromAgglomerated);
+      prolongIncrement(a_phiThisLevel, scratch);
+      return;
+    }
   
   DisjointBoxLayout dbl = a_phiThisLevel.disjointBoxLayout();
   int mgref = 2; //this is a multigrid func
-  DataIterator dit = a_phiThisLevel.dataIterator();
-  int nbox=dit.size();
+  TiledDataIterator tit(dbl);
+  int ntile = tit.size();
   
 #pragma omp parallel 
   {
 #pragma omp for 
-    for(int ibox = 0; ibox < nbox; ibox++)
+    for(int itile = 0; itile < ntile; itile++)
       {
-	FArrayBox& phi =  a_phiThisLevel[dit[ibox]];
-	const FArrayBox& coarse = a_correctCoarse[dit[ibox]];
-	Box region = dbl[dit[ibox]];
-	const IntVect& iv = region.smallEnd();
+	const DataIndex& d = tit[itile];
+	FArrayBox& phi =  a_phiThisLevel[d];
+	const FArrayBox& coarse = a_correctCoarse[d];
+	const Box& region = tit.tile(itile);
+	const IntVect& iv = dbl[d].smallEnd();
 	IntVect civ=coarsen(iv, 2);
 	
 	FORT_PROLONG(CHF_FRA_SHIFT(phi, iv),
@@ -692,6 +832,79 @@ void AMRPoissonOp::prolongIncrement(LevelData<FArrayBox>&       a_phiThisLevel,
   }//end pragma
 }
 
+// ---------------------------------------------------------
+bool AMRPoissonOp::beginCycle()
+{
+  if (!m_agglomerated)
+    {
+      return true;
+    }
+#ifdef CH_MPI
+  if (m_agglomeratedComm == MPI_COMM_NULL)
+    {
+      return false;
+    }
+  m_outerComm = Chombo_MPI::comm;
+  Chombo_MPI::comm = m_agglomeratedComm;
+#endif
+  return true;
+}
+
+// ---------------------------------------------------------
+void AMRPoissonOp::endCycle()
+{
+#ifdef CH_MPI
+  if (m_agglomerated)
+    {
+      Chombo_MPI::comm = m_outerComm;
+    }
+#endif
+}
+
+// ---------------------------------------------------------
+void AMRPoissonOp::setAgglomeratedCoarser(const DisjointBoxLayout& a_grids)
+{
+  m_agglomeratedMGrids = a_grids;
+  m_agglomerateScratch.clear();
+}
+
+// ---------------------------------------------------------
+void AMRPoissonOp::setAgglomerated(int a_numRanks)
+{
+  CH_TIME("AMRPoissonOp::setAgglomerated");
+
+  m_agglomerated = (a_numRanks < numProc());
+#ifdef CH_MPI
+  if (m_agglomeratedComm != MPI_COMM_NULL)
+    {
+      MPI_Comm_free(&m_agglomeratedComm);
+    }
+  if (m_agglomerated)
+    {
+      // the ranks keep their numbers, so the procIDs of the grids hold
+      int color = (procID() < a_numRanks) ? 0 : MPI_UNDEFINED;
+      MPI_Comm_split(Chombo_MPI::comm, color, procID(), &m_agglomeratedComm);
+    }
+#endif
+}
+
+// ---------------------------------------------------------
+LevelData<FArrayBox>& AMRPoissonOp::agglomerateScratch(const DisjointBoxLayout& a_fineGrids,
+                                                       int                      a_nComp)
+{
+  if (m_coarsenedMGrids.size() == 0)
+    {
+      coarsen(m_coarsenedMGrids, a_fineGrids, 2);
+    }
+  if (!m_agglomerateScratch.isDefined() || m_agglomerateScratch.nComp() != a_nComp)
+    {
+      m_agglomerateScratch.define(m_coarsenedMGrids, a_nComp, IntVect::Zero);
+      m_toAgglomerated.define(m_coarsenedMGrids, m_agglomeratedMGrids);
+      m_fromAgglomerated.define(m_agglomeratedMGrids, m_coarsenedMGrids);
+    }
+  return m_agglomerateScratch;
+}
+
 // ---------------------------------------------------------
 void AMRPoissonOp::AMRResidual(LevelData<FArrayBox>&              a_residual,
                                const LevelData<FArrayBox>&        a_phiFine,
@@ -739,6 +952,7 @@ void AMRPoissonOp::AMRResidualNF(LevelData<FArrayBox>&       a_residual,
 
   if (a_phiCoarse.isDefined())
   {
+    setNumComps(phi.nComp());
     m_interpWithCoarser.coarseFineInterp(phi, a_phiCoarse);
   }
 
@@ -762,6 +976,7 @@ void AMRPoissonOp::AMROperator(LevelData<FArrayBox>&              a_LofPhi,
 
   if (a_phiCoarse.isDefined())
   {
+    setNumComps(phi.nComp());
     m_interpWithCoarser.coarseFineInterp(phi, a_phiCoarse);
   }
 
@@ -810,6 +1025,7 @@ void AMRPoissonOp::AMROperatorNF(LevelData<FArrayBox>&       a_LofPhi,
 
   if (a_phiCoarse.isDefined())
   {
+    setNumComps(phi.nComp());
     m_interpWithCoarser.coarseFineInterp(phi, a_phiCoarse);
   }
 
@@ -826,8 +1042,8 @@ void AMRPoissonOp::AMRRestrict(LevelData<FArrayBox>&       a_resCoarse,
 {
   CH_TIME("AMRPoissonOp::AMRRestrict");
 
+  // defined by AMRRestrictS only if it needs the residual on this level
   LevelData<FArrayBox> r;
-  create(r, a_residual);
 
   AMRRestrictS(a_resCoarse, a_residual, a_correction, a_coarseCorrection, r, a_skip_res );
 }
@@ -844,28 +1060,45 @@ void AMRPoissonOp::AMRRestrictS(LevelData<FArrayBox>&       a_resCoarse, // outp
 {
   CH_TIME("AMRPoissonOp::AMRRestrictS");
 
-  if ( !a_skip_res )
+  if ( a_skip_res )
     {
-      AMRResidualNF( a_scratch, a_correction, a_coarseCorrection, a_residual, true );
+      // just average data (phi in this case, even if its called residual)
+      AMRAverage( a_resCoarse, a_residual );
     }
-  else 
+  else if ( s_fusedVCycle && (s_kernelMode == 1 || m_refToCoarser == 2) )
     {
-      // just copy data (phi in this case, even if its called residual)
-      assignLocal( a_scratch, a_residual );
+      AMRRestrictResidual( a_resCoarse, a_residual, a_correction, a_coarseCorrection );
+    }
+  else
+    {
+      if ( !a_scratch.isDefined() )
+        {
+          create( a_scratch, a_residual );
+        }
+      AMRResidualNF( a_scratch, a_correction, a_coarseCorrection, a_residual, true );
+      AMRAverage( a_resCoarse, a_scratch );
     }
+}
+
+// ---------------------------------------------------------
+void AMRPoissonOp::AMRAverage(LevelData<FArrayBox>&       a_resCoarse,
+                              const LevelData<FArrayBox>& a_fine)
+{
+  CH_TIME("AMRPoissonOp::AMRAverage");
 
   DisjointBoxLayout dblCoar = a_resCoarse.disjointBoxLayout();
 
-  DataIterator dit = a_residual.dataIterator();
-  int nbox=dit.size();
+  TiledDataIterator tit(dblCoar);
+  int ntile=tit.size();
 #pragma omp parallel 
   {
 #pragma omp for 
-    for(int ibox = 0; ibox < nbox; ibox++)
+    for(int itile = 0; itile < ntile; itile++)
       {
-	FArrayBox& coarse = a_resCoarse[dit[ibox]];
-	const FArrayBox& fine = a_scratch[dit[ibox]];
-	const Box& b = dblCoar[dit[ibox]];
+	const DataIndex& d = tit[itile];
+	FArrayBox& coarse = a_resCoarse[d];
+	const FArrayBox& fine = a_fine[d];
+	const Box& b = tit.tile(itile);
 	Box refbox(IntVect::Zero,
 		   (m_refToCoarser-1)*IntVect::Unit);
 	FORT_AVERAGE( CHF_FRA(coarse),
@@ -878,6 +1111,72 @@ void AMRPoissonOp::AMRRestrictS(LevelData<FArrayBox>&       a_resCoarse, // outp
   }//end pragma
 }
 
+// ---------------------------------------------------------
+void AMRPoissonOp::AMRRestrictResidual(LevelData<FArrayBox>&       a_resCoarse,
+                                       const LevelData<FArrayBox>& a_residual,
+                                       const LevelData<FArrayBox>& a_correction,
+                                       const LevelData<FArrayBox>& a_coarseCorrection)
+{
+  CH_TIME("AMRPoissonOp::AMRRestrictResidual");
+
+  LevelData<FArrayBox>& phi = (LevelData<FArrayBox>&)a_correction;
+  if (a_coarseCorrection.isDefined())
+    {
+      setNumComps(phi.nComp());
+      m_interpWithCoarser.coarseFineInterp(phi, a_coarseCorrection);
+    }
+  if (s_exchangeMode == 0)
+    phi.exchange(phi.interval(), m_exchangeCopier);
+  else if (s_exchangeMode == 1)
+    phi.exchangeNoOverlap(m_exchangeCopier);
+  else
+    MayDay::Abort("exchangeMode");
+
+  const DisjointBoxLayout& dbl = a_residual.disjointBoxLayout();
+  DataIterator dit = phi.dataIterator();
+  int nbox = dit.size();
+#pragma omp parallel for
+  for (int ibox = 0; ibox < nbox; ibox++)
+    {
+      m_bc(phi[dit[ibox]], dbl[dit[ibox]], m_domain, m_dx, true);
+      a_resCoarse[dit[ibox]].setVal(0.0);
+    }
+
+  // tiles of this level, a multiple of the ratio across, so that no two
+  // restrict into the same coarse cell
+  IntVect tileSize = TiledDataIterator::s_tileSize;
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      tileSize[idir] = m_refToCoarser*((tileSize[idir] + m_refToCoarser - 1)/m_refToCoarser);
+    }
+  TiledDataIterator tit(dbl, IntVect::Zero, tileSize);
+  int ntile = tit.size();
+#pragma omp parallel for
+  for (int itile = 0; itile < ntile; itile++)
+    {
+      const DataIndex& d = tit[itile];
+      const Box& region = tit.tile(itile);
+      if (s_kernelMode == 1)
+        {
+          AMRPoissonOpKernels::restrictResidual(a_resCoarse[d], phi[d], a_residual[d],
+                                                region, m_dx, m_alpha, m_beta,
+                                                m_refToCoarser);
+        }
+      else
+        {
+          const IntVect& iv = dbl[d].smallEnd();
+          IntVect civ = coarsen(iv, 2);
+          FORT_RESTRICTRES(CHF_FRA_SHIFT(a_resCoarse[d], civ),
+                           CHF_CONST_FRA_SHIFT(phi[d], iv),
+                           CHF_CONST_FRA_SHIFT(a_residual[d], iv),
+                           CHF_CONST_REAL(m_alpha),
+                           CHF_CONST_REAL(m_beta),
+                           CHF_BOX_SHIFT(region, iv),
+                           CHF_CONST_REAL(m_dx));
+        }
+    }
+}
+
 // ---------------------------------------------------------
 /** a_correction += I[2h->h](a_coarseCorrection) */
 void AMRPoissonOp::AMRProlong(LevelData<FArrayBox>&       a_correction,
@@ -892,19 +1191,20 @@ void AMRPoissonOp::AMRProlong(LevelData<FArrayBox>&       a_correction,
   a_coarseCorrection.copyTo(eCoar.interval(), eCoar, eCoar.interval());
 
   DisjointBoxLayout dbl = a_correction.disjointBoxLayout();
-  DataIterator dit = a_correction.dataIterator();
-  int nbox=dit.size();
+  TiledDataIterator tit(dbl);
+  int ntile=tit.size();
 
 #pragma omp parallel 
   {
 #pragma omp for 
-    for(int ibox = 0; ibox < nbox; ibox++)
+    for(int itile = 0; itile < ntile; itile++)
       {
-	FArrayBox& phi =  a_correction[dit[ibox]];
-	const FArrayBox& coarse = eCoar[dit[ibox]];
+	const DataIndex& d = tit[itile];
+	FArrayBox& phi =  a_correction[d];
+	const FArrayBox& coarse = eCoar[d];
 	
-	Box region = dbl[dit[ibox]];
-	const IntVect& iv = region.smallEnd();
+	const Box& region = tit.tile(itile);
+	const IntVect& iv = dbl[d].smallEnd();
 	IntVect civ = coarsen(iv, m_refToCoarser);
 	
 	FORT_PROLONG(CHF_FRA_SHIFT(phi, iv),
@@ -926,19 +1226,20 @@ void AMRPoissonOp::AMRProlongS(LevelData<FArrayBox>&       a_correction,
   a_coarseCorrection.copyTo(a_temp.interval(), a_temp, a_temp.interval(), a_copier);
 
   DisjointBoxLayout dbl = a_correction.disjointBoxLayout();
-  DataIterator dit = a_correction.dataIterator();
-  int nbox=dit.size();
+  TiledDataIterator tit(dbl);
+  int ntile=tit.size();
   
 #pragma omp parallel 
   {
 #pragma omp for 
-    for(int ibox = 0; ibox < nbox; ibox++)
+    for(int itile = 0; itile < ntile; itile++)
       {
-	FArrayBox& phi =  a_correction[dit[ibox]];
-	const FArrayBox& coarse = a_temp[dit[ibox]];
+	const DataIndex& d = tit[itile];
+	FArrayBox& phi =  a_correction[d];
+	const FArrayBox& coarse = a_temp[d];
 	
-	Box region = dbl[dit[ibox]];
-	const IntVect& iv =  region.smallEnd();
+	const Box& region = tit.tile(itile);
+	const IntVect& iv = dbl[d].smallEnd();
 	IntVect civ= coarsen(iv, m_refToCoarser);
 	
 	FORT_PROLONG(CHF_FRA_SHIFT(phi, iv),
@@ -1001,6 +1302,16 @@ void AMRPoissonOp::AMRProlongS_2(LevelData<FArrayBox>&       a_correction,
   //write(&a_correction,"z_prol2.hdf5"); exit(12);
 }
 
+// ---------------------------------------------------------
+void AMRPoissonOp::AMRProlongFMG(LevelData<FArrayBox>&       a_phi,
+                                 const LevelData<FArrayBox>& a_coarsePhi)
+{
+  CH_TIME("AMRPoissonOp::AMRProlongFMG");
+
+  FineInterp interp(a_phi.disjointBoxLayout(), a_phi.nComp(), m_refToCoarser, m_domain);
+  interp.interpToFine(a_phi, a_coarsePhi);
+}
+
 // ---------------------------------------------------------
 void AMRPoissonOp::AMRUpdateResidual(LevelData<FArrayBox>&       a_residual,
                                      const LevelData<FArrayBox>& a_correction,
@@ -1013,6 +1324,49 @@ void AMRPoissonOp::AMRUpdateResidual(LevelData<FArrayBox>&       a_residual,
   this->AMRResidualNF(a_residual, a_correction, a_coarseCorrection, a_residual, true);
 }
 
+// ---------------------------------------------------------
+void AMRPoissonOp::AMRProlongSmooth(LevelData<FArrayBox>&       a_correction,
+                                    LevelData<FArrayBox>&       a_residual,
+                                    LevelData<FArrayBox>&       a_dCorr,
+                                    const LevelData<FArrayBox>& a_coarseCorrection,
+                                    LevelData<FArrayBox>&       a_temp,
+                                    const Copier&               a_copier,
+                                    int                         a_numSmooth)
+{
+  CH_TIME("AMRPoissonOp::AMRProlongSmooth");
+
+  if (!s_fusedVCycle || s_relaxMode != 1 || a_numSmooth < 1)
+    {
+      AMRLevelOp<LevelData<FArrayBox> >::AMRProlongSmooth(a_correction, a_residual, a_dCorr,
+                                                          a_coarseCorrection, a_temp,
+                                                          a_copier, a_numSmooth);
+      return;
+    }
+
+  AMRProlongS(a_correction, a_coarseCorrection, a_temp, a_copier);
+  AMRUpdateResidual(a_residual, a_correction, a_coarseCorrection);
+
+  // relax() from a_dCorr = 0
+  levelGSRBFromZero(a_dCorr, a_residual);
+  for (int i = 1; i < a_numSmooth; i++)
+    {
+      levelGSRB(a_dCorr, a_residual);
+    }
+
+  // a_correction += a_dCorr and a_dCorr = a_correction, a tile at a time
+  TiledDataIterator tit(a_correction.disjointBoxLayout(), a_correction.ghostVect());
+  int ntile = tit.size();
+  int ncomp = a_correction.nComp();
+#pragma omp parallel for
+  for (int itile = 0; itile < ntile; itile++)
+    {
+      const DataIndex& d = tit[itile];
+      Box region = tit.tile(itile) & a_dCorr[d].box();
+      a_correction[d].plus(a_dCorr[d], region, region, 1.0, 0, 0, ncomp);
+      a_dCorr[d].copy(a_correction[d], region);
+    }
+}
+
 // ---------------------------------------------------------
 ///compute norm over all cells on coarse not covered by finer
 Real AMRPoissonOp::AMRNorm(const LevelData<FArrayBox>& a_coarResid,
@@ -1081,6 +1435,7 @@ void AMRPoissonOp::reflux(const LevelData<FArrayBox>&        a_phiFine,
 {
   CH_TIMERS("AMRPoissonOp::reflux");
 
+  setNumComps(a_phi.nComp());
   m_levfluxreg.setToZero();
   Interval interv(0,a_phi.nComp()-1);
 
@@ -1113,6 +1468,7 @@ void AMRPoissonOp::reflux(const LevelData<FArrayBox>&        a_phiFine,
   LevelData<FArrayBox>& phiFineRef = ( LevelData<FArrayBox>&)a_phiFine;
 
   AMRPoissonOp* finerAMRPOp = (AMRPoissonOp*) a_finerOp;
+  finerAMRPOp->setNumComps(a_phi.nComp());
   QuadCFInterp& quadCFI = finerAMRPOp->m_interpWithCoarser;
 
   quadCFI.coarseFineInterp(phiFineRef, a_phi);
@@ -1160,6 +1516,28 @@ void AMRPoissonOp::reflux(const LevelData<FArrayBox>&        a_phiFine,
   m_levfluxreg.reflux(a_residual, scale);
 }
 
+// ---------------------------------------------------------
+void AMRPoissonOp::setNumComps(int a_nComp)
+{
+  if (a_nComp == m_numCompsCF)
+    {
+      return;
+    }
+  CH_TIME("AMRPoissonOp::setNumComps");
+
+  m_numCompsCF = a_nComp;
+  if (m_gridsCoarser.isClosed())
+    {
+      m_interpWithCoarser.define(m_grids, &m_gridsCoarser, m_dx,
+                                 m_refToCoarser, a_nComp, m_domain);
+    }
+  if (m_gridsFiner.isClosed())
+    {
+      ProblemDomain fineDomain = refine(m_domain, m_refToFiner);
+      m_levfluxreg.define(m_gridsFiner, m_grids, fineDomain, m_refToFiner, a_nComp);
+    }
+}
+
 // ---------------------------------------------------------
 void AMRPoissonOp::write(const LevelData<FArrayBox>* a_data,
                          const char*                 a_filename)
@@ -1178,6 +1556,20 @@ void AMRPoissonOp::levelGSRB( LevelData<FArrayBox>&       a_phi,
 {
   CH_TIME("AMRPoissonOp::levelGSRB");
 
+  // do first red, then black passes
+  for (int whichPass = 0; whichPass <= 1; whichPass++)
+    {
+      levelGSRBPass(a_phi, a_rhs, whichPass);
+    }
+}
+
+// ---------------------------------------------------------
+void AMRPoissonOp::levelGSRBPass( LevelData<FArrayBox>&       a_phi,
+                                  const LevelData<FArrayBox>& a_rhs,
+                                  int                         a_whichPass )
+{
+  CH_TIME("AMRPoissonOp::levelGSRB::Compute");
+
   CH_assert(a_phi.isDefined());
   CH_assert(a_rhs.isDefined());
   CH_assert(a_phi.ghostVect() >= IntVect::Unit);
@@ -1187,57 +1579,117 @@ void AMRPoissonOp::levelGSRB( LevelData<FArrayBox>&       a_phi,
 
   DataIterator dit = a_phi.dataIterator();
   int nbox=dit.size();
-  // do first red, then black passes
-  for (int whichPass = 0; whichPass <= 1; whichPass++)
-    {
-      CH_TIME("AMRPoissonOp::levelGSRB::Compute");
+  // cells of one color only read cells of the other, so a pass can be
+  // split into tiles
+  TiledDataIterator tit(dbl);
+  int ntile=tit.size();
 
-      // fill in intersection of ghostcells and a_phi's boxes
-      {
-        CH_TIME("AMRPoissonOp::levelGSRB::homogeneousCFInterp");
-        homogeneousCFInterp(a_phi);
-      }
+  // fill in intersection of ghostcells and a_phi's boxes
+  {
+    CH_TIME("AMRPoissonOp::levelGSRB::homogeneousCFInterp");
+    homogeneousCFInterp(a_phi);
+  }
 
-      {
-        CH_TIME("AMRPoissonOp::levelGSRB::exchange");
-        if (s_exchangeMode == 0)
-          a_phi.exchange( a_phi.interval(), m_exchangeCopier );
-        else if (s_exchangeMode == 1)
-          a_phi.exchangeNoOverlap(m_exchangeCopier);
-        else
-          MayDay::Abort("exchangeMode");
-      }
+  {
+    CH_TIME("AMRPoissonOp::levelGSRB::exchange");
+    if (s_exchangeMode == 0)
+      a_phi.exchange( a_phi.interval(), m_exchangeCopier );
+    else if (s_exchangeMode == 1)
+      a_phi.exchangeNoOverlap(m_exchangeCopier);
+    else
+      MayDay::Abort("exchangeMode");
+  }
 #pragma omp parallel
+  {
+#pragma omp for 
+    for (int ibox=0; ibox < nbox; ibox++)
       {
+	m_bc( a_phi[dit[ibox]], dbl[dit[ibox]], m_domain, m_dx, true );
+      }
+
 #pragma omp for 
-	for (int ibox=0; ibox < nbox; ibox++)
+    for (int itile=0; itile < ntile; itile++)
+      {
+	const DataIndex& d = tit[itile];
+	const Box& region = tit.tile(itile);
+	FArrayBox& phiFab = a_phi[d];
+
+	if (s_kernelMode == 1)
 	  {
-	    const Box& region = dbl[dit[ibox]];
-	    FArrayBox& phiFab = a_phi[dit[ibox]];
-	    
-	    m_bc( phiFab, region, m_domain, m_dx, true );
-	    
-	    if (m_alpha == 0.0 && m_beta == 1.0 )
-	      {
-		FORT_GSRBLAPLACIAN(CHF_FRA(phiFab),
-				   CHF_CONST_FRA(a_rhs[dit[ibox]]),
-				   CHF_BOX(region),
-				   CHF_CONST_REAL(m_dx),
-				   CHF_CONST_INT(whichPass));
-	      }
-	    else
-	      {
-		FORT_GSRBHELMHOLTZ(CHF_FRA(phiFab),
-				   CHF_CONST_FRA(a_rhs[dit[ibox]]),
-				   CHF_BOX(region),
-				   CHF_CONST_REAL(m_dx),
-				   CHF_CONST_REAL(m_alpha),
-				   CHF_CONST_REAL(m_beta),
-				   CHF_CONST_INT(whichPass));
-	      }
-	  } // end loop through grids
-      }//end pragma
-    } // end loop through red-black
+	    AMRPoissonOpKernels::gsrb(phiFab, a_rhs[d], region, m_dx,
+	                              m_alpha, m_beta, a_whichPass);
+	  }
+	else if (m_alpha == 0.0 && m_beta == 1.0 )
+	  {
+	    FORT_GSRBLAPLACIAN(CHF_FRA(phiFab),
+			       CHF_CONST_FRA(a_rhs[d]),
+			       CHF_BOX(region),
+			       CHF_CONST_REAL(m_dx),
+			       CHF_CONST_INT(a_whichPass));
+	  }
+	else
+	  {
+	    FORT_GSRBHELMHOLTZ(CHF_FRA(phiFab),
+			       CHF_CONST_FRA(a_rhs[d]),
+			       CHF_BOX(region),
+			       CHF_CONST_REAL(m_dx),
+			       CHF_CONST_REAL(m_alpha),
+			       CHF_CONST_REAL(m_beta),
+			       CHF_CONST_INT(a_whichPass));
+	  }
+      } // end loop through grids
+  }//end pragma
+}
+
+// ---------------------------------------------------------
+void AMRPoissonOp::levelGSRBFromZero( LevelData<FArrayBox>&       a_phi,
+                                      const LevelData<FArrayBox>& a_rhs )
+{
+  CH_TIME("AMRPoissonOp::levelGSRBFromZero");
+
+  CH_assert(a_phi.nComp() == a_rhs.nComp());
+
+  // the red cells only see zeros
+  setGhostToZero(a_phi);
+  TiledDataIterator tit(a_rhs.disjointBoxLayout());
+  int ntile = tit.size();
+#pragma omp parallel for
+  for (int itile = 0; itile < ntile; itile++)
+    {
+      const DataIndex& d = tit[itile];
+      AMRPoissonOpKernels::gsrbFromZero(a_phi[d], a_rhs[d], tit.tile(itile),
+                                        m_dx, m_alpha, m_beta);
+    }
+
+  levelGSRBPass(a_phi, a_rhs, 1);
+}
+
+// ---------------------------------------------------------
+void AMRPoissonOp::setGhostToZero(LevelData<FArrayBox>& a_phi)
+{
+  const DisjointBoxLayout& dbl = a_phi.disjointBoxLayout();
+  DataIterator dit = a_phi.dataIterator();
+  int nbox = dit.size();
+#pragma omp parallel for
+  for (int ibox = 0; ibox < nbox; ibox++)
+    {
+      FArrayBox& fab = a_phi[dit[ibox]];
+      const Box& valid = dbl[dit[ibox]];
+      // slabs on either side of the valid box in each direction, of the
+      // part of the FAB not already done in the directions before
+      Box inner = fab.box();
+      for (int idir = 0; idir < SpaceDim; idir++)
+        {
+          Box lo(inner);
+          lo.setBig(idir, valid.smallEnd(idir) - 1);
+          Box hi(inner);
+          hi.setSmall(idir, valid.bigEnd(idir) + 1);
+          if (!lo.isEmpty()) fab.setVal(0.0, lo, 0, fab.nComp());
+          if (!hi.isEmpty()) fab.setVal(0.0, hi, 0, fab.nComp());
+          inner.setSmall(idir, valid.smallEnd(idir));
+          inner.setBig(idir, valid.bigEnd(idir));
+        }
+    }
 }
 
 // ---------------------------------------------------------
@@ -1321,6 +1773,9 @@ void AMRPoissonOp::looseGSRB(LevelData<FArrayBox>&       a_phi,
       MayDay::Abort("exchangeMode");
   }
 
+  TiledDataIterator tit(dbl);
+  int ntile=tit.size();
+
   // now step through grids...
 #pragma omp parallel
   {
@@ -1328,50 +1783,40 @@ void AMRPoissonOp::looseGSRB(LevelData<FArrayBox>&       a_phi,
     for(int ibox = 0; ibox < nbox; ibox++)
       {
 	// invoke physical BC's where necessary
-	{
-	  CH_TIME("AMRPoissonOp::looseGSRB::BCs");
-	  m_bc(a_phi[dit[ibox]], dbl[dit[ibox]], m_domain, m_dx, true);
-	}
-	
-	const Box& region = dbl[dit[ibox]];
-	
-	if (m_alpha == 0.0 && m_beta == 1.0)
-	  {
-	    int whichPass = 0;
-	    FORT_GSRBLAPLACIAN(CHF_FRA(a_phi[dit[ibox]]),
-			       CHF_CONST_FRA(a_rhs[dit[ibox]]),
-			       CHF_BOX(region),
-			       CHF_CONST_REAL(m_dx),
-			       CHF_CONST_INT(whichPass));
-	    
-	    whichPass = 1;
-	    FORT_GSRBLAPLACIAN(CHF_FRA(a_phi[dit[ibox]]),
-			       CHF_CONST_FRA(a_rhs[dit[ibox]]),
-			       CHF_BOX(region),
-			       CHF_CONST_REAL(m_dx),
-			       CHF_CONST_INT(whichPass));
-	  }
-	else
+	CH_TIME("AMRPoissonOp::looseGSRB::BCs");
+	m_bc(a_phi[dit[ibox]], dbl[dit[ibox]], m_domain, m_dx, true);
+      }
+
+    // both colors without an exchange in between; the barrier at the end
+    // of each omp for keeps the black tiles from starting before the red
+    for (int whichPass = 0; whichPass <= 1; whichPass++)
+      {
+#pragma omp for 
+	for(int itile = 0; itile < ntile; itile++)
 	  {
-	    int whichPass = 0;
-	    FORT_GSRBHELMHOLTZ(CHF_FRA(a_phi[dit[ibox]]),
-			       CHF_CONST_FRA(a_rhs[dit[ibox]]),
-			       CHF_BOX(region),
-			       CHF_CONST_REAL(m_dx),
-			       CHF_CONST_REAL(m_alpha),
-			       CHF_CONST_REAL(m_beta),
-			       CHF_CONST_INT(whichPass));
+	    const DataIndex& d = tit[itile];
+	    const Box& region = tit.tile(itile);
 	    
-	    whichPass = 1;
-	    FORT_GSRBHELMHOLTZ(CHF_FRA(a_phi[dit[ibox]]),
-			       CHF_CONST_FRA(a_rhs[dit[ibox]]),
-			       CHF_BOX(region),
-			       CHF_CONST_REAL(m_dx),
-			       CHF_CONST_REAL(m_alpha),
-			       CHF_CONST_REAL(m_beta),
-			       CHF_CONST_INT(whichPass));
-	  }
-      } // end loop through grids
+	    if (m_alpha == 0.0 && m_beta == 1.0)
+	      {
+		FORT_GSRBLAPLACIAN(CHF_FRA(a_phi[d]),
+				   CHF_CONST_FRA(a_rhs[d]),
+				   CHF_BOX(region),
+				   CHF_CONST_REAL(m_dx),
+				   CHF_CONST_INT(whichPass));
+	      }
+	    else
+	      {
+		FORT_GSRBHELMHOLTZ(CHF_FRA(a_phi[d]),
+				   CHF_CONST_FRA(a_rhs[d]),
+				   CHF_BOX(region),
+				   CHF_CONST_REAL(m_dx),
+				   CHF_CONST_REAL(m_alpha),
+				   CHF_CONST_REAL(m_beta),
+				   CHF_CONST_INT(whichPass));
+	      }
+	  } // end loop through tiles
+      }
   }//end pragma
 }
 
@@ -1399,6 +1844,8 @@ void AMRPoissonOp::overlapGSRB(LevelData<FArrayBox>&       a_phi,
   // now step through grids...
   DataIterator dit = a_phi.dataIterator();
   int nbox=dit.size();
+  TiledDataIterator tit(dbl);
+  int ntile=tit.size();
 #pragma omp parallel
   {
 #pragma omp for 
@@ -1408,21 +1855,23 @@ void AMRPoissonOp::overlapGSRB(LevelData<FArrayBox>&       a_phi,
 	CH_START(tb);
 	m_bc(a_phi[dit[ibox]], dbl[dit[ibox]], m_domain, m_dx, true);
 	CH_STOP(tb);
-	Box region = dbl[dit[ibox]];
-	region.grow(-1); // just do the interior on the first run through
-	int whichPass = 0;
-	FORT_GSRBLAPLACIAN(CHF_FRA(a_phi[dit[ibox]]),
-			   CHF_CONST_FRA(a_rhs[dit[ibox]]),
-			   CHF_BOX(region),
-			   CHF_CONST_REAL(m_dx),
-			   CHF_CONST_INT(whichPass));
-	
-	whichPass = 1;
-	FORT_GSRBLAPLACIAN(CHF_FRA(a_phi[dit[ibox]]),
-			   CHF_CONST_FRA(a_rhs[dit[ibox]]),
-			   CHF_BOX(region),
-			   CHF_CONST_REAL(m_dx),
-			   CHF_CONST_INT(whichPass));
+      }
+
+    for (int whichPass = 0; whichPass <= 1; whichPass++)
+      {
+#pragma omp for 
+	for(int itile = 0; itile < ntile; itile++)
+	  {
+	    const DataIndex& d = tit[itile];
+	    Box region = tit.tile(itile);
+	    region &= grow(dbl[d], -1); // just do the interior on the first run through
+	    if (region.isEmpty()) continue;
+	    FORT_GSRBLAPLACIAN(CHF_FRA(a_phi[d]),
+			       CHF_CONST_FRA(a_rhs[d]),
+			       CHF_BOX(region),
+			       CHF_CONST_REAL(m_dx),
+			       CHF_CONST_INT(whichPass));
+	  }
       }
   }//end pragma
 
@@ -1544,6 +1993,41 @@ void AMRPoissonOp::levelJacobi(LevelData<FArrayBox>&       a_phi,
 {
   CH_TIME("AMRPoissonOp::levelJacobi");
 
+  if (s_kernelMode == 1)
+    {
+      // one pass from a copy of phi instead of a residual and an increment
+      homogeneousCFInterp(a_phi);
+      if (s_exchangeMode == 0)
+        a_phi.exchange(a_phi.interval(), m_exchangeCopier);
+      else if (s_exchangeMode == 1)
+        a_phi.exchangeNoOverlap(m_exchangeCopier);
+      else
+        MayDay::Abort("exchangeMode");
+
+      const DisjointBoxLayout& dbl = a_phi.disjointBoxLayout();
+      LevelData<FArrayBox> phiOld;
+      create(phiOld, a_phi);
+      DataIterator dit = a_phi.dataIterator();
+      int nbox = dit.size();
+#pragma omp parallel for
+      for (int ibox = 0; ibox < nbox; ibox++)
+        {
+          m_bc(a_phi[dit[ibox]], dbl[dit[ibox]], m_domain, m_dx, true);
+          phiOld[dit[ibox]].copy(a_phi[dit[ibox]]);
+        }
+
+      TiledDataIterator tit(dbl);
+      int ntile = tit.size();
+#pragma omp parallel for
+      for (int itile = 0; itile < ntile; itile++)
+        {
+          const DataIndex& d = tit[itile];
+          AMRPoissonOpKernels::jacobi(a_phi[d], phiOld[d], a_rhs[d], tit.tile(itile),
+                                      m_dx, m_alpha, m_beta, 0.666);
+        }
+      return;
+    }
+
   LevelData<FArrayBox> resid;
   create(resid, a_rhs);
 
@@ -1557,6 +2041,149 @@ void AMRPoissonOp::levelJacobi(LevelData<FArrayBox>&       a_phi,
   incr(a_phi, resid, 0.666/weight);
 }
 
+// ---------------------------------------------------------
+void AMRPoissonOp::levelGSRBDeep(LevelData<FArrayBox>&       a_phi,
+                                 const LevelData<FArrayBox>& a_rhs,
+                                 int                         a_sweeps)
+{
+  CH_TIME("AMRPoissonOp::levelGSRBDeep");
+
+  CH_assert(a_phi.isDefined());
+  CH_assert(a_rhs.isDefined());
+  CH_assert(a_phi.nComp() == a_rhs.nComp());
+  CH_assert(a_sweeps <= s_deepSweeps);
+
+  const DisjointBoxLayout& dbl = a_rhs.disjointBoxLayout();
+  IntVect ghost = 2*s_deepSweeps*IntVect::Unit;
+  int ncomp = a_phi.nComp();
+  if (!m_deepPhi.isDefined() || !(m_deepPhi.disjointBoxLayout() == dbl) ||
+      m_deepPhi.ghostVect() != ghost || m_deepPhi.nComp() != ncomp)
+    {
+      CH_TIME("AMRPoissonOp::levelGSRBDeep::define");
+      m_deepPhi.define(dbl, ncomp, ghost);
+      m_deepRhs.define(dbl, ncomp, ghost);
+      m_deepCopier.define(dbl, dbl, m_domain, ghost, true);
+      m_deepCoversDomain = (dbl.numCells() == m_domain.domainBox().numPts());
+    }
+  if (!m_deepCoversDomain)
+    {
+      for (int i = 0; i < a_sweeps; i++)
+        {
+          levelGSRB(a_phi, a_rhs);
+        }
+      return;
+    }
+
+  DataIterator dit = a_phi.dataIterator();
+  int nbox = dit.size();
+#pragma omp parallel for
+  for (int ibox = 0; ibox < nbox; ibox++)
+    {
+      const Box& valid = dbl[dit[ibox]];
+      m_deepPhi[dit[ibox]].copy(a_phi[dit[ibox]], valid);
+      m_deepRhs[dit[ibox]].copy(a_rhs[dit[ibox]], valid);
+    }
+
+  {
+    CH_TIME("AMRPoissonOp::levelGSRBDeep::exchange");
+    if (s_exchangeMode == 0)
+      {
+        m_deepPhi.exchange(m_deepPhi.interval(), m_deepCopier);
+        m_deepRhs.exchange(m_deepRhs.interval(), m_deepCopier);
+      }
+    else if (s_exchangeMode == 1)
+      {
+        m_deepPhi.exchangeNoOverlap(m_deepCopier);
+        m_deepRhs.exchangeNoOverlap(m_deepCopier);
+      }
+    else
+      MayDay::Abort("exchangeMode");
+  }
+
+  // half-sweep h reads the cells updated by half-sweep h-1, so it can
+  // only update one cell less into the ghost region
+  int depth = 2*a_sweeps;
+  for (int h = 0; h < depth; h++)
+    {
+      int whichPass = h % 2;
+#pragma omp parallel for
+      for (int ibox = 0; ibox < nbox; ibox++)
+        {
+          const DataIndex& d = dit[ibox];
+          FArrayBox& phiFab = m_deepPhi[d];
+          Box region = grow(dbl[d], depth - 1 - h);
+          region &= m_domain;
+          m_bc(phiFab, region, m_domain, m_dx, true);
+
+          if (s_kernelMode == 1)
+            {
+              AMRPoissonOpKernels::gsrb(phiFab, m_deepRhs[d], region, m_dx,
+                                        m_alpha, m_beta, whichPass);
+            }
+          else if (m_alpha == 0.0 && m_beta == 1.0 )
+            {
+              FORT_GSRBLAPLACIAN(CHF_FRA(phiFab),
+                                 CHF_CONST_FRA(m_deepRhs[d]),
+                                 CHF_BOX(region),
+                                 CHF_CONST_REAL(m_dx),
+                                 CHF_CONST_INT(whichPass));
+            }
+          else
+            {
+              FORT_GSRBHELMHOLTZ(CHF_FRA(phiFab),
+                                 CHF_CONST_FRA(m_deepRhs[d]),
+                                 CHF_BOX(region),
+                                 CHF_CONST_REAL(m_dx),
+                                 CHF_CONST_REAL(m_alpha),
+                                 CHF_CONST_REAL(m_beta),
+                                 CHF_CONST_INT(whichPass));
+            }
+        }
+    }
+
+#pragma omp parallel for
+  for (int ibox = 0; ibox < nbox; ibox++)
+    {
+      a_phi[dit[ibox]].copy(m_deepPhi[dit[ibox]], dbl[dit[ibox]]);
+    }
+}
+
+// ---------------------------------------------------------
+void AMRPoissonOp::levelChebyshev(LevelData<FArrayBox>&       a_phi,
+                                  const LevelData<FArrayBox>& a_rhs,
+                                  int                         a_degree)
+{
+  CH_TIME("AMRPoissonOp::levelChebyshev");
+
+  if (a_degree < 1) return;
+
+  LevelData<FArrayBox> resid, dir;
+  create(resid, a_rhs);
+  create(dir, a_rhs);
+
+  Real offDiag = 2.0*SpaceDim * m_beta / (m_dx*m_dx);
+  Real diag = m_alpha - offDiag;
+  Real lmax = 1.0 + Abs(offDiag/diag);
+  Real lmin = lmax/(2.0*SpaceDim);
+  Real theta = 0.5*(lmax + lmin);
+  Real delta = 0.5*(lmax - lmin);
+  Real sigma = theta/delta;
+  Real rho = 1.0/sigma;
+
+  residual(resid, a_phi, a_rhs, true);
+  assign(dir, resid);
+  scale(dir, 1.0/(theta*diag));
+  incr(a_phi, dir, 1.0);
+  for (int k = 1; k < a_degree; k++)
+    {
+      residual(resid, a_phi, a_rhs, true);
+      Real rhoNew = 1.0/(2.0*sigma - rho);
+      axby(dir, dir, resid, rhoNew*rho, 2.0*rhoNew/(delta*diag));
+      incr(a_phi, dir, 1.0);
+      rho = rhoNew;
+    }
+}
+
 // ---------------------------------------------------------
 void AMRPoissonOp::homogeneousCFInterp(LevelData<FArrayBox>& a_phif)
 {
@@ -1863,6 +2490,10 @@ void AMRPoissonOpFactory::define(const ProblemDomain&             a_coarseDomain
 
   m_alpha = a_alpha;
   m_beta = a_beta;
+
+  m_mgGrids.resize(0);
+  m_mgRanks.resize(0);
+  m_mgStage.resize(0);
 }
 
 // ---------------------------------------------------------
@@ -1918,23 +2549,46 @@ MGLevelOp<LevelData<FArrayBox> >* AMRPoissonOpFactory::MGnewOp(const ProblemDoma
       domain.coarsen(2);
     }
 
-  if (coarsening > 1 && !m_boxes[ref].coarsenable(coarsening*AMRPoissonOp::s_maxCoarse))
-  {
-    return NULL;
-  }
+  DisjointBoxLayout layout;
+  int numRanks = numProc();
+  int stage = 0;
+  if (agglomerating(ref))
+    {
+      if (!mgGrids(layout, numRanks, stage, a_depth))
+        {
+          return NULL;
+        }
+    }
+  else
+    {
+      if (coarsening > 1 && !m_boxes[ref].coarsenable(coarsening*AMRPoissonOp::s_maxCoarse))
+        {
+          return NULL;
+        }
+      coarsen_dbl(layout, m_boxes[ref], coarsening);
+    }
 
   dx *= coarsening;
 
-  DisjointBoxLayout layout;
-  coarsen_dbl(layout, m_boxes[ref], coarsening);
-
-  Copier ex = m_exchangeCopiers[ref];
-  CFRegion cfregion = m_cfregion[ref];
+  Copier ex;
+  CFRegion cfregion;
+  if (stage == 0)
+    {
+      ex = m_exchangeCopiers[ref];
+      cfregion = m_cfregion[ref];
 
-  if (coarsening > 1)
+      if (coarsening > 1)
+        {
+          ex.coarsen(coarsening);
+          cfregion.coarsen(coarsening);
+        }
+    }
+  else
     {
-      ex.coarsen(coarsening);
-      cfregion.coarsen(coarsening);
+      // grids re-split at depth stage
+      ex.exchangeDefine(layout, IntVect::Unit);
+      ex.trimEdges(layout, IntVect::Unit);
+      cfregion.define(layout, domain);
     }
 
   AMRPoissonOp* newOp = new AMRPoissonOp;
@@ -1948,6 +2602,19 @@ MGLevelOp<LevelData<FArrayBox> >* AMRPoissonOpFactory::MGnewOp(const ProblemDoma
 
   newOp->m_dxCrse = dxCrse;
 
+  if (agglomerating(ref))
+    {
+      if (stage == a_depth)
+        {
+          newOp->setAgglomerated(numRanks);
+        }
+      DisjointBoxLayout coarser;
+      if (mgGrids(coarser, numRanks, stage, a_depth+1) && stage == a_depth+1)
+        {
+          newOp->setAgglomeratedCoarser(coarser);
+        }
+    }
+
   return (MGLevelOp<LevelData<FArrayBox> >*)newOp;
 }
 
@@ -2024,9 +2691,122 @@ AMRLevelOp<LevelData<FArrayBox> >* AMRPoissonOpFactory::AMRnewOp(const ProblemDo
 
   newOp->m_dxCrse = dxCrse;
 
+  if (agglomerating(ref))
+    {
+      DisjointBoxLayout coarser;
+      int numRanks, stage;
+      if (mgGrids(coarser, numRanks, stage, 1) && stage == 1)
+        {
+          newOp->setAgglomeratedCoarser(coarser);
+        }
+    }
+
   return (AMRLevelOp<LevelData<FArrayBox> >*)newOp;
 }
 
+// ---------------------------------------------------------
+bool AMRPoissonOpFactory::agglomerating(int a_ref) const
+{
+  if (a_ref != 0 || AMRPoissonOp::s_agglomerateCells <= 0)
+    {
+      return false;
+    }
+
+  // the domain is re-split, so the grids must cover it
+  long long numPts = 0;
+  for (LayoutIterator lit = m_boxes[0].layoutIterator(); lit.ok(); ++lit)
+    {
+      numPts += m_boxes[0][lit].numPts();
+    }
+  return numPts == m_domains[0].domainBox().numPts();
+}
+
+// ---------------------------------------------------------
+bool AMRPoissonOpFactory::mgGrids(DisjointBoxLayout& a_grids,
+                                  int&               a_numRanks,
+                                  int&               a_stage,
+                                  int                a_depth)
+{
+  CH_TIME("AMRPoissonOpFactory::mgGrids");
+
+  const int maxCoarse = AMRPoissonOp::s_maxCoarse;
+
+  if (m_mgGrids.size() == 0)
+    {
+      m_mgGrids.push_back(m_boxes[0]);
+      m_mgRanks.push_back(numProc());
+      m_mgStage.push_back(0);
+    }
+
+  while (m_mgGrids.size() <= a_depth)
+    {
+      int depth = m_mgGrids.size();
+      const DisjointBoxLayout& fine = m_mgGrids[depth-1];
+      int fineRanks = m_mgRanks[depth-1];
+
+      ProblemDomain domain(m_domains[0]);
+      for (int i = 0; i < depth; i++)
+        {
+          domain.coarsen(2);
+        }
+      const Box& domainBox = domain.domainBox();
+      if (refine(domainBox, 1 << depth) != m_domains[0].domainBox())
+        {
+          break;
+        }
+
+      long long numCells = domainBox.numPts();
+      int numRanks = fineRanks;
+      if (numCells < (long long)fineRanks*AMRPoissonOp::s_agglomerateCells)
+        {
+          numRanks = Max(1, (int)(numCells/AMRPoissonOp::s_agglomerateCells));
+        }
+
+      if (numRanks == fineRanks && fine.coarsenable(2*maxCoarse))
+        {
+          DisjointBoxLayout grids;
+          coarsen(grids, fine, 2);
+          m_mgGrids.push_back(grids);
+          m_mgRanks.push_back(fineRanks);
+          m_mgStage.push_back(m_mgStage[depth-1]);
+          continue;
+        }
+
+      // too few cells per rank, or boxes too small to coarsen: re-split
+      // the domain into the largest boxes that still give each of
+      // numRanks ranks one
+      if (!domainBox.coarsenable(maxCoarse))
+        {
+          break;
+        }
+      int maxSize = domainBox.longside();
+      Vector<Box> boxes;
+      domainSplit(domainBox, boxes, maxSize, maxCoarse);
+      while (boxes.size() < numRanks && maxSize > maxCoarse)
+        {
+          maxSize = maxCoarse*Max(1, maxSize/(2*maxCoarse));
+          domainSplit(domainBox, boxes, maxSize, maxCoarse);
+        }
+      numRanks = Min(numRanks, (int)boxes.size());
+
+      Vector<int> procs;
+      LoadBalance(procs, boxes, numRanks);
+
+      m_mgGrids.push_back(DisjointBoxLayout(boxes, procs, domain));
+      m_mgRanks.push_back(numRanks);
+      m_mgStage.push_back(depth);
+    }
+
+  if (a_depth >= m_mgGrids.size())
+    {
+      return false;
+    }
+  a_grids    = m_mgGrids[a_depth];
+  a_numRanks = m_mgRanks[a_depth];
+  a_stage    = m_mgStage[a_depth];
+  return true;
+}
+
 // ---------------------------------------------------------
 int AMRPoissonOpFactory::refToFiner(const ProblemDomain& a_domain) const
 {
@@ -0,0 +1,541 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+#include <vector>
+
+#include "BoxIterator.H"
+#include "MayDay.H"
+#include "Misc.H"
+#include "AMRPoissonOpKernels.H"
+#include "NamespaceHeader.H"
+
+// The kernels walk the rows of the region with a BoxIterator over the
+// region collapsed in direction 0, and do the work of a row in unit-stride
+// loops over pointers, with the neighbors in directions 1 and 2 at the
+// FAB's strides.  The sums are in the same order as in AMRPoissonOpF.
+
+// ---------------------------------------------------------
+static inline long fabOffset(const Box& a_box, const IntVect& a_iv)
+{
+  long offset = 0;
+  long stride = 1;
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      offset += (a_iv[idir] - a_box.smallEnd(idir))*stride;
+      stride *= a_box.size(idir);
+    }
+  return offset;
+}
+
+// ---------------------------------------------------------
+static inline long fabStride(const Box& a_box, int a_dir)
+{
+  long stride = 1;
+  for (int idir = 0; idir < a_dir; idir++)
+    {
+      stride *= a_box.size(idir);
+    }
+  return stride;
+}
+
+// ---------------------------------------------------------
+static inline Box rowStarts(const Box& a_region)
+{
+  Box rows(a_region);
+  rows.setBig(0, a_region.smallEnd(0));
+  return rows;
+}
+
+// ---------------------------------------------------------
+// a_res[i] = a_rhs[i] - L(a_phi)[i]; a_res may be a_rhs
+template <bool Laplacian, class S>
+static inline void residualRow(S*       a_res,
+                               const S* a_phi,
+                               const S* a_rhs,
+                               int      a_len,
+                               long     a_sy,
+                               long     a_sz,
+                               S        a_dxinv,
+                               S        a_alpha,
+                               S        a_beta)
+{
+  const S diag = 2*SpaceDim;
+#pragma omp simd
+  for (int i = 0; i < a_len; i++)
+    {
+      const S* q = a_phi + i;
+      S lap = (D_TERM(q[1] + q[-1], + q[a_sy] + q[-a_sy], + q[a_sz] + q[-a_sz])
+               - diag*q[0])*a_dxinv;
+      if (Laplacian)
+        {
+          a_res[i] = a_rhs[i] - lap;
+        }
+      else
+        {
+          a_res[i] = -a_alpha*q[0] - a_beta*lap + a_rhs[i];
+        }
+    }
+}
+
+// ---------------------------------------------------------
+template <bool Laplacian, class S>
+static void gsrbKernel(BaseFab<S>&       a_phi,
+                       const BaseFab<S>& a_rhs,
+                       const Box&        a_region,
+                       Real              a_dx,
+                       Real              a_alpha,
+                       Real              a_beta,
+                       int               a_redBlack)
+{
+  const Box& phiBox = a_phi.box();
+  const Box& rhsBox = a_rhs.box();
+  // only the strides of the directions the stencils below use
+  D_TERM(;,
+         const long sy = fabStride(phiBox, 1);,
+         const long sz = fabStride(phiBox, 2););
+  const Real dxinvReal = 1.0/(a_dx*a_dx);
+  const Real sumb = (2*SpaceDim)*dxinvReal;
+  const S dxinv = dxinvReal;
+  const S diag = 2*SpaceDim;
+  const S lambda = Laplacian ? -1.0/sumb : -1.0/(a_alpha - a_beta*sumb);
+  const S alpha = a_alpha;
+  const S beta = a_beta;
+
+  const Box rows = rowStarts(a_region);
+  for (int n = 0; n < a_phi.nComp(); n++)
+    {
+      S* phiBase = a_phi.dataPtr(n);
+      const S* rhsBase = a_rhs.dataPtr(n);
+      for (BoxIterator bit(rows); bit.ok(); ++bit)
+        {
+          IntVect iv = bit();
+          // first cell of the row whose index sum has a_redBlack's parity
+          int indtot = D_TERM(iv[0], + iv[1], + iv[2]);
+          iv[0] += Abs((indtot + a_redBlack) % 2);
+          if (iv[0] > a_region.bigEnd(0)) continue;
+          const int len = (a_region.bigEnd(0) - iv[0])/2 + 1;
+          S* p = phiBase + fabOffset(phiBox, iv);
+          const S* r = rhsBase + fabOffset(rhsBox, iv);
+
+          // the neighbors of a cell are all of the other color, so the
+          // cells of this one are independent
+          if (Laplacian)
+            {
+#pragma omp simd
+              for (int m = 0; m < len; m++)
+                {
+                  S* q = p + 2*m;
+                  S nb = D_TERM(q[1] + q[-1], + q[sy] + q[-sy], + q[sz] + q[-sz]);
+                  q[0] = lambda*(r[2*m] - nb*dxinv);
+                }
+            }
+          else
+            {
+#pragma omp simd
+              for (int m = 0; m < len; m++)
+                {
+                  S* q = p + 2*m;
+                  S nb = D_TERM(q[1] + q[-1], + q[sy] + q[-sy], + q[sz] + q[-sz]);
+                  S lphi = (nb - diag*q[0])*dxinv;
+                  S helmop = alpha*q[0] + beta*lphi;
+                  q[0] = q[0] + lambda*(helmop - r[2*m]);
+                }
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------
+template <class S>
+static void gsrbSelect(BaseFab<S>&       a_phi,
+                       const BaseFab<S>& a_rhs,
+                       const Box&        a_region,
+                       Real              a_dx,
+                       Real              a_alpha,
+                       Real              a_beta,
+                       int               a_redBlack)
+{
+  CH_assert(a_phi.nComp() == a_rhs.nComp());
+  if (a_alpha == 0.0 && a_beta == 1.0)
+    {
+      gsrbKernel<true, S>(a_phi, a_rhs, a_region, a_dx, a_alpha, a_beta, a_redBlack);
+    }
+  else
+    {
+      gsrbKernel<false, S>(a_phi, a_rhs, a_region, a_dx, a_alpha, a_beta, a_redBlack);
+    }
+}
+
+// ---------------------------------------------------------
+void AMRPoissonOpKernels::gsrb(FArrayBox&       a_phi,
+                               const FArrayBox& a_rhs,
+                               const Box&       a_region,
+                               Real             a_dx,
+                               Real             a_alpha,
+                               Real             a_beta,
+                               int              a_redBlack)
+{
+  gsrbSelect<Real>(a_phi, a_rhs, a_region, a_dx, a_alpha, a_beta, a_redBlack);
+}
+
+// ---------------------------------------------------------
+void AMRPoissonOpKernels::gsrb(BaseFab<float>&       a_phi,
+                               const BaseFab<float>& a_rhs,
+                               const Box&            a_region,
+                               Real                  a_dx,
+                               Real                  a_alpha,
+                               Real                  a_beta,
+                               int                   a_redBlack)
+{
+  gsrbSelect<float>(a_phi, a_rhs, a_region, a_dx, a_alpha, a_beta, a_redBlack);
+}
+
+// ---------------------------------------------------------
+template <bool Laplacian, class S>
+static void residualKernel(BaseFab<S>&       a_res,
+                           const BaseFab<S>& a_phi,
+                           const BaseFab<S>& a_rhs,
+                           const Box&        a_region,
+                           Real              a_dx,
+                           Real              a_alpha,
+                           Real              a_beta)
+{
+  const Box& phiBox = a_phi.box();
+  const long sy = fabStride(phiBox, 1);
+  const long sz = fabStride(phiBox, 2);
+  const S dxinv = 1.0/(a_dx*a_dx);
+  const int len = a_region.size(0);
+
+  const Box rows = rowStarts(a_region);
+  for (int n = 0; n < a_phi.nComp(); n++)
+    {
+      for (BoxIterator bit(rows); bit.ok(); ++bit)
+        {
+          const IntVect& iv = bit();
+          residualRow<Laplacian, S>(a_res.dataPtr(n) + fabOffset(a_res.box(), iv),
+                                    a_phi.dataPtr(n) + fabOffset(phiBox, iv),
+                                    a_rhs.dataPtr(n) + fabOffset(a_rhs.box(), iv),
+                                    len, sy, sz, dxinv, a_alpha, a_beta);
+        }
+    }
+}
+
+// ---------------------------------------------------------
+template <class S>
+static void residualSelect(BaseFab<S>&       a_res,
+                           const BaseFab<S>& a_phi,
+                           const BaseFab<S>& a_rhs,
+                           const Box&        a_region,
+                           Real              a_dx,
+                           Real              a_alpha,
+                           Real              a_beta)
+{
+  CH_assert(a_phi.nComp() == a_rhs.nComp());
+  CH_assert(a_res.nComp() == a_phi.nComp());
+  if (a_alpha == 0.0 && a_beta == 1.0)
+    {
+      residualKernel<true, S>(a_res, a_phi, a_rhs, a_region, a_dx, a_alpha, a_beta);
+    }
+  else
+    {
+      residualKernel<false, S>(a_res, a_phi, a_rhs, a_region, a_dx, a_alpha, a_beta);
+    }
+}
+
+// ---------------------------------------------------------
+void AMRPoissonOpKernels::residual(FArrayBox&       a_res,
+                                   const FArrayBox& a_phi,
+                                   const FArrayBox& a_rhs,
+                                   const Box&       a_region,
+                                   Real             a_dx,
+                                   Real             a_alpha,
+                                   Real             a_beta)
+{
+  residualSelect<Real>(a_res, a_phi, a_rhs, a_region, a_dx, a_alpha, a_beta);
+}
+
+// ---------------------------------------------------------
+void AMRPoissonOpKernels::residual(BaseFab<float>&       a_res,
+                                   const BaseFab<float>& a_phi,
+                                   const BaseFab<float>& a_rhs,
+                                   const Box&            a_region,
+                                   Real                  a_dx,
+                                   Real                  a_alpha,
+                                   Real                  a_beta)
+{
+  residualSelect<float>(a_res, a_phi, a_rhs, a_region, a_dx, a_alpha, a_beta);
+}
+
+// ---------------------------------------------------------
+void AMRPoissonOpKernels::jacobi(FArrayBox&       a_phi,
+                                 const FArrayBox& a_phiOld,
+                                 const FArrayBox& a_rhs,
+                                 const Box&       a_region,
+                                 Real             a_dx,
+                                 Real             a_alpha,
+                                 Real             a_beta,
+                                 Real             a_weight)
+{
+  CH_assert(a_phi.nComp() == a_phiOld.nComp());
+  CH_assert(a_phi.nComp() == a_rhs.nComp());
+  CH_assert(&a_phi != &a_phiOld);
+
+  const Box& oldBox = a_phiOld.box();
+  const long sy = fabStride(oldBox, 1);
+  const long sz = fabStride(oldBox, 2);
+  const Real dxinv = 1.0/(a_dx*a_dx);
+  const Real scale = a_weight/(a_alpha - 2*SpaceDim*a_beta*dxinv);
+  const int len = a_region.size(0);
+  const bool laplacian = (a_alpha == 0.0 && a_beta == 1.0);
+
+  const Box rows = rowStarts(a_region);
+  for (int n = 0; n < a_phi.nComp(); n++)
+    {
+      for (BoxIterator bit(rows); bit.ok(); ++bit)
+        {
+          const IntVect& iv = bit();
+          Real* phi = a_phi.dataPtr(n) + fabOffset(a_phi.box(), iv);
+          const Real* old = a_phiOld.dataPtr(n) + fabOffset(oldBox, iv);
+          const Real* rhs = a_rhs.dataPtr(n) + fabOffset(a_rhs.box(), iv);
+          // the residual goes into a_phi's row, which a_phiOld doesn't share
+          if (laplacian)
+            {
+              residualRow<true, Real>(phi, old, rhs, len, sy, sz, dxinv, a_alpha, a_beta);
+            }
+          else
+            {
+              residualRow<false, Real>(phi, old, rhs, len, sy, sz, dxinv, a_alpha, a_beta);
+            }
+#pragma omp simd
+          for (int i = 0; i < len; i++)
+            {
+              phi[i] = old[i] + scale*phi[i];
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------
+template <class S>
+static void restrictResidualKernel(BaseFab<S>&       a_resCoarse,
+                                   const BaseFab<S>& a_phi,
+                                   const BaseFab<S>& a_rhs,
+                                   const Box&        a_region,
+                                   Real              a_dx,
+                                   Real              a_alpha,
+                                   Real              a_beta,
+                                   int               a_refRatio)
+{
+  CH_assert(a_phi.nComp() == a_rhs.nComp());
+  CH_assert(a_resCoarse.nComp() == a_phi.nComp());
+  CH_assert(a_resCoarse.box().contains(coarsen(a_region, a_refRatio)));
+
+  int shift = 0;
+  while ((1 << shift) < a_refRatio) shift++;
+  CH_assert((1 << shift) == a_refRatio);
+
+  const Box& phiBox = a_phi.box();
+  const long sy = fabStride(phiBox, 1);
+  const long sz = fabStride(phiBox, 2);
+  const S dxinv = 1.0/(a_dx*a_dx);
+  const S scale = 1.0/(D_TERM(a_refRatio, *a_refRatio, *a_refRatio));
+  const int lo = a_region.smallEnd(0);
+  const int len = a_region.size(0);
+  const bool laplacian = (a_alpha == 0.0 && a_beta == 1.0);
+  // pairs of fine cells in direction 0 share a coarse cell
+  const bool paired = (a_refRatio == 2) && (lo % 2 == 0) && (len % 2 == 0);
+  std::vector<S> buffer(len);
+  S* res = &buffer[0];
+
+  const Box rows = rowStarts(a_region);
+  for (int n = 0; n < a_phi.nComp(); n++)
+    {
+      for (BoxIterator bit(rows); bit.ok(); ++bit)
+        {
+          const IntVect& iv = bit();
+          const IntVect civ = coarsen(iv, a_refRatio);
+          const S* phi = a_phi.dataPtr(n) + fabOffset(phiBox, iv);
+          const S* rhs = a_rhs.dataPtr(n) + fabOffset(a_rhs.box(), iv);
+          S* coarse = a_resCoarse.dataPtr(n) + fabOffset(a_resCoarse.box(), civ);
+          if (laplacian)
+            {
+              residualRow<true, S>(res, phi, rhs, len, sy, sz, dxinv, a_alpha, a_beta);
+            }
+          else
+            {
+              residualRow<false, S>(res, phi, rhs, len, sy, sz, dxinv, a_alpha, a_beta);
+            }
+          if (paired)
+            {
+#pragma omp simd
+              for (int m = 0; m < len/2; m++)
+                {
+                  coarse[m] += (res[2*m] + res[2*m+1])*scale;
+                }
+            }
+          else
+            {
+              for (int i = 0; i < len; i++)
+                {
+                  coarse[((lo + i) >> shift) - civ[0]] += res[i]*scale;
+                }
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------
+void AMRPoissonOpKernels::restrictResidual(FArrayBox&       a_resCoarse,
+                                           const FArrayBox& a_phi,
+                                           const FArrayBox& a_rhs,
+                                           const Box&       a_region,
+                                           Real             a_dx,
+                                           Real             a_alpha,
+                                           Real             a_beta,
+                                           int              a_refRatio)
+{
+  restrictResidualKernel<Real>(a_resCoarse, a_phi, a_rhs, a_region,
+                               a_dx, a_alpha, a_beta, a_refRatio);
+}
+
+// ---------------------------------------------------------
+void AMRPoissonOpKernels::restrictResidual(BaseFab<float>&       a_resCoarse,
+                                           const BaseFab<float>& a_phi,
+                                           const BaseFab<float>& a_rhs,
+                                           const Box&            a_region,
+                                           Real                  a_dx,
+                                           Real                  a_alpha,
+                                           Real                  a_beta,
+                                           int                   a_refRatio)
+{
+  restrictResidualKernel<float>(a_resCoarse, a_phi, a_rhs, a_region,
+                                a_dx, a_alpha, a_beta, a_refRatio);
+}
+
+// ---------------------------------------------------------
+template <bool Variable, class S>
+static void gsrbFromZeroKernel(BaseFab<S>&       a_phi,
+                               const BaseFab<S>& a_rhs,
+                               const BaseFab<S>* a_lambda,
+                               const Box&        a_region,
+                               S                 a_scale)
+{
+  const int len = a_region.size(0);
+  const Box rows = rowStarts(a_region);
+  for (int n = 0; n < a_phi.nComp(); n++)
+    {
+      for (BoxIterator bit(rows); bit.ok(); ++bit)
+        {
+          const IntVect& iv = bit();
+          // 0 if the first cell of the row is red, 1 if it is black
+          const int first = Abs(D_TERM(iv[0], + iv[1], + iv[2]) % 2);
+          S* phi = a_phi.dataPtr(n) + fabOffset(a_phi.box(), iv);
+          const S* rhs = a_rhs.dataPtr(n) + fabOffset(a_rhs.box(), iv);
+          const S* lambda = Variable ?
+            a_lambda->dataPtr(Min(n, a_lambda->nComp()-1))
+            + fabOffset(a_lambda->box(), iv) : NULL;
+#pragma omp simd
+          for (int i = 0; i < len; i++)
+            {
+              S scale = Variable ? lambda[i] : a_scale;
+              phi[i] = ((i + first) % 2 == 0) ? scale*rhs[i] : S(0);
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------
+void AMRPoissonOpKernels::gsrbFromZero(FArrayBox&       a_phi,
+                                       const FArrayBox& a_rhs,
+                                       const Box&       a_region,
+                                       Real             a_dx,
+                                       Real             a_alpha,
+                                       Real             a_beta)
+{
+  CH_assert(a_phi.nComp() == a_rhs.nComp());
+  // gsrb gives lambda*(0 - a_rhs), lambda = -1/diag, which is this to the bit
+  const Real sumb = (2*SpaceDim)*(1.0/(a_dx*a_dx));
+  const Real scale = 1.0/(a_alpha - a_beta*sumb);
+  gsrbFromZeroKernel<false, Real>(a_phi, a_rhs, NULL, a_region, scale);
+}
+
+// ---------------------------------------------------------
+void AMRPoissonOpKernels::gsrbFromZero(BaseFab<float>&       a_phi,
+                                       const BaseFab<float>& a_rhs,
+                                       const Box&            a_region,
+                                       Real                  a_dx,
+                                       Real                  a_alpha,
+                                       Real                  a_beta)
+{
+  CH_assert(a_phi.nComp() == a_rhs.nComp());
+  const Real sumb = (2*SpaceDim)*(1.0/(a_dx*a_dx));
+  const float scale = 1.0/(a_alpha - a_beta*sumb);
+  gsrbFromZeroKernel<false, float>(a_phi, a_rhs, NULL, a_region, scale);
+}
+
+// ---------------------------------------------------------
+void AMRPoissonOpKernels::gsrbFromZero(FArrayBox&       a_phi,
+                                       const FArrayBox& a_rhs,
+                                       const FArrayBox& a_lambda,
+                                       const Box&       a_region)
+{
+  CH_assert(a_phi.nComp() == a_rhs.nComp());
+  CH_assert(a_lambda.nComp() == a_rhs.nComp() || a_lambda.nComp() == 1);
+  gsrbFromZeroKernel<true, Real>(a_phi, a_rhs, &a_lambda, a_region, 0.0);
+}
+
+// ---------------------------------------------------------
+int AMRPoissonOpKernels::flopsPerCell(Kernel a_kernel,
+                                      Real   a_alpha,
+                                      Real   a_beta)
+{
+  const bool laplacian = (a_alpha == 0.0 && a_beta == 1.0);
+  // 2*SpaceDim-1 adds for the neighbors, a multiply and subtract for the
+  // center and the multiply by 1/dx^2
+  const int lap = 2*SpaceDim + 2;
+  const int res = laplacian ? lap + 1 : lap + 4;
+  switch (a_kernel)
+    {
+    case GSRB:
+      return laplacian ? 2*SpaceDim + 2 : lap + 6;
+    case Jacobi:
+      return res + 2;
+    case Residual:
+      return res;
+    case RestrictResidual:
+      return res + 2;
+    default:
+      MayDay::Error("AMRPoissonOpKernels::flopsPerCell: bad kernel");
+    }
+  return 0;
+}
+
+// ---------------------------------------------------------
+int AMRPoissonOpKernels::bytesPerCell(Kernel a_kernel)
+{
+  const int word = sizeof(Real);
+  switch (a_kernel)
+    {
+    case GSRB:
+      // each half-sweep reads phi and rhs and writes phi
+      return 2*3*word;
+    case Jacobi:
+    case Residual:
+      return 3*word;
+    case RestrictResidual:
+      // and the coarse residual, read and written
+      return 2*word + (2*word)/(D_TERM(2, *2, *2));
+    default:
+      MayDay::Error("AMRPoissonOpKernels::bytesPerCell: bad kernel");
+    }
+  return 0;
+}
+
+#include "NamespaceFooter.H"
@@ -170,6 +170,36 @@ RefCountedPtr<BCFunction> ConstDiriNeumBC(const IntVect&  a_loSideType,
   return retval;
 }
 
+ComponentBCFunction::ComponentBCFunction(const Vector<BCHolder>& a_bcs)
+  : m_bcs(a_bcs)
+{
+}
+
+ComponentBCFunction::~ComponentBCFunction()
+{
+}
+
+void ComponentBCFunction::operator()(FArrayBox&           a_state,
+                                     const Box&           a_valid,
+                                     const ProblemDomain& a_domain,
+                                     Real                 a_dx,
+                                     bool                 a_homogeneous)
+{
+  CH_assert(a_state.nComp() == m_bcs.size());
+  for (int icomp = 0; icomp < m_bcs.size(); icomp++)
+    {
+      FArrayBox stateComp(Interval(icomp, icomp), a_state);
+      m_bcs[icomp](stateComp, a_valid, a_domain, a_dx, a_homogeneous);
+    }
+}
+
+RefCountedPtr<BCFunction> ComponentBC(const Vector<BCHolder>& a_bcs)
+{
+  RefCountedPtr<BCFunction> retval(new ComponentBCFunction(a_bcs));
+
+  return retval;
+}
+
 void NeumBC(FArrayBox&      a_state,
             const Box&      a_valid,
             Real            a_dx,
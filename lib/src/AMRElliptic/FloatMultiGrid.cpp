@@ -0,0 +1,396 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+#include "FloatMultiGrid.H"
+#include "VCAMRPoissonOp2.H"
+#include "AMRPoissonOpKernels.H"
+#include "TiledDataIterator.H"
+#include "BoxIterator.H"
+#include "LoHiSide.H"
+#include "MayDay.H"
+#include "CH_Timer.H"
+#include "NamespaceHeader.H"
+
+// cells of the valid box next to a domain face that the boundary
+// condition is given; the BCFunc extrapolations use two
+static const int s_bcCells = 3;
+
+// ---------------------------------------------------------
+// a_dst = a_src on a_region, row by row
+template <class D, class S>
+static void convert(BaseFab<D>&       a_dst,
+                    const BaseFab<S>& a_src,
+                    const Box&        a_region)
+{
+  Box rows(a_region);
+  rows.setBig(0, a_region.smallEnd(0));
+  const int len = a_region.size(0);
+  for (int n = 0; n < a_dst.nComp(); n++)
+    {
+      for (BoxIterator bit(rows); bit.ok(); ++bit)
+        {
+          D* dst = a_dst.dataPtr() + a_dst.offset(bit(), n);
+          const S* src = a_src.dataPtr() + a_src.offset(bit(), n);
+#pragma omp simd
+          for (int i = 0; i < len; i++)
+            {
+              dst[i] = src[i];
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------
+// a_phi += a_coarse, piecewise constant from the cells of a_region
+// coarsened by 2
+static void prolongIncrement(BaseFab<float>&       a_phi,
+                             const BaseFab<float>& a_coarse,
+                             const Box&            a_region)
+{
+  Box rows(a_region);
+  rows.setBig(0, a_region.smallEnd(0));
+  const int lo = a_region.smallEnd(0);
+  const int len = a_region.size(0);
+  for (int n = 0; n < a_phi.nComp(); n++)
+    {
+      for (BoxIterator bit(rows); bit.ok(); ++bit)
+        {
+          const IntVect& iv = bit();
+          const IntVect civ = coarsen(iv, 2);
+          float* phi = a_phi.dataPtr() + a_phi.offset(iv, n);
+          const float* coarse = a_coarse.dataPtr() + a_coarse.offset(civ, n);
+          for (int i = 0; i < len; i++)
+            {
+              phi[i] += coarse[((lo + i) >> 1) - civ[0]];
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------
+// The homogeneous boundary condition on the ghost cells of a_phi outside
+// a_domain.  BCHolder works on FArrayBox, so it gets double copies of
+// the cells of a_valid within s_bcCells of each face on the domain
+// boundary, with their ghost cells, and only those are copied back: the
+// round trip leaves the other cells as they were.
+static void homogeneousBC(BaseFab<float>&      a_phi,
+                          const Box&           a_valid,
+                          const ProblemDomain& a_domain,
+                          Real                 a_dx,
+                          BCHolder&            a_bc,
+                          const DataIndex&     a_index)
+{
+  const Box& domainBox = a_domain.domainBox();
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      if (a_domain.isPeriodic(idir))
+        {
+          continue;
+        }
+      for (SideIterator sit; sit.ok(); ++sit)
+        {
+          Side::LoHiSide side = sit();
+          if (a_valid.sideEnd(side)[idir] != domainBox.sideEnd(side)[idir])
+            {
+              continue;
+            }
+          Box slab(a_valid);
+          if (side == Side::Lo)
+            {
+              slab.setBig(idir, Min(a_valid.smallEnd(idir) + s_bcCells - 1, a_valid.bigEnd(idir)));
+            }
+          else
+            {
+              slab.setSmall(idir, Max(a_valid.bigEnd(idir) - s_bcCells + 1, a_valid.smallEnd(idir)));
+            }
+          Box region = grow(slab, 1);
+          FArrayBox state(region, a_phi.nComp());
+          convert(state, a_phi, region);
+          a_bc(state, slab, a_domain, a_dx, true, a_index);
+          convert(a_phi, state, region);
+        }
+    }
+}
+
+// ---------------------------------------------------------
+FloatMultiGrid::FloatMultiGrid()
+  :m_imax(1),
+   m_pre(2),
+   m_post(2),
+   m_maxDepth(-1),
+   m_op(NULL),
+   m_alpha(0),
+   m_beta(1),
+   m_nComp(0),
+   m_bottomOp(NULL)
+{
+  m_bottomSolver.m_verbosity = 0;
+}
+
+// ---------------------------------------------------------
+FloatMultiGrid::~FloatMultiGrid()
+{
+  clear();
+}
+
+// ---------------------------------------------------------
+void FloatMultiGrid::clear()
+{
+  for (int i = 0; i < m_phi.size(); i++)
+    {
+      delete m_phi[i];
+      delete m_rhs[i];
+    }
+  m_phi.resize(0);
+  m_rhs.resize(0);
+  m_grids.resize(0);
+  m_domains.resize(0);
+  m_dx.resize(0);
+  m_exchangeCopiers.resize(0);
+  delete m_bottomOp;
+  m_bottomOp = NULL;
+}
+
+// ---------------------------------------------------------
+void FloatMultiGrid::setHomogeneous(bool a_homogeneous)
+{
+  if (!a_homogeneous)
+    {
+      MayDay::Error("FloatMultiGrid only solves with homogeneous boundary conditions");
+    }
+}
+
+// ---------------------------------------------------------
+void FloatMultiGrid::define(LinearOp<LevelData<FArrayBox> >* a_op, bool a_homogeneous)
+{
+  setHomogeneous(a_homogeneous);
+  AMRPoissonOp* op = dynamic_cast<AMRPoissonOp*>(a_op);
+  if (op == NULL || dynamic_cast<VCAMRPoissonOp2*>(a_op) != NULL)
+    {
+      MayDay::Error("FloatMultiGrid::define: the operator must be a constant coefficient AMRPoissonOp");
+    }
+  if (op != m_op)
+    {
+      clear();
+      m_op = op;
+      m_bc = op->getBC();
+    }
+}
+
+// ---------------------------------------------------------
+void FloatMultiGrid::setup(const LevelData<FArrayBox>& a_rhs)
+{
+  CH_TIME("FloatMultiGrid::setup");
+  CH_assert(m_op != NULL);
+
+  clear();
+  m_nComp = a_rhs.nComp();
+
+  DisjointBoxLayout grids = a_rhs.disjointBoxLayout();
+  ProblemDomain domain = m_op->getDomain();
+  Real dx = m_op->dx();
+  for (int depth = 0; ; depth++)
+    {
+      m_grids.push_back(grids);
+      m_domains.push_back(domain);
+      m_dx.push_back(dx);
+      Copier exchangeCopier;
+      exchangeCopier.exchangeDefine(grids, IntVect::Unit);
+      exchangeCopier.trimEdges(grids, IntVect::Unit);
+      m_exchangeCopiers.push_back(exchangeCopier);
+      m_phi.push_back(new LevelData<BaseFab<float> >(grids, m_nComp, IntVect::Unit));
+      m_rhs.push_back(new LevelData<BaseFab<float> >(grids, m_nComp, IntVect::Zero));
+
+      // the coarsening rule of AMRPoissonOpFactory::MGnewOp
+      if (depth == m_maxDepth || !grids.coarsenable(2*AMRPoissonOp::s_maxCoarse))
+        {
+          break;
+        }
+      DisjointBoxLayout coarser;
+      coarsen(coarser, grids, 2);
+      grids = coarser;
+      domain.coarsen(2);
+      dx *= 2;
+    }
+
+  m_bottomOp = new AMRPoissonOp;
+  m_bottomOp->define(m_grids.back(), m_dx.back(), m_domains.back(), m_bc);
+  m_bottomPhi.define(m_grids.back(), m_nComp, IntVect::Unit);
+  m_bottomRhs.define(m_grids.back(), m_nComp, IntVect::Zero);
+  m_bottomSolver.define(m_bottomOp, true);
+}
+
+// ---------------------------------------------------------
+void FloatMultiGrid::solve(LevelData<FArrayBox>&       a_phi,
+                           const LevelData<FArrayBox>& a_rhs)
+{
+  CH_TIME("FloatMultiGrid::solve");
+  CH_assert(m_op != NULL);
+
+  if (m_phi.size() == 0 || !(a_rhs.disjointBoxLayout() == m_grids[0]) ||
+      a_rhs.nComp() != m_nComp)
+    {
+      setup(a_rhs);
+    }
+
+  // the operator's scalars may have changed since the last solve
+  m_alpha = m_op->m_alpha;
+  m_beta  = m_op->m_beta;
+  m_bottomOp->m_alpha = m_alpha;
+  m_bottomOp->m_beta  = m_beta;
+  m_bottomOp->m_aCoef = m_alpha;
+  m_bottomOp->m_bCoef = m_beta;
+
+  LevelData<BaseFab<float> >& phi = *m_phi[0];
+  LevelData<BaseFab<float> >& rhs = *m_rhs[0];
+  TiledDataIterator tit(m_grids[0]);
+  int ntile = tit.size();
+#pragma omp parallel for
+  for (int itile = 0; itile < ntile; itile++)
+    {
+      const DataIndex& d = tit[itile];
+      const Box& region = tit.tile(itile);
+      convert(rhs[d], a_rhs[d], region);
+      convert(phi[d], a_phi[d], region);
+    }
+
+  for (int iter = 0; iter < m_imax; iter++)
+    {
+      cycle(0);
+    }
+
+#pragma omp parallel for
+  for (int itile = 0; itile < ntile; itile++)
+    {
+      const DataIndex& d = tit[itile];
+      const Box& region = tit.tile(itile);
+      convert(a_phi[d], phi[d], region);
+    }
+}
+
+// ---------------------------------------------------------
+void FloatMultiGrid::cycle(int a_depth)
+{
+  if (a_depth == m_phi.size() - 1)
+    {
+      bottomSolve();
+      return;
+    }
+
+  relax(a_depth, m_pre);
+
+  // restrict the residual
+  LevelData<BaseFab<float> >& phi = *m_phi[a_depth];
+  LevelData<BaseFab<float> >& rhs = *m_rhs[a_depth];
+  LevelData<BaseFab<float> >& phiCoarse = *m_phi[a_depth+1];
+  LevelData<BaseFab<float> >& rhsCoarse = *m_rhs[a_depth+1];
+  {
+    CH_TIME("FloatMultiGrid::restrictResidual");
+    fillGhosts(a_depth);
+    for (DataIterator dit = m_grids[a_depth+1].dataIterator(); dit.ok(); ++dit)
+      {
+        rhsCoarse[dit].setVal(0.0f);
+        phiCoarse[dit].setVal(0.0f);
+      }
+    // the tiles of a box do not share coarse cells
+    TiledDataIterator tit(m_grids[a_depth]);
+    int ntile = tit.size();
+#pragma omp parallel for
+    for (int itile = 0; itile < ntile; itile++)
+      {
+        const DataIndex& d = tit[itile];
+        AMRPoissonOpKernels::restrictResidual(rhsCoarse[d], phi[d], rhs[d], tit.tile(itile),
+                                              m_dx[a_depth], m_alpha, m_beta);
+      }
+  }
+
+  cycle(a_depth + 1);
+
+  {
+    CH_TIME("FloatMultiGrid::prolongIncrement");
+    TiledDataIterator tit(m_grids[a_depth]);
+    int ntile = tit.size();
+#pragma omp parallel for
+    for (int itile = 0; itile < ntile; itile++)
+      {
+        const DataIndex& d = tit[itile];
+        prolongIncrement(phi[d], phiCoarse[d], tit.tile(itile));
+      }
+  }
+
+  relax(a_depth, m_post);
+}
+
+// ---------------------------------------------------------
+void FloatMultiGrid::relax(int a_depth, int a_numSweeps)
+{
+  CH_TIME("FloatMultiGrid::relax");
+
+  LevelData<BaseFab<float> >& phi = *m_phi[a_depth];
+  const LevelData<BaseFab<float> >& rhs = *m_rhs[a_depth];
+  // cells of one color only read cells of the other, so a pass can be
+  // split into tiles
+  TiledDataIterator tit(m_grids[a_depth]);
+  int ntile = tit.size();
+  for (int sweep = 0; sweep < a_numSweeps; sweep++)
+    {
+      for (int whichPass = 0; whichPass <= 1; whichPass++)
+        {
+          fillGhosts(a_depth);
+#pragma omp parallel for
+          for (int itile = 0; itile < ntile; itile++)
+            {
+              const DataIndex& d = tit[itile];
+              AMRPoissonOpKernels::gsrb(phi[d], rhs[d], tit.tile(itile), m_dx[a_depth],
+                                        m_alpha, m_beta, whichPass);
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------
+void FloatMultiGrid::fillGhosts(int a_depth)
+{
+  LevelData<BaseFab<float> >& phi = *m_phi[a_depth];
+  phi.exchange(m_exchangeCopiers[a_depth]);
+
+  const DisjointBoxLayout& grids = m_grids[a_depth];
+  DataIterator dit = grids.dataIterator();
+  int nbox = dit.size();
+#pragma omp parallel for
+  for (int ibox = 0; ibox < nbox; ibox++)
+    {
+      homogeneousBC(phi[dit[ibox]], grids[dit[ibox]], m_domains[a_depth],
+                    m_dx[a_depth], m_bc, dit[ibox]);
+    }
+}
+
+// ---------------------------------------------------------
+void FloatMultiGrid::bottomSolve()
+{
+  CH_TIME("FloatMultiGrid::bottomSolve");
+
+  const int depth = m_phi.size() - 1;
+  LevelData<BaseFab<float> >& phi = *m_phi[depth];
+  const LevelData<BaseFab<float> >& rhs = *m_rhs[depth];
+  for (DataIterator dit = m_grids[depth].dataIterator(); dit.ok(); ++dit)
+    {
+      const Box& valid = m_grids[depth][dit];
+      convert(m_bottomRhs[dit], rhs[dit], valid);
+      m_bottomPhi[dit].setVal(0.0);
+    }
+  m_bottomSolver.solve(m_bottomPhi, m_bottomRhs);
+  for (DataIterator dit = m_grids[depth].dataIterator(); dit.ok(); ++dit)
+    {
+      convert(phi[dit], m_bottomPhi[dit], m_grids[depth][dit]);
+    }
+}
+
+#include "NamespaceFooter.H"
@@ -0,0 +1,226 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+#ifdef CH_MPI
+#include <string>
+#include <sstream>
+#endif
+#include "LevelDataOps.H"
+#include "TiledDataIterator.H"
+#include "NamespaceHeader.H"
+
+// Tiles of the valid boxes are used where the generic version works on the
+// valid region, and tiles of the ghosted boxes where it works on whole FABs.
+
+template < >
+Real LevelDataOps<FArrayBox>::dotProduct(const LevelData<FArrayBox>& a_1,
+                                         const LevelData<FArrayBox>& a_2)
+{
+  Real val = 0.0;
+  TiledDataIterator tit(a_1.disjointBoxLayout());
+  int ntile = tit.size();
+#pragma omp parallel for reduction (+:val)
+  for (int i=0; i<ntile; i++)
+    {
+      const DataIndex& d = tit[i];
+      val += a_1[d].dotProduct(a_2[d], tit.tile(i));
+    }
+
+#ifdef CH_MPI
+  Real recv;
+  int result = MPI_Allreduce(&val, &recv, 1, MPI_CH_REAL,
+                             MPI_SUM, Chombo_MPI::comm);
+  if ( result != 0 )
+  {
+    std::ostringstream msg;
+    msg << "LevelDataOps::dotProduct() called MPI_Allreduce() which returned error code " << result ;
+    MayDay::Warning( msg.str().c_str() );
+  }
+  val = recv;
+#endif
+  return val;
+}
+
+template < >
+void LevelDataOps<FArrayBox>::mDotProduct(const LevelData<FArrayBox>& a_1,
+                                          const int a_sz,
+                                          const LevelData<FArrayBox> a_2arr[],
+                                          Real a_mdots[])
+{
+  TiledDataIterator tit(a_1.disjointBoxLayout());
+  int ntile = tit.size();
+  for (int ii=0;ii<a_sz;ii++)
+    {
+      Real val = 0.0;
+      const LevelData<FArrayBox> &a_2 = a_2arr[ii];
+#pragma omp parallel for reduction (+:val)
+      for (int i=0; i<ntile; i++)
+        {
+          const DataIndex& d = tit[i];
+          val += a_1[d].dotProduct(a_2[d], tit.tile(i));
+        }
+      a_mdots[ii] = val;
+    }
+
+#ifdef CH_MPI
+  Real *recv = new Real[a_sz];
+
+  int result = MPI_Allreduce(a_mdots, recv, a_sz, MPI_CH_REAL,
+                             MPI_SUM, Chombo_MPI::comm);
+  if ( result != 0 )
+  {
+    std::ostringstream msg;
+    msg << "LevelDataOps::mDotProduct() called MPI_Allreduce() which returned error code " << result ;
+    MayDay::Warning( msg.str().c_str() );
+  }
+  for (int ii=0;ii<a_sz;ii++)
+    {
+      a_mdots[ii] = recv[ii];
+    }
+
+  delete [] recv;
+#endif
+}
+
+template < >
+void LevelDataOps<FArrayBox>::mDotProductStart(const int a_sz,
+                                               const LevelData<FArrayBox>* const a_1[],
+                                               const LevelData<FArrayBox>* const a_2[],
+                                               Real a_dots[])
+{
+  for (int j=0; j<a_sz; j++)
+    {
+      const LevelData<FArrayBox>& data1 = *a_1[j];
+      const LevelData<FArrayBox>& data2 = *a_2[j];
+      TiledDataIterator tit(data1.disjointBoxLayout());
+      int ntile = tit.size();
+      Real val = 0.0;
+#pragma omp parallel for reduction (+:val)
+      for (int i=0; i<ntile; i++)
+        {
+          const DataIndex& d = tit[i];
+          val += data1[d].dotProduct(data2[d], tit.tile(i));
+        }
+      a_dots[j] = val;
+    }
+  startDotReduction(a_sz, a_dots);
+}
+
+template < >
+void LevelDataOps<FArrayBox>::incr(LevelData<FArrayBox>& a_lhs,
+                                   const LevelData<FArrayBox>& a_rhs,
+                                   Real a_scale)
+{
+  int numcomp = a_lhs.nComp();
+  TiledDataIterator tit(a_lhs.disjointBoxLayout());
+  int ntile = tit.size();
+#pragma omp parallel for
+  for (int i=0; i<ntile; i++)
+    {
+      const DataIndex& d = tit[i];
+      const Box& region = tit.tile(i);
+      a_lhs[d].plus(a_rhs[d], region, region, a_scale, 0, 0, numcomp);
+    }
+}
+
+template < >
+void LevelDataOps<FArrayBox>::mult(LevelData<FArrayBox>& a_lhs,
+                                   const LevelData<FArrayBox>& a_rhs)
+{
+  int numcomp = a_lhs.nComp();
+  TiledDataIterator tit(a_lhs.disjointBoxLayout(), a_lhs.ghostVect());
+  int ntile = tit.size();
+#pragma omp parallel for
+  for (int i=0; i<ntile; i++)
+    {
+      const DataIndex& d = tit[i];
+      a_lhs[d].mult(a_rhs[d], tit.tile(i), 0, 0, numcomp);
+    }
+}
+
+template < >
+void LevelDataOps<FArrayBox>::axby(LevelData<FArrayBox>& a_lhs,
+                                   const LevelData<FArrayBox>& a_x,
+                                   const LevelData<FArrayBox>& a_y,
+                                   Real a, Real b)
+{
+  int numcomp = a_lhs.nComp();
+  TiledDataIterator tit(a_lhs.disjointBoxLayout(), a_lhs.ghostVect());
+  int ntile = tit.size();
+#pragma omp parallel for
+  for (int i=0; i<ntile; i++)
+    {
+      const DataIndex& d = tit[i];
+      FArrayBox& data = a_lhs[d];
+      const Box& region = tit.tile(i);
+      Box xRegion = region & a_x[d].box();
+      Box yRegion = region & a_y[d].box();
+      if (!xRegion.isEmpty()) data.copy(a_x[d], xRegion);
+      data.mult(a, region, 0, numcomp);
+      if (!yRegion.isEmpty()) data.plus(a_y[d], yRegion, yRegion, b, 0, 0, numcomp);
+    }
+}
+
+template < >
+void LevelDataOps<FArrayBox>::scale(LevelData<FArrayBox>& a_lhs,
+                                    const Real& a_scale)
+{
+  int numcomp = a_lhs.nComp();
+  TiledDataIterator tit(a_lhs.disjointBoxLayout(), a_lhs.ghostVect());
+  int ntile = tit.size();
+#pragma omp parallel for
+  for (int i=0; i<ntile; i++)
+    {
+      a_lhs[tit[i]].mult(a_scale, tit.tile(i), 0, numcomp);
+    }
+}
+
+template < >
+void LevelDataOps<FArrayBox>::plus(LevelData<FArrayBox>& a_lhs,
+                                   const Real& a_inc)
+{
+  int numcomp = a_lhs.nComp();
+  TiledDataIterator tit(a_lhs.disjointBoxLayout(), a_lhs.ghostVect());
+  int ntile = tit.size();
+#pragma omp parallel for
+  for (int i=0; i<ntile; i++)
+    {
+      a_lhs[tit[i]].plus(a_inc, tit.tile(i), 0, numcomp);
+    }
+}
+
+template < >
+void LevelDataOps<FArrayBox>::setToZero(LevelData<FArrayBox>& a_lhs)
+{
+  int numcomp = a_lhs.nComp();
+  TiledDataIterator tit(a_lhs.disjointBoxLayout(), a_lhs.ghostVect());
+  int ntile = tit.size();
+#pragma omp parallel for
+  for (int i=0; i<ntile; i++)
+    {
+      a_lhs[tit[i]].setVal(0.0, tit.tile(i), 0, numcomp);
+    }
+}
+
+template < >
+void LevelDataOps<FArrayBox>::setVal(LevelData<FArrayBox>& a_lhs,
+                                     const Real& a_val)
+{
+  int numcomp = a_lhs.nComp();
+  TiledDataIterator tit(a_lhs.disjointBoxLayout(), a_lhs.ghostVect());
+  int ntile = tit.size();
+#pragma omp parallel for
+  for (int i=0; i<ntile; i++)
+    {
+      a_lhs[tit[i]].setVal(a_val, tit.tile(i), 0, numcomp);
+    }
+}
+
+#include "NamespaceFooter.H"
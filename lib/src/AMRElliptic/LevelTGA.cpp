@@ -122,7 +122,7 @@ LevelTGA::updateSoln(LevelData<FArrayBox>& a_phiNew,
      a_fineFluxRegPtr, a_crseFluxRegPtr,
      a_crsePhiOldPtr,  a_crsePhiNewPtr,
      a_oldTime, a_crseOldTime, a_crseNewTime, a_dt,
-     a_level, a_zeroPhi, a_fluxStartComponent);
+     a_level, a_zeroPhi, false, a_fluxStartComponent);
 }
 
 void
@@ -233,7 +233,7 @@ LevelBackwardEuler::updateSoln(LevelData<FArrayBox>& a_phiNew,
      a_fineFluxRegPtr, a_crseFluxRegPtr,
      a_crsePhiOldPtr,  a_crsePhiNewPtr,
      a_oldTime, a_crseOldTime, a_crseNewTime, a_dt,
-     a_level, a_zeroPhi, a_fluxStartComponent);
+     a_level, a_zeroPhi, false, a_fluxStartComponent);
 }
 
 #include "NamespaceFooter.H"
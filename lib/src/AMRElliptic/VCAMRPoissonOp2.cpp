@@ -22,6 +22,7 @@
 #include "AMRPoissonOpF_F.H"
 
 #include "VCAMRPoissonOp2.H"
+#include "AMRPoissonOpKernels.H"
 #include "VCAMRPoissonOpF_F.H"
 #include "DebugOut.H"
 
@@ -86,6 +87,27 @@ void VCAMRPoissonOp2::residualI(LevelData<FArrayBox>&       a_lhs,
     } // end loop over boxes
 }
 
+/**************************/
+// a_fab *= a_lambda on a_box; a_lambda has the components of aCoef, one
+// for each component of a_fab or one for all of them
+static void multLambda(FArrayBox&       a_fab,
+                       const FArrayBox& a_lambda,
+                       const Box&       a_box)
+{
+  if (a_lambda.nComp() == a_fab.nComp())
+    {
+      a_fab.mult(a_lambda, a_box, 0, 0, a_fab.nComp());
+    }
+  else
+    {
+      CH_assert(a_lambda.nComp() == 1);
+      for (int comp = 0; comp < a_fab.nComp(); comp++)
+        {
+          a_fab.mult(a_lambda, a_box, 0, comp, 1);
+        }
+    }
+}
+
 /**************************/
 // this preconditioner first initializes phihat to (IA)phihat = rhshat
 // (diagonization of L -- A is the matrix version of L)
@@ -106,10 +128,10 @@ void VCAMRPoissonOp2::preCond(LevelData<FArrayBox>&       a_phi,
 
   CH_assert(m_lambda.isDefined());
   CH_assert(a_rhs.nComp()    == ncomp);
-  CH_assert(m_bCoef->nComp() == ncomp);
+  CH_assert(m_bCoef->nComp() == ncomp || m_bCoef->nComp() == 1);
 
   // Recompute the relaxation coefficient if needed.
-  resetLambda();
+  updateLambda();
 
   // don't need to use a Copier -- plain copy will do
   DataIterator dit = a_phi.dataIterator();
@@ -120,7 +142,7 @@ void VCAMRPoissonOp2::preCond(LevelData<FArrayBox>&       a_phi,
 
       // approximate inverse
       a_phi[dit].copy(a_rhs[dit]);
-      a_phi[dit].mult(m_lambda[dit], gridBox, 0, 0, ncomp);
+      multLambda(a_phi[dit], m_lambda[dit], gridBox);
     }
 
   relax(a_phi, a_rhs, 2);
@@ -255,13 +277,100 @@ void VCAMRPoissonOp2::restrictResidual(LevelData<FArrayBox>&       a_resCoarse,
     }
 }
 
+void VCAMRPoissonOp2::AMRRestrictS(LevelData<FArrayBox>&       a_resCoarse,
+                                   const LevelData<FArrayBox>& a_residual,
+                                   const LevelData<FArrayBox>& a_correction,
+                                   const LevelData<FArrayBox>& a_coarseCorrection,
+                                   LevelData<FArrayBox>&       a_scratch,
+                                   bool                        a_skip_res)
+{
+  CH_TIME("VCAMRPoissonOp2::AMRRestrictS");
+
+  if (a_skip_res)
+    {
+      AMRAverage(a_resCoarse, a_residual);
+      return;
+    }
+  if (!s_fusedVCycle || m_refToCoarser != 2)
+    {
+      if (!a_scratch.isDefined())
+        {
+          create(a_scratch, a_residual);
+        }
+      AMRResidualNF(a_scratch, a_correction, a_coarseCorrection, a_residual, true);
+      AMRAverage(a_resCoarse, a_scratch);
+      return;
+    }
+
+  // as restrictResidual, with the coarse-fine interpolation from
+  // a_coarseCorrection and the BCs of residualI
+  LevelData<FArrayBox>& phi = (LevelData<FArrayBox>&)a_correction;
+  if (a_coarseCorrection.isDefined())
+    {
+      setNumComps(phi.nComp());
+      m_interpWithCoarser.coarseFineInterp(phi, a_coarseCorrection);
+    }
+  const DisjointBoxLayout& dblFine = phi.disjointBoxLayout();
+  for (DataIterator dit = phi.dataIterator(); dit.ok(); ++dit)
+    {
+      m_bc(phi[dit], dblFine[dit()], m_domain, m_dx, true);
+    }
+
+  phi.exchange(phi.interval(), m_exchangeCopier);
+
+  for (DataIterator dit = phi.dataIterator(); dit.ok(); ++dit)
+    {
+      const FArrayBox& thisACoef = (*m_aCoef)[dit];
+      const FluxBox&   thisBCoef = (*m_bCoef)[dit];
+      FArrayBox&       res = a_resCoarse[dit];
+
+      Box region = dblFine.get(dit());
+      const IntVect& iv = region.smallEnd();
+      IntVect civ = coarsen(iv, 2);
+
+      res.setVal(0.0);
+
+#if CH_SPACEDIM == 1
+      FORT_RESTRICTRESVC1D
+#elif CH_SPACEDIM == 2
+      FORT_RESTRICTRESVC2D
+#elif CH_SPACEDIM == 3
+      FORT_RESTRICTRESVC3D
+#else
+      This_will_not_compile!
+#endif
+                          (CHF_FRA_SHIFT(res, civ),
+                           CHF_CONST_FRA_SHIFT(phi[dit], iv),
+                           CHF_CONST_FRA_SHIFT(a_residual[dit], iv),
+                           CHF_CONST_REAL(m_alpha),
+                           CHF_CONST_FRA_SHIFT(thisACoef, iv),
+                           CHF_CONST_REAL(m_beta),
+#if CH_SPACEDIM >= 1
+                           CHF_CONST_FRA_SHIFT(thisBCoef[0], iv),
+#endif
+#if CH_SPACEDIM >= 2
+                           CHF_CONST_FRA_SHIFT(thisBCoef[1], iv),
+#endif
+#if CH_SPACEDIM >= 3
+                           CHF_CONST_FRA_SHIFT(thisBCoef[2], iv),
+#endif
+#if CH_SPACEDIM >= 4
+                           This_will_not_compile!
+#endif
+                           CHF_BOX_SHIFT(region, iv),
+                           CHF_CONST_REAL(m_dx));
+    }
+}
+
 void VCAMRPoissonOp2::setAlphaAndBeta(const Real& a_alpha,
                                       const Real& a_beta)
 {
   m_alpha = a_alpha;
   m_beta  = a_beta;
 
-  // Our relaxation parameter is officially out of date!
+  // Our relaxation parameter is officially out of date!  It is rebuilt
+  // from the current aCoef; the sums of the face coefficients only depend
+  // on bCoef, so they are kept.
   m_lambdaNeedsResetting = true;
 }
 
@@ -277,36 +386,80 @@ void VCAMRPoissonOp2::setCoefs(const RefCountedPtr<LevelData<FArrayBox> >& a_aCo
   m_bCoef = a_bCoef;
 
   // Our relaxation parameter is officially out of date!
+  m_faceCoefSumNeedsResetting = true;
   m_lambdaNeedsResetting = true;
 }
 
+void VCAMRPoissonOp2::resetCoefficients()
+{
+  m_faceCoefSumNeedsResetting = true;
+  m_lambdaNeedsResetting = true;
+
+  // Coarser multigrid operators average the coefficients again.
+  notifyObserversOfChange();
+}
+
+void VCAMRPoissonOp2::resetFaceCoefSum()
+{
+  CH_TIME("VCAMRPoissonOp2::resetFaceCoefSum");
+
+  if (!m_faceCoefSum.isDefined())
+  {
+    m_faceCoefSum.define(m_lambda.disjointBoxLayout(), m_lambda.nComp());
+  }
+
+  Real scale = 1.0 / (m_dx*m_dx);
+  Real one = 1.0;
+
+  for (DataIterator dit = m_faceCoefSum.dataIterator(); dit.ok(); ++dit)
+  {
+    FArrayBox&     sumFab   = m_faceCoefSum[dit];
+    const FluxBox& bCoefFab = (*m_bCoef)[dit];
+    const Box& curBox = sumFab.box();
+
+    sumFab.setVal(0.0);
+    for (int dir = 0; dir < SpaceDim; dir++)
+    {
+      FORT_SUMFACES(CHF_FRA(sumFab),
+                    CHF_CONST_REAL(one),
+                    CHF_CONST_FRA(bCoefFab[dir]),
+                    CHF_BOX(curBox),
+                    CHF_CONST_INT(dir),
+                    CHF_CONST_REAL(scale));
+    }
+  }
+
+  m_faceCoefSumNeedsResetting = false;
+}
+
 void VCAMRPoissonOp2::resetLambda()
 {
+  // The caller may have changed aCoef or bCoef in place.
+  m_faceCoefSumNeedsResetting = true;
+  updateLambda();
+}
+
+void VCAMRPoissonOp2::updateLambda()
+{
+  if (m_faceCoefSumNeedsResetting)
+  {
+    resetFaceCoefSum();
+    m_lambdaNeedsResetting = true;
+  }
+
   if (m_lambdaNeedsResetting)
   {
-    Real scale = 1.0 / (m_dx*m_dx);
+    CH_TIME("VCAMRPoissonOp2::updateLambda");
 
-    // Compute it box by box, point by point
+    // Compute it box by box: the diagonal term is
+    // alpha*aCoef + beta*(sum of bCoef on the faces)/dx^2
     for (DataIterator dit = m_lambda.dataIterator(); dit.ok(); ++dit)
     {
-      FArrayBox&       lambdaFab = m_lambda[dit];
-      const FArrayBox& aCoefFab  = (*m_aCoef)[dit];
-      const FluxBox&   bCoefFab  = (*m_bCoef)[dit];
-      const Box& curBox = lambdaFab.box();
+      FArrayBox& lambdaFab = m_lambda[dit];
 
-      // Compute the diagonal term
-      lambdaFab.copy(aCoefFab);
+      lambdaFab.copy((*m_aCoef)[dit]);
       lambdaFab.mult(m_alpha);
-
-      for (int dir = 0; dir < SpaceDim; dir++)
-      {
-        FORT_SUMFACES(CHF_FRA(lambdaFab),
-            CHF_CONST_REAL(m_beta),
-            CHF_CONST_FRA(bCoefFab[dir]),
-            CHF_BOX(curBox),
-            CHF_CONST_INT(dir),
-            CHF_CONST_REAL(scale));
-      }
+      lambdaFab.plus(m_faceCoefSum[dit], m_beta);
 
       // Take its reciprocal
       lambdaFab.invert(1.0);
@@ -326,7 +479,8 @@ void VCAMRPoissonOp2::computeLambda()
 
   // Define lambda
   m_lambda.define(m_aCoef->disjointBoxLayout(),m_aCoef->nComp());
-  resetLambda();
+  m_faceCoefSumNeedsResetting = true;
+  updateLambda();
 }
 
 #if 1
@@ -343,6 +497,7 @@ void VCAMRPoissonOp2::reflux(const LevelData<FArrayBox>&        a_phiFine,
 {
   CH_TIMERS("VCAMRPoissonOp2::reflux");
 
+  setNumComps(a_phi.nComp());
   m_levfluxreg.setToZero();
   Interval interv(0,a_phi.nComp()-1);
 
@@ -378,6 +533,7 @@ void VCAMRPoissonOp2::reflux(const LevelData<FArrayBox>&        a_phiFine,
   LevelData<FArrayBox>& phiFineRef = ( LevelData<FArrayBox>&)a_phiFine;
 
   VCAMRPoissonOp2* finerAMRPOp = (VCAMRPoissonOp2*) a_finerOp;
+  finerAMRPOp->setNumComps(a_phi.nComp());
   QuadCFInterp& quadCFI = finerAMRPOp->m_interpWithCoarser;
 
   quadCFI.coarseFineInterp(phiFineRef, a_phi);
@@ -470,6 +626,7 @@ void VCAMRPoissonOp2::reflux(const LevelData<FArrayBox>&        a_phiFine,
   // has to be its own object because the finer operator
   // owns an interpolator and we have no way of getting to it
   VCAMRPoissonOp2* finerAMRPOp = (VCAMRPoissonOp2*) a_finerOp;
+  finerAMRPOp->setNumComps(a_phi.nComp());
   QuadCFInterp& quadCFI = finerAMRPOp->m_interpWithCoarser;
 
   quadCFI.coarseFineInterp(p, a_phi);
@@ -544,8 +701,9 @@ void VCAMRPoissonOp2::reflux(const LevelData<FArrayBox>&        a_phiFine,
 
 #endif
 
-void VCAMRPoissonOp2::levelGSRB(LevelData<FArrayBox>&       a_phi,
-                               const LevelData<FArrayBox>& a_rhs)
+void VCAMRPoissonOp2::levelGSRBPass(LevelData<FArrayBox>&       a_phi,
+                                    const LevelData<FArrayBox>& a_rhs,
+                                    int                         a_whichPass)
 {
   CH_TIME("VCAMRPoissonOp2::levelGSRB");
 
@@ -555,75 +713,87 @@ void VCAMRPoissonOp2::levelGSRB(LevelData<FArrayBox>&       a_phi,
   CH_assert(a_phi.nComp() == a_rhs.nComp());
 
   // Recompute the relaxation coefficient if needed.
-  resetLambda();
+  updateLambda();
 
   const DisjointBoxLayout& dbl = a_phi.disjointBoxLayout();
 
   DataIterator dit = a_phi.dataIterator();
 
-  // do first red, then black passes
-  for (int whichPass = 0; whichPass <= 1; whichPass++)
-    {
-      CH_TIMERS("VCAMRPoissonOp2::levelGSRB::Compute");
-
-      // fill in intersection of ghostcells and a_phi's boxes
-      {
-        CH_TIME("VCAMRPoissonOp2::levelGSRB::homogeneousCFInterp");
-        homogeneousCFInterp(a_phi);
-      }
+  // fill in intersection of ghostcells and a_phi's boxes
+  {
+    CH_TIME("VCAMRPoissonOp2::levelGSRB::homogeneousCFInterp");
+    homogeneousCFInterp(a_phi);
+  }
 
-      {
-        CH_TIME("VCAMRPoissonOp2::levelGSRB::exchange");
-        a_phi.exchange(a_phi.interval(), m_exchangeCopier);
-      }
+  {
+    CH_TIME("VCAMRPoissonOp2::levelGSRB::exchange");
+    a_phi.exchange(a_phi.interval(), m_exchangeCopier);
+  }
 
+  {
+    CH_TIME("VCAMRPoissonOp2::levelGSRB::BCs");
+    // now step through grids...
+    for (dit.begin(); dit.ok(); ++dit)
       {
-        CH_TIME("VCAMRPoissonOp2::levelGSRB::BCs");
-        // now step through grids...
-        for (dit.begin(); dit.ok(); ++dit)
-          {
-            // invoke physical BC's where necessary
-            m_bc(a_phi[dit], dbl[dit()], m_domain, m_dx, true);
-          }
+        // invoke physical BC's where necessary
+        m_bc(a_phi[dit], dbl[dit()], m_domain, m_dx, true);
       }
+  }
 
-      for (dit.begin(); dit.ok(); ++dit)
-        {
-          const Box& region = dbl.get(dit());
-          const FluxBox& thisBCoef  = (*m_bCoef)[dit];
+  for (dit.begin(); dit.ok(); ++dit)
+    {
+      const Box& region = dbl.get(dit());
+      const FluxBox& thisBCoef  = (*m_bCoef)[dit];
 
 #if CH_SPACEDIM == 1
-          FORT_GSRBHELMHOLTZVC1D
+      FORT_GSRBHELMHOLTZVC1D
 #elif CH_SPACEDIM == 2
-          FORT_GSRBHELMHOLTZVC2D
+      FORT_GSRBHELMHOLTZVC2D
 #elif CH_SPACEDIM == 3
-          FORT_GSRBHELMHOLTZVC3D
+      FORT_GSRBHELMHOLTZVC3D
 #else
-          This_will_not_compile!
+      This_will_not_compile!
 #endif
-                                (CHF_FRA(a_phi[dit]),
-                                 CHF_CONST_FRA(a_rhs[dit]),
-                                 CHF_BOX(region),
-                                 CHF_CONST_REAL(m_dx),
-                                 CHF_CONST_REAL(m_alpha),
-                                 CHF_CONST_FRA((*m_aCoef)[dit]),
-                                 CHF_CONST_REAL(m_beta),
+                            (CHF_FRA(a_phi[dit]),
+                             CHF_CONST_FRA(a_rhs[dit]),
+                             CHF_BOX(region),
+                             CHF_CONST_REAL(m_dx),
+                             CHF_CONST_REAL(m_alpha),
+                             CHF_CONST_FRA((*m_aCoef)[dit]),
+                             CHF_CONST_REAL(m_beta),
 #if CH_SPACEDIM >= 1
-                                 CHF_CONST_FRA(thisBCoef[0]),
+                             CHF_CONST_FRA(thisBCoef[0]),
 #endif
 #if CH_SPACEDIM >= 2
-                                 CHF_CONST_FRA(thisBCoef[1]),
+                             CHF_CONST_FRA(thisBCoef[1]),
 #endif
 #if CH_SPACEDIM >= 3
-                                 CHF_CONST_FRA(thisBCoef[2]),
+                             CHF_CONST_FRA(thisBCoef[2]),
 #endif
 #if CH_SPACEDIM >= 4
-                                 This_will_not_compile!
+                             This_will_not_compile!
 #endif
-                                 CHF_CONST_FRA(m_lambda[dit]),
-                                 CHF_CONST_INT(whichPass));
-        } // end loop through grids
-    } // end loop through red-black
+                             CHF_CONST_FRA(m_lambda[dit]),
+                             CHF_CONST_INT(a_whichPass));
+    } // end loop through grids
+}
+
+void VCAMRPoissonOp2::levelGSRBFromZero(LevelData<FArrayBox>&       a_phi,
+                                        const LevelData<FArrayBox>& a_rhs)
+{
+  CH_TIME("VCAMRPoissonOp2::levelGSRBFromZero");
+
+  updateLambda();
+
+  // red cells get m_lambda*a_rhs, as GSRBHELMHOLTZVC gives from zero
+  setGhostToZero(a_phi);
+  const DisjointBoxLayout& dbl = a_phi.disjointBoxLayout();
+  for (DataIterator dit = a_phi.dataIterator(); dit.ok(); ++dit)
+    {
+      AMRPoissonOpKernels::gsrbFromZero(a_phi[dit], a_rhs[dit], m_lambda[dit], dbl[dit]);
+    }
+
+  levelGSRBPass(a_phi, a_rhs, 1);
 }
 
 void VCAMRPoissonOp2::levelMultiColor(LevelData<FArrayBox>&       a_phi,
@@ -648,7 +818,7 @@ void VCAMRPoissonOp2::looseGSRB(LevelData<FArrayBox>&       a_phi,
   CH_assert(a_phi.nComp() == a_rhs.nComp());
 
   // Recompute the relaxation coefficient if needed.
-  resetLambda();
+  updateLambda();
 
   const DisjointBoxLayout& dbl = a_phi.disjointBoxLayout();
 
@@ -766,7 +936,7 @@ void VCAMRPoissonOp2::levelJacobi(LevelData<FArrayBox>&       a_phi,
   CH_TIME("VCAMRPoissonOp2::levelJacobi");
 
   // Recompute the relaxation coefficient if needed.
-  resetLambda();
+  updateLambda();
 
   LevelData<FArrayBox> resid;
   create(resid, a_rhs);
@@ -778,13 +948,33 @@ void VCAMRPoissonOp2::levelJacobi(LevelData<FArrayBox>&       a_phi,
   DataIterator dit = m_lambda.dataIterator();
   for (dit.begin(); dit.ok(); ++dit)
   {
-    resid[dit].mult(m_lambda[dit]);
+    multLambda(resid[dit], m_lambda[dit], resid[dit].box());
   }
 
   // Do the Jacobi relaxation
   incr(a_phi, resid, 0.5);
 }
 
+void VCAMRPoissonOp2::levelGSRBDeep(LevelData<FArrayBox>&       a_phi,
+                                    const LevelData<FArrayBox>& a_rhs,
+                                    int                         a_sweeps)
+{
+  CH_TIME("VCAMRPoissonOp2::levelGSRBDeep");
+
+  for (int i = 0; i < a_sweeps; i++)
+    {
+      levelGSRB(a_phi, a_rhs);
+    }
+}
+
+void VCAMRPoissonOp2::levelChebyshev(LevelData<FArrayBox>&       a_phi,
+                                     const LevelData<FArrayBox>& a_rhs,
+                                     int                         a_degree)
+{
+  CH_TIME("VCAMRPoissonOp2::levelChebyshev");
+  MayDay::Abort("VCAMRPoissonOp2::levelChebyshev - Not implemented");
+}
+
 void VCAMRPoissonOp2::getFlux(FArrayBox&       a_flux,
                              const FArrayBox& a_data,
                              const FluxBox&   a_bCoef,
@@ -809,6 +999,8 @@ void VCAMRPoissonOp2::getFlux(FArrayBox&       a_flux,
 
   // reality check for bCoef
   CH_assert(bCoefDir.box().contains(a_facebox));
+  CH_assert(bCoefDir.nComp() == a_data.nComp() || bCoefDir.nComp() == 1);
+  const int lastCoefComp = bCoefDir.nComp() - 1;
 
   a_flux.resize(a_facebox, a_data.nComp());
   BoxIterator bit(a_facebox);
@@ -831,7 +1023,7 @@ void VCAMRPoissonOp2::getFlux(FArrayBox&       a_flux,
           Real philo = a_data(ivlo,ivar);
           Real gradphi = (phihi - philo ) * scale;
 
-          a_flux(iv,ivar) = -bCoefDir(iv, ivar) * gradphi;
+          a_flux(iv,ivar) = -bCoefDir(iv, Min(ivar, lastCoefComp)) * gradphi;
         }
     }
 }
@@ -851,15 +1043,13 @@ setTime(Real a_time)
       !m_bCoefInterpolator->dependsUponSolution())
     m_bCoefInterpolator->interpolate(*m_bCoef, a_time);
 
-  // Our relaxation parameter is officially out of date!
-  m_lambdaNeedsResetting = true;
-
   // Set the time on the boundary holder.
   m_bc.setTime(a_time);
 
-  // Notify our observers that the time has been set.
-  // FIXME: Must implement response of multigrid operators!
-  notifyObserversOfChange();
+  // The coefficients may have changed, by the interpolator or in place by
+  // the caller: the relaxation parameter is out of date, and our observers
+  // average the coefficients again.
+  resetCoefficients();
 }
 //-----------------------------------------------------------------------
 
@@ -1198,29 +1388,35 @@ finerOperatorChanged(const MGLevelOp<LevelData<FArrayBox> >& a_operator,
   const LevelData<FluxBox>& bcoefFine = *(op.m_bCoef);
   if (a_coarseningFactor != 1)
   {
-    CoarseAverage cellAverage(acoefFine.disjointBoxLayout(),
-                              acoefCoar.disjointBoxLayout(),
-                              1, a_coarseningFactor);
+    // The averaging operators only depend on the layouts, so they are
+    // built once and reused every time the finer operator changes.
+    if (m_coefCoarsening != a_coarseningFactor)
+    {
+      m_cellAverage = RefCountedPtr<CoarseAverage>(
+        new CoarseAverage(acoefFine.disjointBoxLayout(),
+                          acoefCoar.disjointBoxLayout(),
+                          acoefCoar.nComp(), a_coarseningFactor));
+      m_faceAverage = RefCountedPtr<CoarseAverageFace>(
+        new CoarseAverageFace(bcoefFine.disjointBoxLayout(),
+                              bcoefCoar.nComp(), a_coarseningFactor));
+      m_coefCoarsening = a_coarseningFactor;
+    }
+
     for (DataIterator dit = acoefCoar.disjointBoxLayout().dataIterator(); dit.ok(); ++dit)
       acoefCoar[dit()].setVal(0.);
-    cellAverage.averageToCoarse(acoefCoar, acoefFine);
+    m_cellAverage->averageToCoarse(acoefCoar, acoefFine);
 
-    CoarseAverageFace faceAverage(bcoefFine.disjointBoxLayout(),
-                                  1, a_coarseningFactor);
     for (DataIterator dit = bcoefCoar.disjointBoxLayout().dataIterator(); dit.ok(); ++dit)
       bcoefCoar[dit()].setVal(0.);
-    faceAverage.averageToCoarse(bcoefCoar, bcoefFine);
+    m_faceAverage->averageToCoarse(bcoefCoar, bcoefFine);
   }
 
   // Handle inter-box ghost cells.
   acoefCoar.exchange();
   bcoefCoar.exchange();
 
-  // Mark the relaxation coefficient dirty.
-  m_lambdaNeedsResetting = true;
-
-  // Notify any observers of this change.
-  notifyObserversOfChange();
+  // Mark the relaxation coefficient dirty and notify any observers.
+  resetCoefficients();
 }
 //-----------------------------------------------------------------------
 
@@ -1248,6 +1248,7 @@ define(const DisjointBoxLayout&                    a_grids,
 
   //define lambda, the relaxation coef
   m_relaxCoef.define(a_grids, SpaceDim,          IntVect::Zero);
+  m_faceCoefSum.define(a_grids, SpaceDim,        IntVect::Zero);
   m_grad.define(     a_grids, SpaceDim*SpaceDim, IntVect::Unit);
   DataIterator lit = a_grids.dataIterator();
   for (int idir = 0; idir < SpaceDim; idir++)
@@ -1274,40 +1275,52 @@ define(const DisjointBoxLayout&                    a_grids,
 
         }
     }
+  defineFaceCoefSum();
   defineRelCoef();
   m_levelOps.setToZero(m_grad);
 }
 void
 ViscousTensorOp::
-defineRelCoef()
+defineFaceCoefSum()
 {
+  CH_TIME("ViscousTensorOp::defineFaceCoefSum");
 
-  DisjointBoxLayout grids = m_relaxCoef.disjointBoxLayout();
+  Real one = 1.0;
+  DisjointBoxLayout grids = m_faceCoefSum.disjointBoxLayout();
   for (DataIterator dit(grids); dit.ok(); ++dit)
     {
       const Box& grid = grids.get(dit());
-      for (int ivar = 0; ivar < SpaceDim; ivar++)
-        {
-          int src = 0; int dst = ivar; int ncomp = 1;
-          m_relaxCoef[dit()].copy((*m_acoef)[dit()], src,dst,ncomp);
-        }
-      m_relaxCoef[dit()] *= m_alpha;
+      m_faceCoefSum[dit()].setVal(0.0);
       for (int idir = 0; idir < SpaceDim; idir++)
         {
-          FORT_DECRINVRELCOEFVTOP(CHF_FRA(m_relaxCoef[dit()]),
+          FORT_DECRINVRELCOEFVTOP(CHF_FRA(m_faceCoefSum[dit()]),
                                   CHF_FRA((*m_eta)[dit()][idir]),
                                   CHF_FRA((*m_lambda)[dit()][idir]),
-                                  CHF_CONST_REAL(m_beta),
+                                  CHF_CONST_REAL(one),
                                   CHF_BOX(grid),
                                   CHF_REAL(m_dx),
                                   CHF_INT(idir),
                                   CHF_INT(m_ncomp));
-#if 0
-          CH_assert(abs(m_relaxCoef[dit()].min(0)) > 1.0e-15
-                    && abs(m_relaxCoef[dit()].max(0)) > 1.0e-15);
-#endif
+        }
+    }
+}
+/***/
+void
+ViscousTensorOp::
+defineRelCoef()
+{
 
+  DisjointBoxLayout grids = m_relaxCoef.disjointBoxLayout();
+  for (DataIterator dit(grids); dit.ok(); ++dit)
+    {
+      const Box& grid = grids.get(dit());
+      for (int ivar = 0; ivar < SpaceDim; ivar++)
+        {
+          int src = 0; int dst = ivar; int ncomp = 1;
+          m_relaxCoef[dit()].copy((*m_acoef)[dit()], src,dst,ncomp);
         }
+      m_relaxCoef[dit()] *= m_alpha;
+      m_relaxCoef[dit()].plus(m_faceCoefSum[dit()], m_beta);
 
       //now invert so lambda = stable lambda for variable coef lapl
       //(according to phil, this is the correct lambda)
@@ -1321,6 +1334,35 @@ defineRelCoef()
 
     }
 }
+/***/
+void
+ViscousTensorOp::
+resetCoefficients()
+{
+  defineFaceCoefSum();
+  defineRelCoef();
+  notifyObserversOfChange();
+}
+/***/
+void
+ViscousTensorOp::
+finerOperatorChanged(const MGLevelOp<LevelData<FArrayBox> >& a_operator,
+                     int a_coarseningFactor)
+{
+  const ViscousTensorOp& op =
+    dynamic_cast<const ViscousTensorOp&>(a_operator);
+
+  // the operators at the top of a multigrid hierarchy share the
+  // coefficients of the AMR operators
+  if (a_coarseningFactor != 1)
+    {
+      coarsenStuff(*m_eta, *m_lambda, *m_acoef,
+                   *op.m_eta, *op.m_lambda, *op.m_acoef,
+                   a_coarseningFactor,
+                   ViscousTensorOpFactory::s_coefficientAverageType);
+    }
+  resetCoefficients();
+}
 
 /***/
 ViscousTensorOpFactory::
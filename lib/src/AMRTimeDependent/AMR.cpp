@@ -99,6 +99,9 @@ void AMR::setDefaultValues()
   m_dt_tolerance_factor = 1.1;
   m_fixedDt = -1;
   m_blockFactor = 4;
+  m_lbMode = LB_GREEDY;
+  m_lbMeasuredCost = false;
+  m_lbWarned = false;
 #ifdef CH_USE_TIMER
   m_timer = NULL ;
 #endif
@@ -186,6 +189,27 @@ void AMR::gridBufferSize(int a_grid_buffer_size)
 }
 //-----------------------------------------------------------------------
 
+//-----------------------------------------------------------------------
+void AMR::distributedTags(bool a_distributed)
+{
+  m_mesh_refine_ptr->setDistributedTags(a_distributed);
+}
+//-----------------------------------------------------------------------
+
+//-----------------------------------------------------------------------
+void AMR::loadBalanceMode(LoadBalanceMode a_mode)
+{
+  m_lbMode = a_mode;
+}
+//-----------------------------------------------------------------------
+
+//-----------------------------------------------------------------------
+void AMR::loadBalanceOnMeasuredCost(bool a_useMeasuredCost)
+{
+  m_lbMeasuredCost = a_useMeasuredCost;
+}
+//-----------------------------------------------------------------------
+
 //-----------------------------------------------------------------------
 int AMR::maxGridSize() const
 {
@@ -444,10 +468,12 @@ void AMR::setupForFixedHierarchyRun(const Vector<Vector<Box> >& a_amr_grids,
 
   {
     CH_TIME("Initialize");
+    assignHierarchyProcs(m_amr_grids, 0);
     for (int level = 0; level <= m_finest_level; ++level)
       {
         m_amrlevels[level]->initialGrid(m_amr_grids[level]);
       }
+    checkHierarchyProcs(0, m_finest_level);
     for (int level = m_finest_level; level >= 0; --level)
       {
         m_amrlevels[level]->postInitialGrid(false);
@@ -1452,10 +1478,29 @@ void AMR::regrid(int a_base_level)
       m_amrlevels[level]->preRegrid(a_base_level, new_grids);
     }
 
+  if (m_lbMode != LB_GREEDY || m_lbMeasuredCost)
+    {
+      Vector<Vector<Box> > hierarchy(m_finest_level+1);
+      for (int level = 0; level <= m_finest_level; ++level)
+        {
+          hierarchy[level] = (level > a_base_level) ? new_grids[level]
+                                                    : m_amrlevels[level]->boxes();
+        }
+      assignHierarchyProcs(hierarchy, a_base_level+1);
+    }
+
   for (int level = a_base_level + 1; level <= m_finest_level; ++level)
     {
       m_amrlevels[level]->regrid(new_grids[level]);
     }
+  checkHierarchyProcs(a_base_level + 1, m_finest_level);
+
+  // the next regrid balances on what is measured from now on, also on the
+  // levels this one kept, so old costs do not pile up
+  for (int level = 0; level <= m_max_level; ++level)
+    {
+      m_amrlevels[level]->clearMeasuredCosts();
+    }
 
   for (int level = m_finest_level + 1; level <= m_max_level; ++level)
     {
@@ -1503,6 +1548,112 @@ Real AMR::getCurrentTime() const
 }
 //-----------------------------------------------------------------------
 
+//-----------------------------------------------------------------------
+void AMR::assignHierarchyProcs(const Vector<Vector<Box> >& a_grids,
+                               int                         a_numFixedLevels)
+{
+  if (m_lbMode == LB_GREEDY && !m_lbMeasuredCost) return;
+  CH_TIME("AMR::assignHierarchyProcs");
+
+  int numLevels = Min((int)a_grids.size(), m_finest_level+1);
+  Vector<Vector<Box> > grids(numLevels);
+  Vector<Vector<long> > loads(numLevels);
+  Vector<int> refRatios(numLevels);
+  Vector<Vector<int> > procs(numLevels);
+  for (int level = 0; level < numLevels; ++level)
+    {
+      grids[level] = a_grids[level];
+      refRatios[level] = m_amrlevels[level]->refRatio();
+      if (level < a_numFixedLevels)
+        {
+          // kept as they are; only their processors matter
+          loads[level].resize(grids[level].size(), 1);
+          m_amrlevels[level]->procIDs(procs[level]);
+        }
+      else
+        {
+          measuredLoads(loads[level], grids[level], level);
+        }
+    }
+
+  // every rank computes the same assignment, so no broadcast is needed
+  Real effRatio;
+  long long edgeCut;
+  int status = LoadBalance(procs, effRatio, edgeCut, grids, loads, refRatios,
+                           m_lbMode, 1, numProc(), a_numFixedLevels);
+  if (status != 0)
+    {
+      MayDay::Error("AMR::assignHierarchyProcs: LoadBalance failed");
+    }
+
+  if (m_verbosity >= 2)
+    {
+      pout() << "AMR::assignHierarchyProcs: efficiency ratio = " << effRatio
+             << ", edge cut = " << edgeCut << " cells" << endl;
+    }
+
+  for (int level = a_numFixedLevels; level < numLevels; ++level)
+    {
+      m_amrlevels[level]->hierarchyProcs(grids[level], procs[level]);
+    }
+}
+//-----------------------------------------------------------------------
+
+//-----------------------------------------------------------------------
+void AMR::checkHierarchyProcs(int a_firstLevel,
+                              int a_lastLevel)
+{
+  if ((m_lbMode == LB_GREEDY && !m_lbMeasuredCost) || m_lbWarned) return;
+
+  for (int level = a_firstLevel; level <= a_lastLevel; ++level)
+    {
+      // a level may balance on one processor and broadcast the result
+      int used = m_amrlevels[level]->usedHierarchyProcs() ? 1 : 0;
+#ifdef CH_MPI
+      int localUsed = used;
+      MPI_Allreduce(&localUsed, &used, 1, MPI_INT, MPI_MAX, Chombo_MPI::comm);
+#endif
+      if (used == 0)
+        {
+          char msg[256];
+          sprintf(msg, "AMR: level %d does not assign its processors with "
+                  "AMRLevel::loadBalanceGrids(), so loadBalanceMode() and "
+                  "loadBalanceOnMeasuredCost() have no effect on it", level);
+          MayDay::Warning(msg);
+          m_lbWarned = true;
+          return;
+        }
+    }
+}
+//-----------------------------------------------------------------------
+
+//-----------------------------------------------------------------------
+void AMR::measuredLoads(Vector<long>&      a_loads,
+                        const Vector<Box>& a_grids,
+                        int                a_level) const
+{
+  const AMRLevel& amrLevel = *m_amrlevels[a_level];
+  if (!m_lbMeasuredCost || amrLevel.measuredCostBoxes().size() == 0)
+    {
+      a_loads.resize(a_grids.size());
+      for (int i = 0; i < a_grids.size(); ++i)
+        {
+          a_loads[i] = a_grids[i].numPts();
+        }
+      return;
+    }
+
+  // each processor only timed its own boxes
+  Vector<unsigned long long> costs = amrLevel.measuredCosts();
+#ifdef CH_MPI
+  Vector<unsigned long long> localCosts = costs;
+  MPI_Allreduce(&(localCosts[0]), &(costs[0]), costs.size(),
+                MPI_UNSIGNED_LONG_LONG, MPI_SUM, Chombo_MPI::comm);
+#endif
+  LoadBalanceMeasuredLoads(a_loads, a_grids, amrLevel.measuredCostBoxes(), costs);
+}
+//-----------------------------------------------------------------------
+
 //-----------------------------------------------------------------------
 void AMR::makeBaseLevelMesh(Vector<Box>& a_grids) const
 {
@@ -1614,10 +1765,12 @@ void AMR::initialGrid()
           // computing initial velocity from initial
           // vorticity through a multilevel elliptic solve)
           // DFM(11/28/2000)
+          assignHierarchyProcs(old_grids, 0);
           for (int level = 0; level <= top_level; ++level)
             {
               m_amrlevels[level]->initialGrid(old_grids[level]);
             }
+          checkHierarchyProcs(0, top_level);
 
           for (int level = top_level; level >= 0; --level)
             {
@@ -1715,10 +1868,12 @@ void AMR::initialGrid()
   // to ensure that hierarchy is defined before we do initialization
   // (for case where initialization is a multilevel operatation)
   // (dfm 11/7/02)
+  assignHierarchyProcs(new_grids, 0);
   for (int level = 0; level <= m_finest_level; ++level)
     {
       m_amrlevels[level]->initialGrid(new_grids[level]);
     }
+  checkHierarchyProcs(0, m_finest_level);
 
   for (int level = m_finest_level; level >= 0; --level)
     {
@@ -9,6 +9,7 @@
 #endif
 
 #include <iostream>
+#include <map>
 using std::cout;
 using std::cin;
 using std::cerr;
@@ -18,6 +19,7 @@ using std::endl;
 #include "Vector.H"
 #include "LayoutIterator.H"
 #include "parstream.H"
+#include "LoadBalance.H"
 
 #include "AMRLevel.H"
 #include "NamespaceHeader.H"
@@ -47,6 +49,7 @@ AMRLevel::AMRLevel()
   m_time = 0;
   m_dt = 0;
   m_initial_dt_multiplier = 0.1;
+  m_hierarchy_procs_used = true;
 }
 //-----------------------------------------------------------------------
 
@@ -117,6 +120,135 @@ Vector<Box> AMRLevel::boxes() const
 }
 //-----------------------------------------------------------------------
 
+//-----------------------------------------------------------------------
+void AMRLevel::hierarchyProcs(const Vector<Box>& a_grids,
+                              const Vector<int>& a_procs)
+{
+  CH_assert(a_grids.size() == a_procs.size());
+  m_hierarchy_grids = a_grids;
+  m_hierarchy_procs = a_procs;
+  m_hierarchy_procs_used = (a_grids.size() == 0);
+}
+//-----------------------------------------------------------------------
+
+//-----------------------------------------------------------------------
+void AMRLevel::loadBalanceGrids(Vector<int>&       a_procs,
+                                const Vector<Box>& a_grids) const
+{
+  bool same = (a_grids.size() == m_hierarchy_grids.size()) && (a_grids.size() > 0);
+  if (same)
+    {
+      // levels may reorder their boxes (e.g. mortonOrdering) before asking
+      std::map<Box, int> procOf;
+      for (int i = 0; i < m_hierarchy_grids.size(); ++i)
+        {
+          procOf[m_hierarchy_grids[i]] = m_hierarchy_procs[i];
+        }
+      a_procs.resize(a_grids.size());
+      for (int i = 0; same && i < a_grids.size(); ++i)
+        {
+          std::map<Box, int>::const_iterator it = procOf.find(a_grids[i]);
+          same = (it != procOf.end());
+          if (same) a_procs[i] = it->second;
+        }
+    }
+  if (same)
+    {
+      m_hierarchy_procs_used = true;
+    }
+  else
+    {
+      LoadBalance(a_procs, a_grids);
+    }
+  m_balanced_grids = a_grids;
+  m_balanced_procs = a_procs;
+}
+//-----------------------------------------------------------------------
+
+//-----------------------------------------------------------------------
+void AMRLevel::procIDs(Vector<int>& a_procs) const
+{
+  std::map<Box, int> procOf;
+  for (int i = 0; i < m_balanced_grids.size(); ++i)
+    {
+      procOf[m_balanced_grids[i]] = m_balanced_procs[i];
+    }
+  a_procs.resize(m_level_grids.size());
+  for (int i = 0; i < m_level_grids.size(); ++i)
+    {
+      std::map<Box, int>::const_iterator it = procOf.find(m_level_grids[i]);
+      if (it == procOf.end())
+        {
+          LoadBalance(a_procs, m_level_grids);
+          return;
+        }
+      a_procs[i] = it->second;
+    }
+}
+//-----------------------------------------------------------------------
+
+//-----------------------------------------------------------------------
+bool AMRLevel::usedHierarchyProcs() const
+{
+  return m_hierarchy_procs_used;
+}
+//-----------------------------------------------------------------------
+
+//-----------------------------------------------------------------------
+void AMRLevel::measuredCosts(const Vector<Box>&                a_boxes,
+                             const Vector<unsigned long long>& a_costs)
+{
+  CH_assert(a_boxes.size() == a_costs.size());
+  bool same = (a_boxes.size() == m_cost_boxes.size());
+  for (int i = 0; same && i < a_boxes.size(); ++i)
+    {
+      same = (a_boxes[i] == m_cost_boxes[i]);
+    }
+  if (same)
+    {
+      for (int i = 0; i < a_costs.size(); ++i)
+        {
+          m_costs[i] += a_costs[i];
+        }
+    }
+  else
+    {
+      m_cost_boxes = a_boxes;
+      m_costs      = a_costs;
+    }
+}
+//-----------------------------------------------------------------------
+
+//-----------------------------------------------------------------------
+void AMRLevel::measuredCosts(TimedDataIterator& a_dit)
+{
+  measuredCosts(a_dit.getBoxes(), a_dit.getTime());
+  a_dit.clearTime();
+}
+//-----------------------------------------------------------------------
+
+//-----------------------------------------------------------------------
+const Vector<Box>& AMRLevel::measuredCostBoxes() const
+{
+  return m_cost_boxes;
+}
+//-----------------------------------------------------------------------
+
+//-----------------------------------------------------------------------
+const Vector<unsigned long long>& AMRLevel::measuredCosts() const
+{
+  return m_costs;
+}
+//-----------------------------------------------------------------------
+
+//-----------------------------------------------------------------------
+void AMRLevel::clearMeasuredCosts()
+{
+  m_cost_boxes.resize(0);
+  m_costs.resize(0);
+}
+//-----------------------------------------------------------------------
+
 //-----------------------------------------------------------------------
 bool AMRLevel::hasCoarserLevel() const
 {
@@ -15,16 +15,50 @@
 #include "PhysIBC.H"
 #include "LoHiSide.H"
 #include "CH_Timer.H"
+#include "CH_Thread.H"
 
 #include "LevelGodunov.H"
 
 #include "NamespaceHeader.H"
 
+// Threads of the task loop of step() that may drive the MPI progress of the
+// ghost cell exchange, from the thread support MPI was initialized with
+enum ProgressThreads
+{
+  // MPI_THREAD_SINGLE: the exchange completes before the tasks start
+  NoProgressThread,
+  // MPI_THREAD_FUNNELED: the master thread only
+  MasterProgressThread,
+  // MPI_THREAD_SERIALIZED or more, or no MPI: any thread, one at a time
+  AnyProgressThread
+};
+
+static ProgressThreads progressThreads()
+{
+#ifdef CH_MPI
+  int provided = MPI_THREAD_SINGLE;
+  MPI_Query_thread(&provided);
+  if (provided >= MPI_THREAD_SERIALIZED)
+    {
+      return AnyProgressThread;
+    }
+  if (provided == MPI_THREAD_FUNNELED)
+    {
+      return MasterProgressThread;
+    }
+  return NoProgressThread;
+#else
+  return AnyProgressThread;
+#endif
+}
+
 // Constructor - set up some defaults
 LevelGodunov::LevelGodunov()
 {
   m_dx           = 0.0;
   m_refineCoarse = 0;
+  m_taskScheduling = false;
+  m_numLocalGhostTasks = 0;
   m_isDefined    = false;
 }
 
@@ -121,6 +155,33 @@ void LevelGodunov::define(const DisjointBoxLayout&    a_thisDisjointBoxLayout,
   m_exchangeCopier.exchangeDefine(a_thisDisjointBoxLayout,
                                   m_numGhost*IntVect::Unit);
 
+  // Task order for taskScheduling(): patches that receive ghost cells from
+  // other processors go last
+  {
+    DataIterator dit = m_grids.dataIterator();
+    int nbox = dit.size();
+    LayoutData<bool> remoteGhosts(m_grids);
+    for (int ibox = 0; ibox < nbox; ibox++)
+      {
+        remoteGhosts[dit[ibox]] = false;
+      }
+    CopyIterator toIt(m_exchangeCopier, CopyIterator::TO);
+    for (int i = 0; i < toIt.size(); i++)
+      {
+        remoteGhosts[toIt[i].toIndex] = true;
+      }
+    m_taskOrder.resize(0);
+    for (int ibox = 0; ibox < nbox; ibox++)
+      {
+        if (!remoteGhosts[dit[ibox]]) m_taskOrder.push_back(ibox);
+      }
+    m_numLocalGhostTasks = m_taskOrder.size();
+    for (int ibox = 0; ibox < nbox; ibox++)
+      {
+        if (remoteGhosts[dit[ibox]]) m_taskOrder.push_back(ibox);
+      }
+  }
+
   // Setup an interval corresponding to the conserved variables
   Interval UInterval(0,m_numCons-1);
 
@@ -200,7 +261,15 @@ Real LevelGodunov::step(LevelData<FArrayBox>&       a_U,
       } //end data iterator loop
 
   }//end pragma
-  m_U.exchange(m_exchangeCopier);
+  if (m_taskScheduling)
+    {
+      // completed by the patch update tasks below
+      m_U.exchangeBegin(m_exchangeCopier);
+    }
+  else
+    {
+      m_U.exchange(m_exchangeCopier);
+    }
   
   
   // Fill m_U's ghost cells using fillInterp
@@ -255,79 +324,87 @@ Real LevelGodunov::step(LevelData<FArrayBox>&       a_U,
   CH_STOP(timeSetup);
   //  return 0;
   Vector<Real> speeds(m_grids.size(), 0);
-#pragma omp parallel  default (shared)
-  {
-    int nbox = dit.size();
-#pragma omp for 
-    for(int ibox = 0; ibox < nbox; ibox++)
-      {
-	//	CH_START(timeUpdate);
-	FArrayBox zeroSource;
-	//AD: work on this section later
-      // The current box
-      const Box& curBox = m_grids.get(dit[ibox]);
-
-      // The current grid of conserved variables
-      FArrayBox& curU = m_U[dit[ibox]];
-
-      // The current source terms if they exist
-      const FArrayBox* source = &zeroSource;
-      if (a_S.isDefined())
-        {
-          source = &a_S[dit[ibox]];
-        }
-
-      // The fluxes computed for this grid - used for refluxing and returning
-      // other face centered quantities
-      FluxBox flux;
-
-
-      Real maxWaveSpeedGrid;
-
-      // Update the current grid's conserved variables, return the final
-      // fluxes used for this, and the maximum wave speed for this grid
-      m_patchGodunov[dit[ibox]].setCurrentTime(a_time);
-      m_patchGodunov[dit[ibox]].updateState(curU,
-                                 flux,
-                                 maxWaveSpeedGrid,
-                                 *source,
-                                 a_dt,
-                                 curBox);
-
-      // Clamp away from zero
-           speeds[ibox]=maxWaveSpeedGrid;
-           maxWaveSpeed = Max(maxWaveSpeed,maxWaveSpeedGrid);
-
-      //      CH_STOP(timeUpdate);
-
-      //CH_START(timeReflux);
-
-      // Do flux register updates
-      for (int idir = 0; idir < SpaceDim; idir++)
+  int nbox = dit.size();
+  if (m_taskScheduling)
+    {
+      // The first m_numLocalGhostTasks tasks can start at once; the others
+      // wait until a thread allowed to call MPI sees the exchange complete
+      // and finishes it.  The critical section serializes the MPI calls.
+      ProgressThreads progress = progressThreads();
+      bool ghostsFilled = false;
+      if (progress == NoProgressThread)
         {
-          // Increment coarse flux register between this level and the next
-          // finer level - this level is the next coarser level with respect
-          // to the next finer level
-          if (m_hasFiner)
+          static bool s_warned = false;
+          if (!s_warned)
             {
-              a_finerFluxRegister.incrementCoarse(flux[idir],a_dt,dit[ibox],
-                                                  UInterval,
-                                                  UInterval,idir);
+              MayDay::Warning("LevelGodunov::step: task scheduling needs MPI "
+                              "initialized with MPI_Init_thread and at least "
+                              "MPI_THREAD_FUNNELED to overlap the exchange");
+              s_warned = true;
             }
-
-          // Increment fine flux registers between this level and the next
-          // coarser level - this level is the next finer level with respect
-          // to the next coarser level
-          if (m_hasCoarser)
+          m_U.exchangeEnd();
+          ghostsFilled = true;
+        }
+      int nextTask = 0;
+#pragma omp parallel default (shared)
+      {
+        bool mayProgress = (progress == AnyProgressThread) ||
+          (progress == MasterProgressThread && onThread0());
+        while (true)
+          {
+            int itask = -1;
+            bool mustWait = false;
+#pragma omp critical (LevelGodunov_step)
             {
-              a_coarserFluxRegister.incrementFine(flux[idir],a_dt,dit[ibox],
-                                                  UInterval,
-                                                  UInterval,idir);
+              if (!ghostsFilled && mayProgress && m_U.exchangeProgress())
+                {
+                  m_U.exchangeEnd();
+                  ghostsFilled = true;
+                }
+              if (nextTask < nbox)
+                {
+                  mustWait = (nextTask >= m_numLocalGhostTasks && !ghostsFilled);
+                  if (!mustWait)
+                    {
+                      itask = nextTask++;
+                    }
+                }
             }
+            if (itask >= 0)
+              {
+                int ibox = m_taskOrder[itask];
+                speeds[ibox] = updatePatch(dit[ibox],
+                                           a_finerFluxRegister,
+                                           a_coarserFluxRegister,
+                                           a_S, a_time, a_dt);
+              }
+            else if (!mustWait)
+              {
+                break;
+              }
+            else
+              {
+                threadYield();
+              }
+          }
+      }//end pragma
+      if (!ghostsFilled)
+        {
+          // nothing waited on the exchange, but our sends must complete
+          m_U.exchangeEnd();
         }
-      //CH_STOP(timeReflux);
-      }
-  }
+    }
+  else
+    {
+#pragma omp parallel for
+      for(int ibox = 0; ibox < nbox; ibox++)
+        {
+          speeds[ibox] = updatePatch(dit[ibox],
+                                     a_finerFluxRegister,
+                                     a_coarserFluxRegister,
+                                     a_S, a_time, a_dt);
+        }
+    }
   for(int ibox = 0; ibox < speeds.size(); ibox++)
     {
       maxWaveSpeed = Max(maxWaveSpeed, speeds[ibox]);
@@ -701,6 +778,77 @@ Real LevelGodunov::getMaxWaveSpeed(const LevelData<FArrayBox>& a_U)
   return speed;
 }
 
+void LevelGodunov::taskScheduling(bool a_taskScheduling)
+{
+  m_taskScheduling = a_taskScheduling;
+}
+
+Real LevelGodunov::updatePatch(const DataIndex&            a_index,
+                               LevelFluxRegister&          a_finerFluxRegister,
+                               LevelFluxRegister&          a_coarserFluxRegister,
+                               const LevelData<FArrayBox>& a_S,
+                               const Real&                 a_time,
+                               const Real&                 a_dt)
+{
+  Interval UInterval(0,m_numCons-1);
+  FArrayBox zeroSource;
+
+  // The current box
+  const Box& curBox = m_grids.get(a_index);
+
+  // The current grid of conserved variables
+  FArrayBox& curU = m_U[a_index];
+
+  // The current source terms if they exist
+  const FArrayBox* source = &zeroSource;
+  if (a_S.isDefined())
+    {
+      source = &a_S[a_index];
+    }
+
+  // The fluxes computed for this grid - used for refluxing and returning
+  // other face centered quantities
+  FluxBox flux;
+
+  Real maxWaveSpeedGrid;
+
+  // Update the current grid's conserved variables, return the final
+  // fluxes used for this, and the maximum wave speed for this grid
+  m_patchGodunov[a_index].setCurrentTime(a_time);
+  m_patchGodunov[a_index].updateState(curU,
+                                      flux,
+                                      maxWaveSpeedGrid,
+                                      *source,
+                                      a_dt,
+                                      curBox);
+
+  // Do flux register updates
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      // Increment coarse flux register between this level and the next
+      // finer level - this level is the next coarser level with respect
+      // to the next finer level
+      if (m_hasFiner)
+        {
+          a_finerFluxRegister.incrementCoarse(flux[idir],a_dt,a_index,
+                                              UInterval,
+                                              UInterval,idir);
+        }
+
+      // Increment fine flux registers between this level and the next
+      // coarser level - this level is the next finer level with respect
+      // to the next coarser level
+      if (m_hasCoarser)
+        {
+          a_coarserFluxRegister.incrementFine(flux[idir],a_dt,a_index,
+                                              UInterval,
+                                              UInterval,idir);
+        }
+    }
+
+  return maxWaveSpeedGrid;
+}
+
 void LevelGodunov::highOrderLimiter(bool a_highOrderLimiter)
 {
   CH_assert(m_isDefined);
@@ -17,6 +17,7 @@
 #include "ProblemDomain.H"
 #include "NeighborIterator.H"
 #include "DisjointBoxLayout.H"
+#include "BoxBinIndex.H"
 #include "NamespaceHeader.H"
 
 //--Definitions for static member data
@@ -358,6 +359,53 @@ void CFIVS::define(const ProblemDomain&     a_domain,
 
   packIVS();
 }
+
+//-----------------------------------------------------------------------
+void CFIVS::define(const ProblemDomain&     a_domain,
+                   const Box&               a_boxIn,
+                   const BoxBinIndex&       a_periodicFineIndex,
+                   int                      a_direction,
+                   Side::LoHiSide           a_hiorlo)
+{
+  CH_TIME("CFIVS::define(indexed)");
+  m_defined = true;
+
+  CH_assert(a_direction >= 0);
+  CH_assert(a_direction < SpaceDim);
+  CH_assert(!a_domain.isEmpty());
+  CH_assert(a_domain.contains(a_boxIn));
+  CH_assert((a_hiorlo == Side::Lo) || (a_hiorlo == Side::Hi));
+
+  // create fine stencil
+  Box edgebox;
+
+  if (a_hiorlo == Side::Lo)
+    {
+      edgebox = adjCellLo(a_boxIn,a_direction,1);
+    }
+  else
+    {
+      edgebox = adjCellHi(a_boxIn,a_direction,1);
+    }
+
+  edgebox &= a_domain;
+
+  if (edgebox.isEmpty())
+    {
+      m_packed = false;
+      return;
+    }
+
+  m_IVS.define(edgebox);
+  Vector<int> ids;
+  a_periodicFineIndex.intersecting(ids, edgebox);
+  for (int i=0; i<ids.size(); ++i)
+    {
+      m_IVS -= a_periodicFineIndex.box(ids[i]);
+    }
+
+  packIVS();
+}
 //-----------------------------------------------------------------------
 
 //-----------------------------------------------------------------------
@@ -10,6 +10,7 @@
 
 #include "CFRegion.H"
 #include "CFStencil.H"
+#include "BoxBinIndex.H"
 #include "NamespaceHeader.H"
 
 void
@@ -18,6 +19,7 @@ CFRegion::define(const DisjointBoxLayout& a_grids,
 {
   Vector<Box> periodicBoxes;
   CFStencil::buildPeriodicVector(periodicBoxes, a_domain, a_grids);
+  BoxBinIndex periodicIndex(periodicBoxes);
   for (int i=0; i<CH_SPACEDIM; ++i)
     {
       LayoutData<CFIVS>& lo =  m_loCFIVS[i];
@@ -28,8 +30,8 @@ CFRegion::define(const DisjointBoxLayout& a_grids,
         {
 //          lo[dit].define(a_domain, dit(), a_grids, i, Side::Lo);
 //          hi[dit].define(a_domain, dit(), a_grids, i, Side::Hi);
-          lo[dit].define(a_domain, a_grids.get(dit), periodicBoxes, i, Side::Lo);
-          hi[dit].define(a_domain, a_grids.get(dit), periodicBoxes, i, Side::Hi);
+          lo[dit].define(a_domain, a_grids.get(dit), periodicIndex, i, Side::Lo);
+          hi[dit].define(a_domain, a_grids.get(dit), periodicIndex, i, Side::Hi);
         }
     }
   m_defined=true;
@@ -894,6 +894,7 @@ void CornerCopier::define(const BoxLayout& a_level,
     } // end if any of the "From" boxes were outside the domain
 
   } // end if we need to do anything for periodicity
+  defineLocalDestinations();
 }
 
 
@@ -13,11 +13,15 @@
 #include "CH_assert.H"
 #include <cstdlib>
 #include <cstring>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
 using std::pair;
 #include "parstream.H"
 #include "memusage.H"
 //#include "memtrack.H"
 #include "Arena.H"
+#include "CH_Thread.H"
 #include "MayDay.H"
 #include "BaseNamespaceHeader.H"
 
@@ -65,6 +69,35 @@ Arena::~Arena()
 #endif
 }
 
+#ifdef CH_USE_MEMORY_TRACKING
+void Arena::addBytes(long int a_bytes)
+{
+  // BaseFabs are allocated and freed by several threads (see BoxLayoutData)
+  long int current;
+#pragma omp atomic capture
+  {
+    bytes += a_bytes;
+    current = bytes;
+  }
+  CH_assert(current >= 0);
+
+  long int lastPeak;
+#pragma omp atomic read
+  lastPeak = peak;
+  if (current > lastPeak)
+  {
+#pragma omp critical (Arena_peak)
+    {
+      if (current > peak)
+      {
+#pragma omp atomic write
+        peak = current;
+      }
+    }
+  }
+}
+#endif
+
 BArena::BArena(const char* a_name)
 {
 #ifdef CH_USE_MEMORY_TRACKING
@@ -110,6 +143,215 @@ void BArena::free(void* a_pt)
   ::free(a_pt);
 }
 
+PArena::PArena(const char* a_name,
+               size_t      a_maxCached)
+  :
+  m_maxCached(a_maxCached),
+  m_firstTouch(false),
+  m_hugePageBytes(0)
+{
+#ifdef CH_USE_MEMORY_TRACKING
+  strncpy(name_, a_name, NSIZE);
+  name_[NSIZE-1]=0;
+#endif
+  int numThreads = 1;
+#ifdef _OPENMP
+  numThreads = omp_get_max_threads();
+  if (omp_get_num_procs() > numThreads)
+    {
+      numThreads = omp_get_num_procs();
+    }
+#endif
+  m_threads.resize(numThreads);
+}
+
+PArena::~PArena()
+{
+  release();
+}
+
+size_t PArena::headerSize()
+{
+  return ClassSize;
+}
+
+PArena::ThreadCache* PArena::threadCache()
+{
+  unsigned int thread = threadNumber();
+  if (thread < m_threads.size())
+    {
+      return &m_threads[thread];
+    }
+  return NULL;
+}
+
+void* PArena::alloc(size_t a_sz)
+{
+  size_t sz = (a_sz == 0 ? 1 : a_sz);
+  sz = ((sz + ClassSize - 1)/ClassSize)*ClassSize;
+
+  // only the calling thread touches its cache, so no lock is needed
+  char* block = NULL;
+  ThreadCache* cache = threadCache();
+  if (cache != NULL)
+    {
+      cache->m_numAllocs++;
+      std::multimap<size_t, void*>::iterator it = cache->m_blocks.lower_bound(sz);
+      if (it != cache->m_blocks.end() && it->first <= sz + sz/8)
+        {
+          block = static_cast<char*>(it->second);
+          cache->m_cachedBytes -= it->first;
+          cache->m_blocks.erase(it);
+        }
+      else
+        {
+          cache->m_numHeapAllocs++;
+        }
+    }
+
+  if (block == NULL)
+    {
+      block = heapBlock(sz);
+      reinterpret_cast<size_t*>(block)[0] = sz;
+      reinterpret_cast<size_t*>(block)[1] = threadNumber();
+    }
+
+  return block + headerSize();
+}
+
+char* PArena::heapBlock(size_t a_sz)
+{
+  size_t nbytes = headerSize() + a_sz;
+  void* block = NULL;
+  if (m_hugePageBytes > 0 && a_sz >= m_hugePageBytes)
+    {
+      nbytes = ((nbytes + HugePageSize - 1)/HugePageSize)*HugePageSize;
+      if (posix_memalign(&block, HugePageSize, nbytes) != 0)
+        {
+          block = NULL;
+        }
+#ifdef MADV_HUGEPAGE
+      else
+        {
+          // only advice; the kernel may still use small pages
+          madvise(block, nbytes, MADV_HUGEPAGE);
+        }
+#endif
+    }
+  else if (posix_memalign(&block, ClassSize, nbytes) != 0)
+    {
+      block = NULL;
+    }
+
+  if (block == NULL)
+    {
+      print_memory_line("Out of memory");
+      pout() << " Trying to allocate " << nbytes << " bytes in PArena::alloc()" << std::endl;
+      MayDay::Error("Out of memory in PArena::alloc (BaseFab) ");
+    }
+
+  if (m_firstTouch)
+    {
+      // one write per (small) page places the whole page
+      char* bytes = static_cast<char*>(block);
+      for (size_t i = 0; i < nbytes; i += 4096)
+        {
+          bytes[i] = 0;
+        }
+    }
+
+  return static_cast<char*>(block);
+}
+
+void PArena::free(void* a_pt)
+{
+  if (a_pt == NULL)
+    {
+      return;
+    }
+
+  char* block = static_cast<char*>(a_pt) - headerSize();
+  size_t sz = reinterpret_cast<size_t*>(block)[0];
+  size_t thread = reinterpret_cast<size_t*>(block)[1];
+  ThreadCache* cache = threadCache();
+  // under first touch, a block is only local to the thread that allocated it
+  if (cache == NULL || (m_firstTouch && thread != (size_t)threadNumber()))
+    {
+      ::free(block);
+      return;
+    }
+
+  cache->m_blocks.insert(std::pair<const size_t, void*>(sz, block));
+  cache->m_cachedBytes += sz;
+  trim(*cache);
+}
+
+void PArena::release()
+{
+  for (unsigned int ithread = 0; ithread < m_threads.size(); ithread++)
+    {
+      ThreadCache& cache = m_threads[ithread];
+      std::multimap<size_t, void*>::iterator it;
+      for (it = cache.m_blocks.begin(); it != cache.m_blocks.end(); ++it)
+        {
+          ::free(it->second);
+        }
+      cache.m_blocks.clear();
+      cache.m_cachedBytes = 0;
+    }
+}
+
+void PArena::maxCached(size_t a_maxCached)
+{
+  m_maxCached = a_maxCached;
+  for (unsigned int ithread = 0; ithread < m_threads.size(); ithread++)
+    {
+      trim(m_threads[ithread]);
+    }
+}
+
+long PArena::numAllocs() const
+{
+  long numAllocs = 0;
+  for (unsigned int ithread = 0; ithread < m_threads.size(); ithread++)
+    {
+      numAllocs += m_threads[ithread].m_numAllocs;
+    }
+  return numAllocs;
+}
+
+long PArena::numHeapAllocs() const
+{
+  long numHeapAllocs = 0;
+  for (unsigned int ithread = 0; ithread < m_threads.size(); ithread++)
+    {
+      numHeapAllocs += m_threads[ithread].m_numHeapAllocs;
+    }
+  return numHeapAllocs;
+}
+
+size_t PArena::cachedBytes() const
+{
+  size_t cachedBytes = 0;
+  for (unsigned int ithread = 0; ithread < m_threads.size(); ithread++)
+    {
+      cachedBytes += m_threads[ithread].m_cachedBytes;
+    }
+  return cachedBytes;
+}
+
+void PArena::trim(ThreadCache& a_cache)
+{
+  while (a_cache.m_cachedBytes > m_maxCached)
+    {
+      std::multimap<size_t, void*>::iterator last = a_cache.m_blocks.end();
+      --last;
+      a_cache.m_cachedBytes -= last->first;
+      ::free(last->second);
+      a_cache.m_blocks.erase(last);
+    }
+}
+
 CArena::CArena(size_t a_hunk_size)
 {
   //
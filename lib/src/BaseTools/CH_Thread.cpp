@@ -8,6 +8,7 @@
  */
 #endif
 
+#include <sched.h>
 #include "CH_Thread.H"
 #include "BaseNamespaceHeader.H"
 
@@ -21,6 +22,20 @@ bool onThread0()
   return retval;
 }
 
+int threadNumber()
+{
+  int thread_num = 0;
+#ifdef _OPENMP
+  thread_num = omp_get_thread_num();
+#endif
+  return thread_num;
+}
+
+void threadYield()
+{
+  sched_yield();
+}
+
 
 
 #include "BaseNamespaceFooter.H"
@@ -154,6 +154,8 @@ unsigned long grandPeak  = 0;
 
 bool trackingOn = true;
 
+bool reportArenaStats = false;
+
 static int registerAbortHandler = registerMemorySignals();
 
 void ReportUnfreedMemory(ostream& a_os)
@@ -252,6 +254,15 @@ void ReportUnfreedMemory(ostream& a_os)
              << (*a)->bytes/BYTES_PER_MEG << " Mb)\n";
         totalSize += (*a)->bytes;
       }
+
+      PArena* pooled = dynamic_cast<PArena*>(*a);
+      if (reportArenaStats && pooled != NULL && pooled->numAllocs() != 0)
+      {
+        a_os << "Arena " << (*a)->name_ << ": "
+             << pooled->numAllocs() << " allocations, "
+             << pooled->numHeapAllocs() << " from the heap, "
+             << pooled->cachedBytes() << " bytes kept for reuse\n";
+      }
     }
   }
 
@@ -389,6 +400,18 @@ void ReportAllocatedMemory(ostream& a_os)
               a_os << temp;
               totalSize += (*a)->bytes;
             }
+
+          PArena* pooled = dynamic_cast<PArena*>(*a);
+          if (pooled != NULL && pooled->numAllocs() != 0)
+            {
+              // kept blocks are held from the heap too
+              string entry = "FabPool";
+              sprintf(temp, "%11s %-40s %12ld b  %11.4f Mb  allocs=%ld heap=%ld\n", entry.data(), (*a)->name_,
+                      (long)pooled->cachedBytes(), (Real)pooled->cachedBytes()/(Real)BYTES_PER_MEG,
+                      pooled->numAllocs(), pooled->numHeapAllocs());
+              a_os << temp;
+              totalSize += pooled->cachedBytes();
+            }
         }
     }
 
@@ -464,6 +487,11 @@ void memtrackingOff()
   trackingOn = false;
 }
 
+void memtrackArenaStats(bool a_report)
+{
+  reportArenaStats = a_report;
+}
+
 void overallMemoryUsage(long long& a_currentTotal,
                         long long& a_peak)
 {
@@ -10,6 +10,8 @@
 
 #include <fstream>
 #include <iostream>
+#include <vector>
+#include <algorithm>
 #include "SPMD.H"
 
 #include "CH_Timer.H"
@@ -31,6 +33,7 @@
 // Include files:
 
 #include "BRMeshRefine.H"
+#include "BoxBinIndex.H"
 #include "MayDay.H"
 #include "parstream.H"
 #include "NamespaceHeader.H"
@@ -1130,4 +1133,247 @@ BRMeshRefine::receiveBoxesParallel(const Interval& a_from,
   //pout()<<"received "<<a_mesh.size()<<" boxes from "<<source<<std::endl;
 #endif
 }
+#ifdef CH_MPI
+// Cut the bounding box of all processors' tags into a_nParts disjoint
+// boxes by recursive bisection, at the cut that splits the tag count in
+// proportion to the processors on each side.  Each round is one
+// MPI_Allreduce of the tag counts along the cut directions.  Every
+// processor gets the same boxes; pieces that could not be cut leave
+// some parts empty.
+static void partitionTags(Vector<Box>&      a_parts,
+                          const IntVectSet& a_tags,
+                          const int         a_nParts)
+{
+  CH_TIME("BRMeshRefine::partitionTags");
+  a_parts.resize(0);
+  a_parts.resize(a_nParts, Box());
+
+  // global bounding box, as max(-lo) and max(hi)
+  int lohi[2*CH_SPACEDIM];
+  int globalLohi[2*CH_SPACEDIM];
+  Box minbox = a_tags.minBox();
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      lohi[idir]          = minbox.isEmpty() ? INT_MIN : -minbox.smallEnd(idir);
+      lohi[SpaceDim+idir] = minbox.isEmpty() ? INT_MIN :  minbox.bigEnd(idir);
+    }
+  MPI_Allreduce(lohi, globalLohi, 2*SpaceDim, MPI_INT, MPI_MAX, Chombo_MPI::comm);
+  if (globalLohi[0] == INT_MIN) return; // no tags anywhere
+  IntVect lo, hi;
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      lo[idir] = -globalLohi[idir];
+      hi[idir] =  globalLohi[SpaceDim+idir];
+    }
+
+  // regions[r] is shared by parts first[r] .. first[r]+count[r]-1
+  Vector<Box> regions(1, Box(lo, hi));
+  Vector<int> first(1, 0);
+  Vector<int> count(1, a_nParts);
+  Vector<int> ids;
+  while (true)
+    {
+      int nreg = regions.size();
+      Vector<int> cutDir(nreg, -1);
+      Vector<int> offset(nreg+1, 0);
+      for (int r = 0; r < nreg; r++)
+        {
+          offset[r+1] = offset[r];
+          if (count[r] > 1 && !regions[r].isEmpty())
+            {
+              int dir;
+              regions[r].longside(dir);
+              if (regions[r].size(dir) > 1)
+                {
+                  cutDir[r] = dir;
+                  offset[r+1] += regions[r].size(dir);
+                }
+            }
+        }
+      if (offset[nreg] == 0) break;
+
+      // tag counts along each region's cut direction
+      std::vector<long> localTrace(offset[nreg], 0);
+      std::vector<long> trace(offset[nreg], 0);
+      BoxBinIndex regionIndex(regions);
+      for (IVSIterator it(a_tags); it.ok(); ++it)
+        {
+          const IntVect& iv = it();
+          regionIndex.intersecting(ids, Box(iv, iv));
+          CH_assert(ids.size() == 1);
+          int r = ids[0];
+          if (cutDir[r] >= 0)
+            {
+              localTrace[offset[r] + iv[cutDir[r]] - regions[r].smallEnd(cutDir[r])]++;
+            }
+        }
+      MPI_Allreduce(&(localTrace[0]), &(trace[0]), offset[nreg],
+                    MPI_LONG, MPI_SUM, Chombo_MPI::comm);
+
+      Vector<Box> newRegions;
+      Vector<int> newFirst, newCount;
+      for (int r = 0; r < nreg; r++)
+        {
+          if (cutDir[r] < 0)
+            {
+              newRegions.push_back(regions[r]);
+              newFirst.push_back(first[r]);
+              newCount.push_back(count[r] > 1 && !regions[r].isEmpty() ? 1 : count[r]);
+              continue;
+            }
+          int dir = cutDir[r];
+          int n = regions[r].size(dir);
+          int nLo = count[r]/2;
+          long total = 0;
+          for (int i = 0; i < n; i++) total += trace[offset[r] + i];
+
+          // last index of the low side; both sides keep at least one cell
+          int cut = (n*nLo)/count[r] - 1;
+          if (total > 0)
+            {
+              double target = (double)total*nLo/count[r];
+              long sum = 0;
+              for (cut = 0; cut < n-1; cut++)
+                {
+                  sum += trace[offset[r] + cut];
+                  if (sum >= target) break;
+                }
+            }
+          cut = Max(0, Min(cut, n-2));
+
+          Box loBox(regions[r]);
+          Box hiBox = loBox.chop(dir, regions[r].smallEnd(dir) + cut + 1);
+          newRegions.push_back(loBox);
+          newFirst.push_back(first[r]);
+          newCount.push_back(nLo);
+          newRegions.push_back(hiBox);
+          newFirst.push_back(first[r] + nLo);
+          newCount.push_back(count[r] - nLo);
+        }
+      regions = newRegions;
+      first   = newFirst;
+      count   = newCount;
+    }
+
+  for (int r = 0; r < regions.size(); r++)
+    {
+      a_parts[first[r]] = regions[r];
+    }
+}
+
+// Send each of a_tags to the processor whose part contains it.
+static void routeTags(IntVectSet&        a_myTags,
+                      const IntVectSet&  a_tags,
+                      const Vector<Box>& a_parts)
+{
+  CH_TIME("BRMeshRefine::routeTags");
+  int nProc = numProc();
+  BoxBinIndex partIndex(a_parts);
+  Vector<int> ids;
+  std::vector<std::vector<int> > outgoing(nProc);
+  for (IVSIterator it(a_tags); it.ok(); ++it)
+    {
+      const IntVect& iv = it();
+      partIndex.intersecting(ids, Box(iv, iv));
+      CH_assert(ids.size() == 1);
+      std::vector<int>& out = outgoing[ids[0]];
+      for (int idir = 0; idir < SpaceDim; idir++) out.push_back(iv[idir]);
+    }
+
+  std::vector<int> sendCounts(nProc), recvCounts(nProc);
+  std::vector<int> sendDispls(nProc+1, 0), recvDispls(nProc+1, 0);
+  for (int p = 0; p < nProc; p++)
+    {
+      sendCounts[p] = outgoing[p].size();
+      sendDispls[p+1] = sendDispls[p] + sendCounts[p];
+    }
+  MPI_Alltoall(&(sendCounts[0]), 1, MPI_INT, &(recvCounts[0]), 1, MPI_INT,
+               Chombo_MPI::comm);
+  for (int p = 0; p < nProc; p++)
+    {
+      recvDispls[p+1] = recvDispls[p] + recvCounts[p];
+    }
+
+  std::vector<int> sendBuf(sendDispls[nProc] + 1), recvBuf(recvDispls[nProc] + 1);
+  for (int p = 0; p < nProc; p++)
+    {
+      std::copy(outgoing[p].begin(), outgoing[p].end(), sendBuf.begin() + sendDispls[p]);
+      std::vector<int>().swap(outgoing[p]);
+    }
+  MPI_Alltoallv(&(sendBuf[0]), &(sendCounts[0]), &(sendDispls[0]), MPI_INT,
+                &(recvBuf[0]), &(recvCounts[0]), &(recvDispls[0]), MPI_INT,
+                Chombo_MPI::comm);
+
+  a_myTags.makeEmpty();
+  IntVect iv;
+  for (int i = 0; i < recvDispls[nProc]; i += SpaceDim)
+    {
+      for (int idir = 0; idir < SpaceDim; idir++) iv[idir] = recvBuf[i+idir];
+      a_myTags |= iv;
+    }
+}
+
+// Concatenate every processor's boxes, in processor order, on all processors.
+static void allGatherBoxes(Vector<Box>& a_all, const std::list<Box>& a_mine)
+{
+  CH_TIME("BRMeshRefine::allGatherBoxes");
+  const int boxSize = 2*CH_SPACEDIM;
+  int nProc = numProc();
+  std::vector<int> sendBuf(a_mine.size()*boxSize + 1);
+  int n = 0;
+  for (std::list<Box>::const_iterator it = a_mine.begin(); it != a_mine.end(); ++it)
+    {
+      for (int idir = 0; idir < SpaceDim; idir++)
+        {
+          sendBuf[n++] = it->smallEnd(idir);
+          sendBuf[n++] = it->bigEnd(idir);
+        }
+    }
+  std::vector<int> counts(nProc), displs(nProc+1, 0);
+  MPI_Allgather(&n, 1, MPI_INT, &(counts[0]), 1, MPI_INT, Chombo_MPI::comm);
+  for (int p = 0; p < nProc; p++) displs[p+1] = displs[p] + counts[p];
+  std::vector<int> recvBuf(displs[nProc] + 1);
+  MPI_Allgatherv(&(sendBuf[0]), n, MPI_INT, &(recvBuf[0]), &(counts[0]), &(displs[0]),
+                 MPI_INT, Chombo_MPI::comm);
+
+  a_all.resize(0);
+  IntVect lo, hi;
+  for (int i = 0; i < displs[nProc]; i += boxSize)
+    {
+      for (int idir = 0; idir < SpaceDim; idir++)
+        {
+          lo[idir] = recvBuf[i + 2*idir];
+          hi[idir] = recvBuf[i + 2*idir + 1];
+        }
+      a_all.push_back(Box(lo, hi));
+    }
+}
+#endif
+
+void
+BRMeshRefine::makeBoxesDistributed(Vector<Box>&         a_mesh,
+                                   IntVectSet&          a_localTags,
+                                   const IntVectSet&    a_pnd,
+                                   const ProblemDomain& a_domain,
+                                   const int            a_maxBoxSize,
+                                   const int            a_totalBufferSize) const
+{
+  CH_TIME("BRMeshRefine::makeBoxesDistributed");
+  std::list<Box> boxes;
+#ifdef CH_MPI
+  Vector<Box> parts;
+  partitionTags(parts, a_localTags, numProc());
+  IntVectSet myTags;
+  routeTags(myTags, a_localTags, parts);
+  a_localTags.makeEmpty();
+
+  makeBoxes(boxes, myTags, a_pnd, a_domain, a_maxBoxSize, 0, a_totalBufferSize);
+  allGatherBoxes(a_mesh, boxes);
+#else
+  makeBoxes(boxes, a_localTags, a_pnd, a_domain, a_maxBoxSize, 0, a_totalBufferSize);
+  a_mesh.resize(boxes.size());
+  std::list<Box>::iterator it = boxes.begin();
+  for (int i=0; i<a_mesh.size(); ++i, ++it) a_mesh[i]=*it;
+#endif
+}
 #include "NamespaceFooter.H"
@@ -66,17 +66,7 @@ template < > void BaseFab<Real>::define()
   CH_assert(!m_aliased);
   //CH_assert(!(The_FAB_Arena == 0)); // not a sufficient test!!!
 
-#ifdef CH_USE_MEMORY_TRACKING
-  if (s_Arena == NULL)
-  {
-    s_Arena = new BArena(name().c_str());
-  }
-#else
-  if (s_Arena == NULL)
-  {
-    s_Arena = new BArena("");
-  }
-#endif
+  Arena* fabArena = arena();
 
   // if (s_Arena == NULL)
   // {
@@ -84,15 +74,10 @@ template < > void BaseFab<Real>::define()
   // }
 
   m_truesize = m_nvar * m_numpts;
-  m_dptr     = static_cast<Real*>(s_Arena->alloc(m_truesize * sizeof(Real)));
+  m_dptr     = static_cast<Real*>(fabArena->alloc(m_truesize * sizeof(Real)));
 
 #ifdef CH_USE_MEMORY_TRACKING
-  s_Arena->bytes += m_truesize * sizeof(Real) + sizeof(BaseFab<Real>);
-  CH_assert(s_Arena->bytes >= 0);
-  if (s_Arena->bytes > s_Arena->peak)
-  {
-    s_Arena->peak = s_Arena->bytes;
-  }
+  fabArena->addBytes(m_truesize * sizeof(Real) + sizeof(BaseFab<Real>));
 #endif
 
 #ifdef CH_USE_SETVAL
@@ -100,6 +85,20 @@ template < > void BaseFab<Real>::define()
 #endif
 }
 
+template < > Arena* BaseFab<Real>::arena()
+{
+  // FArrayBox temporaries are created and destroyed over and over (in the
+  // solvers especially), so keep freed blocks for reuse.  The arena is made
+  // once, by the initialization of a local static, which the compiler
+  // guards against other threads.
+#ifdef CH_USE_MEMORY_TRACKING
+  static Arena* const arenaPtr = s_Arena = new PArena(name().c_str());
+#else
+  static Arena* const arenaPtr = s_Arena = new PArena("");
+#endif
+  return arenaPtr;
+}
+
 template < > void BaseFab<int>::define()
 {
   CH_assert(m_nvar > 0);
@@ -109,33 +108,13 @@ template < > void BaseFab<int>::define()
   CH_assert(!m_aliased);
   //CH_assert(!(The_FAB_Arena == 0)); // not a sufficient test!!!
 
-#ifdef CH_USE_MEMORY_TRACKING
-  if (s_Arena == NULL)
-  {
-    s_Arena = new BArena(name().c_str());
-  }
-#else
-  if (s_Arena == NULL)
-  {
-    s_Arena = new BArena("");
-  }
-#endif
-
-  // if (s_Arena == NULL)
-  // {
-  //   MayDay::Error("malloc in basefab failed");
-  // }
+  Arena* fabArena = arena();
 
   m_truesize = m_nvar * m_numpts;
-  m_dptr     = static_cast<int*>(s_Arena->alloc(m_truesize * sizeof(int)));
+  m_dptr     = static_cast<int*>(fabArena->alloc(m_truesize * sizeof(int)));
 
 #ifdef CH_USE_MEMORY_TRACKING
-  s_Arena->bytes += m_truesize * sizeof(int) + sizeof(BaseFab<int>);
-  CH_assert(s_Arena->bytes >= 0);
-  if (s_Arena->bytes > s_Arena->peak)
-  {
-    s_Arena->peak = s_Arena->bytes;
-  }
+  fabArena->addBytes(m_truesize * sizeof(int) + sizeof(BaseFab<int>));
 #endif
 }
 
@@ -152,11 +131,11 @@ template < > void BaseFab<Real>::undefine()
     return;
   }
 
-  s_Arena->free(m_dptr);
+  Arena* fabArena = arena();
+  fabArena->free(m_dptr);
 
 #ifdef CH_USE_MEMORY_TRACKING
-  s_Arena->bytes -= m_truesize * sizeof(Real) + sizeof(BaseFab<Real>);
-  CH_assert(s_Arena->bytes >= 0);
+  fabArena->addBytes(-(long int)(m_truesize * sizeof(Real) + sizeof(BaseFab<Real>)));
 #endif
 
   m_dptr = 0;
@@ -175,11 +154,11 @@ template < > void BaseFab<int>::undefine()
     return;
   }
 
-  s_Arena->free(m_dptr);
+  Arena* fabArena = arena();
+  fabArena->free(m_dptr);
 
 #ifdef CH_USE_MEMORY_TRACKING
-  s_Arena->bytes -= m_truesize * sizeof(int) + sizeof(BaseFab<int>);
-  CH_assert(s_Arena->bytes >= 0);
+  fabArena->addBytes(-(long int)(m_truesize * sizeof(int) + sizeof(BaseFab<int>)));
 #endif
 
   m_dptr = 0;
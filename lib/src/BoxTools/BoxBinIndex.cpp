@@ -0,0 +1,172 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+#include <algorithm>
+#include "BoxBinIndex.H"
+#include "BoxIterator.H"
+#include "CH_Timer.H"
+#include "NamespaceHeader.H"
+
+// floor(a_num/a_den) for a_den > 0
+static inline int floorDiv(int a_num, int a_den)
+{
+  return (a_num >= 0) ? a_num/a_den : -((-a_num + a_den - 1)/a_den);
+}
+
+BoxBinIndex::BoxBinIndex()
+  :
+  m_isDefined(false)
+{
+}
+
+BoxBinIndex::BoxBinIndex(const Vector<Box>& a_boxes)
+  :
+  m_isDefined(false)
+{
+  define(a_boxes);
+}
+
+BoxBinIndex::~BoxBinIndex()
+{
+}
+
+void BoxBinIndex::clear()
+{
+  m_boxes.resize(0);
+  m_entries.clear();
+  m_isDefined = false;
+}
+
+long long BoxBinIndex::binKey(const IntVect& a_bin) const
+{
+  long long key = 0;
+  for (int idir = SpaceDim-1; idir >= 0; idir--)
+    {
+      long long extent = m_binHi[idir] - m_binLo[idir] + 1;
+      key = key*extent + (a_bin[idir] - m_binLo[idir]);
+    }
+  return key;
+}
+
+void BoxBinIndex::define(const Vector<Box>& a_boxes)
+{
+  CH_TIME("BoxBinIndex::define");
+  clear();
+  m_boxes = a_boxes;
+
+  // bin size is the median box extent, so a typical box spans at most two
+  // bins in any direction and one large box does not make every bin large
+  m_binSize = IntVect::Unit;
+  std::vector<int> extents[SpaceDim];
+  bool first = true;
+  IntVect lo = IntVect::Zero;
+  IntVect hi = IntVect::Zero;
+  for (int i = 0; i < m_boxes.size(); i++)
+    {
+      const Box& b = m_boxes[i];
+      if (b.isEmpty()) continue;
+      for (int idir = 0; idir < SpaceDim; idir++)
+        {
+          extents[idir].push_back(b.size(idir));
+        }
+      if (first)
+        {
+          lo = b.smallEnd();
+          hi = b.bigEnd();
+          first = false;
+        }
+      else
+        {
+          lo.min(b.smallEnd());
+          hi.max(b.bigEnd());
+        }
+    }
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      std::vector<int>& ext = extents[idir];
+      if (!ext.empty())
+        {
+          std::nth_element(ext.begin(), ext.begin() + ext.size()/2, ext.end());
+          m_binSize[idir] = ext[ext.size()/2];
+        }
+      m_binLo[idir] = floorDiv(lo[idir], m_binSize[idir]);
+      m_binHi[idir] = floorDiv(hi[idir], m_binSize[idir]);
+    }
+
+  m_entries.reserve(m_boxes.size()*2);
+  for (int i = 0; i < m_boxes.size(); i++)
+    {
+      const Box& b = m_boxes[i];
+      if (b.isEmpty()) continue;
+      IntVect blo, bhi;
+      for (int idir = 0; idir < SpaceDim; idir++)
+        {
+          blo[idir] = floorDiv(b.smallEnd(idir), m_binSize[idir]);
+          bhi[idir] = floorDiv(b.bigEnd(idir),   m_binSize[idir]);
+        }
+      Box bins(blo, bhi);
+      for (BoxIterator bit(bins); bit.ok(); ++bit)
+        {
+          m_entries.push_back(std::pair<long long, int>(binKey(bit()), i));
+        }
+    }
+  std::sort(m_entries.begin(), m_entries.end());
+  m_isDefined = true;
+}
+
+void BoxBinIndex::intersecting(Vector<int>& a_ids, const Box& a_region) const
+{
+  CH_assert(m_isDefined);
+  a_ids.resize(0);
+  if (a_region.isEmpty() || m_entries.empty()) return;
+
+  // clip the region's bins to the occupied bins
+  IntVect blo, bhi;
+  long long nbins = 1;
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      blo[idir] = Max(m_binLo[idir], floorDiv(a_region.smallEnd(idir), m_binSize[idir]));
+      bhi[idir] = Min(m_binHi[idir], floorDiv(a_region.bigEnd(idir),   m_binSize[idir]));
+      if (bhi[idir] < blo[idir]) return;
+      nbins *= bhi[idir] - blo[idir] + 1;
+    }
+
+  if (nbins > (long long)m_entries.size())
+    {
+      // a region this large is cheaper to test box by box
+      for (int i = 0; i < m_boxes.size(); i++)
+        {
+          if (m_boxes[i].intersectsNotEmpty(a_region)) a_ids.push_back(i);
+        }
+      return;
+    }
+
+  Box bins(blo, bhi);
+  for (BoxIterator bit(bins); bit.ok(); ++bit)
+    {
+      long long key = binKey(bit());
+      std::vector<std::pair<long long, int> >::const_iterator it =
+        std::lower_bound(m_entries.begin(), m_entries.end(),
+                         std::pair<long long, int>(key, -1));
+      for (; it != m_entries.end() && it->first == key; ++it)
+        {
+          if (m_boxes[it->second].intersectsNotEmpty(a_region))
+            {
+              a_ids.push_back(it->second);
+            }
+        }
+    }
+  // a box spanning several bins is found once per bin
+  std::vector<int>& ids = a_ids.stdVector();
+  std::sort(ids.begin(), ids.end());
+  a_ids.resize(std::unique(ids.begin(), ids.end()) - ids.begin());
+}
+
+#include "NamespaceFooter.H"
@@ -32,6 +32,7 @@ transform(BaseTransform& a_transform)
       Box fullBox = (*m_boxes)[ivec].box;
       (*m_boxes)[ivec].box = a_transform(fullBox);
     }
+  m_binIndex->clear();
 }
 
 //need at least one non-inlined function, otherwise
@@ -68,7 +69,8 @@ BoxLayout::BoxLayout()
    m_closed(new bool(false)),
    m_sorted(new bool(false)),
    m_dataIterator(RefCountedPtr<DataIterator>()),
-   m_indicies(new Vector<LayoutIndex>())
+   m_indicies(new Vector<LayoutIndex>()),
+   m_binIndex(new BoxBinIndex())
 {
 }
 
@@ -80,6 +82,7 @@ BoxLayout& BoxLayout::operator=(const BoxLayout& a_rhs)
   m_closed = a_rhs.m_closed;
   m_sorted = a_rhs.m_sorted;
   m_dataIterator = a_rhs.m_dataIterator;
+  m_binIndex = a_rhs.m_binIndex;
 #ifdef CH_MPI
   m_dataIndex = a_rhs.m_dataIndex;
 #endif
@@ -187,12 +190,29 @@ LayoutIterator BoxLayout::layoutIterator() const
   return LayoutIterator(*this, m_layout);
 }
 
+void BoxLayout::intersectingBoxes(Vector<int>& a_indices, const Box& a_region) const
+{
+  CH_assert(*m_closed);
+  BoxBinIndex& binIndex = *m_binIndex;
+  if (!binIndex.isDefined())
+    {
+      Vector<Box> boxes(m_boxes->size());
+      for (int i = 0; i < boxes.size(); i++)
+        {
+          boxes[i] = (*m_boxes)[i].box;
+        }
+      binIndex.define(boxes);
+    }
+  binIndex.intersecting(a_indices, a_region);
+}
+
 BoxLayout::BoxLayout(const Vector<Box>& a_boxes, const Vector<int>& assignments)
   :m_boxes( new Vector<Entry>()),
    m_layout(new int),
    m_closed(new bool(false)),
    m_sorted(new bool(false)),
-   m_indicies(new Vector<LayoutIndex>())
+   m_indicies(new Vector<LayoutIndex>()),
+   m_binIndex(new BoxBinIndex())
 {
   define(a_boxes, assignments);
 }
@@ -202,7 +222,8 @@ BoxLayout::BoxLayout(const LayoutData<Box>& a_newLayout)
    m_layout(new int),
    m_closed(new bool(false)),
    m_sorted(new bool(false)),
-   m_indicies(new Vector<LayoutIndex>())
+   m_indicies(new Vector<LayoutIndex>()),
+   m_binIndex(new BoxBinIndex())
 {
   define(a_newLayout);
 }
@@ -264,6 +285,7 @@ BoxLayout::define(const LayoutData<Box>& a_newLayout)
   // First copy from the base layout.
   m_boxes =  RefCountedPtr<Vector<Entry> >(
                new Vector<Entry>(*(baseLayout.m_boxes)));
+  m_binIndex = RefCountedPtr<BoxBinIndex>(new BoxBinIndex());
   m_layout = baseLayout.m_layout;
 #ifdef CH_MPI
   m_dataIndex = baseLayout.m_dataIndex;
@@ -336,6 +358,7 @@ BoxLayout::deepCopy(const BoxLayout& a_source)
 {
   m_boxes =  RefCountedPtr<Vector<Entry> >(
                 new Vector<Entry>(*(a_source.m_boxes)));
+  m_binIndex = RefCountedPtr<BoxBinIndex>(new BoxBinIndex());
   m_layout = a_source.m_layout;
 #ifdef CH_MPI
   m_dataIndex = a_source.m_dataIndex;
@@ -387,6 +410,7 @@ coarsen(BoxLayout& a_output, const BoxLayout& a_input, int a_refinement)
     }
   //a_output.deepCopy(a_input);
   a_output.m_boxes      = RefCountedPtr<Vector<Entry> >(new Vector<Entry>(*(a_input.m_boxes)));
+  a_output.m_binIndex   = RefCountedPtr<BoxBinIndex>(new BoxBinIndex());
   a_output.m_layout     = a_input.m_layout;
 #ifdef CH_MPI
   a_output.m_dataIndex  = a_input.m_dataIndex;
@@ -412,6 +436,7 @@ coarsen(BoxLayout& a_output, const BoxLayout& a_input, const IntVect& a_refineme
     }
   //a_output.deepCopy(a_input);
   a_output.m_boxes      = RefCountedPtr<Vector<Entry> >(new Vector<Entry>(*(a_input.m_boxes)));
+  a_output.m_binIndex   = RefCountedPtr<BoxBinIndex>(new BoxBinIndex());
   a_output.m_layout     = a_input.m_layout;
 #ifdef CH_MPI
   a_output.m_dataIndex  = a_input.m_dataIndex;
@@ -432,6 +457,7 @@ operator&= (const Box& a_box)
     {
       (*m_boxes)[ivec].box &= a_box;
     }
+  m_binIndex->clear();
 }
 
 void
@@ -442,6 +468,7 @@ operator&= (const ProblemDomain& a_domain)
     {
       (*m_boxes)[ivec].box &= a_domain;
     }
+  m_binIndex->clear();
 }
 
 void
@@ -460,6 +487,7 @@ adjCellSide(int a_idir, int a_length, Side::LoHiSide a_side)
           (*m_boxes)[ivec].box = adjCellHi( fullBox, a_idir, a_length);
         }
     }
+  m_binIndex->clear();
 }
 
 void
@@ -477,6 +505,7 @@ growSide(int a_idir, int a_length, Side::LoHiSide a_side)
           (*m_boxes)[ivec].box.growHi(a_idir, a_length);
         }
     }
+  m_binIndex->clear();
 }
 //////////////
 void
@@ -487,6 +516,7 @@ surroundingNodes()
     {
       (*m_boxes)[ivec].box.surroundingNodes();
     }
+  m_binIndex->clear();
 }
 
 //////////////
@@ -500,6 +530,7 @@ convertNewToOld(const IntVect& a_permutation,
     {
       (*m_boxes)[ivec].box.convertNewToOld(a_permutation, a_sign, a_translation);
     }
+  m_binIndex->clear();
 }
 //////////////
 void
@@ -512,6 +543,7 @@ convertOldToNew(const IntVect& a_permutation,
     {
       (*m_boxes)[ivec].box.convertOldToNew(a_permutation, a_sign, a_translation);
     }
+  m_binIndex->clear();
 }
 ///////////
 void
@@ -522,6 +554,7 @@ enclosedCells()
     {
       (*m_boxes)[ivec].box.enclosedCells();
     }
+  m_binIndex->clear();
 }
 
 ///////////
@@ -533,6 +566,7 @@ grow(int a_growth)
     {
       (*m_boxes)[ivec].box.grow(a_growth);
     }
+  m_binIndex->clear();
 }
 ///////////
 void
@@ -543,6 +577,7 @@ grow(int a_idir, int a_growth)
     {
       (*m_boxes)[ivec].box.grow(a_idir, a_growth);
     }
+  m_binIndex->clear();
 }
 ///////////
 void
@@ -553,6 +588,7 @@ grow(IntVect a_growth)
     {
       (*m_boxes)[ivec].box.grow(a_growth);
     }
+  m_binIndex->clear();
 }
 
 ///////////
@@ -564,6 +600,7 @@ coarsen(int a_ref)
     {
       (*m_boxes)[ivec].box.coarsen(a_ref);
     }
+  m_binIndex->clear();
 }
 ///////////
 void
@@ -574,6 +611,7 @@ refine(int a_ref)
     {
       (*m_boxes)[ivec].box.refine(a_ref);
     }
+  m_binIndex->clear();
 }
 
 // we have an easier time with refine, since we know that refinement will
@@ -112,6 +112,12 @@ FArrayBox* DefaultDataFactory<FArrayBox>::create(const Box& box, int ncomps,
   return new FArrayBox(box, ncomps);
 }
 
+template <>
+bool DefaultDataFactory<FArrayBox>::threadSafe() const
+{
+  return true;
+}
+
 FABAliasDataFactory::FABAliasDataFactory(const LayoutData<Real*>& aliases)
 {
   define(aliases);
@@ -20,6 +20,7 @@
 #include "parstream.H"
 
 #include <vector>
+#include <algorithm>
 #include "NamespaceHeader.H"
 
 using std::ostream;
@@ -33,6 +34,7 @@ CopierBuffer::~CopierBuffer()
 
 void CopierBuffer::clear()
 {
+  clearPersistent();
   if (m_sendbuffer != NULL) freeMT(m_sendbuffer);
   if (m_recbuffer  != NULL) freeMT(m_recbuffer);
   m_sendbuffer = NULL;
@@ -42,6 +44,29 @@ void CopierBuffer::clear()
   m_ncomps = 0;
 }
 
+void CopierBuffer::clearPersistent() const
+{
+#ifdef CH_MPI
+  // Copiers can outlive MPI (static objects), in which case there is
+  // nothing left to free.
+  int finalized = 0;
+  MPI_Finalized(&finalized);
+  if (!finalized)
+    {
+      for (int i = 0; i < m_sendPersistent.size(); ++i)
+        {
+          MPI_Request_free(&(m_sendPersistent[i]));
+        }
+      for (int i = 0; i < m_recvPersistent.size(); ++i)
+        {
+          MPI_Request_free(&(m_recvPersistent[i]));
+        }
+    }
+  m_sendPersistent.resize(0);
+  m_recvPersistent.resize(0);
+#endif
+}
+
 Copier::Copier(const DisjointBoxLayout& a_level,
                const BoxLayout& a_dest,
                bool a_exchange,
@@ -100,6 +125,8 @@ void Copier::clear()
   m_toMotionPlan.resize(0);
   m_isDefined = false;
   m_buffers.clear();
+  m_localDestOrder.resize(0);
+  m_localDestStarts.resize(0);
 }
 
 Copier::Copier(const Copier& a_rhs)
@@ -128,6 +155,8 @@ Copier& Copier::operator= (const Copier& b)
     {
       m_toMotionPlan[i] = new (s_motionItemPool.getPtr()) MotionItem(*(b.m_toMotionPlan[i]));
     }
+  m_localDestOrder  = b.m_localDestOrder;
+  m_localDestStarts = b.m_localDestStarts;
 
   m_isDefined = true;
   return *this;
@@ -166,6 +195,7 @@ void Copier::trimEdges(const DisjointBoxLayout& a_exchangedLayout, const IntVect
   //         << "new Copy operations:" << m_localMotionPlan.size() << "\n";
   trimMotion(a_exchangedLayout, a_ghost, oldCopier.m_fromMotionPlan, m_fromMotionPlan);
   trimMotion(a_exchangedLayout, a_ghost, oldCopier.m_toMotionPlan, m_toMotionPlan);
+  defineLocalDestinations();
 }
 
 void Copier::reverse()
@@ -183,6 +213,7 @@ void Copier::reverse()
       m_toMotionPlan[i]->reverse();
     }
   m_fromMotionPlan.swap(m_toMotionPlan);
+  defineLocalDestinations();
 
 }
 
@@ -353,7 +384,12 @@ void Copier::define(const BoxLayout& a_level,
   }
 #endif
 
-  bool isSorted = (a_level.isSorted() && a_dest.isSorted());
+  // Candidate intersections come from the spatial index each closed
+  // BoxLayout keeps (BoxLayout::intersectingBoxes), so each box costs a
+  // few binary searches rather than a sweep over the other layout.  The
+  // index reports positions in layout order, which is also the order of
+  // vectorLevelDI and vectorDestDI.
+  Vector<int> ids;
 
   // loop over all dest/to DI's on my processor
   for (vector<DataIndex>::iterator vdi = vectorDestOnProcDI.begin();
@@ -367,19 +403,13 @@ void Copier::define(const BoxLayout& a_level,
 
     ghost.grow(a_ghost);
 
-    //bool isSorted = (a_level.isSorted() && a_dest.isSorted());
-    // then for each level/from DI, see if they intersect
-    for (vector<DataIndex>::iterator vli = vectorLevelDI.begin();
-        vli != vectorLevelDI.end(); ++vli)
+    // then for each level/from DI that the index finds, see if they intersect
+    level.intersectingBoxes(ids, ghost);
+    for (int i = 0; i < ids.size(); ++i)
     {
-      const DataIndex fromdi(*vli);
+      const DataIndex fromdi(vectorLevelDI[ids[i]]);
       const unsigned int fromProcID = level.procID(fromdi);
       const Box& fromBox = level[fromdi];
-      if ((fromBox.bigEnd(0) < ghost.smallEnd(0)) && isSorted )
-      {
-        //can skip rest cuz we haven't gotten to something interesting
-        continue;
-      }
 
       if (ghost.intersectsNotEmpty(fromBox))
       {
@@ -407,48 +437,37 @@ void Copier::define(const BoxLayout& a_level,
           m_toMotionPlan.push_back(item);
         }
       }
-      if ((fromBox.smallEnd(0) > ghost.bigEnd(0)) && isSorted)
-      {
-        //can break out of loop, since we know that the smallEnd
-        // of all the remaining boxes are lexigraphically beyond this ghosted box.
-        break;
-      }
-
     }
   }
 
   // Don't need to worry about this in serial as we already
   // took care of the local copy motion items just above.  skip this.
 #ifdef CH_MPI
-  // loop over all dest/to DI's
-  for (vector<DataIndex>::iterator vdi = vectorDestDI.begin();
-      vdi != vectorDestDI.end(); ++vdi)
+  // loop over all level/from DI's on this processor.  The motion plans are
+  // sorted at the end of define(), so the order they are built in here does
+  // not matter.
+  for (vector<DataIndex>::iterator vli = vectorLevelOnProcDI.begin();
+      vli != vectorLevelOnProcDI.end(); ++vli)
   {
-
-    const DataIndex todi(*vdi);
-
-    Box ghost(dest[todi]);
-    ghost -= a_shift;
-
-    ghost.grow(a_ghost);
-
-    const unsigned int toProcID = dest.procID(todi);
-
-    // then for each level/from DI on this processor, see if they intersect
-    for (vector<DataIndex>::iterator vli = vectorLevelOnProcDI.begin();
-        vli != vectorLevelOnProcDI.end(); ++vli)
+    // at this point, i know myprocID == fromProcID
+    const DataIndex fromdi(*vli);
+    const Box& fromBox = level[fromdi];
+
+    // dest boxes whose ghosted, shifted region can reach fromBox
+    Box reach(fromBox);
+    reach += a_shift;
+    reach.grow(a_ghost);
+    dest.intersectingBoxes(ids, reach);
+    for (int i = 0; i < ids.size(); ++i)
     {
+      const DataIndex todi(vectorDestDI[ids[i]]);
 
-      // at this point, i know myprocID == fromProcID
+      Box ghost(dest[todi]);
+      ghost -= a_shift;
 
-      const DataIndex fromdi(*vli);
-      const Box& fromBox = level[fromdi];
+      ghost.grow(a_ghost);
 
-      if ((fromBox.bigEnd(0) < ghost.smallEnd(0)) && isSorted)
-      {
-        //can skip rest cuz we haven't gotten to something interesting
-        continue;
-      }
+      const unsigned int toProcID = dest.procID(todi);
 
       if (ghost.intersectsNotEmpty(fromBox))
       {
@@ -476,12 +495,6 @@ void Copier::define(const BoxLayout& a_level,
           m_fromMotionPlan.push_back(item);
         }
       }
-      if ((fromBox.smallEnd(0) > ghost.bigEnd(0)) && isSorted)
-      {
-        //can break out of loop, since we know that the smallEnd
-        // of all the remaining boxes are lexigraphically beyond this ghosted box.
-        break;
-      }
     }
   }
 #endif
@@ -814,6 +827,43 @@ void Copier::sort()
   std::sort(vfrom.begin(), vfrom.end(), MotionItemSorter());
   std::vector<MotionItem*>& vto = m_toMotionPlan.stdVector();
   std::sort(vto.begin(), vto.end(), MotionItemSorter());
+  defineLocalDestinations();
+}
+
+const Vector<int>& Copier::localDestinationOrder() const
+{
+  return m_localDestOrder;
+}
+
+const Vector<int>& Copier::localDestinationStarts() const
+{
+  return m_localDestStarts;
+}
+
+void Copier::defineLocalDestinations()
+{
+  CH_TIME("Copier::defineLocalDestinations");
+  int nitems = m_localMotionPlan.size();
+  std::vector<std::pair<int, int> > keys(nitems);
+  for (int i = 0; i < nitems; ++i)
+    {
+      keys[i] = std::pair<int, int>(m_localMotionPlan[i]->toIndex.intCode(), i);
+    }
+  // stable with respect to the sorted motion plan, so each group is still
+  // processed in the original order
+  std::sort(keys.begin(), keys.end());
+
+  m_localDestOrder.resize(nitems);
+  m_localDestStarts.resize(0);
+  for (int i = 0; i < nitems; ++i)
+    {
+      m_localDestOrder[i] = keys[i].second;
+      if (i == 0 || keys[i].first != keys[i-1].first)
+        {
+          m_localDestStarts.push_back(i);
+        }
+    }
+  m_localDestStarts.push_back(nitems);
 }
 
 int Copier::print() const
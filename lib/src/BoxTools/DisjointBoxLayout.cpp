@@ -16,6 +16,7 @@
 #include "LoadBalance.H"
 #include "SliceSpec.H"
 #include <list>
+#include <algorithm>
 #include "CH_Timer.H"
 #include "NamespaceHeader.H"
 
@@ -153,16 +154,13 @@ void DisjointBoxLayout::computeNeighbors()
 {
   CH_TIME("DisjointBoxLayout::computeNeighbors");
   const Vector<Entry>& boxes = *m_boxes;
-  int n = boxes.size();
-  int maxI=0;
-  for (int i=0; i<n; ++i)
+  // periodic images are only possible for boxes touching a periodic
+  // face of the domain
+  bool periodic = !m_physDomain.isEmpty() && m_physDomain.isPeriodic();
+  Box periodicTestBox;
+  if (periodic)
     {
-      maxI = Max(maxI, boxes[i].box.size(0));
-    }
-  std::list<std::pair<int, LayoutIndex> > periodicImages;
-  if (!m_physDomain.isEmpty() && m_physDomain.isPeriodic())
-    {
-      Box periodicTestBox(m_physDomain.domainBox());
+      periodicTestBox = m_physDomain.domainBox();
       for (int idir=0; idir<CH_SPACEDIM; idir++)
         {
           if (m_physDomain.isPeriodic(idir))
@@ -170,82 +168,58 @@ void DisjointBoxLayout::computeNeighbors()
               periodicTestBox.grow(idir,-1);
             }
         }
-
-      LayoutIterator lit = layoutIterator();
-      unsigned int index = 0;
-      ShiftIterator shiftIt = m_physDomain.shiftIterator();
-      for (lit.reset(); lit.ok(); ++lit,++index)
-        {
-          const Box& box = this->operator[](lit);
-          // if periodic, also need to add periodic images
-          // only do this IF we're periodic and box
-          // adjacent to  the domain box boundary somewhere
-          if (!periodicTestBox.contains(box))
-            {
-              //IntVect shiftMult(m_physDomain.domainBox().size());
-              //Box shiftedBox(box);
-              for (shiftIt.begin(); shiftIt.ok(); ++shiftIt)
-                {
-                  //IntVect shiftVect = shiftMult*shiftIt();
-                  //shiftedBox.shift(shiftVect);
-
-                  periodicImages.push_back(std::pair<int, LayoutIndex>(shiftIt.index(), lit()));
-                  //shiftedBox.shift(-shiftVect);
-                } // end loop over periodic shift directions
-            } // end if periodic
-        }
     }
-  //  OK, for this work, we don't use a standard LayoutIterator, since I want to
-  // be pushing the start of the window forward, which LayoutIterator is not built to do.
-  unsigned int id = 0;
-  unsigned int start = 0;
-  unsigned int end   = size();
   m_neighbors = RefCountedPtr<Vector<Vector<std::pair<int, LayoutIndex > > > >(
             new Vector<Vector<std::pair<int, LayoutIndex> > >());
-  DataIterator dit = dataIterator();
   m_neighbors->resize(size());
   LayoutIterator lit = layoutIterator();
   const Vector<LayoutIndex>& vecLayoutIndex = *(lit.m_indicies);
 
+  // candidates come from the layout's spatial index instead of a sweep
+  // over all the boxes
+  Vector<int> ids;
   for (DataIterator dit=dataIterator(); dit.ok(); ++dit)
     {
       Box gbox = get(dit());
       gbox.grow(1);
       Vector<std::pair<int, LayoutIndex> >& neighbors = (*m_neighbors)[dit().intCode()];
-      int low =  gbox.smallEnd()[0] - maxI;
-      int high = gbox.smallEnd()[0] + maxI + 1;
-      for (id=start; id<end; ++id)
+      unsigned int self = index(dit());
+      intersectingBoxes(ids, gbox);
+      for (int i=0; i<ids.size(); ++i)
         {
-          if (id != index(dit()))
-          {
-            //don't include yourself as neighbor
-            const Box& b = boxes[id].box;
-            const IntVect& s = b.smallEnd();
-            if (s[0]< low) start = id+1;
-            else if (s[0] > high) id=end;
-            if (gbox.intersectsNotEmpty(b))
-              {
-                neighbors.push_back(std::pair<int, LayoutIndex>(-1, vecLayoutIndex[id]));
-              }
-          }
+          //don't include yourself as neighbor
+          if ((unsigned int)ids[i] != self)
+            {
+              neighbors.push_back(std::pair<int, LayoutIndex>(-1, vecLayoutIndex[ids[i]]));
+            }
+        }
+      //now run through periodic images.
+      if (periodic && !m_physDomain.domainBox().contains(gbox))
+        {
+          // (box, shift) pairs, sorted so that images are listed by box
+          // and then by shift, as the neighbor iterators have always seen them
+          std::vector<std::pair<int, int> > images;
+          ShiftIterator shiftIt = m_physDomain.shiftIterator();
+          for (shiftIt.begin(); shiftIt.ok(); ++shiftIt)
+            {
+              Box unshifted(gbox);
+              m_physDomain.unshiftIt(unshifted, shiftIt.index());
+              intersectingBoxes(ids, unshifted);
+              for (int i=0; i<ids.size(); ++i)
+                {
+                  if (!periodicTestBox.contains(boxes[ids[i]].box))
+                    {
+                      images.push_back(std::pair<int, int>(ids[i], shiftIt.index()));
+                    }
+                }
+            }
+          std::sort(images.begin(), images.end());
+          for (int i=0; i<(int)images.size(); ++i)
+            {
+              neighbors.push_back(std::pair<int, LayoutIndex>(images[i].second,
+                                                              vecLayoutIndex[images[i].first]));
+            }
         }
-      //now run through periodic boxes.
-      if(!m_physDomain.isEmpty() && !m_physDomain.domainBox().contains(gbox))
-	{
-	  std::list<std::pair<int, LayoutIndex> >::iterator it;
-	  for (it=periodicImages.begin(); it!=periodicImages.end(); ++it)
-	    {
-	      Box b = (*m_boxes)[(*it).second.intCode()].box;
-	      m_physDomain.shiftIt(b, (*it).first);
-	      if (gbox.intersectsNotEmpty(b))
-		{
-		  pair<int, LayoutIndex> entry(*it);
-		  //HERE
-		  entry.second = (*it).second;
-		  neighbors.push_back(entry);
-		}
-	    }
-	}
     }
 }
 
@@ -501,6 +475,7 @@ coarsen(DisjointBoxLayout& a_output, const DisjointBoxLayout& a_input,
   // copy first, then coarsen everything
   // a_output.deepCopy(a_input);
   a_output.m_boxes      = RefCountedPtr<Vector<Entry> >(new Vector<Entry>(*(a_input.m_boxes)));
+  a_output.m_binIndex   = RefCountedPtr<BoxBinIndex>(new BoxBinIndex());
   a_output.m_layout     = a_input.m_layout;
 #ifdef CH_MPI
   a_output.m_dataIndex  = a_input.m_dataIndex;
@@ -11,6 +11,8 @@
 #include <iostream>
 #include <list>
 #include <set>
+#include <map>
+#include <algorithm>
 using std::cout;
 
 #include "parstream.H"
@@ -20,6 +22,7 @@ using std::cout;
 #include "SPMD.H"
 #include "LoadBalance.H"
 #include "LayoutIterator.H"
+#include "BoxBinIndex.H"
 #include "CH_Timer.H"
 
 // Write a text file per call to LoadBalance()
@@ -756,6 +759,488 @@ LoadBalance(Vector<Vector<int> >& procAssignments  //output: processor number
   return status;
 }
 
+// ---------------------------------------------------------------------
+// Locality-aware load balancing: space-filling curves and edge cut.
+// ---------------------------------------------------------------------
+
+// (neighbor box, cells) pairs for one box
+typedef Vector<std::pair<int, long long> > LBEdges;
+
+// Interleave the low a_bits bits of the coordinates, Morton order.
+static unsigned long long mortonKey(const unsigned int* a_x, int a_bits)
+{
+  unsigned long long key = 0;
+  for (int b = a_bits-1; b >= 0; b--)
+    {
+      for (int idir = 0; idir < SpaceDim; idir++)
+        {
+          key = (key << 1) | ((a_x[idir] >> b) & 1);
+        }
+    }
+  return key;
+}
+
+// Hilbert index of a point with a_bits bits per coordinate
+// (J. Skilling, "Programming the Hilbert curve", AIP Conf. Proc. 707, 2004).
+static unsigned long long hilbertKey(const unsigned int* a_x, int a_bits)
+{
+  unsigned int x[SpaceDim];
+  for (int idir = 0; idir < SpaceDim; idir++) x[idir] = a_x[idir];
+
+  unsigned int m = 1U << (a_bits-1);
+  // inverse undo
+  for (unsigned int q = m; q > 1; q >>= 1)
+    {
+      unsigned int p = q - 1;
+      for (int idir = 0; idir < SpaceDim; idir++)
+        {
+          if (x[idir] & q)
+            {
+              x[0] ^= p;
+            }
+          else
+            {
+              unsigned int t = (x[0] ^ x[idir]) & p;
+              x[0] ^= t;
+              x[idir] ^= t;
+            }
+        }
+    }
+  // Gray encode
+  for (int idir = 1; idir < SpaceDim; idir++) x[idir] ^= x[idir-1];
+  unsigned int t = 0;
+  for (unsigned int q = m; q > 1; q >>= 1)
+    {
+      if (x[SpaceDim-1] & q) t ^= q - 1;
+    }
+  for (int idir = 0; idir < SpaceDim; idir++) x[idir] ^= t;
+
+  return mortonKey(x, a_bits);
+}
+
+// Curve position of the center of every box of every level, in level-0
+// index space scaled so the bounding box of level 0 fills the curve.
+static void curveKeys(Vector<Vector<unsigned long long> >& a_keys,
+                      const Vector<Vector<Box> >&         a_grids,
+                      const Vector<int>&                  a_refRatios,
+                      LoadBalanceMode                     a_mode)
+{
+  const int bits = Min(31, 62/SpaceDim);
+  const double cells = (double)(1U << bits);
+
+  // bounding box of the coarsest populated level, in level-0 units
+  Box bbox;
+  int bboxRatio = 1;
+  for (int lvl = 0; lvl < a_grids.size() && bbox.isEmpty(); lvl++)
+    {
+      if (lvl > 0) bboxRatio *= a_refRatios[lvl-1];
+      for (int i = 0; i < a_grids[lvl].size(); i++)
+        {
+          const Box& b = a_grids[lvl][i];
+          if (b.isEmpty()) continue;
+          if (bbox.isEmpty())
+            {
+              bbox = b;
+            }
+          else
+            {
+              bbox.minBox(b);
+            }
+        }
+      if (!bbox.isEmpty()) bbox.coarsen(bboxRatio);
+    }
+  double extent = 1.0;
+  for (int idir = 0; idir < SpaceDim && !bbox.isEmpty(); idir++)
+    {
+      extent = Max(extent, (double)bbox.size(idir));
+    }
+
+  a_keys.resize(a_grids.size());
+  double ratio = 1.0;
+  for (int lvl = 0; lvl < a_grids.size(); lvl++)
+    {
+      if (lvl > 0) ratio *= a_refRatios[lvl-1];
+      a_keys[lvl].resize(a_grids[lvl].size());
+      for (int i = 0; i < a_grids[lvl].size(); i++)
+        {
+          const Box& b = a_grids[lvl][i];
+          unsigned int x[SpaceDim];
+          for (int idir = 0; idir < SpaceDim; idir++)
+            {
+              double center = 0.5*(b.smallEnd(idir) + b.bigEnd(idir) + 1)/ratio;
+              double s = (center - bbox.smallEnd(idir))/extent*cells;
+              s = Max(0.0, Min(cells - 1.0, s));
+              x[idir] = (unsigned int)s;
+            }
+          a_keys[lvl][i] = (a_mode == LB_MORTON) ? mortonKey(x, bits) : hilbertKey(x, bits);
+        }
+    }
+}
+
+// Ghost cells each box of a level gets from the other boxes of the level.
+// Both ends of an overlap record it, so a_edges[i] lists i's ghosts filled
+// by j as well as j's ghosts filled by i.
+static void levelEdges(Vector<LBEdges>&   a_edges,
+                       const Vector<Box>& a_boxes,
+                       int                a_nGhost)
+{
+  a_edges.resize(0);
+  a_edges.resize(a_boxes.size());
+  BoxBinIndex index(a_boxes);
+  Vector<int> ids;
+  for (int i = 0; i < a_boxes.size(); i++)
+    {
+      Box ghost = grow(a_boxes[i], a_nGhost);
+      index.intersecting(ids, ghost);
+      for (int k = 0; k < ids.size(); k++)
+        {
+          int j = ids[k];
+          if (j == i) continue;
+          long long w = (ghost & a_boxes[j]).numPts();
+          a_edges[i].push_back(std::pair<int, long long>(j, w));
+          a_edges[j].push_back(std::pair<int, long long>(i, w));
+        }
+    }
+}
+
+// Coarse cells under each grown fine box, by coarse box.
+static void coarseFineEdges(Vector<LBEdges>&   a_edges,
+                            const Vector<Box>& a_fine,
+                            const Vector<Box>& a_coarse,
+                            int                a_refRatio,
+                            int                a_nGhost)
+{
+  a_edges.resize(0);
+  a_edges.resize(a_fine.size());
+  BoxBinIndex index(a_coarse);
+  Vector<int> ids;
+  for (int i = 0; i < a_fine.size(); i++)
+    {
+      Box region = coarsen(grow(a_fine[i], a_nGhost), a_refRatio);
+      index.intersecting(ids, region);
+      for (int k = 0; k < ids.size(); k++)
+        {
+          long long w = (region & a_coarse[ids[k]]).numPts();
+          a_edges[i].push_back(std::pair<int, long long>(ids[k], w));
+        }
+    }
+}
+
+// Move boxes of one level between processors while that reduces the edge
+// cut and keeps each processor's load within the band of the initial
+// partition widened by 5% around the average.
+static void refineLevel(Vector<int>&             a_procs,
+                        const Vector<long>&      a_loads,
+                        const Vector<LBEdges>&   a_edges,
+                        const Vector<LBEdges>&   a_coarseEdges,
+                        const Vector<int>&       a_coarseProcs,
+                        int                      a_nProc)
+{
+  const int nbox = a_procs.size();
+  Vector<long long> procLoad(a_nProc, 0);
+  long long total = 0;
+  for (int i = 0; i < nbox; i++)
+    {
+      procLoad[a_procs[i]] += a_loads[i];
+      total += a_loads[i];
+    }
+  long long maxLoad = procLoad[0], minLoad = procLoad[0];
+  for (int p = 1; p < a_nProc; p++)
+    {
+      maxLoad = Max(maxLoad, procLoad[p]);
+      minLoad = Min(minLoad, procLoad[p]);
+    }
+  double avg = (double)total/a_nProc;
+  long long hiLoad = Max(maxLoad, (long long)(1.05*avg));
+  long long loLoad = Min(minLoad, (long long)(0.95*avg));
+
+  std::map<int, long long> conn;
+  for (int pass = 0; pass < 8; pass++)
+    {
+      int moves = 0;
+      for (int i = 0; i < nbox; i++)
+        {
+          // cells box i exchanges with each processor
+          conn.clear();
+          for (int k = 0; k < a_edges[i].size(); k++)
+            {
+              conn[a_procs[a_edges[i][k].first]] += a_edges[i][k].second;
+            }
+          if (a_coarseEdges.size() > 0)
+            {
+              const LBEdges& ce = a_coarseEdges[i];
+              for (int c = 0; c < ce.size(); c++)
+                {
+                  conn[a_coarseProcs[ce[c].first]] += ce[c].second;
+                }
+            }
+          const int p = a_procs[i];
+          long long here = conn.count(p) ? conn[p] : 0;
+          int best = p;
+          long long bestGain = 0;
+          for (std::map<int, long long>::const_iterator it = conn.begin();
+               it != conn.end(); ++it)
+            {
+              const int q = it->first;
+              if (q == p) continue;
+              long long gain = it->second - here;
+              if (gain > bestGain
+                  && procLoad[q] + a_loads[i] <= hiLoad
+                  && procLoad[p] - a_loads[i] >= loLoad)
+                {
+                  best = q;
+                  bestGain = gain;
+                }
+            }
+          if (best != p)
+            {
+              procLoad[p]    -= a_loads[i];
+              procLoad[best] += a_loads[i];
+              a_procs[i] = best;
+              moves++;
+            }
+        }
+      if (moves == 0) break;
+    }
+}
+
+static Real levelEffRatio(const Vector<int>&  a_procs,
+                          const Vector<long>& a_loads,
+                          int                 a_nProc)
+{
+  Vector<long long> procLoad(a_nProc, 0);
+  for (int i = 0; i < a_procs.size(); i++)
+    {
+      procLoad[a_procs[i]] += a_loads[i];
+    }
+  int imin, imax;
+  min_max_elements(imin, imax, procLoad);
+  if (procLoad[imax] == 0) return 1.0;
+  return (Real)procLoad[imin] / (Real)procLoad[imax];
+}
+
+///
+// Locality-aware version: one space-filling curve for all levels, with
+// optional edge-cut refinement.
+///
+int
+LoadBalance(Vector<Vector<int> >&         a_procAssignments
+            ,Real&                        a_effRatio
+            ,long long&                   a_edgeCut
+            ,const Vector<Vector<Box> >&  a_Grids
+            ,const Vector<Vector<long> >& a_ComputeLoads
+            ,const Vector<int>&           a_RefRatios
+            ,LoadBalanceMode              a_mode
+            ,int                          a_nGhost
+            ,int                          a_nProc
+            ,int                          a_numFixedLevels
+            )
+{
+  CH_TIME("LoadBalance:VectorBoxSFC");
+  // Validate inputs (same codes as the greedy version)
+  if ( a_Grids.size() != a_ComputeLoads.size() )
+    { return -1011; }
+  if ( a_Grids.size() != a_RefRatios.size() )
+    { return -1013; }
+  for ( int lvl=0; lvl<a_Grids.size(); ++lvl )
+    {
+      if ( a_Grids[lvl].size() != a_ComputeLoads[lvl].size() )
+        { return -1012; }
+    }
+  const int numFixed = Min(a_numFixedLevels, (int)a_Grids.size());
+  if ( a_procAssignments.size() < numFixed )
+    { return -1014; }
+  for ( int lvl=0; lvl<numFixed; ++lvl )
+    {
+      if ( a_procAssignments[lvl].size() != a_Grids[lvl].size() )
+        { return -1014; }
+    }
+  a_procAssignments.resize(a_Grids.size());
+
+  if (a_mode == LB_GREEDY)
+    {
+      // the greedy version balances each level on its own
+      int numFree = a_Grids.size() - numFixed;
+      Vector<Vector<Box> >  grids(numFree);
+      Vector<Vector<long> > loads(numFree);
+      Vector<int>           refRatios(numFree);
+      for (int lvl = numFixed; lvl < a_Grids.size(); lvl++)
+        {
+          grids[lvl-numFixed]     = a_Grids[lvl];
+          loads[lvl-numFixed]     = a_ComputeLoads[lvl];
+          refRatios[lvl-numFixed] = a_RefRatios[lvl];
+        }
+      Vector<Vector<int> > procs;
+      a_effRatio = 1.0;
+      int status = LoadBalance(procs, a_effRatio, grids, loads, refRatios, a_nProc);
+      if (status == 0)
+        {
+          for (int lvl = numFixed; lvl < a_Grids.size(); lvl++)
+            {
+              a_procAssignments[lvl] = procs[lvl-numFixed];
+            }
+          a_edgeCut = LoadBalanceEdgeCut(a_procAssignments, a_Grids,
+                                         a_RefRatios, a_nGhost);
+        }
+      return status;
+    }
+
+  Vector<Vector<unsigned long long> > keys;
+  curveKeys(keys, a_Grids, a_RefRatios, a_mode);
+
+  a_effRatio = 1.0;
+  Vector<LBEdges> edges, coarseEdges;
+  for (int lvl = numFixed; lvl < a_Grids.size(); lvl++)
+    {
+      const Vector<Box>& boxes = a_Grids[lvl];
+      const int nbox = boxes.size();
+
+      // cut the curve into contiguous pieces of (nearly) equal load
+      std::vector<std::pair<unsigned long long, int> > order(nbox);
+      for (int i = 0; i < nbox; i++)
+        {
+          order[i] = std::pair<unsigned long long, int>(keys[lvl][i], i);
+        }
+      std::sort(order.begin(), order.end());
+      Vector<long long> sortedLoads(nbox);
+      Vector<Box> sortedBoxes(nbox);
+      for (int i = 0; i < nbox; i++)
+        {
+          sortedLoads[i] = a_ComputeLoads[lvl][order[i].second];
+          sortedBoxes[i] = boxes[order[i].second];
+        }
+      Vector<int> sortedProcs;
+      LoadBalance(sortedProcs, sortedLoads, sortedBoxes, a_nProc);
+
+      Vector<int>& procs = a_procAssignments[lvl];
+      procs.resize(nbox);
+      for (int i = 0; i < nbox; i++)
+        {
+          procs[order[i].second] = sortedProcs[i];
+        }
+
+      if (a_mode == LB_GRAPH && a_nProc > 1 && nbox > 1)
+        {
+          levelEdges(edges, boxes, a_nGhost);
+          if (lvl > 0)
+            {
+              coarseFineEdges(coarseEdges, boxes, a_Grids[lvl-1],
+                              a_RefRatios[lvl-1], a_nGhost);
+              refineLevel(procs, a_ComputeLoads[lvl], edges, coarseEdges,
+                          a_procAssignments[lvl-1], a_nProc);
+            }
+          else
+            {
+              refineLevel(procs, a_ComputeLoads[lvl], edges, Vector<LBEdges>(),
+                          Vector<int>(), a_nProc);
+            }
+        }
+
+      if (nbox > 0)
+        {
+          a_effRatio = Min(a_effRatio, levelEffRatio(procs, a_ComputeLoads[lvl], a_nProc));
+        }
+    }
+
+  a_edgeCut = LoadBalanceEdgeCut(a_procAssignments, a_Grids, a_RefRatios, a_nGhost);
+  return 0;
+}
+
+long long
+LoadBalanceEdgeCut(const Vector<Vector<int> >&  a_procAssignments
+                   ,const Vector<Vector<Box> >& a_Grids
+                   ,const Vector<int>&          a_RefRatios
+                   ,int                         a_nGhost
+                   )
+{
+  CH_TIME("LoadBalanceEdgeCut");
+  long long cut = 0;
+  Vector<LBEdges> edges;
+  for (int lvl = 0; lvl < a_Grids.size(); lvl++)
+    {
+      const Vector<int>& procs = a_procAssignments[lvl];
+      // levelEdges records each overlap at both boxes
+      levelEdges(edges, a_Grids[lvl], a_nGhost);
+      long long levelCut = 0;
+      for (int i = 0; i < edges.size(); i++)
+        {
+          for (int k = 0; k < edges[i].size(); k++)
+            {
+              if (procs[i] != procs[edges[i][k].first]) levelCut += edges[i][k].second;
+            }
+        }
+      cut += levelCut/2;
+
+      if (lvl > 0)
+        {
+          const Vector<int>& coarseProcs = a_procAssignments[lvl-1];
+          coarseFineEdges(edges, a_Grids[lvl], a_Grids[lvl-1],
+                          a_RefRatios[lvl-1], a_nGhost);
+          for (int i = 0; i < edges.size(); i++)
+            {
+              for (int k = 0; k < edges[i].size(); k++)
+                {
+                  if (procs[i] != coarseProcs[edges[i][k].first]) cut += edges[i][k].second;
+                }
+            }
+        }
+    }
+  return cut;
+}
+
+void
+LoadBalanceMeasuredLoads(Vector<long>&                     a_newLoads
+                         ,const Vector<Box>&               a_newBoxes
+                         ,const Vector<Box>&               a_oldBoxes
+                         ,const Vector<unsigned long long>& a_oldCosts
+                         )
+{
+  CH_TIME("LoadBalanceMeasuredLoads");
+  CH_assert(a_oldBoxes.size() == a_oldCosts.size());
+
+  // mean cost per cell of the measured boxes; loads come out in cells
+  // weighted by how much more (or less) than the mean a cell costs
+  double totalCost = 0;
+  double totalCells = 0;
+  for (int j = 0; j < a_oldBoxes.size(); j++)
+    {
+      totalCost  += a_oldCosts[j];
+      totalCells += a_oldBoxes[j].numPts();
+    }
+
+  a_newLoads.resize(a_newBoxes.size());
+  if (totalCost <= 0 || totalCells <= 0)
+    {
+      for (int i = 0; i < a_newBoxes.size(); i++)
+        {
+          a_newLoads[i] = a_newBoxes[i].numPts();
+        }
+      return;
+    }
+  double meanDensity = totalCost/totalCells;
+
+  BoxBinIndex oldIndex(a_oldBoxes);
+  Vector<int> ids;
+  for (int i = 0; i < a_newBoxes.size(); i++)
+    {
+      const Box& newBox = a_newBoxes[i];
+      oldIndex.intersecting(ids, newBox);
+      double load = 0;
+      long long covered = 0;
+      for (int k = 0; k < ids.size(); k++)
+        {
+          const Box& oldBox = a_oldBoxes[ids[k]];
+          Box overlap = newBox & oldBox;
+          double density = a_oldCosts[ids[k]]/(double)oldBox.numPts();
+          load    += overlap.numPts()*density/meanDensity;
+          covered += overlap.numPts();
+        }
+      // cells that were not in any measured box cost the mean
+      load += newBox.numPts() - covered;
+      a_newLoads[i] = Max((long)(load + 0.5), 1L);
+    }
+}
+
 /// convenience function to gather a distributed set of Boxes with their corresponding processor assignment
 /** Assumption is that each processor has at most one valid box. This is useful when interacting with other distributed codes which might not have the entire set of distributed boxes on all processors.
  */
@@ -279,7 +279,7 @@ using std::endl;
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-MeshRefine::MeshRefine() : m_isDefined(false), m_granularity(1)
+MeshRefine::MeshRefine() : m_isDefined(false), m_granularity(1), m_distributedTags(false)
 {
 }
 
@@ -293,7 +293,7 @@ MeshRefine::MeshRefine(const Box& a_baseDomain,
                        const int a_blockFactor,
                        const int a_bufferSize,
                        const int a_maxBoxSize)
-  :m_granularity(1)
+  :m_granularity(1), m_distributedTags(false)
 {
   ProblemDomain crseDom(a_baseDomain);
   define(crseDom, a_refRatios, a_fillRatio, a_blockFactor,
@@ -306,7 +306,7 @@ MeshRefine::MeshRefine(const ProblemDomain& a_baseDomain,
                        const int a_blockFactor,
                        const int a_bufferSize,
                        const int a_maxBoxSize)
-  :m_granularity(1)
+  :m_granularity(1), m_distributedTags(false)
 {
   define(a_baseDomain, a_refRatios, a_fillRatio, a_blockFactor,
          a_bufferSize, a_maxBoxSize);
@@ -389,6 +389,38 @@ void MeshRefine::setPNDMode(int a_mode)
   m_PNDMode = a_mode;
 }
 
+void MeshRefine::setDistributedTags(bool a_distributed)
+{
+  m_distributedTags = a_distributed;
+}
+
+// default: gather the tags to every processor and cluster them there
+void
+MeshRefine::makeBoxesDistributed(Vector<Box>&         a_mesh,
+                                 IntVectSet&          a_localTags,
+                                 const IntVectSet&    a_pnd,
+                                 const ProblemDomain& a_domain,
+                                 const int            a_maxSize,
+                                 const int            a_totalBufferSize) const
+{
+  const int dest_proc = uniqueProc(SerialTask::compute);
+  Vector<IntVectSet> all_tags;
+  gather(all_tags, a_localTags, dest_proc);
+  if (procID() == dest_proc)
+    {
+      for (int i = 0; i < all_tags.size(); ++i)
+        {
+          for (IVSIterator ivsit(all_tags[i]); ivsit.ok(); ++ivsit)
+            {
+              a_localTags |= ivsit();
+            }
+          all_tags[i].makeEmpty();
+        }
+    }
+  broadcast(a_localTags, dest_proc);
+  makeBoxes(a_mesh, a_localTags, a_pnd, a_domain, a_maxSize, a_totalBufferSize);
+}
+
 //
 // This regrid function takes a single IntVectSet of tags
 //
@@ -590,54 +622,71 @@ MeshRefine::regrid(Vector<Vector<Box> >&   a_newmeshes,
           for ( int lvl = TopLevel ; lvl >= a_baseLevel ; lvl-- )
           {
             // make a new mesh at the same level as the tags
+            ProblemDomain lvldomain = Domains[lvl]; // domain of this level
 
-            const int dest_proc = uniqueProc(SerialTask::compute);
-
-            Vector<IntVectSet> all_tags;
-            gather(all_tags, modifiedTags[lvl], dest_proc);
+            // this is the maximum allowable box size at this resolution
+            // which will result in satisfying the maxSize restriction when
+            // everything is refined up to the new level
+            const int maxBoxSizeLevel = m_maxSize/(m_level_blockfactors[lvl]*m_nRefVect[lvl]);
 
-            if (procID() == dest_proc)
+            if (m_distributedTags)
               {
-                for (int i = 0; i < all_tags.size(); ++i)
+                // every processor knows lvlboxes; each adds the support of
+                // its share of them, so no support cell is tagged twice
+                Vector<Box> supportBoxes;
+                for (int ibox = procID(); ibox < lvlboxes.size(); ibox += numProc())
                   {
-//                     modifiedTags[lvl] |= all_tags[i];
-                    //**FIXME -- revert to above line when IVS is fixed.
-                    //**The following works around a bug in IVS that appears if
-                    //**the above line is used.  This bug is observed when there
-                    //**is a coarsening of an IVS containing only IntVect::Zero
-                    //**followed by an IVS |= IVS.
-                    for (IVSIterator ivsit(all_tags[i]); ivsit.ok(); ++ivsit)
-                      {
-                        modifiedTags[lvl] |= ivsit();
-                      }
-                    //**FIXME -- end
-                    // Regain memory used (BVS,NDK 6/30/2008)
-                    all_tags[i].makeEmpty();
+                    supportBoxes.push_back(lvlboxes[ibox]);
                   }
+                buildSupport(lvldomain, supportBoxes, modifiedTags[lvl]);
+                makeBoxesDistributed(lvlboxes, modifiedTags[lvl], m_pnds[lvl],
+                                     lvldomain, maxBoxSizeLevel, totalBufferSize[lvl]);
               }
+            else
+              {
+                const int dest_proc = uniqueProc(SerialTask::compute);
 
-            broadcast( modifiedTags[lvl] , dest_proc);
-
-            // Move this union _after_ the above gather/broadcast to
-            // reduce memory -- shouldn't have other effects. (BVS,NDK 6/30/2008)
-            // Union the meshes from the previous level with the tags on this
-            // level to guarantee that proper nesting is satisfied.  On the
-            // first iteration this is a no-op because \var{lvlboxes} is empty.
-            // [NOTE: for every iteration after the first, \var{lvlboxes} will
-            //        already be coarsened by \var{BlockFactor} so it will be
-            //        at the same refinement level as \var{tags[lvl]}, which
-            //        has also been coarsened]
-            // this is simple in the non-periodic case, more complicated
-            // in the periodic case
-            ProblemDomain lvldomain = Domains[lvl]; // domain of this level
-            buildSupport(lvldomain, lvlboxes, modifiedTags[lvl]);
+                Vector<IntVectSet> all_tags;
+                gather(all_tags, modifiedTags[lvl], dest_proc);
 
-            // this is the maximum allowable box size at this resolution
-            // which will result in satisfying the maxSize restriction when
-            // everything is refined up to the new level
-            const int maxBoxSizeLevel = m_maxSize/(m_level_blockfactors[lvl]*m_nRefVect[lvl]);
-            makeBoxes(lvlboxes, modifiedTags[lvl], m_pnds[lvl],
-                      lvldomain, maxBoxSizeLevel, totalBufferSize[lvl]);
+                if (procID() == dest_proc)
+                  {
+                    for (int i = 0; i < all_tags.size(); ++i)
+                      {
+//                       modifiedTags[lvl] |= all_tags[i];
+                        //**FIXME -- revert to above line when IVS is fixed.
+                        //**The following works around a bug in IVS that appears if
+                        //**the above line is used.  This bug is observed when there
+                        //**is a coarsening of an IVS containing only IntVect::Zero
+                        //**followed by an IVS |= IVS.
+                        for (IVSIterator ivsit(all_tags[i]); ivsit.ok(); ++ivsit)
+                          {
+                            modifiedTags[lvl] |= ivsit();
+                          }
+                        //**FIXME -- end
+                        // Regain memory used (BVS,NDK 6/30/2008)
+                        all_tags[i].makeEmpty();
+                      }
+                  }
+
+                broadcast( modifiedTags[lvl] , dest_proc);
+
+                // Move this union _after_ the above gather/broadcast to
+                // reduce memory -- shouldn't have other effects. (BVS,NDK 6/30/2008)
+                // Union the meshes from the previous level with the tags on this
+                // level to guarantee that proper nesting is satisfied.  On the
+                // first iteration this is a no-op because \var{lvlboxes} is empty.
+                // [NOTE: for every iteration after the first, \var{lvlboxes} will
+                //        already be coarsened by \var{BlockFactor} so it will be
+                //        at the same refinement level as \var{tags[lvl]}, which
+                //        has also been coarsened]
+                // this is simple in the non-periodic case, more complicated
+                // in the periodic case
+                buildSupport(lvldomain, lvlboxes, modifiedTags[lvl]);
+
+                makeBoxes(lvlboxes, modifiedTags[lvl], m_pnds[lvl],
+                          lvldomain, maxBoxSizeLevel, totalBufferSize[lvl]);
+              }
             // After change to reduce memory, this may now be needed.
             // Previously, there were a_tags.makeEmpty() calls in BRMesh.cpp, and now,
             // if there are a few tags leftover here, they will get added onto the mix -- which is not
@@ -966,6 +966,7 @@ void ReductionCopier::define(const BoxLayout& a_level,
         } // end if any of the "From" boxes were outside the domain
 
     } // end if we need to do anything for periodicity
+  defineLocalDestinations();
 }
 
 void ReductionCopier::reverse()
@@ -987,6 +988,7 @@ void ReductionCopier::reverse()
       m_toMotionPlan[i]->reverse();
     }
   m_fromMotionPlan.swap(m_toMotionPlan);
+  defineLocalDestinations();
 }
 
 int ReductionCopier::print() const
@@ -0,0 +1,75 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+#include "TiledDataIterator.H"
+#include "DataIterator.H"
+#include "BoxIterator.H"
+#include "CH_Timer.H"
+#include "NamespaceHeader.H"
+
+IntVect TiledDataIterator::s_tileSize(D_DECL6(1024, 8, 8, 8, 8, 8));
+
+TiledDataIterator::TiledDataIterator()
+  :
+  m_current(0)
+{
+}
+
+TiledDataIterator::TiledDataIterator(const BoxLayout& a_layout,
+                                     const IntVect&   a_ghost)
+  :
+  m_current(0)
+{
+  define(a_layout, a_ghost, s_tileSize);
+}
+
+TiledDataIterator::TiledDataIterator(const BoxLayout& a_layout,
+                                     const IntVect&   a_ghost,
+                                     const IntVect&   a_tileSize)
+  :
+  m_current(0)
+{
+  define(a_layout, a_ghost, a_tileSize);
+}
+
+void TiledDataIterator::define(const BoxLayout& a_layout,
+                               const IntVect&   a_ghost,
+                               const IntVect&   a_tileSize)
+{
+  CH_TIME("TiledDataIterator::define");
+  CH_assert(a_tileSize >= IntVect::Unit);
+
+  m_indices.resize(0);
+  m_tiles.resize(0);
+  m_current = 0;
+
+  DataIterator dit = a_layout.dataIterator();
+  for (dit.begin(); dit.ok(); ++dit)
+    {
+      Box b = grow(a_layout[dit], a_ghost);
+      if (b.isEmpty()) continue;
+
+      IntVect ntile;
+      for (int idir = 0; idir < SpaceDim; idir++)
+        {
+          ntile[idir] = (b.size(idir) + a_tileSize[idir] - 1)/a_tileSize[idir];
+        }
+      for (BoxIterator bit(Box(IntVect::Zero, ntile - IntVect::Unit)); bit.ok(); ++bit)
+        {
+          IntVect lo = b.smallEnd() + bit()*a_tileSize;
+          IntVect hi = lo + a_tileSize - IntVect::Unit;
+          hi.min(b.bigEnd());
+          m_indices.push_back(dit());
+          m_tiles.push_back(Box(lo, hi, b.ixType()));
+        }
+    }
+}
+
+#include "NamespaceFooter.H"
@@ -31,6 +31,8 @@
 #include "BCFunc.H"
 #include "EBLevelGrid.H"
 #include "EBAlias.H"
+#include "EBStencilCache.H"
+#include "GeometryHash.H"
 #include "ParmParse.H"
 #include "NamespaceHeader.H"
 
@@ -365,6 +367,48 @@ defineEBCFStencils()
     }
 }
 /******/
+// what defineStencils keeps in EBStencilCache for one box
+class EBAMRPoissonOpStencils : public EBStencilCache::Entry
+{
+public:
+  virtual long memUsage() const;
+
+  // in the order of the irregular vofs of the box
+  Vector<VoFStencil>                m_opStencil;
+  Vector<Real>                      m_betaWeight;
+
+  Vector<VolIndex>                  m_rhsSetList;
+  RefCountedPtr<EBStencil>          m_opEBStencil;
+  RefCountedPtr<EBStencil>          m_invDiagEBStencil;
+  RefCountedPtr<EBStencil>          m_opEBStencilInhomDomLo[SpaceDim];
+  RefCountedPtr<EBStencil>          m_opEBStencilInhomDomHi[SpaceDim];
+  Vector<RefCountedPtr<EBStencil> > m_colorEBStencil;
+};
+/******/
+long
+EBAMRPoissonOpStencils::
+memUsage() const
+{
+  long retval = sizeof(EBAMRPoissonOpStencils);
+  for (int ivof = 0; ivof < int(m_opStencil.size()); ivof++)
+    {
+      retval += EBStencilCache::memUsage(m_opStencil[ivof]);
+    }
+  retval += m_betaWeight.size()*sizeof(Real) + m_rhsSetList.size()*sizeof(VolIndex);
+  retval += EBStencilCache::memUsage(m_opEBStencil);
+  retval += EBStencilCache::memUsage(m_invDiagEBStencil);
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      retval += EBStencilCache::memUsage(m_opEBStencilInhomDomLo[idir]);
+      retval += EBStencilCache::memUsage(m_opEBStencilInhomDomHi[idir]);
+    }
+  for (int icolor = 0; icolor < int(m_colorEBStencil.size()); icolor++)
+    {
+      retval += EBStencilCache::memUsage(m_colorEBStencil[icolor]);
+    }
+  return retval;
+}
+/******/
 void
 EBAMRPoissonOp::
 defineStencils()
@@ -391,6 +435,19 @@ defineStencils()
   m_ebBC->define((*m_eblg.getCFIVS()), 1./m_dx[0]);
   LayoutData<BaseIVFAB<VoFStencil> >* ebFluxStencil = m_ebBC->getFluxStencil(0);
 
+  //the stencils of a box depend on its geometry and on what goes into
+  //this version.  boxes found in the cache are not built again.
+  GeometryHash opHash(true);
+  opHash.add(m_dx);
+  opHash.add(m_ghostCellsPhi);
+  opHash.add(m_ghostCellsRHS);
+  opHash.add(m_relaxType);
+  opHash.add(int(s_doInconsistentRelax));
+  opHash.add(int(s_areaFracWeighted));
+  opHash.add(int(s_doSetListValueResid));
+  LayoutData<RefCountedPtr<EBStencilCache::Entry> > cached(m_eblg.getDBL());
+  LayoutData<GeometryHash> version(m_eblg.getDBL());
+
   m_alphaDiagWeight.define(  m_eblg.getDBL());
   m_betaDiagWeight.define(   m_eblg.getDBL());
   m_one.define(   m_eblg.getDBL());
@@ -407,7 +464,7 @@ defineStencils()
       m_cacheInhomDomBCLo[icomp].resize(SpaceDim);
       m_cacheInhomDomBCHi[icomp].resize(SpaceDim);
     }
-  
+
   for (int idir = 0; idir < SpaceDim; idir++)
     {
       sideBoxLo[idir] = adjCellLo(domainBox, idir, 1);
@@ -443,8 +500,6 @@ defineStencils()
       BaseIVFAB<Real>&        betaWeight  = m_betaDiagWeight[dit()];
       BaseIVFAB<Real>&        one  = m_one[dit()];
       curStencilBaseIVFAB.define(notRegular,curEBGraph, 1);
-      relStencilBaseIVFAB.define(notRegular,curEBGraph, 1);
-      invDiagStencilBaseIVFAB.define(notRegular,curEBGraph, 1);
       alphaWeight.define(        notRegular,curEBGraph, 1);
       betaWeight.define(         notRegular,curEBGraph, 1);
       one.define(         notRegular,curEBGraph, 1);
@@ -477,16 +532,7 @@ defineStencils()
         {
           const VolIndex& VoF = vofit();
 
-          VoFStencil& curStencil = curStencilBaseIVFAB(VoF,0);
-          VoFStencil& relStencil = relStencilBaseIVFAB(VoF,0);
-          VoFStencil& invDiagStencil = invDiagStencilBaseIVFAB(VoF,0);
-          invDiagStencil.clear();
-
-          getDivFStencil(curStencil,VoF, dit(), true);
-          getDivFStencil(relStencil,VoF, dit(), !s_doInconsistentRelax);
-
           Real& curAlphaWeight  = alphaWeight(VoF,0);
-          Real& curBetaWeight   =  betaWeight(VoF,0);
           Real& curOne   =  one(VoF,0);
 
           const Real kappa = curEBISBox.volFrac(VoF);
@@ -498,6 +544,137 @@ defineStencils()
             {
               curAlphaWeight *= curEBISBox.areaFracScaling(VoF);
             }
+        }
+
+      //cache the inhomogeneous part of the domain bc in irregular cells
+      for (int idir = 0; idir < SpaceDim; idir++)
+        {
+          VoFIterator& vofitlo = m_vofItIrregDomLo[idir][dit()];
+          for (vofitlo.reset(); vofitlo.ok(); ++vofitlo)
+            {
+              const VolIndex& vof = vofitlo();
+              for (int icomp = 0; icomp < s_numComps; icomp++)
+                {
+                  Real flux;
+                  m_domainBC->getInhomFaceFlux(flux,
+                                               vof,
+                                               icomp,//comp
+                                               (*m_cacheInhomDomBCLo[icomp][idir])[dit()],
+                                               m_origin,
+                                               m_dx,
+                                               idir,
+                                               Side::Lo,
+                                               dit(),
+                                               s_time);
+
+                  (*m_cacheInhomDomBCLo[icomp][idir])[dit()](vof, 0) = flux;
+                }
+            }//vofitlo
+
+          VoFIterator& vofithi = m_vofItIrregDomHi[idir][dit()];
+          for (vofithi.reset(); vofithi.ok(); ++vofithi)
+            {
+              const VolIndex& vof = vofithi();
+              for (int icomp = 0; icomp < s_numComps; icomp++)
+                {
+                  Real flux;
+                  m_domainBC->getInhomFaceFlux(flux,
+                                               vof,
+                                               icomp,//comp
+                                               (*m_cacheInhomDomBCHi[icomp][idir])[dit()],
+                                               m_origin,
+                                               m_dx,
+                                               idir,
+                                               Side::Hi,
+                                               dit(),
+                                               s_time);
+
+                  (*m_cacheInhomDomBCHi[icomp][idir])[dit()](vof, 0) = flux;
+                }
+            }//vofithi
+        }//idir
+
+      //the domain flux stencils go into the version as well as the operator
+      GeometryHash boxHash = opHash;
+      EBStencilCache::hash(boxHash, (*m_eblg.getCFIVS())[dit()]);
+      boxHash.add(int(ebFluxStencil != NULL));
+      if (ebFluxStencil != NULL)
+        {
+          for (vofit.reset(); vofit.ok(); ++vofit)
+            {
+              EBStencilCache::hash(boxHash, (*ebFluxStencil)[dit()](vofit(), 0));
+            }
+        }
+      for (int idir = 0; idir < SpaceDim; idir++)
+        {
+          VoFIterator& vofitlo = m_vofItIrregDomLo[idir][dit()];
+          for (vofitlo.reset(); vofitlo.ok(); ++vofitlo)
+            {
+              VoFStencil& opStencilDomLo = opStencilDomLoBaseIVFAB[idir](vofitlo(),0);
+              opStencilDomLo.clear();
+              m_domainBC->getFluxStencil(opStencilDomLo,
+                                         vofitlo(),
+                                         0,//comp
+                                         m_dx,
+                                         idir,
+                                         Side::Lo,
+                                         curEBISBox);
+              EBStencilCache::hash(boxHash, opStencilDomLo);
+            }
+          VoFIterator& vofithi = m_vofItIrregDomHi[idir][dit()];
+          for (vofithi.reset(); vofithi.ok(); ++vofithi)
+            {
+              VoFStencil& opStencilDomHi = opStencilDomHiBaseIVFAB[idir](vofithi(),0);
+              opStencilDomHi.clear();
+              m_domainBC->getFluxStencil(opStencilDomHi,
+                                         vofithi(),
+                                         0,//comp
+                                         m_dx,
+                                         idir,
+                                         Side::Hi,
+                                         curEBISBox);
+              EBStencilCache::hash(boxHash, opStencilDomHi);
+            }
+        }
+      version[dit()] = boxHash;
+      cached[dit()] = EBStencilCache::find(EBStencilCache::Key(m_eblg, curBox, "EBAMRPoissonOp", version[dit()]));
+
+      if (!cached[dit()].isNull())
+        {
+          const EBAMRPoissonOpStencils& stencils =
+            dynamic_cast<const EBAMRPoissonOpStencils&>(*cached[dit()]);
+          int ivof = 0;
+          for (vofit.reset(); vofit.ok(); ++vofit, ++ivof)
+            {
+              curStencilBaseIVFAB(vofit(),0) = stencils.m_opStencil[ivof];
+              betaWeight(vofit(),0) = stencils.m_betaWeight[ivof];
+            }
+          rhsSetList = stencils.m_rhsSetList;
+          m_opEBStencil[dit()] = stencils.m_opEBStencil;
+          m_invDiagEBStencil[dit()] = stencils.m_invDiagEBStencil;
+          for (int idir = 0; idir < SpaceDim; idir++)
+            {
+              m_opEBStencilInhomDomLo[idir][dit()] = stencils.m_opEBStencilInhomDomLo[idir];
+              m_opEBStencilInhomDomHi[idir][dit()] = stencils.m_opEBStencilInhomDomHi[idir];
+            }
+          continue;
+        }
+
+      relStencilBaseIVFAB.define(notRegular,curEBGraph, 1);
+      invDiagStencilBaseIVFAB.define(notRegular,curEBGraph, 1);
+      for (vofit.reset(); vofit.ok(); ++vofit)
+        {
+          const VolIndex& VoF = vofit();
+
+          VoFStencil& curStencil = curStencilBaseIVFAB(VoF,0);
+          VoFStencil& relStencil = relStencilBaseIVFAB(VoF,0);
+          VoFStencil& invDiagStencil = invDiagStencilBaseIVFAB(VoF,0);
+          invDiagStencil.clear();
+
+          getDivFStencil(curStencil,VoF, dit(), true);
+          getDivFStencil(relStencil,VoF, dit(), !s_doInconsistentRelax);
+
+          Real& curBetaWeight   =  betaWeight(VoF,0);
 
           curBetaWeight = EBArith::getDiagWeight(relStencil, VoF);
           const IntVect& iv = VoF.gridIndex();
@@ -559,7 +736,7 @@ defineStencils()
             }
         }//vofitIrreg
 
-      //add in the homogeneous part of stencil when EB x domain and cache the inhomogeneous part
+      //add in the homogeneous part of stencil when EB x domain
       BaseIVFAB<VoFStencil>& opStencilBaseIVFAB = opStencil[dit()];
       for (int idir = 0; idir < SpaceDim; idir++)
         {
@@ -568,38 +745,11 @@ defineStencils()
             {
               const VolIndex& vof = vofitlo();
 
-              VoFStencil& opStencilDomLo = opStencilDomLoBaseIVFAB[idir](vof,0);
-              opStencilDomLo.clear();
-              m_domainBC->getFluxStencil(opStencilDomLo,
-                                         vof,
-                                         0,//comp
-                                         m_dx,
-                                         idir,
-                                         Side::Lo,
-                                         curEBISBox);
-
               VoFStencil& opStencil = opStencilBaseIVFAB(vof,0);
-              opStencil += opStencilDomLo;
+              opStencil += opStencilDomLoBaseIVFAB[idir](vof,0);
 
               VoFStencil& opStencilInhomDomLo = opStencilInhomDomLoBaseIVFAB[idir](vof,0);
               opStencilInhomDomLo.clear();
-
-              for (int icomp = 0; icomp < s_numComps; icomp++)
-                {
-                  Real flux;
-                  m_domainBC->getInhomFaceFlux(flux,
-                                               vof,
-                                               icomp,//comp
-                                               (*m_cacheInhomDomBCLo[icomp][idir])[dit()],
-                                               m_origin,
-                                               m_dx,
-                                               idir,
-                                               Side::Lo,
-                                               dit(),
-                                               s_time);
-
-                  (*m_cacheInhomDomBCLo[icomp][idir])[dit()](vof, 0) = flux;
-                }
             }//vofitlo
 
           VoFIterator& vofithi = m_vofItIrregDomHi[idir][dit()];
@@ -607,41 +757,15 @@ defineStencils()
             {
               const VolIndex& vof = vofithi();
 
-              VoFStencil& opStencilDomHi = opStencilDomHiBaseIVFAB[idir](vof,0);
-              opStencilDomHi.clear();
-              m_domainBC->getFluxStencil(opStencilDomHi,
-                                         vof,
-                                         0,//comp
-                                         m_dx,
-                                         idir,
-                                         Side::Hi,
-                                         curEBISBox);
-
               VoFStencil& opStencil = opStencilBaseIVFAB(vof,0);
-              opStencil += opStencilDomHi;
+              opStencil += opStencilDomHiBaseIVFAB[idir](vof,0);
 
               VoFStencil& opStencilInhomDomHi = opStencilInhomDomHiBaseIVFAB[idir](vof,0);
               opStencilInhomDomHi.clear();
-
-              for (int icomp = 0; icomp < s_numComps; icomp++)
-                {
-                  Real flux;
-                  m_domainBC->getInhomFaceFlux(flux,
-                                               vof,
-                                               icomp,//comp
-                                               (*m_cacheInhomDomBCHi[icomp][idir])[dit()],
-                                               m_origin,
-                                               m_dx,
-                                               idir,
-                                               Side::Hi,
-                                               dit(),
-                                               s_time);
-
-                  (*m_cacheInhomDomBCHi[icomp][idir])[dit()](vof, 0) = flux;
-                }
             }//vofithi
         }//idir
 
+
       //Operator ebstencil
       m_opEBStencil[dit()] =
         RefCountedPtr<EBStencil>(new EBStencil(m_vofItIrreg[dit()].getVector(),
@@ -753,7 +877,6 @@ defineStencils()
             }
 
           m_vofItIrregColor[icolor][dit()].define(ivsColor, curEBGraph);
-          colorStencilBaseIVFAB.define(ivsColor, curEBGraph, 1);
 
           for (int idir = 0; idir < SpaceDim; idir++)
             {
@@ -761,12 +884,25 @@ defineStencils()
               IntVectSet hiIrregColor = ivsColor;
               loIrregColor &= sideBoxLo[idir];
               hiIrregColor &= sideBoxHi[idir];
-              colorStencilDomLoBaseIVFAB[idir].define(loIrregColor, curEBGraph, 1);
-              colorStencilDomHiBaseIVFAB[idir].define(hiIrregColor, curEBGraph, 1);
               m_vofItIrregColorDomLo[icolor][idir][dit()].define(loIrregColor,curEBGraph);
               m_vofItIrregColorDomHi[icolor][idir][dit()].define(hiIrregColor,curEBGraph);
+              if (cached[dit()].isNull())
+                {
+                  colorStencilDomLoBaseIVFAB[idir].define(loIrregColor, curEBGraph, 1);
+                  colorStencilDomHiBaseIVFAB[idir].define(hiIrregColor, curEBGraph, 1);
+                }
             }
 
+          if (!cached[dit()].isNull())
+            {
+              const EBAMRPoissonOpStencils& stencils =
+                dynamic_cast<const EBAMRPoissonOpStencils&>(*cached[dit()]);
+              m_colorEBStencil[icolor][dit()] = stencils.m_colorEBStencil[icolor];
+              continue;
+            }
+
+          colorStencilBaseIVFAB.define(ivsColor, curEBGraph, 1);
+
           VoFIterator& vofitcolor = m_vofItIrregColor[icolor][dit()];
           for (vofitcolor.reset(); vofitcolor.ok(); ++vofitcolor)
             {
@@ -832,6 +968,36 @@ defineStencils()
 
         }//dit
     }//color
+
+  //keep what was built for the next operator on these boxes
+  for (DataIterator dit = m_eblg.getDBL().dataIterator(); dit.ok(); ++dit)
+    {
+      if (!cached[dit()].isNull())
+        {
+          continue;
+        }
+      EBAMRPoissonOpStencils* stencils = new EBAMRPoissonOpStencils();
+      VoFIterator& vofit = m_vofItIrreg[dit()];
+      for (vofit.reset(); vofit.ok(); ++vofit)
+        {
+          stencils->m_opStencil.push_back(opStencil[dit()](vofit(),0));
+          stencils->m_betaWeight.push_back(m_betaDiagWeight[dit()](vofit(),0));
+        }
+      stencils->m_rhsSetList = m_rhsSetList[dit()];
+      stencils->m_opEBStencil = m_opEBStencil[dit()];
+      stencils->m_invDiagEBStencil = m_invDiagEBStencil[dit()];
+      for (int idir = 0; idir < SpaceDim; idir++)
+        {
+          stencils->m_opEBStencilInhomDomLo[idir] = m_opEBStencilInhomDomLo[idir][dit()];
+          stencils->m_opEBStencilInhomDomHi[idir] = m_opEBStencilInhomDomHi[idir][dit()];
+        }
+      for (int icolor=0; icolor < m_colors.size(); ++icolor)
+        {
+          stencils->m_colorEBStencil.push_back(m_colorEBStencil[icolor][dit()]);
+        }
+      EBStencilCache::insert(EBStencilCache::Key(m_eblg, m_eblg.getDBL().get(dit()), "EBAMRPoissonOp", version[dit()]),
+                             RefCountedPtr<EBStencilCache::Entry>(stencils));
+    }
 }
 
 //version that does not fill ebislCoar
@@ -23,6 +23,7 @@
 #include "BCFunc.H"
 #include "EBLevelGrid.H"
 #include "EBAlias.H"
+#include "GeometryHash.H"
 #include "EBCoarseAverage.H"
 #include "ParmParse.H"
 #include "NamespaceHeader.H"
@@ -681,6 +682,32 @@ calculateRelaxationCoefficient()
     }
 }
 //-----------------------------------------------------------------------
+// what defineStencils keeps in EBStencilCache for one box
+class EBConductivityOpStencils : public EBStencilCache::Entry
+{
+public:
+  virtual long memUsage() const;
+
+  // in the order of the irregular vofs of the box
+  Vector<Real>                      m_betaWeight;
+
+  RefCountedPtr<EBStencil>          m_opEBStencil;
+  Vector<RefCountedPtr<EBStencil> > m_colorEBStencil;
+};
+//-----------------------------------------------------------------------
+long
+EBConductivityOpStencils::
+memUsage() const
+{
+  long retval = sizeof(EBConductivityOpStencils) + m_betaWeight.size()*sizeof(Real);
+  retval += EBStencilCache::memUsage(m_opEBStencil);
+  for (int icolor = 0; icolor < int(m_colorEBStencil.size()); icolor++)
+    {
+      retval += EBStencilCache::memUsage(m_colorEBStencil[icolor]);
+    }
+  return retval;
+}
+//-----------------------------------------------------------------------
 void
 EBConductivityOp::
 defineStencils()
@@ -698,6 +725,15 @@ defineStencils()
   m_ebBC->define((*m_eblg.getCFIVS()), dxScale); //has to happen AFTER coefs are set
   LayoutData<BaseIVFAB<VoFStencil> >* fluxStencil = m_ebBC->getFluxStencil(0);
 
+  //the stencils of a box depend on its geometry and on what goes into
+  //this version.  boxes found in the cache are not built again.
+  GeometryHash opHash(true);
+  opHash.add(m_dx);
+  opHash.add(m_ghostCellsPhi);
+  opHash.add(m_ghostCellsRHS);
+  LayoutData<RefCountedPtr<EBStencilCache::Entry> > cached(m_eblg.getDBL());
+  LayoutData<GeometryHash> version(m_eblg.getDBL());
+
   m_vofIterIrreg.define(     m_eblg.getDBL()); // vofiterator cache
   m_vofIterMulti.define(     m_eblg.getDBL()); // vofiterator cache
   m_alphaDiagWeight.define(  m_eblg.getDBL());
@@ -725,8 +761,6 @@ defineStencils()
       IntVectSet irregIVS = ebisBox.getIrregIVS(curBox);
       IntVectSet multiIVS = ebisBox.getMultiCells(curBox);
 
-      BaseIVFAB<VoFStencil> opStencil(irregIVS,ebgraph, 1);
-
       //cache the vofIterators
       m_alphaDiagWeight[dit()].define(irregIVS,ebisBox.getEBGraph(), 1);
       m_betaDiagWeight [dit()].define(irregIVS,ebisBox.getEBGraph(), 1);
@@ -743,7 +777,38 @@ defineStencils()
           m_vofIterDomHi[idir][dit()].define(hiIrreg,ebisBox.getEBGraph());
         }
 
+      //the irregular stencils read bcoef only on faces next to irregular cells
+      IntVectSet nearIrreg = irregIVS;
+      nearIrreg.grow(1);
+      GeometryHash boxHash = opHash;
+      EBStencilCache::hash(boxHash, (*m_eblg.getCFIVS())[dit()]);
+      EBStencilCache::hash(boxHash, (*m_bcoef)[dit()], nearIrreg);
+      boxHash.add(int(fluxStencil != NULL));
       VoFIterator& vofit = m_vofIterIrreg[dit()];
+      if (fluxStencil != NULL)
+        {
+          for (vofit.reset(); vofit.ok(); ++vofit)
+            {
+              EBStencilCache::hash(boxHash, (*fluxStencil)[dit()](vofit(), 0));
+            }
+        }
+      version[dit()] = boxHash;
+      cached[dit()] = EBStencilCache::find(EBStencilCache::Key(m_eblg, curBox, "EBConductivityOp", version[dit()]));
+
+      if (!cached[dit()].isNull())
+        {
+          const EBConductivityOpStencils& stencils =
+            dynamic_cast<const EBConductivityOpStencils&>(*cached[dit()]);
+          int ivof = 0;
+          for (vofit.reset(); vofit.ok(); ++vofit, ++ivof)
+            {
+              m_betaDiagWeight[dit()](vofit(), 0) = stencils.m_betaWeight[ivof];
+            }
+          m_opEBStencil[dit()] = stencils.m_opEBStencil;
+          continue;
+        }
+
+      BaseIVFAB<VoFStencil> opStencil(irregIVS,ebgraph, 1);
       for (vofit.reset(); vofit.ok(); ++vofit)
         {
           const VolIndex& VoF = vofit();
@@ -823,13 +888,36 @@ defineStencils()
       m_hasEBCF = m_fastFR.hasEBCF();
     }
   defineEBCFStencils();
-  defineColorStencils(sideBoxLo, sideBoxHi);
+  defineColorStencils(sideBoxLo, sideBoxHi, cached);
+
+  //keep what was built for the next operator on these boxes
+  for (DataIterator dit = m_eblg.getDBL().dataIterator(); dit.ok(); ++dit)
+    {
+      if (!cached[dit()].isNull())
+        {
+          continue;
+        }
+      EBConductivityOpStencils* stencils = new EBConductivityOpStencils();
+      VoFIterator& vofit = m_vofIterIrreg[dit()];
+      for (vofit.reset(); vofit.ok(); ++vofit)
+        {
+          stencils->m_betaWeight.push_back(m_betaDiagWeight[dit()](vofit(), 0));
+        }
+      stencils->m_opEBStencil = m_opEBStencil[dit()];
+      for (int icolor=0; icolor < m_colors.size(); ++icolor)
+        {
+          stencils->m_colorEBStencil.push_back(m_colorEBStencil[icolor][dit()]);
+        }
+      EBStencilCache::insert(EBStencilCache::Key(m_eblg, m_eblg.getDBL().get(dit()), "EBConductivityOp", version[dit()]),
+                             RefCountedPtr<EBStencilCache::Entry>(stencils));
+    }
 }
 //-----------------------------------------------------------------------
 void
 EBConductivityOp::
 defineColorStencils(Box a_sideBoxLo[SpaceDim],
-                    Box a_sideBoxHi[SpaceDim])
+                    Box a_sideBoxHi[SpaceDim],
+                    const LayoutData<RefCountedPtr<EBStencilCache::Entry> >& a_cached)
 {
   LayoutData<BaseIVFAB<VoFStencil> >* fluxStencil = m_ebBC->getFluxStencil(0);
   //define the stencils and iterators specific to gsrb.
@@ -888,6 +976,14 @@ defineColorStencils(Box a_sideBoxLo[SpaceDim],
               m_cacheEBxDomainFluxHi[icolor][idir][dit()].define(hiIrregColor,curEBGraph,1);
             }
 
+          if (!a_cached[dit()].isNull())
+            {
+              const EBConductivityOpStencils& stencils =
+                dynamic_cast<const EBConductivityOpStencils&>(*a_cached[dit()]);
+              m_colorEBStencil[icolor][dit()] = stencils.m_colorEBStencil[icolor];
+              continue;
+            }
+
           VoFIterator vofitcolor(ivsColor, curEBGraph);
           int ivof = 0;
           for (vofitcolor.reset(); vofitcolor.ok(); ++vofitcolor)
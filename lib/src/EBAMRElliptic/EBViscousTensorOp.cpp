@@ -21,6 +21,8 @@
 #include "ParmParse.H"
 #include "EBLevelDataOpsF_F.H"
 #include "EBAlias.H"
+#include "EBStencilCache.H"
+#include "GeometryHash.H"
 #include "QuadCFInterp.H"
 #include "NamespaceHeader.H"
 bool EBViscousTensorOp::s_doLazyRelax = false;
@@ -1008,6 +1010,30 @@ calculateRelaxationCoefficient()
 }
 //-----------------------------------------------------------------------
 
+/*****/
+// what defineStencils keeps in EBStencilCache for one box
+class EBViscousTensorOpStencils : public EBStencilCache::Entry
+{
+public:
+  virtual long memUsage() const;
+
+  // SpaceDim per irregular vof, in the order of the vofs of the box
+  Vector<Real>             m_betaWeight;
+
+  RefCountedPtr<EBStencil> m_opEBStencil[SpaceDim];
+};
+/*****/
+long
+EBViscousTensorOpStencils::
+memUsage() const
+{
+  long retval = sizeof(EBViscousTensorOpStencils) + m_betaWeight.size()*sizeof(Real);
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      retval += EBStencilCache::memUsage(m_opEBStencil[idir]);
+    }
+  return retval;
+}
 /*****/
 void
 EBViscousTensorOp::
@@ -1100,12 +1126,73 @@ defineStencils()
   m_ebBC->setCoef(    m_eblg,   fakeBeta,      m_etaIrreg, m_lambdaIrreg, m_eta, m_lambda);
   m_ebBC->define(    *m_eblg.getCFIVS(), 1.0);
 
+  //the stencils of a box depend on its geometry and on what goes into
+  //this version.  boxes found in the cache are not built again.
+  GeometryHash opHash(true);
+  opHash.add(m_dx);
+  opHash.add(m_ghostCellsPhi);
+  opHash.add(m_ghostCellsRHS);
+  opHash.add(int(s_setIntersectionsToZero));
+  LayoutData<RefCountedPtr<EBStencilCache::Entry> > cached(m_eblg.getDBL());
+  LayoutData<GeometryHash> version(m_eblg.getDBL());
+  for (DataIterator dit = m_eblg.getDBL().dataIterator(); dit.ok(); ++dit)
+    {
+      //the stencils read eta and lambda only on faces next to the cells of ivsStenc
+      IntVectSet nearStenc = ivsStencLD[dit()];
+      nearStenc.grow(1);
+      GeometryHash boxHash = opHash;
+      EBStencilCache::hash(boxHash, (*m_eblg.getCFIVS())[dit()]);
+      EBStencilCache::hash(boxHash, (*m_eta)[dit()], nearStenc);
+      EBStencilCache::hash(boxHash, (*m_lambda)[dit()], nearStenc);
+      VoFIterator& vofit = m_vofIterIrreg[dit()];
+      for (int ivar = 0; ivar < SpaceDim; ivar++)
+        {
+          LayoutData<BaseIVFAB<VoFStencil> >* fluxStencil = m_ebBC->getFluxStencil(ivar);
+          boxHash.add(int(fluxStencil != NULL));
+          if (fluxStencil != NULL)
+            {
+              BaseIVFAB<VoFStencil>& stenFAB = (*fluxStencil)[dit()];
+              for (vofit.reset(); vofit.ok(); ++vofit)
+                {
+                  if (stenFAB.getIVS().contains(vofit().gridIndex()))
+                    {
+                      EBStencilCache::hash(boxHash, stenFAB(vofit(), 0));
+                    }
+                }
+            }
+        }
+      version[dit()] = boxHash;
+      cached[dit()] = EBStencilCache::find(EBStencilCache::Key(m_eblg, m_eblg.getDBL().get(dit()), "EBViscousTensorOp", version[dit()]));
+
+      if (!cached[dit()].isNull())
+        {
+          const EBViscousTensorOpStencils& stencils =
+            dynamic_cast<const EBViscousTensorOpStencils&>(*cached[dit()]);
+          int iweight = 0;
+          for (vofit.reset(); vofit.ok(); ++vofit)
+            {
+              for (int ivar = 0; ivar < SpaceDim; ivar++, iweight++)
+                {
+                  m_betaDiagWeight[dit()](vofit(), ivar) = stencils.m_betaWeight[iweight];
+                }
+            }
+          for (int ivar = 0; ivar < SpaceDim; ivar++)
+            {
+              m_opEBStencil[ivar][dit()] = stencils.m_opEBStencil[ivar];
+            }
+        }
+    }
+
   //now define the stencils for each variable
   for (int ivar = 0; ivar < SpaceDim; ivar++)
     {
       LayoutData<BaseIVFAB<VoFStencil> >* fluxStencil = m_ebBC->getFluxStencil(ivar);
       for (DataIterator dit = m_eblg.getDBL().dataIterator(); dit.ok(); ++dit)
         {
+          if (!cached[dit()].isNull())
+            {
+              continue;
+            }
           const EBISBox& ebisBox = m_eblg.getEBISL()[dit()];
           for (m_vofIterIrreg[dit()].reset(); m_vofIterIrreg[dit()].ok(); ++m_vofIterIrreg[dit()])
             {
@@ -1160,6 +1247,30 @@ defineStencils()
 
         }
     }
+
+  //keep what was built for the next operator on these boxes
+  for (DataIterator dit = m_eblg.getDBL().dataIterator(); dit.ok(); ++dit)
+    {
+      if (!cached[dit()].isNull())
+        {
+          continue;
+        }
+      EBViscousTensorOpStencils* stencils = new EBViscousTensorOpStencils();
+      VoFIterator& vofit = m_vofIterIrreg[dit()];
+      for (vofit.reset(); vofit.ok(); ++vofit)
+        {
+          for (int ivar = 0; ivar < SpaceDim; ivar++)
+            {
+              stencils->m_betaWeight.push_back(m_betaDiagWeight[dit()](vofit(), ivar));
+            }
+        }
+      for (int ivar = 0; ivar < SpaceDim; ivar++)
+        {
+          stencils->m_opEBStencil[ivar] = m_opEBStencil[ivar][dit()];
+        }
+      EBStencilCache::insert(EBStencilCache::Key(m_eblg, m_eblg.getDBL().get(dit()), "EBViscousTensorOp", version[dit()]),
+                             RefCountedPtr<EBStencilCache::Entry>(stencils));
+    }
   calculateAlphaWeight();
   calculateRelaxationCoefficient();
 }
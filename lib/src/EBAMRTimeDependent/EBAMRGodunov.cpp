@@ -290,6 +290,8 @@ Real EBAMRGodunov::advance()
                                    told,
                                    tnew,
                                    m_dt);
+    measuredCosts(m_grids.boxArray(), m_ebLevelGodunov.boxCosts());
+    m_ebLevelGodunov.clearBoxCosts();
   }
   dumpDebug(string("after levelgodunov"));
 
@@ -811,7 +813,7 @@ void EBAMRGodunov::regrid(const Vector<Box>& a_new_grids)
     }
   else
     {
-      LoadBalance(proc_map,a_new_grids);
+      loadBalanceGrids(proc_map,a_new_grids);
     }
 
   m_grids= DisjointBoxLayout(a_new_grids,proc_map);
@@ -860,7 +862,7 @@ void EBAMRGodunov::initialGrid(const Vector<Box>& a_new_grids)
     }
   else
     {
-      LoadBalance(proc_map,a_new_grids);
+      loadBalanceGrids(proc_map,a_new_grids);
     }
   if (s_verbosity >= 3)
     {
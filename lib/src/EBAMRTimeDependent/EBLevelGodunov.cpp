@@ -47,6 +47,26 @@ EBLevelGodunov::~EBLevelGodunov()
 /*****************************/
 /*****************************/
 void
+EBLevelGodunov::clearBoxCosts()
+{
+  m_boxCosts.resize(0);
+  m_boxCosts.resize(m_thisGrids.size(), 0);
+}
+/*****************************/
+/*****************************/
+void
+EBLevelGodunov::addBoxCosts(const TimedDataIterator& a_dit)
+{
+  const Vector<unsigned long long>& times = a_dit.getTime();
+  CH_assert(times.size() == m_boxCosts.size());
+  for (int ibox = 0; ibox < times.size(); ibox++)
+    {
+      m_boxCosts[ibox] += times[ibox];
+    }
+}
+/*****************************/
+/*****************************/
+void
 EBLevelGodunov::define(const DisjointBoxLayout&      a_thisDBL,
                        const DisjointBoxLayout&      a_coarDBL,
                        const EBISLayout&             a_thisEBISL,
@@ -69,6 +89,7 @@ EBLevelGodunov::define(const DisjointBoxLayout&      a_thisDBL,
   m_isDefined = true;
   m_useMassRedist = a_useMassRedist;
   m_thisGrids = a_thisDBL;
+  clearBoxCosts();
   m_thisEBISL = a_thisEBISL;
   m_refRatCrse= a_nRefine;
   m_dx = a_dx;
@@ -280,7 +301,11 @@ doRegularUpdate(EBFluxRegister&               a_fineFluxRegister,
   int ibox = 0;
   Interval consInterv(0, m_nCons-1);
   Interval fluxInterv(0, m_nFlux-1);
-  for (DataIterator dit = m_thisGrids.dataIterator(); dit.ok(); ++dit, ibox++)
+  //time each box so AMR can balance on measured cost
+  TimedDataIterator dit = m_thisGrids.timedDataIterator();
+  dit.clearTime();
+  dit.enableTime();
+  for (dit.begin(); dit.ok(); ++dit, ibox++)
     {
       const Box& cellBox = m_thisGrids.get(dit());
       const EBISBox& ebisBox = m_thisEBISL[dit()];
@@ -373,6 +398,7 @@ doRegularUpdate(EBFluxRegister&               a_fineFluxRegister,
             }
         }
     }
+  addBoxCosts(dit);
 
   for (int faceDir = 0; faceDir < SpaceDim; faceDir++)
     {
@@ -393,7 +419,11 @@ doIrregularUpdate(EBFluxRegister&               a_fineFluxRegister,
   int ibox = 0;
   Interval consInterv(0, m_nCons-1);
   Interval fluxInterv(0, m_nFlux-1);
-  for (DataIterator dit = m_thisGrids.dataIterator(); dit.ok(); ++dit, ibox++)
+  //time each box so AMR can balance on measured cost
+  TimedDataIterator dit = m_thisGrids.timedDataIterator();
+  dit.clearTime();
+  dit.enableTime();
+  for (dit.begin(); dit.ok(); ++dit, ibox++)
     {
       const Box& cellBox = m_thisGrids.get(dit());
       const EBISBox& ebisBox = m_thisEBISL[dit()];
@@ -471,6 +501,7 @@ doIrregularUpdate(EBFluxRegister&               a_fineFluxRegister,
             }
         }
     }// end of loop over grids.
+  addBoxCosts(dit);
   a_consState.exchange(consInterv);
   return maxWaveSpeed;
 }
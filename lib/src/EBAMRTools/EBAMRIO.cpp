@@ -1841,7 +1841,7 @@ writeEBInfo(HDF5Handle& a_handle,
         const EBGraph& graph = ebox.getEBGraph();
         b.grow(a_ghost);
         int index = dbl.index(dit());
-        const BaseIVFAB<VolData>& vdata = ebox.getEBData().getVolData();
+        const EBData& ebdata = ebox.getEBData();
         // VoF data
         int size = a_offsets[0][index+1]-a_offsets[0][index];
         if (size > 0)
@@ -1856,13 +1856,8 @@ writeEBInfo(HDF5Handle& a_handle,
 
           for (int i=0; it.ok(); ++it, ++i)
             {
-              VolData& v = (VolData&)vdata(it(), 0);
-              buffer[i] = v;
+              buffer[i] = ebdata.volData(it());
               buffer[i] = it();
-
-              int& volCount = (int&)(v.m_averageFace.m_volIndex);
-              volCount = i;  // two phase flow hack.
-                             // I know that this member isn't used.
             }
           writeDataset(vdataset, vdataspace, &(buffer[0]), a_offsets[0][index], size);
 
@@ -1883,9 +1878,6 @@ writeEBInfo(HDF5Handle& a_handle,
                 fbuffer[i].m_loIv = face.gridIndex(Side::Lo);
                 fbuffer[i].m_loVof = face.cellIndex(Side::Lo);
                 fbuffer[i].m_hiVof = face.cellIndex(Side::Hi);
-                // two phase flow hack, see also above.   in single phase code, these next two lines are broken.
-                //fbuffer[i].m_loVof = (int)(vdata(face.getVoF(Side::Lo),0).m_averageFace.m_volIndex.cellIndex());
-                //fbuffer[i].m_hiVof = (int)(vdata(face.getVoF(Side::Hi),0).m_averageFace.m_volIndex.cellIndex());
               }
               writeDataset(fdataset[dir], fdataspace[dir], &(fbuffer[0]),
                            a_offsets[dir+1][index], size);
@@ -19,6 +19,7 @@
 #include "EBArith.H"
 #include "CH_Timer.H"
 #include "EBLevelDataOps.H"
+#include "EBStencilCache.H"
 #include "NamespaceHeader.H"
 /************************************/
 void
@@ -29,6 +30,18 @@ EBMGAverage::setDefaultValues()
   m_nComp = -1;
 }
 /************************************/
+// what defineStencils keeps in EBStencilCache for one coarse box
+class EBMGAverageStencil : public EBStencilCache::Entry
+{
+public:
+  virtual long memUsage() const
+  {
+    return sizeof(EBMGAverageStencil) + EBStencilCache::memUsage(m_averageEBStencil);
+  }
+
+  RefCountedPtr<EBStencil> m_averageEBStencil;
+};
+/************************************/
 EBMGAverage::EBMGAverage()
 {
   setDefaultValues();
@@ -188,6 +201,24 @@ defineStencils()
         const EBISBox& ebisBoxCoar = ebislStenCoar[dit()];
         const EBGraph& ebGraphCoar = ebisBoxCoar.getEBGraph();
 
+        //the stencil of a coarse box depends only on the geometry
+        GeometryHash boxHash(true);
+        boxHash.add(boxFine);
+        boxHash.add(m_refRat);
+        boxHash.add(m_ghost);
+        boxHash.add(ebislStenFine.getGhost());
+        EBStencilCache::Key key(ebislStenCoar.getEBIS(), m_coarDomain, ebislStenCoar.getGhost(),
+                                boxCoar, "EBMGAverage", boxHash);
+        if (key.m_ebisPtr != NULL)
+          {
+            RefCountedPtr<EBStencilCache::Entry> cached = EBStencilCache::find(key);
+            if (!cached.isNull())
+              {
+                m_averageEBStencil[dit()] = dynamic_cast<const EBMGAverageStencil&>(*cached).m_averageEBStencil;
+                continue;
+              }
+          }
+
         IntVectSet notRegularCoar = ebisBoxCoar.getIrregIVS(boxCoar);
         vofItIrregCoar[dit()].define(notRegularCoar, ebGraphCoar);
 
@@ -221,6 +252,12 @@ defineStencils()
           }
 
         m_averageEBStencil[dit()] = RefCountedPtr<EBStencil>(new EBStencil(allCoarVofs, averageStencil[dit()], boxCoar,  boxFine, ebisBoxCoar,  ebisBoxFine,  m_ghost, m_ghost));
+        if (key.m_ebisPtr != NULL)
+          {
+            EBMGAverageStencil* stencil = new EBMGAverageStencil();
+            stencil->m_averageEBStencil = m_averageEBStencil[dit()];
+            EBStencilCache::insert(key, RefCountedPtr<EBStencilCache::Entry>(stencil));
+          }
       }
   }
 }
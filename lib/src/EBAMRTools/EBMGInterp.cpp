@@ -19,6 +19,7 @@
 #include "EBArith.H"
 #include "CH_Timer.H"
 #include "EBLevelGrid.H"
+#include "EBStencilCache.H"
 #include "NamespaceHeader.H"
 
 /************************************/
@@ -31,6 +32,20 @@ EBMGInterp::setDefaultValues()
   m_nComp = -1;
 }
 /************************************/
+// what defineStencils keeps in EBStencilCache for one coarse box
+class EBMGInterpStencils : public EBStencilCache::Entry
+{
+public:
+  virtual long memUsage() const
+  {
+    return sizeof(EBMGInterpStencils) + EBStencilCache::memUsage(m_interpEBStencil)
+      + EBStencilCache::memUsage(m_linearEBStencil);
+  }
+
+  RefCountedPtr<EBStencil> m_interpEBStencil;
+  RefCountedPtr<EBStencil> m_linearEBStencil;
+};
+/************************************/
 EBMGInterp::EBMGInterp()
 {
   setDefaultValues();
@@ -180,6 +195,31 @@ defineStencils()
         const EBGraph& ebGraphFine =  ebisBoxFine.getEBGraph();
 
         const Box& boxCoar         = gridsStenCoar[dit()];
+
+        //the stencils of a coarse box depend only on the geometry
+        GeometryHash boxHash(true);
+        boxHash.add(boxFine);
+        boxHash.add(m_refRat);
+        boxHash.add(m_ghost);
+        boxHash.add(ebislStenFine.getGhost());
+        boxHash.add(int(m_doLinear));
+        EBStencilCache::Key key(ebislStenCoar.getEBIS(), m_coarDomain, ebislStenCoar.getGhost(),
+                                boxCoar, "EBMGInterp", boxHash);
+        if (key.m_ebisPtr != NULL)
+          {
+            RefCountedPtr<EBStencilCache::Entry> cached = EBStencilCache::find(key);
+            if (!cached.isNull())
+              {
+                const EBMGInterpStencils& stencils = dynamic_cast<const EBMGInterpStencils&>(*cached);
+                m_interpEBStencil[dit()] = stencils.m_interpEBStencil;
+                if (m_doLinear)
+                  {
+                    m_linearEBStencil[dit()] = stencils.m_linearEBStencil;
+                  }
+                continue;
+              }
+          }
+
         IntVectSet notRegularCoar = ebisBoxCoar.getIrregIVS(boxCoar);
 
         IntVectSet ivsFine = refine(notRegularCoar, m_refRat);
@@ -194,6 +234,16 @@ defineStencils()
                                 ebislStenFine, ebislStenCoar,
                                 boxFine, boxCoar);
           }
+        if (key.m_ebisPtr != NULL)
+          {
+            EBMGInterpStencils* stencils = new EBMGInterpStencils();
+            stencils->m_interpEBStencil = m_interpEBStencil[dit()];
+            if (m_doLinear)
+              {
+                stencils->m_linearEBStencil = m_linearEBStencil[dit()];
+              }
+            EBStencilCache::insert(key, RefCountedPtr<EBStencilCache::Entry>(stencils));
+          }
       }
   }
 }
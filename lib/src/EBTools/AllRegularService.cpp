@@ -65,4 +65,12 @@ AllRegularService::fillGraph(BaseFab<int>&        a_regIrregCovered,
 }
 /*******************/
 /*******************/
+bool
+AllRegularService::hash(GeometryHash& a_hash) const
+{
+  a_hash.add(std::string("AllRegularService"));
+  return true;
+}
+/*******************/
+/*******************/
 #include "NamespaceFooter.H"
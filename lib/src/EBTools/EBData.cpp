@@ -11,6 +11,7 @@
 //  ANAG, LBNL
 
 #include <cmath>
+#include <algorithm>
 
 #include "EBData.H"
 #include "VoFIterator.H"
@@ -185,6 +186,7 @@ addFullIrregularVoFs(const IntVectSet& a_vofsToChange,
 {
   if (!a_vofsToChange.isEmpty())
     {
+      expand();
       //calculate set by adding in new intvects
       const IntVectSet& ivsOld = m_volData.getIVS();
       IntVectSet ivsNew = ivsOld | a_vofsToChange;
@@ -289,6 +291,7 @@ addEmptyIrregularVoFs(const IntVectSet& a_vofsToChange,
 {
   if (!a_vofsToChange.isEmpty())
     {
+      expand();
       //calculate set by adding in new intvects
       const IntVectSet& ivsOld = m_volData.getIVS();
       IntVectSet ivsNew = ivsOld | a_vofsToChange;
@@ -355,6 +358,7 @@ EBDataImplem()
 {
   m_isVoFDataDefined = false;
   m_isFaceDataDefined = false;
+  m_isCompact = false;
 }
 /************************/
 EBDataImplem::
@@ -383,7 +387,20 @@ copy(const Box&      a_regionFrom,
   CH_assert(m_isFaceDataDefined);
   CH_assert(a_source.m_isVoFDataDefined);
   CH_assert(a_source.m_isFaceDataDefined);
+  expand();
   Interval ivsca(0,0);
+  if (a_source.m_isCompact)
+    {
+      EBDataImplem expanded;
+      a_source.fillExpanded(expanded.m_volData, expanded.m_faceData,
+                            a_source.m_compactIVS & grow(a_regionFrom, 1));
+      m_volData.copy(a_regionFrom, ivsca, a_regionTo, expanded.m_volData ,ivsca);
+      for (int idir = 0; idir < SpaceDim; idir++)
+        {
+          m_faceData[idir].copy(a_regionFrom, ivsca, a_regionTo, expanded.m_faceData[idir], ivsca);
+        }
+      return;
+    }
   m_volData.copy(a_regionFrom, ivsca, a_regionTo, a_source.m_volData ,ivsca);
   for (int idir = 0; idir < SpaceDim; idir++)
     {
@@ -398,6 +415,7 @@ defineVoFData(const EBGraph& a_graph,
 {
   CH_TIME("EBDataImpem::defineVoFData");
   m_isVoFDataDefined = true;
+  clearCompact();
 
   IntVectSet ivsIrreg = a_graph.getIrregCells(a_validBox);
   m_volData.define(ivsIrreg, a_graph, 1);
@@ -409,6 +427,7 @@ defineFaceData(const EBGraph& a_graph,
 {
   CH_TIME("EBDataImpem::defineFaceData");
   m_isFaceDataDefined = true;
+  clearCompact();
   IntVectSet ivsIrreg = a_graph.getIrregCells(a_validBox);
   for (int idir = 0; idir < SpaceDim; idir++)
     {
@@ -470,12 +489,25 @@ EBDataImplem::define(const EBGraph&           a_graph,
 /*******************************/
 const Real& EBDataImplem::volFrac(const VolIndex& a_vof) const
 {
+  if (m_isCompact)
+    {
+      return m_volFrac[vofOrdinal(a_vof)];
+    }
   return m_volData(a_vof, 0).m_volFrac;
 }
 
 /*******************************/
 const Real& EBDataImplem::bndryArea(const VolIndex& a_vof, int face) const
 {
+  if (m_isCompact)
+    {
+      int numFaces;
+      const BoundaryData* faces = phaseFaces(numFaces, a_vof);
+      if (numFaces > 0)
+        return faces[face].m_bndryArea;
+      CH_assert(face == 0);
+      return m_bndryArea[vofOrdinal(a_vof)];
+    }
   const VolData& v =  m_volData(a_vof, 0);
   if (v.m_phaseFaces.size()>0)
     return v.m_phaseFaces[face].m_bndryArea;
@@ -486,6 +518,13 @@ const Real& EBDataImplem::bndryArea(const VolIndex& a_vof, int face) const
 const Real& EBDataImplem::bndryArea(const VolIndex& a_vof) const
 {
   static Real zero = 0;
+  if (m_isCompact)
+    {
+      if (cellOrdinal(a_vof.gridIndex()) >= 0)
+        return m_bndryArea[vofOrdinal(a_vof)];
+
+      return zero;
+    }
   if (m_volData.getIVS().contains(a_vof.gridIndex()))
     return m_volData(a_vof, 0).m_averageFace.m_bndryArea;
 
@@ -495,11 +534,24 @@ const Real& EBDataImplem::bndryArea(const VolIndex& a_vof) const
 /*******************************/
 const RealVect& EBDataImplem::normal(const VolIndex& a_vof) const
 {
+  if (m_isCompact)
+    {
+      return m_normal[vofOrdinal(a_vof)];
+    }
   return m_volData(a_vof, 0).m_averageFace.m_normal;
 
 }
 const RealVect& EBDataImplem::normal(const VolIndex& a_vof, int face) const
 {
+  if (m_isCompact)
+    {
+      int numFaces;
+      const BoundaryData* faces = phaseFaces(numFaces, a_vof);
+      if (numFaces > 0)
+        return faces[face].m_normal;
+      CH_assert(face == 0);
+      return m_normal[vofOrdinal(a_vof)];
+    }
   const VolData& v =  m_volData(a_vof, 0);
   if (v.m_phaseFaces.size()>0)
     return v.m_phaseFaces[face].m_normal;
@@ -510,15 +562,32 @@ const RealVect& EBDataImplem::normal(const VolIndex& a_vof, int face) const
 /*******************************/
 const RealVect& EBDataImplem::centroid(const VolIndex& a_vof) const
 {
+  if (m_isCompact)
+    {
+      return m_volCentroid[vofOrdinal(a_vof)];
+    }
   return m_volData(a_vof, 0).m_volCentroid;
 }
 /*******************************/
 const RealVect& EBDataImplem::bndryCentroid(const VolIndex& a_vof) const
 {
+  if (m_isCompact)
+    {
+      return m_bndryCentroid[vofOrdinal(a_vof)];
+    }
   return m_volData(a_vof, 0).m_averageFace.m_bndryCentroid;
 }
 const RealVect& EBDataImplem::bndryCentroid(const VolIndex& a_vof, int face) const
 {
+  if (m_isCompact)
+    {
+      int numFaces;
+      const BoundaryData* faces = phaseFaces(numFaces, a_vof);
+      if (numFaces > 0)
+        return faces[face].m_bndryCentroid;
+      CH_assert(face == 0);
+      return m_bndryCentroid[vofOrdinal(a_vof)];
+    }
   const VolData& v =  m_volData(a_vof, 0);
   if (v.m_phaseFaces.size()>0)
     return v.m_phaseFaces[face].m_bndryCentroid;
@@ -530,18 +599,33 @@ const RealVect& EBDataImplem::bndryCentroid(const VolIndex& a_vof, int face) con
   /// used by multi-fluid code
 int EBDataImplem::facePhase(const VolIndex& a_vof, int face) const
 {
+  if (m_isCompact)
+    {
+      int numFaces;
+      const BoundaryData* faces = phaseFaces(numFaces, a_vof);
+      CH_assert(face < numFaces);
+      return faces[face].m_bndryPhase;
+    }
   return m_volData(a_vof, 0).m_phaseFaces[face].m_bndryPhase;
 }
 
   /// used by multi-fluid code
 const VolIndex& EBDataImplem::faceIndex(const VolIndex& a_vof, int face) const
 {
+  if (m_isCompact)
+    {
+      int numFaces;
+      const BoundaryData* faces = phaseFaces(numFaces, a_vof);
+      CH_assert(face < numFaces);
+      return faces[face].m_volIndex;
+    }
   return m_volData(a_vof, 0).m_phaseFaces[face].m_volIndex;
 }
 
   /// used by multi-fluid code
 void EBDataImplem::setFacePhase(const VolIndex& a_vof, int face, int phase)
 {
+  expand();
   VolData& voldat = m_volData(a_vof, 0);
   voldat.m_phaseFaces[face].m_bndryPhase=phase;
 }
@@ -549,12 +633,19 @@ void EBDataImplem::setFacePhase(const VolIndex& a_vof, int face, int phase)
   /// used by multi-fluid code
 void EBDataImplem::setFaceIndex(const VolIndex& a_vof, int face, const VolIndex& index)
 {
+  expand();
   m_volData(a_vof, 0).m_phaseFaces[face].m_volIndex = index;
 }
 
 ///
 int EBDataImplem::numFacePhase(const VolIndex& a_vof) const
 {
+  if (m_isCompact)
+    {
+      int numFaces;
+      phaseFaces(numFaces, a_vof);
+      return numFaces;
+    }
   return  m_volData(a_vof, 0).m_phaseFaces.size();
 }
 
@@ -562,12 +653,20 @@ int EBDataImplem::numFacePhase(const VolIndex& a_vof) const
 const RealVect& EBDataImplem::centroid(const FaceIndex& a_face) const
 {
   int faceDir = a_face.direction();
+  if (m_isCompact)
+    {
+      return m_faceCentroid[faceDir][faceOrdinal(a_face)];
+    }
   return m_faceData[faceDir](a_face, 0).m_faceCentroid;
 }
 /*******************************/
 const Real& EBDataImplem::areaFrac(const FaceIndex& a_face) const
 {
   int faceDir = a_face.direction();
+  if (m_isCompact)
+    {
+      return m_areaFrac[faceDir][faceOrdinal(a_face)];
+    }
   return m_faceData[faceDir](a_face, 0).m_areaFrac;
 }
 /*******************************/
@@ -654,6 +753,7 @@ void EBData::setBoundaryPhase(int phase)
 
 void   EBDataImplem::setBoundaryPhase(int phase)
 {
+  expand();
   CH_assert(m_volData.nComp() == 1);
   VolData*  p = m_volData.dataPtr(0);
   for (int i=0; i<m_volData.numVoFs(); ++i)
@@ -670,6 +770,7 @@ void EBData::clearMultiBoundaries()
 
 void   EBDataImplem::clearMultiBoundaries()
 {
+  expand();
   CH_assert(m_volData.nComp() == 1);
   if (m_volData.numVoFs() > 0)
     {
@@ -717,7 +818,7 @@ coarsenVoFs(const EBDataImplem&  a_fineEBDataImplem,
 
               if (a_fineGraph.isIrregular(vofFine.gridIndex()))
                 {
-                  const VolData& vol = a_fineEBDataImplem.m_volData(vofFine,0);
+                  const VolData vol = a_fineEBDataImplem.volData(vofFine);
                   bndryAreaFine[ifine] = vol.m_averageFace.m_bndryArea;
                   //a_fineEBDataImplem.bndryArea(vofFine);
 
@@ -1028,6 +1129,14 @@ EBDataImplem::size(const Box& a_region, const Interval& a_comps) const
 {
   CH_assert(m_isFaceDataDefined);
   CH_assert(m_isVoFDataDefined);
+  if (m_isCompact)
+    {
+      EBDataImplem expanded;
+      expanded.m_isVoFDataDefined  = true;
+      expanded.m_isFaceDataDefined = true;
+      fillExpanded(expanded.m_volData, expanded.m_faceData, m_compactIVS & grow(a_region, 1));
+      return expanded.size(a_region, a_comps);
+    }
   int linearSize = m_volData.size(a_region, a_comps);
   for (int idir = 0; idir < SpaceDim; idir++)
     {
@@ -1047,6 +1156,15 @@ EBDataImplem::linearOut(void* a_buf,
 {
   CH_assert(m_isFaceDataDefined);
   CH_assert(m_isVoFDataDefined);
+  if (m_isCompact)
+    {
+      EBDataImplem expanded;
+      expanded.m_isVoFDataDefined  = true;
+      expanded.m_isFaceDataDefined = true;
+      fillExpanded(expanded.m_volData, expanded.m_faceData, m_compactIVS & grow(a_region, 1));
+      expanded.linearOut(a_buf, a_region, a_comps);
+      return;
+    }
 
   if (s_verboseDebug)
     {
@@ -1084,6 +1202,7 @@ EBDataImplem::linearIn(void*           a_buf,
 {
   CH_assert(m_isFaceDataDefined);
   CH_assert(m_isVoFDataDefined);
+  expand();
 
   if (s_verboseDebug)
     {
@@ -1121,6 +1240,405 @@ EBDataImplem::linearIn(void*           a_buf,
     }
 }
 /*******************************/
+int
+EBDataImplem::cellOrdinal(const IntVect& a_iv) const
+{
+  if (!m_cellBox.contains(a_iv))
+    {
+      return -1;
+    }
+  int key = m_cellBox.index(a_iv);
+  const int* keys = &m_cellKey[0];
+  const int* found = std::lower_bound(keys, keys + m_cellKey.size(), key);
+  if ((found == keys + m_cellKey.size()) || (*found != key))
+    {
+      return -1;
+    }
+  return found - keys;
+}
+/*******************************/
+int
+EBDataImplem::vofOrdinal(const VolIndex& a_vof) const
+{
+  int ordinal = cellOrdinal(a_vof.gridIndex());
+  CH_assert(ordinal >= 0);
+  if (a_vof.cellIndex() > 0)
+    {
+      const int* multi = &m_multiCell[0];
+      const int* found = std::lower_bound(multi, multi + m_multiCell.size(), ordinal);
+      CH_assert((found != multi + m_multiCell.size()) && (*found == ordinal));
+      ordinal = m_multiFirst[found - multi] + a_vof.cellIndex() - 1;
+    }
+  return ordinal;
+}
+/*******************************/
+int
+EBDataImplem::faceOrdinal(const FaceIndex& a_face) const
+{
+  int idir = a_face.direction();
+  const Box& faceBox = m_faceBox[idir];
+  const Vector<int>& faceKey = m_faceKey[idir];
+  IntVect ivHi = a_face.gridIndex(Side::Hi);
+  CH_assert(faceBox.contains(ivHi));
+  int key = faceBox.index(ivHi);
+  const int* keys = &faceKey[0];
+  const int* found = std::lower_bound(keys, keys + faceKey.size(), key);
+  CH_assert((found != keys + faceKey.size()) && (*found == key));
+  int ordinal = found - keys;
+
+  // the faces at a cell are numbered by their vofs on either side
+  int cellLo = a_face.cellIndex(Side::Lo);
+  int cellHi = a_face.cellIndex(Side::Hi);
+  int local;
+  if (a_face.isBoundary())
+    {
+      local = Max(cellLo, cellHi);
+    }
+  else
+    {
+      local = cellLo;
+      if (cellHi > 0)
+        {
+          local += cellHi*m_compactFaceGraph.numVoFs(a_face.gridIndex(Side::Lo));
+        }
+    }
+  if (local > 0)
+    {
+      const Vector<int>& multiFace = m_multiFace[idir];
+      const int* multi = &multiFace[0];
+      const int* foundMulti = std::lower_bound(multi, multi + multiFace.size(), ordinal);
+      CH_assert((foundMulti != multi + multiFace.size()) && (*foundMulti == ordinal));
+      ordinal = m_multiFaceFirst[idir][foundMulti - multi] + local - 1;
+    }
+  return ordinal;
+}
+/*******************************/
+int
+EBDataImplem::sideIndex(int a_vofOrdinal) const
+{
+  if (m_sideVoF.size() == 0)
+    {
+      return -1;
+    }
+  const int* side = &m_sideVoF[0];
+  const int* found = std::lower_bound(side, side + m_sideVoF.size(), a_vofOrdinal);
+  if ((found == side + m_sideVoF.size()) || (*found != a_vofOrdinal))
+    {
+      return -1;
+    }
+  return found - side;
+}
+/*******************************/
+const BoundaryData*
+EBDataImplem::phaseFaces(int& a_numFaces, const VolIndex& a_vof) const
+{
+  a_numFaces = 0;
+  int iside = sideIndex(vofOrdinal(a_vof));
+  if (iside < 0)
+    {
+      return NULL;
+    }
+  a_numFaces = m_sideFirst[iside+1] - m_sideFirst[iside];
+  if (a_numFaces == 0)
+    {
+      return NULL;
+    }
+  return &m_phaseFaces[m_sideFirst[iside]];
+}
+/*******************************/
+VolData
+EBDataImplem::compactVolData(const VolIndex& a_vof) const
+{
+  int ordinal = vofOrdinal(a_vof);
+  VolData volData;
+  volData.m_volFrac     = m_volFrac[ordinal];
+  volData.m_volCentroid = m_volCentroid[ordinal];
+
+  VolIndex averageIndex = a_vof;
+  int iside = sideIndex(ordinal);
+  if (iside >= 0)
+    {
+      averageIndex = m_sideVolIndex[iside];
+      for (int iface = m_sideFirst[iside]; iface < m_sideFirst[iside+1]; iface++)
+        {
+          volData.m_phaseFaces.push_back(m_phaseFaces[iface]);
+        }
+    }
+  volData.m_averageFace = BoundaryData(m_bndryArea[ordinal],
+                                       m_normal[ordinal],
+                                       m_bndryCentroid[ordinal],
+                                       m_bndryPhase[ordinal],
+                                       averageIndex);
+  return volData;
+}
+/*******************************/
+FaceData
+EBDataImplem::compactFaceData(const FaceIndex& a_face) const
+{
+  int idir = a_face.direction();
+  int ordinal = faceOrdinal(a_face);
+  FaceData faceData;
+  faceData.m_areaFrac     = m_areaFrac[idir][ordinal];
+  faceData.m_faceCentroid = m_faceCentroid[idir][ordinal];
+  return faceData;
+}
+/*******************************/
+void
+EBDataImplem::fillExpanded(BaseIVFAB<VolData>&  a_volData,
+                           BaseIFFAB<FaceData>  a_faceData[SpaceDim],
+                           const IntVectSet&    a_ivs) const
+{
+  CH_assert(m_isCompact);
+  a_volData.define(a_ivs, m_compactGraph, 1);
+  for (VoFIterator vofit(a_ivs, m_compactGraph); vofit.ok(); ++vofit)
+    {
+      a_volData(vofit(), 0) = compactVolData(vofit());
+    }
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      a_faceData[idir].define(a_ivs, m_compactFaceGraph, idir, 1);
+      for (FaceIterator faceit(a_ivs, m_compactFaceGraph, idir, FaceStop::SurroundingWithBoundary);
+          faceit.ok(); ++faceit)
+        {
+          a_faceData[idir](faceit(), 0) = compactFaceData(faceit());
+        }
+    }
+}
+/*******************************/
+// sorts the cells and faces of compact() by their offsets
+struct CompactEntry
+{
+  int      m_key;
+  int      m_local;
+  IntVect  m_iv;
+  FaceData m_data;
+
+  bool operator<(const CompactEntry& a_entry) const
+  {
+    return ((m_key < a_entry.m_key) ||
+            ((m_key == a_entry.m_key) && (m_local < a_entry.m_local)));
+  }
+};
+/*******************************/
+void
+EBDataImplem::compact()
+{
+  CH_TIME("EBDataImplem::compact");
+  if (m_isCompact || !m_isVoFDataDefined || !m_isFaceDataDefined || !m_volData.isDefined())
+    {
+      return;
+    }
+  m_compactGraph     = m_volData.getEBGraph();
+  m_compactFaceGraph = m_faceData[0].getEBGraph();
+  m_compactIVS       = m_volData.getIVS();
+  m_cellBox      = m_compactIVS.minBox();
+
+  // the cells, in the order of their offsets
+  std::vector<CompactEntry> cells;
+  for (IVSIterator ivsit(m_compactIVS); ivsit.ok(); ++ivsit)
+    {
+      CompactEntry entry;
+      entry.m_iv    = ivsit();
+      entry.m_key   = m_cellBox.index(entry.m_iv);
+      entry.m_local = 0;
+      cells.push_back(entry);
+    }
+  std::sort(cells.begin(), cells.end());
+  int numCells = cells.size();
+  int numVoFs = numCells;
+  m_cellKey.resize(numCells);
+  for (int icell = 0; icell < numCells; icell++)
+    {
+      m_cellKey[icell] = cells[icell].m_key;
+      int numCellVoFs = m_compactGraph.numVoFs(cells[icell].m_iv);
+      if (numCellVoFs > 1)
+        {
+          m_multiCell.push_back(icell);
+          m_multiFirst.push_back(numVoFs);
+          numVoFs += numCellVoFs - 1;
+        }
+    }
+
+  // the vofs
+  m_volFrac.resize(numVoFs);
+  m_volCentroid.resize(numVoFs);
+  m_bndryArea.resize(numVoFs);
+  m_normal.resize(numVoFs);
+  m_bndryCentroid.resize(numVoFs);
+  m_bndryPhase.resize(numVoFs);
+  std::vector<std::pair<int, VolIndex> > sideVoFs;
+  for (int icell = 0; icell < numCells; icell++)
+    {
+      Vector<VolIndex> vofs = m_compactGraph.getVoFs(cells[icell].m_iv);
+      for (int ivof = 0; ivof < vofs.size(); ivof++)
+        {
+          const VolIndex& vof = vofs[ivof];
+          const VolData& volData = m_volData(vof, 0);
+          int ordinal = vofOrdinal(vof);
+          m_volFrac[ordinal]       = volData.m_volFrac;
+          m_volCentroid[ordinal]   = volData.m_volCentroid;
+          m_bndryArea[ordinal]     = volData.m_averageFace.m_bndryArea;
+          m_normal[ordinal]        = volData.m_averageFace.m_normal;
+          m_bndryCentroid[ordinal] = volData.m_averageFace.m_bndryCentroid;
+          m_bndryPhase[ordinal]    = volData.m_averageFace.m_bndryPhase;
+          if ((volData.m_phaseFaces.size() > 0) || !(volData.m_averageFace.m_volIndex == vof))
+            {
+              sideVoFs.push_back(std::pair<int, VolIndex>(ordinal, vof));
+            }
+        }
+    }
+
+  // vofs whose data does not fit in the arrays
+  std::sort(sideVoFs.begin(), sideVoFs.end());
+  m_sideFirst.push_back(0);
+  for (int iside = 0; iside < sideVoFs.size(); iside++)
+    {
+      const VolData& volData = m_volData(sideVoFs[iside].second, 0);
+      m_sideVoF.push_back(sideVoFs[iside].first);
+      m_sideVolIndex.push_back(volData.m_averageFace.m_volIndex);
+      for (int iface = 0; iface < volData.m_phaseFaces.size(); iface++)
+        {
+          m_phaseFaces.push_back(volData.m_phaseFaces[iface]);
+        }
+      m_sideFirst.push_back(m_phaseFaces.size());
+    }
+
+  // the faces, by their high cells
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      m_faceBox[idir] = m_cellBox;
+      m_faceBox[idir].growHi(idir, 1);
+      std::vector<CompactEntry> faces;
+      for (FaceIterator faceit(m_compactIVS, m_compactFaceGraph, idir, FaceStop::SurroundingWithBoundary);
+          faceit.ok(); ++faceit)
+        {
+          const FaceIndex& face = faceit();
+          CompactEntry entry;
+          entry.m_key = m_faceBox[idir].index(face.gridIndex(Side::Hi));
+          int cellLo = face.cellIndex(Side::Lo);
+          int cellHi = face.cellIndex(Side::Hi);
+          if (face.isBoundary())
+            {
+              entry.m_local = Max(cellLo, cellHi);
+            }
+          else
+            {
+              entry.m_local = cellLo + cellHi*m_compactFaceGraph.numVoFs(face.gridIndex(Side::Lo));
+            }
+          entry.m_data = m_faceData[idir](face, 0);
+          faces.push_back(entry);
+        }
+      std::sort(faces.begin(), faces.end());
+
+      // one slot per high cell and more for the cells with more faces
+      Vector<int> numLocal;
+      for (int iface = 0; iface < faces.size(); iface++)
+        {
+          if ((iface == 0) || (faces[iface].m_key != faces[iface-1].m_key))
+            {
+              m_faceKey[idir].push_back(faces[iface].m_key);
+              numLocal.push_back(1);
+            }
+          numLocal.back() = Max(numLocal.back(), faces[iface].m_local + 1);
+        }
+      int numSlots = m_faceKey[idir].size();
+      for (int ikey = 0; ikey < m_faceKey[idir].size(); ikey++)
+        {
+          if (numLocal[ikey] > 1)
+            {
+              m_multiFace[idir].push_back(ikey);
+              m_multiFaceFirst[idir].push_back(numSlots);
+              numSlots += numLocal[ikey] - 1;
+            }
+        }
+      m_areaFrac[idir].resize(numSlots, 0.);
+      m_faceCentroid[idir].resize(numSlots, RealVect::Zero);
+      int ikey = -1;
+      int imulti = 0;
+      for (int iface = 0; iface < faces.size(); iface++)
+        {
+          if ((iface == 0) || (faces[iface].m_key != faces[iface-1].m_key))
+            {
+              ikey++;
+              while ((imulti < m_multiFace[idir].size()) && (m_multiFace[idir][imulti] < ikey))
+                {
+                  imulti++;
+                }
+            }
+          int slot = ikey;
+          if (faces[iface].m_local > 0)
+            {
+              slot = m_multiFaceFirst[idir][imulti] + faces[iface].m_local - 1;
+            }
+          m_areaFrac[idir][slot]     = faces[iface].m_data.m_areaFrac;
+          m_faceCentroid[idir][slot] = faces[iface].m_data.m_faceCentroid;
+        }
+    }
+
+  m_volData.clear();
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      m_faceData[idir].clear();
+    }
+  m_compactGraph.compact();
+  m_compactFaceGraph.compact();
+  m_isCompact = true;
+}
+/*******************************/
+void
+EBDataImplem::expand()
+{
+  if (!m_isCompact)
+    {
+      return;
+    }
+  CH_TIME("EBDataImplem::expand");
+  m_compactGraph.expand();
+  m_compactFaceGraph.expand();
+  fillExpanded(m_volData, m_faceData, m_compactIVS);
+  clearCompact();
+}
+/*******************************/
+// clear() keeps the memory of a Vector
+template <class T>
+static void freeVector(Vector<T>& a_vector)
+{
+  Vector<T> empty;
+  a_vector.swap(empty);
+}
+/*******************************/
+void
+EBDataImplem::clearCompact()
+{
+  m_isCompact = false;
+  m_compactGraph = EBGraph();
+  m_compactFaceGraph = EBGraph();
+  m_compactIVS = IntVectSet();
+  m_cellBox = Box();
+  freeVector(m_cellKey);
+  freeVector(m_multiCell);
+  freeVector(m_multiFirst);
+  freeVector(m_volFrac);
+  freeVector(m_volCentroid);
+  freeVector(m_bndryArea);
+  freeVector(m_normal);
+  freeVector(m_bndryCentroid);
+  freeVector(m_bndryPhase);
+  freeVector(m_sideVoF);
+  freeVector(m_sideVolIndex);
+  freeVector(m_sideFirst);
+  freeVector(m_phaseFaces);
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      m_faceBox[idir] = Box();
+      freeVector(m_faceKey[idir]);
+      freeVector(m_multiFace[idir]);
+      freeVector(m_multiFaceFirst[idir]);
+      freeVector(m_areaFrac[idir]);
+      freeVector(m_faceCentroid[idir]);
+    }
+}
+/*******************************/
 /*******************************/
 /*******************************/
 /************************/
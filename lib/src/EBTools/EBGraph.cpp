@@ -23,6 +23,15 @@ bool    EBGraphImplem::s_verbose = false;
 IntVect EBGraphImplem::s_ivDebug = IntVect(D_DECL(11, 5, 3));
 Box     EBGraphImplem::s_doDebug = Box(IntVect(D_DECL(0, 0, 0)), IntVect(D_DECL(31, 31, 15)));
 
+static GraphNode coveredNode()
+{
+  GraphNode node;
+  node.defineAsCovered();
+  return node;
+}
+const GraphNode EBGraphImplem::s_regularNode;
+const GraphNode EBGraphImplem::s_coveredNode = coveredNode();
+
 /*******************************/
 Vector<FaceIndex> EBGraph::getMultiValuedFaces(const int&  a_idir,
                                                const Box&  a_box) const
@@ -132,6 +141,7 @@ void EBGraphImplem::addEmptyIrregularVoFs(const IntVectSet& a_vofsToChange)
 {
   if (!a_vofsToChange.isEmpty())
     {
+      expand();
       CH_assert(isDefined());
       CH_assert(isDomainSet());
       //this is all supposed to be called for covered vofs
@@ -199,6 +209,7 @@ void EBGraphImplem::addFullIrregularVoFs(const IntVectSet& a_vofsToChange,
 {
   if (!a_vofsToChange.isEmpty())
     {
+      expand();
       CH_assert(isDefined());
       CH_assert(isDomainSet());
       //this is all supposed to be called for regular vofs
@@ -315,6 +326,7 @@ void EBGraphImplem::setToAllRegular()
   if (m_multiIVS != NULL) delete m_multiIVS;
   m_irregIVS = NULL;
   m_multiIVS = NULL;
+  clearCompact();
 }
 
 /*******************************/
@@ -327,6 +339,7 @@ void EBGraphImplem::setToAllCovered()
   if (m_multiIVS != NULL) delete m_multiIVS;
   m_irregIVS = NULL;
   m_multiIVS = NULL;
+  clearCompact();
 }
 
 /*******************************/
@@ -646,7 +659,7 @@ const ProblemDomain& EBGraphImplem::getDomain() const
 
 /*******************************/
 EBGraphImplem::EBGraphImplem(const Box& a_box)
-  :m_irregIVS(NULL),  m_multiIVS(NULL), m_isMaskBuilt(false)
+  :m_isCompact(false), m_irregIVS(NULL),  m_multiIVS(NULL), m_isMaskBuilt(false)
 {
   define(a_box);
 }
@@ -662,6 +675,7 @@ void EBGraphImplem::define(const Box& a_region)
   if (m_multiIVS != NULL) delete m_multiIVS;
   m_irregIVS = NULL;
   m_multiIVS = NULL;
+  clearCompact();
   m_mask.clear();
   m_isMaskBuilt = false;
   m_isDefined= true;
@@ -676,7 +690,7 @@ void EBGraphImplem::setDomain(const ProblemDomain& a_domain)
 
 /*******************************/
 EBGraphImplem::EBGraphImplem()
-  :m_irregIVS(NULL),  m_multiIVS(NULL)
+  :m_isCompact(false), m_irregIVS(NULL),  m_multiIVS(NULL)
 {
   m_isDefined = false;
   m_isDomainSet = false;
@@ -744,7 +758,7 @@ Vector<VolIndex> EBGraphImplem::getVoFs(const IntVect& a_iv) const
     {
       CH_assert(m_region.contains(a_iv));
       CH_assert(m_domain.contains(a_iv));
-      const GraphNode& node = m_graph(a_iv, 0);
+      const GraphNode& node = getNode(a_iv);
       retvec = node.getVoFs(a_iv);
     }
   return retvec;
@@ -768,7 +782,7 @@ bool EBGraphImplem::isRegular(const IntVect& a_iv) const
     {
       //CH_assert(m_region.contains(a_iv)); //picked up my m_graph already
       //CH_assert(m_domain.contains(a_iv));
-      const GraphNode& node = m_graph(a_iv, 0);
+      const GraphNode& node = getNode(a_iv);
       retval = node.isRegular();
     }
   else
@@ -811,7 +825,7 @@ bool EBGraphImplem::isIrregular(const IntVect& a_iv) const
     {
       CH_assert(m_region.contains(a_iv));
       CH_assert(m_domain.contains(a_iv));
-      const GraphNode& node = m_graph(a_iv, 0);
+      const GraphNode& node = getNode(a_iv);
       retval = node.isIrregular();
     }
   else
@@ -846,7 +860,7 @@ int EBGraphImplem::size(const Box&      a_region,
     {
       for (BoxIterator bit(a_region); bit.ok(); ++bit)
         {
-          const GraphNode& node = m_graph(bit(), 0);
+          const GraphNode& node = getNode(bit());
           int nodeSize = node.linearSize();
           linearSize += nodeSize;
         }
@@ -885,7 +899,7 @@ void EBGraphImplem::linearOut(void*           a_buf,
       unsigned char* buffer = (unsigned char*) intbuf;
       for (BoxIterator bit(a_region); bit.ok(); ++bit)
         {
-          const GraphNode& node = m_graph(bit(), 0);
+          const GraphNode& node = getNode(bit());
           int nodeSize = node.linearSize();
           node.linearOut(buffer);
           buffer += nodeSize;
@@ -929,6 +943,8 @@ void EBGraphImplem::linearIn(void*           a_buf,
       CH_assert(secretCode==2);
       unsigned char* buffer = (unsigned char*) intbuf;
 
+      expand();
+
       if (isAllRegular() || isAllCovered())
         {
           m_tag = HasIrregular;
@@ -981,7 +997,7 @@ bool EBGraphImplem::isCovered(const IntVect& a_iv) const
     {
       //CH_assert(m_region.contains(a_iv)); this check picked up by m_graph
       //CH_assert(m_domain.contains(a_iv));
-      const GraphNode& node = m_graph(a_iv, 0);
+      const GraphNode& node = getNode(a_iv);
       retval = node.isCovered();
     }
   else
@@ -1096,7 +1112,7 @@ Vector<FaceIndex> EBGraphImplem::getFaces(const VolIndex&       a_vof,
   else if (m_tag == HasIrregular)
     {
       const IntVect& iv = a_vof.gridIndex();
-      const GraphNode& node = m_graph(iv, 0);
+      const GraphNode& node = getNode(iv);
       retvec = node.getFaces(a_vof, a_idir, a_sd, m_domain);
     }
 
@@ -1120,12 +1136,13 @@ void EBGraph::fillIntMask(BaseFab<int>& a_mask) const
 
 void EBGraphImplem::fillMask(BaseFab<char>& a_mask) const
 {
-  Box b = a_mask.box() & m_graph.box();
+  if (!hasIrregular()) return;
+  Box b = a_mask.box() & m_region;
   if (b.isEmpty()) return;
   BoxIterator bit(b);
   for (; bit.ok(); ++bit)
     {
-      const GraphNode& g = m_graph(bit(), 0);
+      const GraphNode& g = getNode(bit());
       CH_assert(g.size() < 128);
       a_mask(bit(), 0) = (char)(g.size());
     }
@@ -1186,7 +1203,7 @@ void EBGraphImplem::fillCellTypeMask(BaseFab<char>& a_mask) const
     }
   else
     {
-      Box b = a_mask.box() & m_graph.box();
+      Box b = a_mask.box() & m_region;
       if (b.isEmpty()) return;
       for (BoxIterator bit(b); bit.ok(); ++bit)
         {
@@ -1232,10 +1249,10 @@ Vector<FaceIndex>  EBGraphImplem::getIrregFaces(const Box& a_box,
       IntVectSet ivs = this->getIrregCells(b);
       for (IVSIterator it(ivs); it.ok(); ++it)
         {
-          const GraphNode& node = m_graph(it(), 0);
+          const GraphNode& node = getNode(it());
           IntVect hi = it() + BASISV(a_dir);
           CH_assert(node.isIrregular());
-          if (b.contains(hi) && m_graph(hi, 0).isIrregular())
+          if (b.contains(hi) && getNode(hi).isIrregular())
           {
             faces.append(node.getFaces(it(), a_dir, Side::Hi, m_domain));
           }
@@ -1435,7 +1452,7 @@ VolIndex EBGraphImplem::coarsen(const VolIndex& a_fineVoF) const
     {
       CH_assert(m_tag == HasIrregular);
       const IntVect& iv = a_fineVoF.gridIndex();
-      const GraphNode& node = m_graph(iv, 0);
+      const GraphNode& node = getNode(iv);
       retval = node.coarsen(a_fineVoF);
     }
   return retval;
@@ -1477,7 +1494,7 @@ Vector<VolIndex> EBGraphImplem::refine(const VolIndex& a_coarVoF) const
     {
       CH_assert(m_tag == HasIrregular);
       const IntVect& iv = a_coarVoF.gridIndex();
-      const GraphNode& node = m_graph(iv, 0);
+      const GraphNode& node = getNode(iv);
       if (s_verbose)
         {
           pout() << "tag is has irregular" << endl;
@@ -1507,6 +1524,7 @@ void EBGraphImplem::copy(const Box&           a_regionFrom,
   CH_TIME("EBGraphImplem::copy");
   CH_assert(isDefined());
   CH_assert(isDomainSet());
+  expand();
   if (isRegular(a_regionTo) && a_source.isRegular(a_regionFrom))
     {
       return;
@@ -1572,11 +1590,20 @@ void EBGraphImplem::copy(const Box&           a_regionFrom,
       //see if we need to generate a source fab
       BaseFab<GraphNode>* srcFabPtr;
       bool needToDelete;
-      if (a_source.hasIrregular())
+      if (a_source.hasIrregular() && !a_source.m_isCompact)
         {
           srcFabPtr = (BaseFab<GraphNode>*)&a_source.m_graph;
           needToDelete = false;
         }
+      else if (a_source.hasIrregular())
+        {
+          needToDelete = true;
+          srcFabPtr = new BaseFab<GraphNode>(a_regionFrom, 1);
+          for (BoxIterator bit(a_regionFrom); bit.ok(); ++bit)
+            {
+              (*srcFabPtr)(bit(), 0) = a_source.getNode(bit());
+            }
+        }
       else
         {
           needToDelete = true;
@@ -1672,6 +1699,7 @@ void EBGraphImplem::coarsenVoFs(const EBGraphImplem& a_fineGraph,
       if (m_multiIVS != NULL) delete m_multiIVS;
       m_multiIVS = new IntVectSet(DenseIntVectSet(m_region, false));
       m_irregIVS = new IntVectSet(DenseIntVectSet(m_region, false));
+      clearCompact();
       m_graph.define(m_region, 1);
       for (BoxIterator bit(m_region); bit.ok(); ++bit)
         {
@@ -1873,6 +1901,7 @@ void EBGraphImplem::coarsenFaces(const EBGraphImplem& a_coarGhostGraph,
 
   if (hasIrregular())
     {
+      expand();
       CH_assert(a_coarGhostGraph.getDomain() == m_domain);
       for (BoxIterator bit(m_region); bit.ok(); ++bit)
         {
@@ -1910,6 +1939,7 @@ void EBGraphImplem::fixFineToCoarse(EBGraphImplem& a_fineGraph) const
 {
   if (hasIrregular())
     {
+      a_fineGraph.expand();
       for (BoxIterator bit(m_region); bit.ok(); ++bit)
         {
           if (isIrregular(bit()))
@@ -1917,7 +1947,7 @@ void EBGraphImplem::fixFineToCoarse(EBGraphImplem& a_fineGraph) const
               const IntVect& ivCoar = bit();
 
               const Vector<GraphNodeImplem>&
-                vofsCoar = *(m_graph(ivCoar, 0).m_cellList);
+                vofsCoar = *(getNode(ivCoar).m_cellList);
 
               int numVofsCoar = vofsCoar.size();
 
@@ -1975,11 +2005,98 @@ long long EBGraphImplem::numVoFs(const IntVect& a_iv) const
     {
       CH_assert(m_region.contains(a_iv));
       CH_assert(m_domain.contains(a_iv));
-      count = m_graph(a_iv, 0).size();
+      count = getNode(a_iv).size();
     }
   return count;
 }
 
+/*******************************/
+void EBGraphImplem::compact()
+{
+  CH_TIME("EBGraphImplem::compact");
+  if (m_isCompact || (m_tag != HasIrregular))
+    {
+      return;
+    }
+  m_cellType.define(m_region, 1);
+  int numNodes = 0;
+  for (BoxIterator bit(m_region); bit.ok(); ++bit)
+    {
+      const GraphNode& node = m_graph(bit(), 0);
+      if (node.isCovered())
+        {
+          m_cellType(bit(), 0) = 0;
+        }
+      else if (node.isRegularWithSingleValuedParent())
+        {
+          m_cellType(bit(), 0) = 1;
+        }
+      else
+        {
+          m_cellType(bit(), 0) = 2;
+          numNodes++;
+        }
+    }
+
+  //BoxIterator goes in the order of Box::index so the keys come sorted.
+  //the nodes are moved, not copied: their lists are left where they are
+  m_nodeKey.resize(numNodes);
+  m_nodes.resize(numNodes);
+  int inode = 0;
+  for (BoxIterator bit(m_region); bit.ok(); ++bit)
+    {
+      if (m_cellType(bit(), 0) == 2)
+        {
+          GraphNode& node = m_graph(bit(), 0);
+          m_nodeKey[inode] = m_region.index(bit());
+          m_nodes[inode].m_cellList = node.m_cellList;
+          node.m_cellList = (Vector<GraphNodeImplem>*) 1;
+          inode++;
+        }
+    }
+  m_graph.clear();
+  m_isCompact = true;
+}
+
+/*******************************/
+void EBGraphImplem::expand()
+{
+  if (!m_isCompact)
+    {
+      return;
+    }
+  CH_TIME("EBGraphImplem::expand");
+  m_graph.define(m_region, 1);
+  int inode = 0;
+  for (BoxIterator bit(m_region); bit.ok(); ++bit)
+    {
+      char cellType = m_cellType(bit(), 0);
+      if (cellType == 0)
+        {
+          m_graph(bit(), 0).defineAsCovered();
+        }
+      else if (cellType == 2)
+        {
+          GraphNode& node = m_nodes[inode];
+          m_graph(bit(), 0).m_cellList = node.m_cellList;
+          node.m_cellList = (Vector<GraphNodeImplem>*) 1;
+          inode++;
+        }
+    }
+  clearCompact();
+}
+
+/*******************************/
+void EBGraphImplem::clearCompact()
+{
+  m_isCompact = false;
+  m_cellType.clear();
+  Vector<int> noKeys;
+  m_nodeKey.swap(noKeys);
+  Vector<GraphNode> noNodes;
+  m_nodes.swap(noNodes);
+}
+
 /*******************************/
 EBGraph::EBGraph(const Box& a_box, int a_comps)
   : m_implem( RefCountedPtr<EBGraphImplem>( new EBGraphImplem(a_box) ) )
@@ -130,6 +130,11 @@ EBISLayoutImplem::define(const ProblemDomain& a_domain,
       const EBGraph& graphlocal = localGraph[dit()];
       Box graphregion=  graphlocal.getRegion();
       m_ebisBoxes[dit()].define(localGraph[dit()], localData[dit()]);
+      if (EBIndexSpace::s_compactStorage)
+        {
+          localData[dit()].compact();
+          localGraph[dit()].compact();
+        }
     }
   }
   m_defined = true;
@@ -943,6 +943,26 @@ void EBISLevel::clearMultiBoundaries()
     }
 }
 
+void EBISLevel::compact()
+{
+  CH_TIME("EBISLevel::compact");
+  for (DataIterator dit = m_grids.dataIterator(); dit.ok(); ++dit)
+    {
+      m_data[dit()].compact();
+      m_graph[dit()].compact();
+    }
+}
+
+void EBISLevel::expand()
+{
+  CH_TIME("EBISLevel::expand");
+  for (DataIterator dit = m_grids.dataIterator(); dit.ok(); ++dit)
+    {
+      m_data[dit()].expand();
+      m_graph[dit()].expand();
+    }
+}
+
 void EBISLevel::setBoundaryPhase(int phase)
 {
   CH_TIME("EBISLevel::setBoundaryPhase");
@@ -1008,7 +1028,7 @@ void setOtherVoFSingleValued(VolData&        a_vol,
            (a_sourceIvContainedInOtherFluid))
     {
       a_skipCell = true;
-      refVol = a_otherFluidData.getVolData()(a_sourceVoF, 0);
+      refVol = a_otherFluidData.volData(a_sourceVoF);
       // use -1*normal of the VoF with this IV in the other fluid
       RealVect normal = -refVol.m_averageFace.m_normal;
       //figure out which cell we are moving to. Then we use cellIndex = 0
@@ -1329,7 +1349,7 @@ void getFinerBoundaryData(Vector<Vector<BoundaryData> > & a_bndryDataFineA,
                 {
                   if (a_ebisbxFineA.isIrregular(vofFineA.gridIndex()))
                     {
-                      const VolData& voldat = a_ebisbxFineA.getEBData().getVolData()(vofFineA, 0);
+                      const VolData voldat = a_ebisbxFineA.getEBData().volData(vofFineA);
                       const Vector<BoundaryData>& boundaryDat = voldat.m_phaseFaces;
                       for (int iface = 0; iface < boundaryDat.size(); iface++)
                         {
@@ -1732,13 +1752,13 @@ void EBISLevel::getGraphSummary(long long & a_irrVoFs,
     if (curGraph.m_implem->m_tag == EBGraphImplem::HasIrregular)
     {
 
-      BaseFab<GraphNode> & curGraphFAB  = curGraph.m_implem->m_graph;
-      const BaseIVFAB<VolData> & curDataIVFAB = curData.m_implem->m_volData;
+      // compact storage is read as it is; only an expanded graph is pruned
+      bool canPrune = !curGraph.isCompact();
 
       for (BoxIterator bit(curBox); bit.ok(); ++bit)
       {
         const IntVect   & curIV = bit();
-        GraphNode & curGraphNode = curGraphFAB(curIV,0);
+        const GraphNode & curGraphNode = curGraph.m_implem->getNode(curIV);
 
         if (curGraphNode.isIrregular())
         {
@@ -1755,7 +1775,7 @@ void EBISLevel::getGraphSummary(long long & a_irrVoFs,
           {
             VolIndex volIndex(curIV,vof);
 
-            Real volFrac = curDataIVFAB(volIndex,0).m_volFrac;
+            Real volFrac = curData.volFrac(volIndex);
 
             if (volFrac == 0.0)
             {
@@ -1778,8 +1798,12 @@ void EBISLevel::getGraphSummary(long long & a_irrVoFs,
 
               if (vofs == 1 && localVoFArcs == 0)
               {
-                delete curGraphNode.m_cellList;
-                curGraphNode.m_cellList = 0;
+                if (canPrune)
+                {
+                  GraphNode & prunedNode = curGraph.m_implem->m_graph(curIV,0);
+                  delete prunedNode.m_cellList;
+                  prunedNode.m_cellList = 0;
+                }
                 a_irrVoFs--;
               }
               else
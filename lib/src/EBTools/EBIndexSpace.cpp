@@ -8,6 +8,10 @@
  */
 #endif
 
+#include <cstdio>
+#include <fstream>
+#include <unistd.h>
+
 #include "parstream.H"
 #include "memtrack.H"
 #include "CH_Attach.H"
@@ -28,12 +32,21 @@
 #include "AllRegularService.H"
 #include "PolyGeom.H"
 #include "EBLevelDataOps.H"
+#include "GeometryHash.H"
+#include "EBStencilCache.H"
 
 #include "NamespaceHeader.H"
 
 Real EBIndexSpace::s_tolerance = 1.0e-12;
 bool EBIndexSpace::s_verbose   = false;
 bool EBIndexSpace::s_MFSingleBox=false;
+std::string EBIndexSpace::s_cacheDirectory;
+
+// the layout of the cache files, part of their hash and of their header;
+// a change to what writeAllLevels writes must increment it, so that
+// files written before are no longer found
+static const int s_cacheVersion = 1;
+bool EBIndexSpace::s_compactStorage = false;
 
 long long EBIndexSpace::numVoFs(const ProblemDomain& a_domain) const
 {
@@ -98,6 +111,7 @@ void EBIndexSpace::readInAllLevels(HDF5Handle & a_handle,  ProblemDomain a_fines
       m_domainLevel[ilev] = domLev;
       domLev.coarsen(2);
     }
+  compactLevels();
 }
 
 void EBIndexSpace::writeAllLevels(HDF5Handle&   a_handle) const
@@ -121,6 +135,157 @@ void EBIndexSpace::writeAllLevels(HDF5Handle&   a_handle) const
   //coarser levels are derived from graph coarsening
 }
 
+bool EBIndexSpace::readCache(std::string&           a_cacheFile,
+                             std::string&           a_cacheKey,
+                             const ProblemDomain&   a_domain,
+                             const RealVect&        a_origin,
+                             const Real&            a_dx,
+                             const GeometryService& a_geoserver,
+                             int                    a_nCellMax,
+                             int                    a_maxCoarsenings)
+{
+  CH_TIME("EBIndexSpace::readCache");
+
+  a_cacheFile.clear();
+  a_cacheKey.clear();
+  if (s_cacheDirectory.empty() || m_distributedData)
+    {
+      return false;
+    }
+
+  //everything the levels depend on, the format of the file included.
+  //one rank hashes, since the geometry may read files to do it
+  int root = uniqueProc(SerialTask::compute);
+  int hashed = 0;
+  if (procID() == root)
+    {
+      GeometryHash hash;
+      hash.add(std::string("EBIndexSpace_allLevels"));
+      hash.add(s_cacheVersion);
+      hash.add(SpaceDim);
+      hash.add(int(sizeof(Real)));
+      hash.add(a_domain.domainBox());
+      for (int idir = 0; idir < SpaceDim; idir++)
+        {
+          hash.add(a_domain.isPeriodic(idir));
+        }
+      hash.add(a_origin);
+      hash.add(a_dx);
+      hash.add(a_nCellMax);
+      hash.add(a_maxCoarsenings);
+      if (a_geoserver.hash(hash))
+        {
+          hashed = 1;
+          a_cacheKey = hash.hexString();
+        }
+    }
+  broadcast(hashed, root);
+  if (hashed == 0)
+    {
+      pout() << "  Geometry cannot be hashed, not cached" << endl;
+      return false;
+    }
+  broadcast(a_cacheKey, root);
+
+  char suffix[32];
+  sprintf(suffix, ".%dd.hdf5", SpaceDim);
+  a_cacheFile = s_cacheDirectory + "/ebis_" + a_cacheKey + suffix;
+
+  //every rank opens the file or none does
+  int exists = 0;
+  if (procID() == root)
+    {
+      std::ifstream file(a_cacheFile.c_str());
+      exists = file.good() ? 1 : 0;
+    }
+  broadcast(exists, root);
+  if (exists == 0)
+    {
+      pout() << "  No cached index space " << a_cacheFile << endl;
+      return false;
+    }
+
+  HDF5Handle handle;
+  if (handle.open(a_cacheFile, HDF5Handle::OPEN_RDONLY) < 0)
+    {
+      MayDay::Warning("EBIndexSpace::readCache - cannot open cache file, generating the index space");
+      return false;
+    }
+  HDF5HeaderData header;
+  header.readFromFile(handle);
+  if (header.m_string["EBIS_geometryHash"] != a_cacheKey ||
+      header.m_int["EBIS_cacheVersion"] != s_cacheVersion)
+    {
+      handle.close();
+      MayDay::Warning("EBIndexSpace::readCache - cache file is not of this geometry, generating the index space");
+      return false;
+    }
+
+  pout() << "  Reading all levels from " << a_cacheFile << endl;
+  readInAllLevels(handle, a_domain);
+  handle.close();
+
+  return true;
+}
+
+void EBIndexSpace::writeCache(const std::string& a_cacheFile,
+                              const std::string& a_cacheKey) const
+{
+  CH_TIME("EBIndexSpace::writeCache");
+
+  //runs that start meanwhile must not find a partly written file, and
+  //runs on other nodes sharing the directory must not write the same one
+  int root = uniqueProc(SerialTask::compute);
+  std::string partFile;
+  if (procID() == root)
+    {
+      char host[256];
+      if (gethostname(host, sizeof(host)) != 0)
+        {
+          host[0] = '\0';
+        }
+      host[sizeof(host)-1] = '\0';
+      char pid[32];
+      sprintf(pid, ".%d", int(getpid()));
+      partFile = a_cacheFile + "." + host + pid;
+    }
+  broadcast(partFile, root);
+
+  HDF5Handle handle;
+  if (handle.open(partFile, HDF5Handle::CREATE) < 0)
+    {
+      MayDay::Warning("EBIndexSpace::writeCache - cannot create cache file, not cached");
+      return;
+    }
+  writeAllLevels(handle);
+  HDF5HeaderData header;
+  header.m_string["EBIS_geometryHash"] = a_cacheKey;
+  header.m_int["EBIS_cacheVersion"] = s_cacheVersion;
+  header.writeToFile(handle);
+  handle.close();
+
+  barrier();
+  int renamed = 0;
+  if (procID() == root)
+    {
+      if (rename(partFile.c_str(), a_cacheFile.c_str()) == 0)
+        {
+          renamed = 1;
+        }
+      else
+        {
+          remove(partFile.c_str());
+        }
+    }
+  broadcast(renamed, root);
+  if (renamed == 0)
+    {
+      MayDay::Warning("EBIndexSpace::writeCache - cannot rename cache file, not cached");
+      return;
+    }
+  pout() << "  Wrote all levels to " << a_cacheFile << endl;
+}
+
 void EBIndexSpace::define(HDF5Handle & a_handle,
                           int          a_maxCoarsenings)
 {
@@ -174,6 +339,8 @@ void EBIndexSpace::define(EBISLevel * a_level0,
 
   pout() << "EBIndexSpace::define - Given level 0" << endl;
 
+  EBStencilCache::clear(this);
+
   m_nCellMax = a_nCellMax;
   m_isDefined = true;
 
@@ -227,6 +394,7 @@ void EBIndexSpace::define(EBISLevel * a_level0,
       m_ebisLevel[ilev]->sanityCheck(this);
     }
 #endif
+  compactLevels();
 }
 
 void EBIndexSpace::define(const ProblemDomain    & a_domain,
@@ -240,6 +408,15 @@ void EBIndexSpace::define(const ProblemDomain    & a_domain,
 
   pout() << "EBIndexSpace::define - From domain" << endl;
 
+  std::string cacheFile, cacheKey;
+#ifdef CH_USE_HDF5
+  if (readCache(cacheFile, cacheKey, a_domain, a_origin, a_dx, a_geoserver,
+                a_nCellMax, a_maxCoarsenings))
+    {
+      return;
+    }
+#endif
+
   pout() << "  Building finest level..." << endl;
 
   buildFirstLevel(a_domain, a_origin, a_dx, a_geoserver, a_nCellMax, a_maxCoarsenings);
@@ -288,6 +465,29 @@ void EBIndexSpace::define(const ProblemDomain    & a_domain,
       m_ebisLevel[ilev]->sanityCheck(this);
     }
 #endif
+
+#ifdef CH_USE_HDF5
+  if (!cacheFile.empty())
+    {
+      writeCache(cacheFile, cacheKey);
+    }
+#endif
+  compactLevels();
+}
+
+void EBIndexSpace::compactLevels()
+{
+  if (s_compactStorage)
+    {
+      CH_TIME("EBIndexSpace::compactLevels");
+      for (int ilev = 0; ilev < m_nlevels; ilev++)
+        {
+          if (m_ebisLevel[ilev] != NULL)
+            {
+              m_ebisLevel[ilev]->compact();
+            }
+        }
+    }
 }
 
 void EBIndexSpace::define(const ProblemDomain                        & a_entireDomain,
@@ -301,6 +501,8 @@ void EBIndexSpace::define(const ProblemDomain                        & a_entireD
 
   pout() << "EBIndexSpace::define - Stitching" << endl;
 
+  EBStencilCache::clear(this);
+
   CH_assert(a_patches.size() == a_offsets.size());
 
   int numPatches = a_patches.size();
@@ -686,6 +888,8 @@ int EBIndexSpace::numLevels() const
 
 void EBIndexSpace::clear()
 {
+  //stencils built on the old geometry must not be found again
+  EBStencilCache::clear(this);
   for (int ilev = 0; ilev < m_ebisLevel.size(); ilev++)
     {
       delete m_ebisLevel[ilev];
@@ -751,6 +955,12 @@ Vector<RefCountedPtr<EBIndexSpace> > EBIndexSpace::findConnectedComponents(int
 {
   CH_TIME("EBIndexSpace::findConnectedComponents");
 
+  // The graphs and data are read and copied directly below
+  for (int ilev = 0; ilev < m_nlevels; ilev++)
+  {
+    m_ebisLevel[ilev]->expand();
+  }
+
   // Begin by setting up some data holders and other infrastructure to number
   // the connected components and remember the renumbering of the VoFs.
   Vector<LevelData<EBCellFAB>* > numberedComponentses(m_nlevels,NULL);
@@ -1770,6 +1980,12 @@ Vector<RefCountedPtr<EBIndexSpace> > EBIndexSpace::findConnectedComponents(int
     // the parent.  On the other hand, these don't occur frequently.
   }
 
+  for (int iEBIS = 0; iEBIS < connectedEBIS.size(); iEBIS++)
+  {
+    connectedEBIS[iEBIS]->compactLevels();
+  }
+  compactLevels();
+
   // Return only the biggest connected component
   if (a_onlyBiggest)
   {
@@ -8,10 +8,294 @@
  */
 #endif
 
+#include <algorithm>
+#include <utility>
+#include <vector>
+
 #include "EBStencil.H"
 #include "EBCellFAB.H"
 #include "EBFaceFAB.H"
 #include "NamespaceHeader.H"
+
+int EBStencil::s_minThreadRows = 1024;
+
+/**************/
+//rows this wide or narrower get unrolled kernels
+static const int s_maxUnrolledWidth = D_TERM(3, *3, *3);
+/**************/
+//the data of a_vec, which may be empty
+template <class T>
+static inline const T* firstPtr(const Vector<T>& a_vec)
+{
+  return (a_vec.size() > 0) ? &a_vec[0] : NULL;
+}
+/**************/
+//a_sum plus the terms of a row of a_width terms, added in the order of the
+//row.  N is the width, for a loop the compiler unrolls, or 0 for any width.
+template <int N>
+static inline Real rowSum(Real        a_sum,
+                          int         a_width,
+                          const int*  a_offset,
+                          const Real* a_weight,
+                          const Real* a_phi)
+{
+  for (int iterm = 0; iterm < N; iterm++)
+    {
+      a_sum += a_phi[a_offset[iterm]]*a_weight[iterm];
+    }
+  return a_sum;
+}
+
+template <>
+inline Real rowSum<0>(Real        a_sum,
+                      int         a_width,
+                      const int*  a_offset,
+                      const Real* a_weight,
+                      const Real* a_phi)
+{
+  for (int iterm = 0; iterm < a_width; iterm++)
+    {
+      a_sum += a_phi[a_offset[iterm]]*a_weight[iterm];
+    }
+  return a_sum;
+}
+/**************/
+//the compressed rows of an EBStencil
+struct StencilRows
+{
+  StencilRows(const Vector<int>&  a_singleFirst,
+              const Vector<int>&  a_singleOffset,
+              const Vector<Real>& a_singleWeight,
+              const Vector<int>&  a_multiFirst,
+              const Vector<int>&  a_multiOffset,
+              const Vector<Real>& a_multiWeight)
+    : singleFirst( firstPtr(a_singleFirst)),
+      singleOffset(firstPtr(a_singleOffset)),
+      singleWeight(firstPtr(a_singleWeight)),
+      multiFirst(  firstPtr(a_multiFirst)),
+      multiOffset( firstPtr(a_multiOffset)),
+      multiWeight( firstPtr(a_multiWeight))
+  {
+  }
+
+  //a_sum plus row a_isrc applied to phi, the single-valued part of the row
+  //being a_width (and, unless it is 0, N) terms
+  template <int N>
+  Real sum(Real        a_sum,
+           int         a_isrc,
+           int         a_width,
+           const Real* a_singlePhi,
+           const Real* a_multiPhi) const
+  {
+    int first = singleFirst[a_isrc];
+    a_sum = rowSum<N>(a_sum, a_width, singleOffset + first, singleWeight + first, a_singlePhi);
+    first = multiFirst[a_isrc];
+    return rowSum<0>(a_sum, multiFirst[a_isrc+1] - first, multiOffset + first, multiWeight + first, a_multiPhi);
+  }
+
+  const int*  singleFirst;
+  const int*  singleOffset;
+  const Real* singleWeight;
+  const int*  multiFirst;
+  const int*  multiOffset;
+  const Real* multiWeight;
+};
+/**************/
+//lphi = L(phi), or lphi += L(phi)
+struct ApplyKernel
+{
+  template <int N>
+  void update(int a_isrc, int a_width) const
+  {
+    Real* lphiPtr = NULL;
+    if (destTerms[a_isrc].multiValued)
+      {
+        lphiPtr  = multiLph + destTerms[a_isrc].offset;
+      }
+    else
+      {
+        lphiPtr  = singleLph + destTerms[a_isrc].offset;
+      }
+    Real lphi = 0.;
+    if (incrementOnly)
+      {
+        lphi = *lphiPtr;
+      }
+    *lphiPtr = rows.sum<N>(lphi, a_isrc, a_width, singlePhi, multiPhi);
+  }
+
+  StencilRows                  rows;
+  const EBStencil::destTerm_t* destTerms;
+  Real*                        singleLph;
+  Real*                        multiLph;
+  const Real*                  singlePhi;
+  const Real*                  multiPhi;
+  bool                         incrementOnly;
+};
+/**************/
+//lphi = alpha*alphaWeight*phi + beta*L(phi), the latter incremented or not
+struct AlphaApplyKernel
+{
+  template <int N>
+  void update(int a_isrc, int a_width) const
+  {
+    Real* lphiPtr = NULL;
+    const Real* sourPtr = NULL;
+    if (destTerms[a_isrc].multiValued)
+      {
+        lphiPtr  = multiLph + destTerms[a_isrc].offset;
+        sourPtr  = multiPhi + sourTerms[a_isrc].offset;
+      }
+    else
+      {
+        lphiPtr  = singleLph + destTerms[a_isrc].offset;
+        sourPtr  = singlePhi + sourTerms[a_isrc].offset;
+      }
+    Real lphi = 0.;
+    if (incrementOnly)
+      {
+        lphi = *lphiPtr;
+      }
+    lphi = rows.sum<N>(lphi, a_isrc, a_width, singlePhi, multiPhi);
+    *lphiPtr = alpha*alphaWeight[alphaBeta[a_isrc]]*(*sourPtr) + beta*lphi;
+  }
+
+  StencilRows                  rows;
+  const EBStencil::destTerm_t* destTerms;
+  const EBStencil::destTerm_t* sourTerms;
+  const int*                   alphaBeta;
+  Real*                        singleLph;
+  Real*                        multiLph;
+  const Real*                  singlePhi;
+  const Real*                  multiPhi;
+  const Real*                  alphaWeight;
+  Real                         alpha;
+  Real                         beta;
+  bool                         incrementOnly;
+};
+/**************/
+//phi = phiOld + lambda*(rhs - (alpha*alphaWeight*phiOld + beta*L(phiOld))),
+//lambda = safety/(alpha*alphaWeight + beta*betaWeight).  For relax phiOld
+//is phi itself, for relaxClone another fab.
+struct RelaxKernel
+{
+  template <int N>
+  void update(int a_isrc, int a_width) const
+  {
+    const Real* rhsPtr = NULL;
+    Real* sourPtr = NULL;
+    const Real* sourOldPtr = NULL;
+    if (destTerms[a_isrc].multiValued)
+      {
+        rhsPtr      = multiRhs    + destTerms[a_isrc].offset;
+        sourPtr     = multiPhi    + sourTerms[a_isrc].offset;
+        sourOldPtr  = multiPhiOld + sourTerms[a_isrc].offset;
+      }
+    else
+      {
+        rhsPtr      = singleRhs    + destTerms[a_isrc].offset;
+        sourPtr     = singlePhi    + sourTerms[a_isrc].offset;
+        sourOldPtr  = singlePhiOld + sourTerms[a_isrc].offset;
+      }
+    //alpha and beta get the same offset
+    const Real& alphaWeight = alphaWeights[alphaBeta[a_isrc]];
+    const Real&  betaWeight =  betaWeights[alphaBeta[a_isrc]];
+
+    Real denom = alpha*alphaWeight + beta*betaWeight;
+    Real lambda = 0;
+    if (Abs(denom) > 1.0e-12)
+      lambda = safety/(denom);
+
+    const Real phiOld = *sourOldPtr;
+    Real lphi = rows.sum<N>(0., a_isrc, a_width, singlePhiOld, multiPhiOld);
+    lphi = alpha*alphaWeight*phiOld + beta*lphi;
+
+    *sourPtr = phiOld + lambda*(*rhsPtr - lphi);
+  }
+
+  StencilRows                  rows;
+  const EBStencil::destTerm_t* destTerms;
+  const EBStencil::destTerm_t* sourTerms;
+  const int*                   alphaBeta;
+  Real*                        singlePhi;
+  Real*                        multiPhi;
+  const Real*                  singlePhiOld;
+  const Real*                  multiPhiOld;
+  const Real*                  singleRhs;
+  const Real*                  multiRhs;
+  const Real*                  alphaWeights;
+  const Real*                  betaWeights;
+  Real                         alpha;
+  Real                         beta;
+  Real                         safety;
+};
+/**************/
+//a_kernel on rows a_begin to a_end-1 of a_rowOrder, which are all a_width
+//wide, shared among the threads of the enclosing parallel region
+template <int N, class Kernel>
+static void groupLoop(const Kernel& a_kernel,
+                      const int*    a_rowOrder,
+                      int           a_begin,
+                      int           a_end,
+                      int           a_width)
+{
+#pragma omp for nowait
+  for (int irow = a_begin; irow < a_end; irow++)
+    {
+      a_kernel.template update<N>(a_rowOrder[irow], a_width);
+    }
+}
+/**************/
+//a_kernel on a row or a group of rows, unrolled if a_width is N or less
+template <int N, class Kernel>
+struct Unrolled
+{
+  static void row(const Kernel& a_kernel, int a_isrc, int a_width)
+  {
+    if (a_width == N)
+      {
+        a_kernel.template update<N>(a_isrc, a_width);
+      }
+    else
+      {
+        Unrolled<N-1, Kernel>::row(a_kernel, a_isrc, a_width);
+      }
+  }
+
+  static void group(const Kernel& a_kernel,
+                    const int*    a_rowOrder,
+                    int           a_begin,
+                    int           a_end,
+                    int           a_width)
+  {
+    if (a_width == N)
+      {
+        groupLoop<N>(a_kernel, a_rowOrder, a_begin, a_end, a_width);
+      }
+    else
+      {
+        Unrolled<N-1, Kernel>::group(a_kernel, a_rowOrder, a_begin, a_end, a_width);
+      }
+  }
+};
+
+template <class Kernel>
+struct Unrolled<0, Kernel>
+{
+  static void row(const Kernel& a_kernel, int a_isrc, int a_width)
+  {
+    a_kernel.template update<0>(a_isrc, a_width);
+  }
+
+  static void group(const Kernel& a_kernel,
+                    const int*    a_rowOrder,
+                    int           a_begin,
+                    int           a_end,
+                    int           a_width)
+  {
+    groupLoop<0>(a_kernel, a_rowOrder, a_begin, a_end, a_width);
+  }
+};
 /**************/
 /**************/
 /**************/
@@ -86,14 +370,17 @@ EBStencil::EBStencil(const Vector<VolIndex>& a_srcVofs,
   const IntVect& smallendLph = boxLph.smallEnd();
   IntVect ncellsPhi = boxPhi.size();
   IntVect ncellsLph = boxLph.size();
-  m_ebstencil.resize(a_srcVofs.size());
   m_destTerms.resize(a_srcVofs.size());
   m_cacheLph.resize(a_srcVofs.size());
   m_cachePhi.resize(a_srcVofs.size());
+  m_singleFirst.resize(a_srcVofs.size() + 1);
+  m_multiFirst.resize(a_srcVofs.size() + 1);
 
   for (int isrc = 0; isrc < a_srcVofs.size(); isrc++)
     {
       const VolIndex& srcVof = a_srcVofs[isrc];
+      m_singleFirst[isrc] = m_singleOffset.size();
+      m_multiFirst[isrc]  = m_multiOffset.size();
       if (a_ebisBoxLph.numVoFs(srcVof.gridIndex()) > 1)
         {//multi-valued (the dataPtr(0) is correct--that is where we start from)
           m_destTerms[isrc].offset = baseivfabLph.getIndex(srcVof, m_destVar) - baseivfabLph.dataPtr(0);
@@ -123,37 +410,40 @@ EBStencil::EBStencil(const Vector<VolIndex>& a_srcVofs,
         {
           const VolIndex stencilVof = sten.vof(isten);
           int srcVar = sten.variable(isten);
-          stencilTerm stenEntry;
-          stenEntry.weight = sten.weight(isten);
+          Real weight = sten.weight(isten);
           if (a_ebisBoxPhi.numVoFs(stencilVof.gridIndex()) > 1)
             {//multi-valued (the dataPtr(0) is correct--that is where we start from)
-              stenEntry.offset = baseivfabPhi.getIndex(stencilVof, srcVar) - baseivfabPhi.dataPtr(0);
-              m_ebstencil[isrc].multi.push_back(stenEntry);
+              int offset = baseivfabPhi.getIndex(stencilVof, srcVar) - baseivfabPhi.dataPtr(0);
+              m_multiOffset.push_back(offset);
+              m_multiWeight.push_back(weight);
             }
           else
             {//single-valued
               IntVect ivPhi = stencilVof.gridIndex()  - smallendPhi;
-              stenEntry.offset = ivPhi[0] + ivPhi[1]*ncellsPhi[0] ;
+              int offset = ivPhi[0] + ivPhi[1]*ncellsPhi[0] ;
 #if CH_SPACEDIM==3
-              stenEntry.offset +=  ivPhi[2]*ncellsPhi[0]*ncellsPhi[1];
+              offset +=  ivPhi[2]*ncellsPhi[0]*ncellsPhi[1];
 #endif
               //add in term due to variable number
 #if CH_SPACEDIM==2
-              stenEntry.offset += srcVar*ncellsPhi[0]*ncellsPhi[1];
+              offset += srcVar*ncellsPhi[0]*ncellsPhi[1];
 #elif CH_SPACEDIM==3
-              stenEntry.offset += srcVar*ncellsPhi[0]*ncellsPhi[1]*ncellsPhi[2];
+              offset += srcVar*ncellsPhi[0]*ncellsPhi[1]*ncellsPhi[2];
 #else
               bogus_spacedim();
 #endif
-              m_ebstencil[isrc].single.push_back(stenEntry);
+              m_singleOffset.push_back(offset);
+              m_singleWeight.push_back(weight);
             }
         }
     }
+  m_singleFirst[a_srcVofs.size()] = m_singleOffset.size();
+  m_multiFirst[a_srcVofs.size()]  = m_multiOffset.size();
+  groupRows();
   //  CH_STOP(t1);
 }
 /**************/
 /**************/
-
 void EBStencil::apply(EBCellFAB& a_lofphi, const EBCellFAB& a_phi, bool a_incrementOnly, int  a_ivar) const
 {
 
@@ -171,44 +461,22 @@ void EBStencil::apply(EBCellFAB& a_lofphi, const EBCellFAB& a_phi, bool a_increm
   const Real*  multiValuedPtrPhi =    a_phi.getMultiValuedFAB().dataPtr(a_ivar);
   Real*        multiValuedPtrLph = a_lofphi.getMultiValuedFAB().dataPtr(a_ivar);
 
+  StencilRows rows(m_singleFirst, m_singleOffset, m_singleWeight,
+                   m_multiFirst,  m_multiOffset,  m_multiWeight);
+  ApplyKernel kernel = {rows, firstPtr(m_destTerms),
+                        singleValuedPtrLph, multiValuedPtrLph,
+                        singleValuedPtrPhi, multiValuedPtrPhi,
+                        a_incrementOnly};
+  const int* rowOrder = firstPtr(m_rowOrder);
+  const int numGroups = m_groupWidth.size();
   CH_STOP(t4);
   CH_START(t3);
-  for (int isrc = 0; isrc < m_ebstencil.size(); isrc++)
+#pragma omp parallel if (m_distinctDest && ((int)m_destTerms.size() >= s_minThreadRows))
+  for (int igroup = 0; igroup < numGroups; igroup++)
     {
-      //debugging hook
-      //const VolIndex& srcVoF = m_srcVoFs[isrc];
-      const ebstencil_t& ebstencil = m_ebstencil[isrc];
-      Real* lphiPtr = NULL;
-      if (m_destTerms[isrc].multiValued)
-        {
-          lphiPtr  = multiValuedPtrLph + m_destTerms[isrc].offset;
-        }
-      else
-        {
-          lphiPtr  = singleValuedPtrLph + m_destTerms[isrc].offset;
-        }
-
-      Real& lphi = *lphiPtr;
-      if (!a_incrementOnly)
-        {
-          lphi =  0.;
-        }
-      //single-valued
-      for (int isingle = 0; isingle < ebstencil.single.size(); isingle++)
-        {
-          const int & offset = ebstencil.single[isingle].offset;
-          const Real& phiVal = *(singleValuedPtrPhi + offset);
-          const Real& weight = ebstencil.single[isingle].weight;
-          lphi += phiVal*weight;
-        }
-      //multi-valued
-      for (int imulti = 0; imulti < ebstencil.multi.size(); imulti++)
-        {
-          const int & offset = ebstencil.multi[imulti].offset;
-          const Real& phiVal = *(multiValuedPtrPhi + offset);
-          const Real& weight = ebstencil.multi[imulti].weight;
-          lphi += phiVal*weight;
-        }
+      Unrolled<s_maxUnrolledWidth, ApplyKernel>::group(kernel, rowOrder,
+                                                       m_groupFirst[igroup], m_groupFirst[igroup+1],
+                                                       m_groupWidth[igroup]);
     }
   CH_STOP(t3);
 }
@@ -241,55 +509,27 @@ void EBStencil::apply(EBCellFAB&             a_lofphi,
 
   const Real* alphaWeightPtr = a_alphaWeight.dataPtr(0);
 
+  StencilRows rows(m_singleFirst, m_singleOffset, m_singleWeight,
+                   m_multiFirst,  m_multiOffset,  m_multiWeight);
+  AlphaApplyKernel kernel = {rows, firstPtr(m_destTerms), firstPtr(m_sourTerms),
+                             firstPtr(m_alphaBeta),
+                             singleValuedPtrLph, multiValuedPtrLph,
+                             singleValuedPtrPhi, multiValuedPtrPhi,
+                             alphaWeightPtr, a_alpha, a_beta,
+                             a_incrementOnly};
+  const int* rowOrder = firstPtr(m_rowOrder);
+  const int numGroups = m_groupWidth.size();
   CH_STOP(t4);
   CH_START(t3);
-  for (int isrc = 0; isrc < m_ebstencil.size(); isrc++)
+#pragma omp parallel if (m_distinctDest && ((int)m_destTerms.size() >= s_minThreadRows))
+  for (int igroup = 0; igroup < numGroups; igroup++)
     {
-      //debugging hook
-      //const VolIndex& srcVoF = m_srcVoFs[isrc];
-      const ebstencil_t& ebstencil = m_ebstencil[isrc];
-      Real* lphiPtr = NULL;
-      const Real* sourPtr = NULL;
-      int alphaOffset = m_alphaBeta[isrc];
-      const Real& alphaWeight = *(alphaWeightPtr + alphaOffset);
-      if (m_destTerms[isrc].multiValued)
-        {
-          lphiPtr  = multiValuedPtrLph + m_destTerms[isrc].offset;
-          sourPtr  = multiValuedPtrPhi + m_sourTerms[isrc].offset;
-        }
-      else
-        {
-          lphiPtr  = singleValuedPtrLph + m_destTerms[isrc].offset;
-          sourPtr  = singleValuedPtrPhi + m_sourTerms[isrc].offset;
-        }
-
-      Real& lphi = *lphiPtr;
-      const Real& sour = *sourPtr;
-      if (!a_incrementOnly)
-        {
-          lphi =  0.;
-        }
-      //single-valued
-      for (int isingle = 0; isingle < ebstencil.single.size(); isingle++)
-        {
-          const int & offset = ebstencil.single[isingle].offset;
-          const Real& phiVal = *(singleValuedPtrPhi + offset);
-          const Real& weight = ebstencil.single[isingle].weight;
-          lphi += phiVal*weight;
-        }
-      //multi-valued
-      for (int imulti = 0; imulti < ebstencil.multi.size(); imulti++)
-        {
-          const int & offset = ebstencil.multi[imulti].offset;
-          const Real& phiVal = *(multiValuedPtrPhi + offset);
-          const Real& weight = ebstencil.multi[imulti].weight;
-          lphi += phiVal*weight;
-        }
-      lphi = a_alpha*alphaWeight*sour + a_beta*lphi;
+      Unrolled<s_maxUnrolledWidth, AlphaApplyKernel>::group(kernel, rowOrder,
+                                                            m_groupFirst[igroup], m_groupFirst[igroup+1],
+                                                            m_groupWidth[igroup]);
     }
   CH_STOP(t3);
 }
-
 //For EB x domain where m_alpha, m_beta have changed since defineStencils
 //we need both alphaWeight and betaWeight to calculate the relaxation parameter:
 //lambdaDiagWeight = 1/(alpha*alphaWeight+beta*betaWeight)
@@ -327,7 +567,7 @@ void EBStencil::apply(EBCellFAB&             a_lofphi,
 
   CH_STOP(t4);
   CH_START(t3);
-  for (int isrc = 0; isrc < m_ebstencil.size(); isrc++)
+  for (int isrc = 0; isrc < m_destTerms.size(); isrc++)
     {
       //debugging hook
       //const VolIndex& srcVoF = m_srcVoFs[isrc];
@@ -399,7 +639,7 @@ void EBStencil::applyInhomDomBC(EBCellFAB&             a_lofphi,
   const Real* multiValuedPtrPhi =    a_phi.getMultiValuedFAB().dataPtr(0);
   Real*       multiValuedPtrLph = a_lofphi.getMultiValuedFAB().dataPtr(0);
 
-  for (int isrc = 0; isrc < m_ebstencil.size(); isrc++)
+  for (int isrc = 0; isrc < m_destTerms.size(); isrc++)
     {
       //debugging hook
       //const VolIndex& srcVoF = m_srcVoFs[isrc];
@@ -454,57 +694,23 @@ void EBStencil::relax(EBCellFAB&             a_phi,
   const Real* alphaWeightPtr = a_alphaWeight.dataPtr(0);
   const Real*  betaWeightPtr =  a_betaWeight.dataPtr(0);
 
+  StencilRows rows(m_singleFirst, m_singleOffset, m_singleWeight,
+                   m_multiFirst,  m_multiOffset,  m_multiWeight);
+  RelaxKernel kernel = {rows, firstPtr(m_destTerms), firstPtr(m_sourTerms),
+                        firstPtr(m_alphaBeta),
+                        singleValuedPtrPhi, multiValuedPtrPhi,
+                        singleValuedPtrPhi, multiValuedPtrPhi,
+                        singleValuedPtrLph, multiValuedPtrLph,
+                        alphaWeightPtr, betaWeightPtr,
+                        a_alpha, a_beta, a_safety};
+  const int numRows = m_destTerms.size();
   CH_STOP(t4);
   CH_START(t3);
-  for (int isrc = 0; isrc < m_ebstencil.size(); isrc++)
+  //gauss-seidel, so the rows go one at a time in their own order
+  for (int isrc = 0; isrc < numRows; isrc++)
     {
-      //debugging hook
-      //const VolIndex& srcVoF = m_srcVoFs[isrc];
-      const ebstencil_t& ebstencil = m_ebstencil[isrc];
-      const Real* rhsPtr = NULL;
-      Real* sourPtr = NULL;
-      //alpha and beta get the same offset
-      int alphaOffset = m_alphaBeta[isrc];
-      const Real& alphaWeight = *(alphaWeightPtr + alphaOffset);
-      const Real&  betaWeight = *( betaWeightPtr + alphaOffset);
-      if (m_destTerms[isrc].multiValued)
-        {
-          rhsPtr   = multiValuedPtrLph + m_destTerms[isrc].offset;
-          sourPtr  = multiValuedPtrPhi + m_sourTerms[isrc].offset;
-        }
-      else
-        {
-          rhsPtr   = singleValuedPtrLph + m_destTerms[isrc].offset;
-          sourPtr  = singleValuedPtrPhi + m_sourTerms[isrc].offset;
-        }
-
-      Real& phi = *sourPtr;
-      const Real& rhs = *rhsPtr;
-
-      Real denom = a_alpha*alphaWeight + a_beta*betaWeight;
-      Real lambda = 0;
-      if (Abs(denom) > 1.0e-12)
-        lambda = a_safety/(denom);
-
-      Real lphi = a_alpha*alphaWeight*phi;
-      //single-valued
-      for (int isingle = 0; isingle < ebstencil.single.size(); isingle++)
-        {
-          const int & offset = ebstencil.single[isingle].offset;
-          const Real& phiVal = *(singleValuedPtrPhi + offset);
-          const Real& weight = ebstencil.single[isingle].weight;
-          lphi += phiVal*weight*a_beta;
-        }
-      //multi-valued
-      for (int imulti = 0; imulti < ebstencil.multi.size(); imulti++)
-        {
-          const int & offset = ebstencil.multi[imulti].offset;
-          const Real& phiVal = *(multiValuedPtrPhi + offset);
-          const Real& weight = ebstencil.multi[imulti].weight;
-          lphi += phiVal*weight*a_beta;
-        }
-
-      phi = phi + lambda * (rhs - lphi);
+      Unrolled<s_maxUnrolledWidth, RelaxKernel>::row(kernel, isrc,
+                                                     m_singleFirst[isrc+1] - m_singleFirst[isrc]);
     }
   CH_STOP(t3);
 }
@@ -540,62 +746,26 @@ void EBStencil::relaxClone(EBCellFAB&             a_phi,
   const Real* alphaWeightPtr = a_alphaWeight.dataPtr(0);
   const Real*  betaWeightPtr =  a_betaWeight.dataPtr(0);
 
+  StencilRows rows(m_singleFirst, m_singleOffset, m_singleWeight,
+                   m_multiFirst,  m_multiOffset,  m_multiWeight);
+  RelaxKernel kernel = {rows, firstPtr(m_destTerms), firstPtr(m_sourTerms),
+                        firstPtr(m_alphaBeta),
+                        singleValuedPtrPhi, multiValuedPtrPhi,
+                        singleValuedPtrPhiOld, multiValuedPtrPhiOld,
+                        singleValuedPtrLph, multiValuedPtrLph,
+                        alphaWeightPtr, betaWeightPtr,
+                        a_alpha, a_beta, a_safety};
+  const int* rowOrder = firstPtr(m_rowOrder);
+  const int numGroups = m_groupWidth.size();
   CH_STOP(t4);
   CH_START(t3);
-  for (int isrc = 0; isrc < m_ebstencil.size(); isrc++)
+  //the rows only read phiOld, so they can go in any order
+#pragma omp parallel if (m_distinctDest && ((int)m_destTerms.size() >= s_minThreadRows))
+  for (int igroup = 0; igroup < numGroups; igroup++)
     {
-      //debugging hook
-      //const VolIndex& srcVoF = m_srcVoFs[isrc];
-      const ebstencil_t& ebstencil = m_ebstencil[isrc];
-      const Real* rhsPtr = NULL;
-      Real* sourPtr = NULL;
-      const Real* sourOldPtr = NULL;
-      //alpha and beta get the same offset
-      int alphaOffset = m_alphaBeta[isrc];
-      const Real& alphaWeight = *(alphaWeightPtr + alphaOffset);
-      const Real&  betaWeight = *( betaWeightPtr + alphaOffset);
-      if (m_destTerms[isrc].multiValued)
-        {
-          rhsPtr   = multiValuedPtrLph + m_destTerms[isrc].offset;
-          sourPtr  = multiValuedPtrPhi + m_sourTerms[isrc].offset;
-          sourOldPtr  = multiValuedPtrPhiOld + m_sourTerms[isrc].offset;
-        }
-      else
-        {
-          rhsPtr   = singleValuedPtrLph + m_destTerms[isrc].offset;
-          sourPtr  = singleValuedPtrPhi + m_sourTerms[isrc].offset;
-          sourOldPtr  = singleValuedPtrPhiOld + m_sourTerms[isrc].offset;
-        }
-
-      Real& phi = *sourPtr;
-      const Real& phiOld = *sourOldPtr;
-      const Real& rhs = *rhsPtr;
-
-      Real denom = a_alpha*alphaWeight + a_beta*betaWeight;
-      Real lambda = 0;
-      if (Abs(denom) > 1.0e-12)
-        lambda = a_safety/(denom);
-
-      Real lphi = lambda*a_alpha*alphaWeight*phiOld;
-      //single-valued
-      for (int isingle = 0; isingle < ebstencil.single.size(); isingle++)
-        {
-          const int & offset = ebstencil.single[isingle].offset;
-          const Real& phiVal = *(singleValuedPtrPhiOld + offset);
-          const Real& weight = ebstencil.single[isingle].weight;
-          lphi += lambda*phiVal*weight*a_beta;
-        }
-      //multi-valued
-      for (int imulti = 0; imulti < ebstencil.multi.size(); imulti++)
-        {
-          const int & offset = ebstencil.multi[imulti].offset;
-          const Real& phiVal = *(multiValuedPtrPhiOld + offset);
-          const Real& weight = ebstencil.multi[imulti].weight;
-          lphi += lambda*phiVal*weight*a_beta;
-        }
-
-      //lphi already has lambda multiplied in
-      phi = phiOld + lambda*rhs - lphi;
+      Unrolled<s_maxUnrolledWidth, RelaxKernel>::group(kernel, rowOrder,
+                                                       m_groupFirst[igroup], m_groupFirst[igroup+1],
+                                                       m_groupWidth[igroup]);
     }
   CH_STOP(t3);
 }
@@ -643,17 +813,24 @@ EBStencil::computeOffsets(const Vector<VolIndex>&      a_srcVofs,
 
   IntVect ncellsPhi = boxPhi.size();
   IntVect ncellsLph = boxLph.size();
-  m_ebstencil.resize(a_srcVofs.size());
   m_destTerms.resize(a_srcVofs.size());
   m_sourTerms.resize(a_srcVofs.size());
 
   m_cacheLph.resize(a_srcVofs.size());
   m_cachePhi.resize(a_srcVofs.size());
+  m_singleFirst.resize(a_srcVofs.size() + 1);
+  m_multiFirst.resize(a_srcVofs.size() + 1);
+  m_singleOffset.resize(0);
+  m_singleWeight.resize(0);
+  m_multiOffset.resize(0);
+  m_multiWeight.resize(0);
   //debugging hook
   //m_srcVoFs = a_srcVofs;
   for (int isrc = 0; isrc < a_srcVofs.size(); isrc++)
     {
       const VolIndex& srcVof = a_srcVofs[isrc];
+      m_singleFirst[isrc] = m_singleOffset.size();
+      m_multiFirst[isrc]  = m_multiOffset.size();
 
       if (m_ebisBox.numVoFs(srcVof.gridIndex()) > 1)
         {//multi-valued (the dataPtr(0) is correct--that is where we start from)
@@ -690,48 +867,97 @@ EBStencil::computeOffsets(const Vector<VolIndex>&      a_srcVofs,
         {
           const VolIndex stencilVof = sten.vof(isten);
           int srcVar = sten.variable(isten);
-          stencilTerm stenEntry;
-          stenEntry.weight = sten.weight(isten);
-          //debugging hook
-          //stenEntry.vof = stencilVof;
+          Real weight = sten.weight(isten);
           if (m_ebisBox.numVoFs(stencilVof.gridIndex()) > 1)
             {//multi-valued(the dataPtr(0) is correct--that is where we start from)
-              stenEntry.offset = baseivfabPhi.getIndex(stencilVof, srcVar) - baseivfabPhi.dataPtr(0);
-              m_ebstencil[isrc].multi.push_back(stenEntry);
+              int offset = baseivfabPhi.getIndex(stencilVof, srcVar) - baseivfabPhi.dataPtr(0);
+              m_multiOffset.push_back(offset);
+              m_multiWeight.push_back(weight);
             }
           else
             {//single-valued
               IntVect ivPhi = stencilVof.gridIndex()  - smallendPhi;
-              stenEntry.offset = ivPhi[0] + ivPhi[1]*ncellsPhi[0] ;
+              int offset = ivPhi[0] + ivPhi[1]*ncellsPhi[0] ;
 #if CH_SPACEDIM==3
-              stenEntry.offset +=  ivPhi[2]*ncellsPhi[0]*ncellsPhi[1];
+              offset +=  ivPhi[2]*ncellsPhi[0]*ncellsPhi[1];
 #endif
               //add in term due to variable number
 #if CH_SPACEDIM==2
-              stenEntry.offset += srcVar*ncellsPhi[0]*ncellsPhi[1];
+              offset += srcVar*ncellsPhi[0]*ncellsPhi[1];
 #elif CH_SPACEDIM==3
-              stenEntry.offset += srcVar*ncellsPhi[0]*ncellsPhi[1]*ncellsPhi[2];
+              offset += srcVar*ncellsPhi[0]*ncellsPhi[1]*ncellsPhi[2];
 #else
               bogus_spacedim();
 #endif
-              m_ebstencil[isrc].single.push_back(stenEntry);
+              m_singleOffset.push_back(offset);
+              m_singleWeight.push_back(weight);
             }
         }
     }
+  m_singleFirst[a_srcVofs.size()] = m_singleOffset.size();
+  m_multiFirst[a_srcVofs.size()]  = m_multiOffset.size();
+  groupRows();
 }
 
+/**************/
+/**************/
+void
+EBStencil::groupRows()
+{
+  const int numRows = m_destTerms.size();
+  int maxWidth = 0;
+  for (int isrc = 0; isrc < numRows; isrc++)
+    {
+      maxWidth = Max(maxWidth, m_singleFirst[isrc+1] - m_singleFirst[isrc]);
+    }
+
+  //count the rows of each width, then place them, keeping their order
+  //within a width
+  Vector<int> rowStart(maxWidth + 2, 0);
+  for (int isrc = 0; isrc < numRows; isrc++)
+    {
+      rowStart[m_singleFirst[isrc+1] - m_singleFirst[isrc] + 1]++;
+    }
+  m_groupWidth.resize(0);
+  m_groupFirst.resize(0);
+  for (int iwidth = 0; iwidth <= maxWidth; iwidth++)
+    {
+      if (rowStart[iwidth+1] > 0)
+        {
+          m_groupWidth.push_back(iwidth);
+          m_groupFirst.push_back(rowStart[iwidth]);
+        }
+      rowStart[iwidth+1] += rowStart[iwidth];
+    }
+  m_groupFirst.push_back(numRows);
+  m_rowOrder.resize(numRows);
+  for (int isrc = 0; isrc < numRows; isrc++)
+    {
+      int width = m_singleFirst[isrc+1] - m_singleFirst[isrc];
+      m_rowOrder[rowStart[width]] = isrc;
+      rowStart[width]++;
+    }
+
+  std::vector<std::pair<bool, int> > dests(numRows);
+  for (int isrc = 0; isrc < numRows; isrc++)
+    {
+      dests[isrc] = std::make_pair(m_destTerms[isrc].multiValued, m_destTerms[isrc].offset);
+    }
+  std::sort(dests.begin(), dests.end());
+  m_distinctDest = (std::adjacent_find(dests.begin(), dests.end()) == dests.end());
+}
 /**************/
 /**************/
 void
 EBStencil::cachePhi(const EBCellFAB& a_phi, int a_ivar) const
 {
-//   CH_assert(m_cacheLph.size() == m_ebstencil.size());
+//   CH_assert(m_cacheLph.size() == m_destTerms.size());
 
   CH_assert(a_phi.getSingleValuedFAB().box()    == m_phiBox);
   const Real* singleValuedPtrPhi =    a_phi.getSingleValuedFAB().dataPtr(a_ivar);
   const Real*  multiValuedPtrPhi =    a_phi.getMultiValuedFAB().dataPtr(a_ivar);
 
-  for (int isrc = 0; isrc < m_ebstencil.size(); isrc++)
+  for (int isrc = 0; isrc < m_destTerms.size(); isrc++)
     {
       //debugging hook
       //const VolIndex& srcVoF = m_srcVoFs[isrc];
@@ -749,13 +975,13 @@ EBStencil::cachePhi(const EBCellFAB& a_phi, int a_ivar) const
 void
 EBStencil::cache(const EBCellFAB& a_lph, int a_ivar) const
 {
-//   CH_assert(m_cacheLph.size() == m_ebstencil.size());
+//   CH_assert(m_cacheLph.size() == m_destTerms.size());
 
   CH_assert(a_lph.getSingleValuedFAB().box()    == m_lphBox);
   const Real* singleValuedPtrLph =    a_lph.getSingleValuedFAB().dataPtr(a_ivar);
   const Real*  multiValuedPtrLph =    a_lph.getMultiValuedFAB().dataPtr(a_ivar);
 
-  for (int isrc = 0; isrc < m_ebstencil.size(); isrc++)
+  for (int isrc = 0; isrc < m_destTerms.size(); isrc++)
     {
       if (m_destTerms[isrc].multiValued)
         {
@@ -778,7 +1004,7 @@ EBStencil::uncachePhi(EBCellFAB& a_phi, int a_ivar) const
 
   Real* phiPtr = NULL;
 
-  for (int isrc = 0; isrc < m_ebstencil.size(); isrc++)
+  for (int isrc = 0; isrc < m_destTerms.size(); isrc++)
     {
       if (m_sourTerms[isrc].multiValued)
         {
@@ -802,7 +1028,7 @@ EBStencil::uncache(EBCellFAB& a_lph, int a_ivar) const
 
   Real* lphiPtr = NULL;
 
-  for (int isrc = 0; isrc < m_ebstencil.size(); isrc++)
+  for (int isrc = 0; isrc < m_destTerms.size(); isrc++)
     {
       if (m_destTerms[isrc].multiValued)
         {
@@ -819,6 +1045,19 @@ EBStencil::uncache(EBCellFAB& a_lph, int a_ivar) const
 
 /**************/
 /**************/
+long
+EBStencil::memUsage() const
+{
+  long retval = sizeof(EBStencil);
+  retval += (m_destTerms.size() + m_sourTerms.size())*sizeof(destTerm_t);
+  retval += (m_alphaBeta.size() + m_singleFirst.size() + m_singleOffset.size()
+             + m_multiFirst.size() + m_multiOffset.size() + m_rowOrder.size()
+             + m_groupFirst.size() + m_groupWidth.size())*sizeof(int);
+  retval += (m_cacheLph.size() + m_cachePhi.size() + m_singleWeight.size()
+             + m_multiWeight.size())*sizeof(Real);
+  return retval;
+}
+/**************/
 EBStencil::~EBStencil()
 {
 }
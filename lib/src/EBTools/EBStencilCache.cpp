@@ -0,0 +1,377 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+#include <algorithm>
+#include <vector>
+
+#include "EBStencilCache.H"
+#include "EBIndexSpace.H"
+#include "FaceIndex.H"
+#include "NamespaceHeader.H"
+
+bool EBStencilCache::s_enabled  = false;
+long EBStencilCache::s_maxBytes = 64*1024*1024;
+
+EBStencilCache::StoreMap* EBStencilCache::s_store = NULL;
+long EBStencilCache::s_bytes     = 0;
+long EBStencilCache::s_clock     = 0;
+long EBStencilCache::s_numHits   = 0;
+long EBStencilCache::s_numMisses = 0;
+
+/*******************/
+//lexicographic order of boxes
+static bool boxLess(const Box& a_box1,
+                    const Box& a_box2)
+{
+  if (a_box1.smallEnd() != a_box2.smallEnd())
+    {
+      return a_box1.smallEnd().lexLT(a_box2.smallEnd());
+    }
+  if (a_box1.bigEnd() != a_box2.bigEnd())
+    {
+      return a_box1.bigEnd().lexLT(a_box2.bigEnd());
+    }
+  return a_box1.type().lexLT(a_box2.type());
+}
+
+/*******************/
+static bool intVectLess(const IntVect& a_iv1,
+                        const IntVect& a_iv2)
+{
+  return a_iv1.lexLT(a_iv2);
+}
+
+/*******************/
+EBStencilCache::Entry::~Entry()
+{
+}
+
+/*******************/
+EBStencilCache::Key::Key(const EBLevelGrid&  a_eblg,
+                         const Box&          a_box,
+                         const std::string&  a_opType,
+                         const GeometryHash& a_version)
+{
+  *this = Key(a_eblg.getEBIS(), a_eblg.getDomain(), a_eblg.getEBISL().getGhost(),
+              a_box, a_opType, a_version);
+}
+
+/*******************/
+EBStencilCache::Key::Key(const EBIndexSpace*  a_ebisPtr,
+                         const ProblemDomain& a_domain,
+                         int                  a_nghostEBISL,
+                         const Box&           a_box,
+                         const std::string&   a_opType,
+                         const GeometryHash&  a_version)
+  :m_ebisPtr(a_ebisPtr),
+   m_domainBox(a_domain.domainBox()),
+   m_periodic(0),
+   m_nghostEBISL(a_nghostEBISL),
+   m_box(a_box),
+   m_opType(a_opType),
+   m_version(a_version.value()),
+   m_versionBytes(a_version.bytes())
+{
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      if (a_domain.isPeriodic(idir))
+        {
+          m_periodic |= (1 << idir);
+        }
+    }
+}
+
+/*******************/
+bool EBStencilCache::Key::operator<(const Key& a_key) const
+{
+  if (m_ebisPtr != a_key.m_ebisPtr)
+    {
+      return m_ebisPtr < a_key.m_ebisPtr;
+    }
+  if (m_version != a_key.m_version)
+    {
+      return m_version < a_key.m_version;
+    }
+  if (m_box != a_key.m_box)
+    {
+      return boxLess(m_box, a_key.m_box);
+    }
+  if (m_domainBox != a_key.m_domainBox)
+    {
+      return boxLess(m_domainBox, a_key.m_domainBox);
+    }
+  if (m_periodic != a_key.m_periodic)
+    {
+      return m_periodic < a_key.m_periodic;
+    }
+  if (m_nghostEBISL != a_key.m_nghostEBISL)
+    {
+      return m_nghostEBISL < a_key.m_nghostEBISL;
+    }
+  if (m_opType != a_key.m_opType)
+    {
+      return m_opType < a_key.m_opType;
+    }
+  //only reached when the hashes match: the whole version decides
+  return m_versionBytes < a_key.m_versionBytes;
+}
+
+/*******************/
+long EBStencilCache::Key::memUsage() const
+{
+  return sizeof(Key) + m_opType.size() + m_versionBytes.size();
+}
+
+/*******************/
+RefCountedPtr<EBStencilCache::Entry> EBStencilCache::find(const Key& a_key)
+{
+  RefCountedPtr<Entry> entry;
+#pragma omp critical (EBStencilCache)
+  {
+    if (s_enabled && (s_store != NULL))
+      {
+        StoreMap::iterator it = s_store->find(a_key);
+        if (it != s_store->end())
+          {
+            it->second.m_lastUse = ++s_clock;
+            entry = it->second.m_entry;
+          }
+      }
+    if (entry.isNull())
+      {
+        s_numMisses++;
+      }
+    else
+      {
+        s_numHits++;
+      }
+  }
+  return entry;
+}
+
+/*******************/
+void EBStencilCache::insert(const Key&                  a_key,
+                            const RefCountedPtr<Entry>& a_entry)
+{
+  if (!s_enabled)
+    {
+      return;
+    }
+#pragma omp critical (EBStencilCache)
+  {
+    if (s_store == NULL)
+      {
+        s_store = new StoreMap();
+      }
+    std::pair<StoreMap::iterator, bool> inserted =
+      s_store->insert(std::make_pair(a_key, Stored()));
+    Stored& stored = inserted.first->second;
+    if (!inserted.second)
+      {
+        s_bytes -= stored.m_bytes;
+      }
+    stored.m_entry   = a_entry;
+    stored.m_lastUse = ++s_clock;
+    stored.m_bytes   = a_key.memUsage() + a_entry->memUsage();
+    s_bytes += stored.m_bytes;
+    if (s_bytes > s_maxBytes)
+      {
+        dropOldest();
+      }
+  }
+}
+
+/*******************/
+void EBStencilCache::dropOldest()
+{
+  //least recently used first
+  std::vector<std::pair<long, const Key*> > byUse;
+  byUse.reserve(s_store->size());
+  for (StoreMap::const_iterator it = s_store->begin(); it != s_store->end(); ++it)
+    {
+      byUse.push_back(std::make_pair(it->second.m_lastUse, &(it->first)));
+    }
+  std::sort(byUse.begin(), byUse.end());
+
+  for (int ientry = 0; (ientry < int(byUse.size())) && (s_bytes > s_maxBytes/2); ientry++)
+    {
+      StoreMap::iterator it = s_store->find(*byUse[ientry].second);
+      s_bytes -= it->second.m_bytes;
+      s_store->erase(it);
+    }
+}
+
+/*******************/
+void EBStencilCache::clear()
+{
+#pragma omp critical (EBStencilCache)
+  {
+    delete s_store;
+    s_store = NULL;
+    s_bytes = 0;
+  }
+}
+
+/*******************/
+void EBStencilCache::clear(const EBIndexSpace* a_ebisPtr)
+{
+#pragma omp critical (EBStencilCache)
+  {
+    if (s_store != NULL)
+      {
+        StoreMap::iterator it = s_store->begin();
+        while (it != s_store->end())
+          {
+            if (it->first.m_ebisPtr == a_ebisPtr)
+              {
+                s_bytes -= it->second.m_bytes;
+                s_store->erase(it++);
+              }
+            else
+              {
+                ++it;
+              }
+          }
+        if (s_store->empty())
+          {
+            delete s_store;
+            s_store = NULL;
+          }
+      }
+  }
+}
+
+/*******************/
+int EBStencilCache::size()
+{
+  return (s_store == NULL) ? 0 : int(s_store->size());
+}
+
+/*******************/
+long EBStencilCache::bytes()
+{
+  return s_bytes;
+}
+
+/*******************/
+long EBStencilCache::numHits()
+{
+  return s_numHits;
+}
+
+/*******************/
+long EBStencilCache::numMisses()
+{
+  return s_numMisses;
+}
+
+/*******************/
+void EBStencilCache::hash(GeometryHash&     a_hash,
+                          const VoFStencil& a_stencil)
+{
+  a_hash.add(a_stencil.size());
+  for (int isten = 0; isten < a_stencil.size(); isten++)
+    {
+      a_hash.add(a_stencil.vof(isten).gridIndex());
+      a_hash.add(a_stencil.vof(isten).cellIndex());
+      a_hash.add(a_stencil.variable(isten));
+      a_hash.add(a_stencil.weight(isten));
+    }
+}
+
+/*******************/
+long EBStencilCache::memUsage(const VoFStencil& a_stencil)
+{
+  return sizeof(VoFStencil)
+    + a_stencil.size()*(sizeof(VolIndex) + sizeof(Real) + sizeof(int));
+}
+
+/*******************/
+long EBStencilCache::memUsage(const RefCountedPtr<EBStencil>& a_stencil)
+{
+  return a_stencil.isNull() ? 0 : a_stencil->memUsage();
+}
+
+/*******************/
+void EBStencilCache::hash(GeometryHash&     a_hash,
+                          const IntVectSet& a_ivs)
+{
+  //equal sets may iterate in different orders
+  std::vector<IntVect> cells;
+  for (IVSIterator ivsit(a_ivs); ivsit.ok(); ++ivsit)
+    {
+      cells.push_back(ivsit());
+    }
+  std::sort(cells.begin(), cells.end(), intVectLess);
+  a_hash.add(int(cells.size()));
+  for (int icell = 0; icell < int(cells.size()); icell++)
+    {
+      a_hash.add(cells[icell]);
+    }
+}
+
+/*******************/
+void EBStencilCache::hash(GeometryHash&     a_hash,
+                          const EBFluxFAB&  a_fab,
+                          const IntVectSet& a_cells)
+{
+  std::vector<IntVect> cells;
+  for (IVSIterator ivsit(a_cells); ivsit.ok(); ++ivsit)
+    {
+      cells.push_back(ivsit());
+    }
+  std::sort(cells.begin(), cells.end(), intVectLess);
+
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      const EBFaceFAB& faceFAB = a_fab[idir];
+      const BaseFab<Real>& regFAB = faceFAB.getSingleValuedFAB();
+      const Box& faceBox = regFAB.box();
+      a_hash.add(faceBox);
+      a_hash.add(regFAB.nComp());
+      for (int icell = 0; icell < int(cells.size()); icell++)
+        {
+          for (SideIterator sit; sit.ok(); ++sit)
+            {
+              IntVect iv = cells[icell];
+              if (sit() == Side::Hi)
+                {
+                  iv += BASISV(idir);
+                }
+              if (faceBox.contains(iv))
+                {
+                  for (int icomp = 0; icomp < regFAB.nComp(); icomp++)
+                    {
+                      a_hash.add(regFAB(iv, icomp));
+                    }
+                }
+            }
+        }
+
+      const MiniIFFAB<Real>& irrFAB = faceFAB.getMultiValuedFAB();
+      const Vector<FaceIndex>& faces = irrFAB.getFaces();
+      a_hash.add(int(faces.size()));
+      for (int iface = 0; iface < int(faces.size()); iface++)
+        {
+          const FaceIndex& face = faces[iface];
+          for (SideIterator sit; sit.ok(); ++sit)
+            {
+              a_hash.add(face.gridIndex(sit()));
+              a_hash.add(face.cellIndex(sit()));
+            }
+          for (int icomp = 0; icomp < irrFAB.nComp(); icomp++)
+            {
+              a_hash.add(irrFAB(face, icomp));
+            }
+        }
+    }
+}
+
+#include "NamespaceFooter.H"
@@ -0,0 +1,126 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+#include <cstdio>
+#include <fstream>
+
+#include "GeometryHash.H"
+#include "NamespaceHeader.H"
+
+// FNV-1a offset basis and prime
+static const unsigned long long s_fnvBasis = 14695981039346656037ULL;
+static const unsigned long long s_fnvPrime = 1099511628211ULL;
+
+/*******************/
+GeometryHash::GeometryHash()
+  :m_hash(s_fnvBasis),
+   m_keepBytes(false)
+{
+}
+
+/*******************/
+GeometryHash::GeometryHash(bool a_keepBytes)
+  :m_hash(s_fnvBasis),
+   m_keepBytes(a_keepBytes)
+{
+}
+
+/*******************/
+GeometryHash::~GeometryHash()
+{
+}
+
+/*******************/
+void GeometryHash::add(const void* a_bytes,
+                       size_t      a_numBytes)
+{
+  const unsigned char* bytes = static_cast<const unsigned char*>(a_bytes);
+  for (size_t ibyte = 0; ibyte < a_numBytes; ibyte++)
+    {
+      m_hash ^= bytes[ibyte];
+      m_hash *= s_fnvPrime;
+    }
+  if (m_keepBytes)
+    {
+      m_bytes.append(static_cast<const char*>(a_bytes), a_numBytes);
+    }
+}
+
+/*******************/
+void GeometryHash::add(int a_int)
+{
+  add(&a_int, sizeof(int));
+}
+
+/*******************/
+void GeometryHash::add(Real a_real)
+{
+  add(&a_real, sizeof(Real));
+}
+
+/*******************/
+void GeometryHash::add(const RealVect& a_realVect)
+{
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      add(a_realVect[idir]);
+    }
+}
+
+/*******************/
+void GeometryHash::add(const IntVect& a_intVect)
+{
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      add(a_intVect[idir]);
+    }
+}
+
+/*******************/
+void GeometryHash::add(const Box& a_box)
+{
+  add(a_box.smallEnd());
+  add(a_box.bigEnd());
+  add(a_box.type());
+}
+
+/*******************/
+void GeometryHash::add(const std::string& a_string)
+{
+  add(int(a_string.size()));
+  add(a_string.data(), a_string.size());
+}
+
+/*******************/
+bool GeometryHash::addFile(const std::string& a_filename)
+{
+  std::ifstream file(a_filename.c_str(), std::ios::in | std::ios::binary);
+  if (!file.good())
+    {
+      return false;
+    }
+  char buffer[65536];
+  while (file)
+    {
+      file.read(buffer, sizeof(buffer));
+      add(buffer, file.gcount());
+    }
+  return !file.bad();
+}
+
+/*******************/
+std::string GeometryHash::hexString() const
+{
+  char hex[32];
+  sprintf(hex, "%016llx", m_hash);
+  return std::string(hex);
+}
+
+#include "NamespaceFooter.H"
@@ -11,8 +11,11 @@
 //  ANAG, LBNL, DTG
 
 #include "GeometryService.H"
+#include "BoxIterator.H"
 #include "NamespaceHeader.H"
 
+int GeometryService::s_tileSize = 16;
+
 GeometryService::GeometryService()
 {
 }
@@ -33,6 +36,11 @@ bool GeometryService::canGenerateMultiCells() const
   return true;
 }
 
+bool GeometryService::hash(GeometryHash& a_hash) const
+{
+  return false;
+}
+
 GeometryService::InOut GeometryService::InsideOutside(const Box&           a_region,
                                                       const ProblemDomain& a_domain,
                                                       const RealVect&      a_origin,
@@ -69,6 +77,29 @@ bool GeometryService::intersection(const Box&           a_region,
 
 }
 
+void GeometryService::tileRegion(Vector<Box>& a_tiles,
+                                 const Box&   a_region)
+{
+  CH_assert(s_tileSize > 0);
+  a_tiles.resize(0);
+  if (a_region.isEmpty())
+    {
+      return;
+    }
+  IntVect ntile;
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      ntile[idir] = (a_region.size(idir) + s_tileSize - 1)/s_tileSize;
+    }
+  for (BoxIterator bit(Box(IntVect::Zero, ntile - IntVect::Unit)); bit.ok(); ++bit)
+    {
+      IntVect lo = a_region.smallEnd() + s_tileSize*bit();
+      IntVect hi = lo + (s_tileSize-1)*IntVect::Unit;
+      hi.min(a_region.bigEnd());
+      a_tiles.push_back(Box(lo, hi));
+    }
+}
+
 void GeometryService::postMakeBoxLayout(const DisjointBoxLayout& a_dbl,
                                         const RealVect& a_dx)
 {
@@ -59,6 +59,31 @@ Real ComplementIF::value(const RealVect& a_point) const
   return retval;
 }
 
+void ComplementIF::values(Vector<Real>&           a_values,
+                          const Vector<RealVect>& a_points) const
+{
+  // Implicit function values
+  m_impFunc->values(a_values,a_points);
+
+  // Negate them if complement is turned on (true)
+  if (m_complement)
+  {
+    int numPts = a_values.size();
+    for (int ipt = 0; ipt < numPts; ipt++)
+    {
+      a_values[ipt] = -a_values[ipt];
+    }
+  }
+}
+
+bool ComplementIF::hash(GeometryHash& a_hash) const
+{
+  a_hash.add(std::string("ComplementIF"));
+  a_hash.add(m_complement);
+
+  return m_impFunc->hash(a_hash);
+}
+
 Real ComplementIF::value(const IndexTM<Real,GLOBALDIM>& a_point) const
 {
 
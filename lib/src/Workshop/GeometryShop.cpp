@@ -91,6 +91,17 @@ bool GeometryShop::twoEdgeIntersections(edgeMo a_edges[4])const
   return retval;
 }
 
+bool GeometryShop::hash(GeometryHash& a_hash) const
+{
+  a_hash.add(std::string("GeometryShop"));
+  a_hash.add(m_threshold);
+  a_hash.add(m_thrshdVoF);
+  a_hash.add(m_vectDx);
+  a_hash.add(m_phase);
+
+  return m_implicitFunction->hash(a_hash);
+}
+
 bool GeometryShop::isRegular(const Box&           a_region,
                              const ProblemDomain& a_domain,
                              const RealVect&      a_origin,
@@ -460,7 +471,6 @@ GeometryService::InOut GeometryShop::InsideOutside(const Box&           a_region
       physCorner += a_origin;
 
       Real firstValue;
-      Real firstSign;
 
       if (m_stlIF == NULL)
       {
@@ -481,16 +491,7 @@ GeometryService::InOut GeometryShop::InsideOutside(const Box&           a_region
         }
       }
       
-      firstSign  = copysign(1.0, firstValue);
-
-      if ( firstSign < 0 )
-        {
-          rtn = GeometryService::Regular;
-        }
-      else
-        {
-          rtn = GeometryService::Covered;
-        }
+      rtn = firstCornerInOut(firstValue);
 
       BoxIterator bit(allCorners);
 
@@ -500,7 +501,6 @@ GeometryService::InOut GeometryShop::InsideOutside(const Box&           a_region
           IntVect corner = bit();
 
           Real functionValue;
-          Real functionSign;
 
           if (m_stlIF == NULL)
           {
@@ -529,25 +529,144 @@ GeometryService::InOut GeometryShop::InsideOutside(const Box&           a_region
             }
           }
 
-          functionSign = copysign(1.0, functionValue);
+          if (cornerSignsDiffer(firstValue, functionValue))
+            {
+              rtn = GeometryService::Irregular;
+              return rtn;
+            }
+        }
+    }
+
+  return rtn;
+}
+
+GeometryService::InOut GeometryShop::firstCornerInOut(Real a_firstValue)
+{
+  if (copysign(1.0, a_firstValue) < 0)
+    {
+      return GeometryService::Regular;
+    }
+  return GeometryService::Covered;
+}
+
+bool GeometryShop::cornerSignsDiffer(Real a_firstValue,
+                                     Real a_value)
+{
+  if (a_value == 0 || a_firstValue == 0)
+    {
+      if (copysign(1.0, a_value) * copysign(1.0, a_firstValue) < 0)
+        {
+          return true;
+        }
+    }
+  return (a_value * a_firstValue < 0.0);
+}
+
+void GeometryShop::fillTile(BaseFab<int>&        a_regIrregCovered,
+                            Vector<IntVect>&     a_irregCells,
+                            long int&            a_numCovered,
+                            long int&            a_numReg,
+                            const Box&           a_tile,
+                            const Box&           a_validRegion,
+                            const ProblemDomain& a_domain,
+                            const RealVect&      a_origin,
+                            const Real&          a_dx) const
+{
+  CH_TIME("GeometryShop::fillTile");
 
-          if (functionValue == 0 || firstValue == 0)
+  // the node spacing InsideOutside uses
+  RealVect vectDx;
+  if (m_vectDx[0] != 0.0)
+    {
+      vectDx[0] = a_dx;
+      for (int idir = 1; idir < SpaceDim; idir++)
+        {
+          vectDx[idir] = vectDx[0] * m_vectDx[idir] / m_vectDx[0];
+        }
+    }
+  else
+    {
+      vectDx = a_dx * RealVect::Unit;
+    }
+
+  // values of the implicit function at the nodes of the tile, filled when
+  // the first cell without a fast intersection test needs them
+  Box nodeBox = surroundingNodes(a_tile);
+  BaseFab<Real> nodeValues;
+  bool haveNodeValues = false;
+
+  for (BoxIterator bit(a_tile); bit.ok(); ++bit)
+    {
+      const IntVect& iv = bit();
+      Box miniBox(iv, iv);
+      GeometryService::InOut inout;
+
+      if (m_stlIF != NULL ||
+          m_implicitFunction->fastIntersection(miniBox, a_domain, a_origin, a_dx))
+        {
+          inout = InsideOutside(miniBox, a_domain, a_origin, a_dx);
+        }
+      else
+        {
+          if (!haveNodeValues)
             {
-              if (functionSign * firstSign < 0)
+              Vector<RealVect> points;
+              points.reserve(nodeBox.numPts());
+              for (BoxIterator nit(nodeBox); nit.ok(); ++nit)
+                {
+                  RealVect physCorner(nit());
+                  physCorner *= vectDx;
+                  physCorner += a_origin;
+                  points.push_back(physCorner);
+                }
+              Vector<Real> values;
+              m_implicitFunction->values(values, points);
+
+              nodeValues.define(nodeBox, 1);
+              int ipt = 0;
+              for (BoxIterator nit(nodeBox); nit.ok(); ++nit, ++ipt)
                 {
-                  rtn = GeometryService::Irregular;
-                  return rtn;
+                  nodeValues(nit(), 0) = values[ipt];
                 }
+              haveNodeValues = true;
             }
-          if (functionValue * firstValue < 0.0 )
+
+          Real firstValue = nodeValues(iv, 0);
+          inout = firstCornerInOut(firstValue);
+          Box allCorners(miniBox);
+          allCorners.surroundingNodes();
+          for (BoxIterator cit(allCorners); cit.ok(); ++cit)
             {
-              rtn = GeometryService::Irregular;
-              return rtn;
+              if (cornerSignsDiffer(firstValue, nodeValues(cit(), 0)))
+                {
+                  inout = GeometryService::Irregular;
+                  break;
+                }
             }
         }
-    }
 
-  return rtn;
+      if (inout == GeometryService::Covered)
+        {
+          // set covered cells to -1
+          a_regIrregCovered(iv, 0) = -1;
+          a_numCovered++;
+        }
+      else if (inout == GeometryService::Regular)
+        {
+          // set regular cells to 1
+          a_regIrregCovered(iv, 0) =  1;
+          a_numReg++;
+        }
+      else
+        {
+          // set irregular cells to 0
+          a_regIrregCovered(iv, 0) =  0;
+          if (a_validRegion.contains(iv))
+            {
+              a_irregCells.push_back(iv);
+            }
+        }
+    }
 }
 
 /**********************************************/
@@ -589,43 +708,53 @@ GeometryShop::fillGraph(BaseFab<int>        & a_regIrregCovered,
   CH_STOP(p1);
 
   CH_START(p2);
-  for (BoxIterator bit(a_ghostRegion); bit.ok(); ++bit)
+  if (m_stlIF != NULL && !m_STLBoxSet)
     {
-      const IntVect iv =bit();
-      Box miniBox(iv, iv);
-      GeometryService::InOut inout = InsideOutside(miniBox, a_domain, a_origin, a_dx);
+      // explore the STL mesh here, before the threads share it; the
+      // queries the threads make of it afterwards only read it
+      Box firstCell(a_ghostRegion.smallEnd(), a_ghostRegion.smallEnd());
+      InsideOutside(firstCell, a_domain, a_origin, a_dx);
+    }
 
-      if (inout == GeometryService::Covered)
-        {
-          // set covered cells to -1
-          a_regIrregCovered(iv, 0) = -1;
-          numCovered++;
-        }
-      else if (inout == GeometryService::Regular)
-        {
-          // set regular cells to 1
-          a_regIrregCovered(iv, 0) =  1;
-          numReg++;
-        }
-      else
+  // classify the cells tile by tile; tiles write disjoint parts of
+  // a_regIrregCovered and keep their own lists of irregular cells
+  Vector<Box> tiles;
+  tileRegion(tiles, a_ghostRegion);
+  int numTiles = tiles.size();
+  Vector<Vector<IntVect> > tileIrreg(numTiles);
+#pragma omp parallel for schedule(dynamic) reduction(+:numCovered,numReg,numIrreg)
+  for (int itile = 0; itile < numTiles; itile++)
+    {
+      fillTile(a_regIrregCovered, tileIrreg[itile], numCovered, numReg,
+               tiles[itile], a_validRegion, a_domain, a_origin, a_dx);
+      numIrreg += tileIrreg[itile].size();
+    }
+  for (int itile = 0; itile < numTiles; itile++)
+    {
+      for (int icell = 0; icell < tileIrreg[itile].size(); icell++)
         {
-          // set irregular cells to 0
-          a_regIrregCovered(iv, 0) =  0;
-          if (a_validRegion.contains(iv))
-            {
-              ivsirreg |= iv;
-              numIrreg++;
-            }
+          ivsirreg |= tileIrreg[itile][icell];
         }
     }
   // pout()<< "GeometryShop:: Counting cells:  " << numCovered<< "  "<< numReg<< "  "<< numIrreg  <<endl;
   CH_STOP(p2);
 
   CH_START(p3);
-  // now loop through irregular cells and make nodes for each  one.
+  // now make a node for each irregular cell.  The moments of the cells
+  // are computed in parallel; the nodes are then added in the order of
+  // ivsirreg, so that the graph does not depend on the number of threads
+  Vector<IntVect> irregCells;
   for (IVSIterator ivsit(ivsirreg); ivsit.ok(); ++ivsit)
     {
-      VolIndex vof(ivsit(), 0);
+      irregCells.push_back(ivsit());
+    }
+  int numIrregCells = irregCells.size();
+  Vector<IrregNode> irregNodes(numIrregCells);
+#pragma omp parallel for schedule(dynamic)
+  for (int icell = 0; icell < numIrregCells; icell++)
+    {
+      const IntVect& iv = irregCells[icell];
+      VolIndex vof(iv, 0);
       Real     volFrac, bndryArea;
       RealVect normal, volCentroid, bndryCentroid;
       Vector<int> loArc[SpaceDim];
@@ -651,132 +780,47 @@ GeometryShop::fillGraph(BaseFab<int>        & a_regIrregCovered,
                           a_origin,
                           a_dx,
                           vectDx,
-                          ivsit());
-
-
-          IrregNode newNode;
-          newNode.m_cell          = ivsit();
-          newNode.m_volFrac       = volFrac;
-          newNode.m_cellIndex     = 0;
-          newNode.m_volCentroid   = volCentroid;
-          newNode.m_bndryCentroid = bndryCentroid;
-          // if (thrshd == 0.)//begin treb
-          //   {
-          //     //this piece of code successfully removes volFrac=1 cells where EB cuts the vertex
-          //     //this piece of code cannot be used with CP's small volFrac removal below
-          //     //this piece of code does not work for removal of volFrac << 1 because of regular next to covered
-          //     bool isIrregNode;
-          //     if ((volFrac < -thrshd || volFrac > thrshd) && (volFrac < 1.-thrshd || volFrac > 1.+thrshd))
-          //       // if (volFrac < 1.)
-          //       {
-          //         isIrregNode = true;
-          //       }
-          //     else
-          //       {
-          //         isIrregNode = false;
-          //       }
-      
-          //     for (int faceDir = 0; faceDir < SpaceDim; faceDir++)
-          //       {
-          //         int loNodeInd = newNode.index(faceDir, Side::Lo);
-          //         int hiNodeInd = newNode.index(faceDir, Side::Hi);
-          //         newNode.m_arc[loNodeInd]          = loArc[faceDir];
-          //         newNode.m_arc[hiNodeInd]          = hiArc[faceDir];
-          //         newNode.m_areaFrac[loNodeInd]     = loAreaFrac[faceDir];
-          //         newNode.m_areaFrac[hiNodeInd]     = hiAreaFrac[faceDir];
-          //         newNode.m_faceCentroid[loNodeInd] = loFaceCentroid[faceDir];
-          //         newNode.m_faceCentroid[hiNodeInd] = hiFaceCentroid[faceDir];
-          //         if (!isIrregNode)//only go through this logic if a covered or regular cell has chance of being irregular????
-          //           {
-          //             //covered cell with no arcs in all directions
-          //             if ((volFrac == 0.) && (loArc[faceDir].size() == 0) && (hiArc[faceDir].size() == 0))
-          //               {
-          //                 isIrregNode = false;
-          //               }
-          //             //regular cell with exactly one arc one lo and hi sides in all directions
-          //             else if ((volFrac > 1.-thrshd && volFrac < 1.+thrshd) && (loArc[faceDir].size() == 1) && (hiArc[faceDir].size() == 1))
-          //               // else if (volFrac == 1. && (loArc[faceDir].size() == 1) && (hiArc[faceDir].size() == 1))
-          //               {
-          //                 for (int numFace = 0; numFace < loAreaFrac[faceDir].size(); numFace++)
-          //                   {
-          //                     if (loAreaFrac[faceDir][numFace] > 1.-thrshd && loAreaFrac[faceDir][numFace] < 1.+thrshd)
-          //                       {
-          //                         isIrregNode = false;
-          //                       }
-          //                     else
-          //                       {
-          //                         isIrregNode = true;
-          //                       }
-          //                   }
-          //                 for (int numFace = 0; numFace < hiAreaFrac[faceDir].size(); numFace++)
-          //                   {
-          //                     if (hiAreaFrac[faceDir][numFace] > 1.-thrshd && hiAreaFrac[faceDir][numFace] < 1.+thrshd)
-          //                       {
-          //                         isIrregNode = false;
-          //                       }
-          //                     else
-          //                       {
-          //                         isIrregNode = true;
-          //                       }
-          //                   }
-          //               }
-          //             //if none of those fit for all directions, then irregular, and don't come back through this logic
-          //             else
-          //               {
-          //                 isIrregNode = true;
-          //               }
-          //           }
-          //       }
-
-          //     if (isIrregNode)
-          //       {
-          //         a_nodes.push_back(newNode);
-          //       }
-          //     else
-          //       {
-          //         if ((volFrac > 1.-thrshd && volFrac < 1.+thrshd))
-          //           // if (volFrac == 1.)
-          //           {
-          //             a_regIrregCovered(ivsit(), 0) =  1;
-          //             pout() << "Removing regular vof " << vof << " from irreg node list" << endl;
-          //           }
-          //       }
-          //   }//end treb
-          // else//begin CP
-          //   {
-              if (thrshd > 0. && volFrac < thrshd)
-                {
-                  ivsdrop |= ivsit();
-                  a_regIrregCovered(ivsit(), 0) = -1;
-                  if (m_verbosity > 2)
-                    {
-                      pout() << "Removing vof " << vof << " with volFrac " << volFrac << endl;
-                    }
-                }//CP record these nodes to be removed
-              else
-                {
-                  IrregNode newNode;
-                  newNode.m_cell          = ivsit();
-                  newNode.m_volFrac       = volFrac;
-                  newNode.m_cellIndex     = 0;
-                  newNode.m_volCentroid   = volCentroid;
-                  newNode.m_bndryCentroid = bndryCentroid;
-                  
-                  for (int faceDir = 0; faceDir < SpaceDim; faceDir++)
-                    {
-                      int loNodeInd = newNode.index(faceDir, Side::Lo);
-                      int hiNodeInd = newNode.index(faceDir, Side::Hi);
-                      newNode.m_arc[loNodeInd]          = loArc[faceDir];
-                      newNode.m_arc[hiNodeInd]          = hiArc[faceDir];
-                      newNode.m_areaFrac[loNodeInd]     = loAreaFrac[faceDir];
-                      newNode.m_areaFrac[hiNodeInd]     = hiAreaFrac[faceDir];
-                      newNode.m_faceCentroid[loNodeInd] = loFaceCentroid[faceDir];
-                      newNode.m_faceCentroid[hiNodeInd] = hiFaceCentroid[faceDir];
-                    }
-                  a_nodes.push_back(newNode);
-                }
-            // }//end CP
-    } // end loop over cells in the box
+                          iv);
+
+      IrregNode& newNode = irregNodes[icell];
+      newNode.m_cell          = iv;
+      newNode.m_volFrac       = volFrac;
+      newNode.m_cellIndex     = 0;
+      newNode.m_volCentroid   = volCentroid;
+      newNode.m_bndryCentroid = bndryCentroid;
+
+      for (int faceDir = 0; faceDir < SpaceDim; faceDir++)
+        {
+          int loNodeInd = newNode.index(faceDir, Side::Lo);
+          int hiNodeInd = newNode.index(faceDir, Side::Hi);
+          newNode.m_arc[loNodeInd]          = loArc[faceDir];
+          newNode.m_arc[hiNodeInd]          = hiArc[faceDir];
+          newNode.m_areaFrac[loNodeInd]     = loAreaFrac[faceDir];
+          newNode.m_areaFrac[hiNodeInd]     = hiAreaFrac[faceDir];
+          newNode.m_faceCentroid[loNodeInd] = loFaceCentroid[faceDir];
+          newNode.m_faceCentroid[hiNodeInd] = hiFaceCentroid[faceDir];
+        }
+    }
+
+  for (int icell = 0; icell < numIrregCells; icell++)
+    {
+      const IrregNode& newNode = irregNodes[icell];
+      // CP: record the nodes with tiny volume fractions to be removed
+      if (thrshd > 0. && newNode.m_volFrac < thrshd)
+        {
+          ivsdrop |= newNode.m_cell;
+          a_regIrregCovered(newNode.m_cell, 0) = -1;
+          if (m_verbosity > 2)
+            {
+              pout() << "Removing vof " << VolIndex(newNode.m_cell, 0)
+                     << " with volFrac " << newNode.m_volFrac << endl;
+            }
+        }
+      else
+        {
+          a_nodes.push_back(newNode);
+        }
+    }
   CH_STOP(p3);
 
   CH_START(p4);
@@ -2158,6 +2202,7 @@ GeometryShop::computeVoFInternals(Real&               a_volFrac,
   if (thisVofClipped)
     {
       GeometryShop* changedThis = (GeometryShop *) this;
+#pragma omp atomic
       changedThis->m_numCellsClipped += 1;
     }
 }
@@ -113,6 +113,54 @@ Real IntersectionIF::value(const RealVect& a_point) const
   return retval;
 }
 
+void IntersectionIF::values(Vector<Real>&           a_values,
+                            const Vector<RealVect>& a_points) const
+{
+  int numPts = a_points.size();
+
+  if (m_numFuncs == 0)
+    {
+      a_values.resize(numPts);
+      for (int ipt = 0; ipt < numPts; ipt++)
+        {
+          a_values[ipt] = -1.0;
+        }
+      return;
+    }
+
+  // Maximum of the implicit functions values
+  m_impFuncs[0]->values(a_values,a_points);
+
+  Vector<Real> cur;
+  for (int ifunc = 1; ifunc < m_numFuncs; ifunc++)
+    {
+      m_impFuncs[ifunc]->values(cur,a_points);
+      for (int ipt = 0; ipt < numPts; ipt++)
+        {
+          if (cur[ipt] > a_values[ipt])
+            {
+              a_values[ipt] = cur[ipt];
+            }
+        }
+    }
+}
+
+bool IntersectionIF::hash(GeometryHash& a_hash) const
+{
+  a_hash.add(std::string("IntersectionIF"));
+  a_hash.add(m_numFuncs);
+
+  for (int ifunc = 0; ifunc < m_numFuncs; ifunc++)
+  {
+    if (!m_impFuncs[ifunc]->hash(a_hash))
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
 Real IntersectionIF::value(const IndexTM<Real,GLOBALDIM>& a_point) const
 {
   int closestIF = -1;
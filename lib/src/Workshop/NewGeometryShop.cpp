@@ -31,8 +31,21 @@
 #include "PolyGeom.H"
 #include "RealVect.H"
 
+#include "CH_Thread.H"
+
 #include "NamespaceHeader.H"
 
+// the number of threads to keep per thread state for; threadNumber()
+// indexes it
+static int maxThreads()
+{
+#ifdef _OPENMP
+  return omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
 bool NewGeometryShop::s_verbose = false;
 
 /**********************************************/
@@ -118,6 +131,9 @@ NewGeometryShop::NewGeometryShop(const BaseIF& a_baseIF,
 
   m_threshold = 1.0e-15;
   m_numCellsClipped = 0;
+
+  m_currIv.resize(maxThreads());
+  m_cutCellMoments.resize(maxThreads());
 }
 
 /**********************************************/
@@ -401,80 +417,115 @@ void NewGeometryShop::fillGraph(BaseFab<int>&       a_regIrregCovered,
 
   IntVectSet ivsirreg = IntVectSet(DenseIntVectSet(a_ghostRegion, false));
 
-  for (BoxIterator bit(a_ghostRegion); bit.ok(); ++bit)
+  // the per thread state of computeVoFInternals, for the threads below
+  if (m_currIv.size() < maxThreads())
     {
-      const IntVect iv =bit();
-      Box miniBox(iv, iv);
+      m_currIv.resize(maxThreads());
+      m_cutCellMoments.resize(maxThreads());
+    }
 
-      RvgDim cellCenter;
-      for (int idir = 0;idir < SpaceDim; ++idir)
-        {
-          cellCenter[idir] = m_dxVect[idir]*(iv[idir] +0.5) + a_origin[idir];
-        }
-      if (GLOBALDIM != SpaceDim)
+  // classify the cells tile by tile; tiles write disjoint parts of
+  // a_regIrregCovered and keep their own lists of irregular cells
+  Vector<Box> tiles;
+  tileRegion(tiles, a_ghostRegion);
+  int numTiles = tiles.size();
+  Vector<Vector<IntVect> > tileIrreg(numTiles);
+#pragma omp parallel for schedule(dynamic)
+  for (int itile = 0; itile < numTiles; itile++)
+    {
+      for (BoxIterator bit(tiles[itile]); bit.ok(); ++bit)
         {
-          const ReferenceHeightIF *refIF = dynamic_cast<const ReferenceHeightIF *>(m_baseIF);
-          if (refIF == NULL)
-          {
-            MayDay::Error("NewGeomteryShop constructor: Couldn't cast BaseIF pointer to ReferenceHeightIF");
-          }
+          const IntVect iv =bit();
+          Box miniBox(iv, iv);
 
-          cellCenter[SpaceDim] = refIF->getOrigin()[SpaceDim] + (refIF->getReferenceHeight() / 2.0);
-        }
+          RvgDim cellCenter;
+          for (int idir = 0;idir < SpaceDim; ++idir)
+            {
+              cellCenter[idir] = m_dxVect[idir]*(iv[idir] +0.5) + a_origin[idir];
+            }
+          if (GLOBALDIM != SpaceDim)
+            {
+              const ReferenceHeightIF *refIF = dynamic_cast<const ReferenceHeightIF *>(m_baseIF);
+              if (refIF == NULL)
+              {
+                MayDay::Error("NewGeomteryShop constructor: Couldn't cast BaseIF pointer to ReferenceHeightIF");
+              }
+
+              cellCenter[SpaceDim] = refIF->getOrigin()[SpaceDim] + (refIF->getReferenceHeight() / 2.0);
+            }
 
 #if RECURSIVE_GEOMETRY_GENERATION != 0
-      // P+R+D = m_degreePmax + m_orderPmax + GLOBALDIM and
-      // R = Rmax when P = 0, so Rmax = m_degreePmax + m_orderPmax
-      int maxOrder = m_degreePmax + m_orderPmax;
+          // P+R+D = m_degreePmax + m_orderPmax + GLOBALDIM and
+          // R = Rmax when P = 0, so Rmax = m_degreePmax + m_orderPmax
+          int maxOrder = m_degreePmax + m_orderPmax;
 #endif
 
-      //member data: sign(chosen from -1,0,1) of each vertex,
-      //location of each edge intersection, cellCenter,normal and gradNormal
+          //member data: sign(chosen from -1,0,1) of each vertex,
+          //location of each edge intersection, cellCenter,normal and gradNormal
 #if RECURSIVE_GEOMETRY_GENERATION == 0
-      IFData<GLOBALDIM> edgeData(*m_baseIF,m_dxVect,cellCenter,m_order);
+          IFData<GLOBALDIM> edgeData(*m_baseIF,m_dxVect,cellCenter,m_order);
 #else
-      IFData<GLOBALDIM> edgeData(*m_baseIF,m_dxVect,cellCenter,maxOrder);
+          IFData<GLOBALDIM> edgeData(*m_baseIF,m_dxVect,cellCenter,maxOrder);
 #endif
 
-      //create a CutCellMoment object, in order to detect whether any face coincides with the interface
-      CutCellMoments <GLOBALDIM> globalDimCutCell(edgeData);
+          //create a CutCellMoment object, in order to detect whether any face coincides with the interface
+          CutCellMoments <GLOBALDIM> globalDimCutCell(edgeData);
 
 #if (USING_TOP_FACE_MOMENTS)
-      Iv2 bdId;
-      bdId[BDID_DIR]   = 2;
-      bdId[BDID_HILO]  = 1;
-      CutCellMoments<GLOBALDIM-1> cutCell;
-      cutCell = globalDimCutCell.m_bdCutCellMoments[bdId];
+          Iv2 bdId;
+          bdId[BDID_DIR]   = 2;
+          bdId[BDID_HILO]  = 1;
+          CutCellMoments<GLOBALDIM-1> cutCell;
+          cutCell = globalDimCutCell.m_bdCutCellMoments[bdId];
 #else
-      CutCellMoments<GLOBALDIM> cutCell;
-      cutCell = globalDimCutCell;
+          CutCellMoments<GLOBALDIM> cutCell;
+          cutCell = globalDimCutCell;
 #endif
-      if (cutCell.isCovered())
-        {
-          //set covered cells to -1
-          a_regIrregCovered(iv, 0) = -1;
-        }
-      else if (cutCell.isRegular())
-        {
-          //set regular cells to 1
-          a_regIrregCovered(iv, 0) =  1;
-        }
-      else
-        {
-          //set irregular cells to 0
-          //irregular if any face coincides with interface and edgeData.m_allVerticesIn = true
-          a_regIrregCovered(iv, 0) =  0;
-          if (a_validRegion.contains(iv))
+          if (cutCell.isCovered())
+            {
+              //set covered cells to -1
+              a_regIrregCovered(iv, 0) = -1;
+            }
+          else if (cutCell.isRegular())
             {
-              ivsirreg |= iv;
+              //set regular cells to 1
+              a_regIrregCovered(iv, 0) =  1;
             }
+          else
+            {
+              //set irregular cells to 0
+              //irregular if any face coincides with interface and edgeData.m_allVerticesIn = true
+              a_regIrregCovered(iv, 0) =  0;
+              if (a_validRegion.contains(iv))
+                {
+                  tileIrreg[itile].push_back(iv);
+                }
+            }
+        }
+    }
+  for (int itile = 0; itile < numTiles; itile++)
+    {
+      for (int icell = 0; icell < tileIrreg[itile].size(); icell++)
+        {
+          ivsirreg |= tileIrreg[itile][icell];
         }
     }
 
   //now loop through irregular cells and make nodes for each  one.
+  //The cells are computed in parallel and their nodes added in the order
+  //of ivsirreg, so that the graph does not depend on the number of threads
+  Vector<IntVect> irregCells;
   for (IVSIterator ivsit(ivsirreg); ivsit.ok(); ++ivsit)
     {
-      VolIndex vof(ivsit(), 0);
+      irregCells.push_back(ivsit());
+    }
+  int numIrregCells = irregCells.size();
+  Vector<IrregNode> irregNodes(numIrregCells);
+#pragma omp parallel for schedule(dynamic)
+  for (int icell = 0; icell < numIrregCells; icell++)
+    {
+      const IntVect& iv = irregCells[icell];
+      VolIndex vof(iv, 0);
       Real     volFrac, bndryArea;
       RealVect normal, volCentroid, bndryCentroid;
       Vector<int> loArc[SpaceDim];
@@ -501,11 +552,11 @@ void NewGeometryShop::fillGraph(BaseFab<int>&       a_regIrregCovered,
                           a_origin,
                           a_dx,
                           m_vectDx,
-                          ivsit());
+                          iv);
       {
         CH_TIME("fillGraph::endOfirregularCellLoop");
-        IrregNode newNode;
-        newNode.m_cell          = ivsit();
+        IrregNode& newNode = irregNodes[icell];
+        newNode.m_cell          = iv;
         newNode.m_volFrac       = volFrac;
         newNode.m_cellIndex     = 0;
         newNode.m_volCentroid   = volCentroid;
@@ -521,9 +572,13 @@ void NewGeometryShop::fillGraph(BaseFab<int>&       a_regIrregCovered,
             newNode.m_faceCentroid[loNodeInd] = loFaceCentroid[faceDir];
             newNode.m_faceCentroid[hiNodeInd] = hiFaceCentroid[faceDir];
           }
-        a_nodes.push_back(newNode);
       }
     } //end loop over cells in the box
+
+  for (int icell = 0; icell < numIrregCells; icell++)
+    {
+      a_nodes.push_back(irregNodes[icell]);
+    }
 }
 
 /**********************************************/
@@ -549,7 +604,7 @@ void NewGeometryShop::computeVoFInternals(Real&               a_volFrac,
 {
   CH_TIME("GeometryShop::ComputeVofInternals");
 
-  //assigns a_iv to m_currIv
+  //assigns a_iv to currIv()
   settCurrIv(a_iv);
 
   //for each CutCellMoments<dim>, we record the cell Center
@@ -557,7 +612,7 @@ void NewGeometryShop::computeVoFInternals(Real&               a_volFrac,
   RvgDim cellCenter;
   for (int idir = 0;idir < SpaceDim; ++idir)
     {
-      cellCenter[idir] = m_dxVect[idir]*(m_currIv[idir] +0.5) + m_origin[idir];
+      cellCenter[idir] = m_dxVect[idir]*(currIv()[idir] +0.5) + m_origin[idir];
     }
   if (GLOBALDIM != SpaceDim)
     {
@@ -605,11 +660,11 @@ void NewGeometryShop::computeVoFInternals(Real&               a_volFrac,
       Iv2 bdId;
       bdId[BDID_DIR]   = 2;
       bdId[BDID_HILO]  = 1;
-      ((NewGeometryShop *)this)->m_cutCellMoments = thisVof.m_bdCutCellMoments[bdId];
+      cutCellMoments() = thisVof.m_bdCutCellMoments[bdId];
     }
 #else
     {
-      ((NewGeometryShop *)this)->m_cutCellMoments = thisVof;
+      cutCellMoments() = thisVof;
     }
 #endif
 
@@ -663,12 +718,26 @@ void NewGeometryShop::computeVoFInternals(Real&               a_volFrac,
                   a_bndryCentroid,
                   a_loFaceCentroid,
                   a_hiFaceCentroid,
-                  m_currIv);
+                  currIv());
 }
 
 void NewGeometryShop::settCurrIv(const IntVect& a_iv)const
 {
-  m_currIv = a_iv;
+  currIv() = a_iv;
+}
+
+IntVect& NewGeometryShop::currIv()const
+{
+  return m_currIv[threadNumber()];
+}
+
+#if USING_TOP_FACE_MOMENTS
+CutCellMoments<GLOBALDIM-1>& NewGeometryShop::cutCellMoments()const
+#else
+CutCellMoments<GLOBALDIM>& NewGeometryShop::cutCellMoments()const
+#endif
+{
+  return m_cutCellMoments[threadNumber()];
 }
 
 #if RECURSIVE_GEOMETRY_GENERATION == 0
@@ -689,7 +758,7 @@ void NewGeometryShop::fillResiduals(int & a_degreePmax)const
     {
       for (int normJ = 0 ; normJ < 3 ; normJ++)
         {
-          m_residuals(m_currIv,iDegree * 3 + normJ) = m_cutCellMoments.getResidual(iDegree,normJ);
+          m_residuals(currIv(),iDegree * 3 + normJ) = cutCellMoments().getResidual(iDegree,normJ);
         }
     }
 #endif
@@ -701,7 +770,7 @@ Real NewGeometryShop::fillVolFrac()const
   EBorVol momentMap = VolMoment;
 
  //when called with VolMoment , get Vol returns the volume fraction
-  Real volume = m_cutCellMoments.getVol(momentMap);
+  Real volume = cutCellMoments().getVol(momentMap);
 
   return volume/m_volScaleFactor;
 }
@@ -717,7 +786,7 @@ void NewGeometryShop::fillArc(Vector<int>        a_arc[SpaceDim],
   for (int idir = 0; idir < SpaceDim; ++idir)
     {
       bdId[BDID_DIR] = idir;
-      bool covered =  m_cutCellMoments.getBdCutCellMoments(bdId).isCovered();
+      bool covered =  cutCellMoments().getBdCutCellMoments(bdId).isCovered();
 
       if (covered)
         {
@@ -728,7 +797,7 @@ void NewGeometryShop::fillArc(Vector<int>        a_arc[SpaceDim],
           a_arc[idir].resize(1);
 
           //otherIV is the iv in the idir direction on the a_hilo side
-          IntVect otherIV = m_currIv;
+          IntVect otherIV = currIv();
           otherIV[idir] += (a_hilo*2) - 1;
 
           if (m_domain.contains(otherIV))
@@ -785,12 +854,12 @@ void NewGeometryShop::fillAreaFrac(Vector<Real>  a_areaFrac[SpaceDim],
   for (int idir = 0; idir < SpaceDim ;++ idir)
     {
       bdId[BDID_DIR] = idir;
-      bool covered = m_cutCellMoments.getBdCutCellMoments(bdId).isCovered();
+      bool covered = cutCellMoments().getBdCutCellMoments(bdId).isCovered();
       //when called with VolMoment,get Vol returns the volume fraction
       if (!covered)
         {
           a_areaFrac[idir].resize(1);
-          a_areaFrac[idir][0] = m_cutCellMoments.getBdCutCellMoments(bdId).getVol(momentMap);
+          a_areaFrac[idir][0] = cutCellMoments().getBdCutCellMoments(bdId).getVol(momentMap);
           //scale area fraction
           Real scaleFactor = m_vectDx[idir]/m_volScaleFactor;
           a_areaFrac[idir][0] *= scaleFactor;
@@ -819,7 +888,7 @@ void NewGeometryShop::fillHiAreaFrac(Vector<Real>a_loAreaFrac[SpaceDim])const
 Real NewGeometryShop::fillBndryArea()const
 {
   EBorVol momentMap = EBMoment;
-  Real bndryArea =  m_cutCellMoments.getVol(momentMap);
+  Real bndryArea =  cutCellMoments().getVol(momentMap);
   bndryArea /= m_bndryAreaScaleFactor;
 
   return bndryArea;
@@ -835,7 +904,7 @@ RealVect NewGeometryShop::fillNormal() const
   map<IndexTM<int,SpaceDim>,
       IndexTM<Real,SpaceDim>,
       LexLT<IndexTM<int,SpaceDim> > >::const_iterator iter =
-        m_cutCellMoments.m_IFData.m_normalDerivatives.find(zeroDerivative);
+        cutCellMoments().m_IFData.m_normalDerivatives.find(zeroDerivative);
 
   for (int idir = 0; idir < SpaceDim; ++idir)
     {
@@ -851,7 +920,7 @@ RealVect NewGeometryShop::fillvolCentroid()const
   EBorVol momentMap = VolMoment;
 
   //returns IndexTM physical coordinates
-  RealVect cutCellCentroidPhysCoord = m_cutCellMoments.getCentroid(momentMap);
+  RealVect cutCellCentroidPhysCoord = cutCellMoments().getCentroid(momentMap);
 
   //returns RealVect coordinates relative to cell center
   RealVect centroid = convert2RelativeCoord(cutCellCentroidPhysCoord);
@@ -865,9 +934,9 @@ RealVect NewGeometryShop::fillBndryCentroid()const
   EBorVol momentMap = EBMoment;
 
   //returns IndexTM physical coordinates
-  RealVect cutCellCentroidPhysCoord = m_cutCellMoments.getCentroid(momentMap);
+  RealVect cutCellCentroidPhysCoord = cutCellMoments().getCentroid(momentMap);
 
-  //returns realvect relative to m_currIv
+  //returns realvect relative to currIv()
   RealVect centroid = convert2RelativeCoord(cutCellCentroidPhysCoord);
   return(centroid);
 }
@@ -884,14 +953,14 @@ void NewGeometryShop::fillFaceCentroid(Vector<RealVect>  a_faceCentroid[SpaceDim
   for (int idir = 0; idir < SpaceDim ;++ idir)
     {
       bdId[BDID_DIR] = idir;
-      bool covered = m_cutCellMoments.getBdCutCellMoments(bdId).isCovered();
+      bool covered = cutCellMoments().getBdCutCellMoments(bdId).isCovered();
        if (!covered)
         {
           a_faceCentroid[idir].resize(1);
 
           IndexTM<Real,SpaceDim - 1>centroidRel2FacePhysCoord;
           //returns IndexTM in physical (SpaceDim-1) coordinates
-          centroidRel2FacePhysCoord = m_cutCellMoments.getBdCutCellMoments(bdId).getCentroid(momentMap);
+          centroidRel2FacePhysCoord = cutCellMoments().getBdCutCellMoments(bdId).getCentroid(momentMap);
           //assigns SpaceDim-1 values to the appropriate components of a RealVect
           RealVect centroidPhysCoord;
 
@@ -932,7 +1001,7 @@ void NewGeometryShop::fillHiFaceCentroid(Vector<RealVect>a_hiFaceCentroid[SpaceD
 }
 
 
-//takes RealVect physical coordinates to coordinates relative to m_currIv
+//takes RealVect physical coordinates to coordinates relative to currIv()
 RealVect NewGeometryShop::convert2RelativeCoord(const RealVect& a_rVect)const
 {
   //rvect[idir] = dx*(iv[idir] + 0.5 + relCoord[idir]) + origin[idir]
@@ -941,13 +1010,13 @@ RealVect NewGeometryShop::convert2RelativeCoord(const RealVect& a_rVect)const
     {
       // retval[idir] = a_rVect[idir] - m_origin[idir];
       retval[idir] = a_rVect[idir] /  m_vectDx[idir];
-      //retval[idir] -= (m_currIv[idir] + 0.5);
+      //retval[idir] -= (currIv()[idir] + 0.5);
     }
 
   return retval;
 }
 
-//takes IndexTM physical coordinates to coordinates relative to m_currIv
+//takes IndexTM physical coordinates to coordinates relative to currIv()
 RealVect NewGeometryShop::convert2RelativeCoord(const IndexTM<Real,SpaceDim>& a_rVect)const
 {
   //rvect[idir] = dx*(iv[idir] + 0.5 + relCoord[idir]) + origin[idir]
@@ -956,7 +1025,7 @@ RealVect NewGeometryShop::convert2RelativeCoord(const IndexTM<Real,SpaceDim>& a_
     {
       // retval[idir] = a_rVect[idir] - m_origin[idir];
       retval[idir] = a_rVect[idir] / m_vectDx[idir];
-      //      retval[idir] -= (m_currIv[idir] + 0.5);
+      //      retval[idir] -= (currIv()[idir] + 0.5);
     }
   return retval;
 }
@@ -1476,6 +1545,7 @@ void NewGeometryShop::clipComputedVal(Real            &    a_volFrac,
               if (thisVofClipped)
                 {
                   NewGeometryShop* changedThis = (NewGeometryShop *) this;
+#pragma omp atomic
                   changedThis->m_numCellsClipped += 1;
                 }
             }
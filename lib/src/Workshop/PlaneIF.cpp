@@ -75,6 +75,50 @@ Real PlaneIF::value(const RealVect& a_point) const
   return retval;
 }
 
+void PlaneIF::values(Vector<Real>&           a_values,
+                     const Vector<RealVect>& a_points) const
+{
+  int numPts = a_points.size();
+  a_values.resize(numPts);
+  if (numPts == 0)
+  {
+    return;
+  }
+
+  // Local copies so that the loop below does not reload them
+  Real point[SpaceDim];
+  Real normal[SpaceDim];
+  for (int idir = 0; idir < SpaceDim; idir++)
+  {
+    point[idir]  = m_point[idir];
+    normal[idir] = m_normal[idir];
+  }
+  Real sign = m_inside ? 1.0 : -1.0;
+
+  Real* values = &(a_values[0]);
+  const RealVect* points = &(a_points[0]);
+  for (int ipt = 0; ipt < numPts; ipt++)
+  {
+    // Same operations as value(), summed in the order of dotProduct()
+    Real dot = (point[0] - points[ipt][0])*normal[0];
+    for (int idir = 1; idir < SpaceDim; idir++)
+    {
+      dot += (point[idir] - points[ipt][idir])*normal[idir];
+    }
+    values[ipt] = sign*dot;
+  }
+}
+
+bool PlaneIF::hash(GeometryHash& a_hash) const
+{
+  a_hash.add(std::string("PlaneIF"));
+  a_hash.add(m_normal);
+  a_hash.add(m_point);
+  a_hash.add(m_inside);
+
+  return true;
+}
+
 GeometryService::InOut PlaneIF::InsideOutside(const RealVect& lo, const RealVect& hi) const
 {
 
@@ -63,6 +63,14 @@ Real STLIF::value(const RealVect& a_point) const
   return retval;
 }
 
+bool STLIF::hash(GeometryHash& a_hash) const
+{
+  a_hash.add(std::string("STLIF"));
+  a_hash.add(int(m_dataType));
+
+  return a_hash.addFile(m_filename);
+}
+
 BaseIF* STLIF::newImplicitFunction() const
 {
   CH_TIME("STLIF::newImplicitFunction");
@@ -124,6 +124,50 @@ Real SphereIF::value(const RealVect& a_point) const
   return retval;
 }
 
+void SphereIF::values(Vector<Real>&           a_values,
+                      const Vector<RealVect>& a_points) const
+{
+  int numPts = a_points.size();
+  a_values.resize(numPts);
+  if (numPts == 0)
+  {
+    return;
+  }
+
+  // Local copies so that the loop below does not reload them
+  Real center[SpaceDim];
+  for (int idir = 0; idir < SpaceDim; idir++)
+  {
+    center[idir] = m_center[idir];
+  }
+  Real radius2 = m_radius2;
+  Real sign = m_inside ? 1.0 : -1.0;
+
+  Real* values = &(a_values[0]);
+  const RealVect* points = &(a_points[0]);
+  for (int ipt = 0; ipt < numPts; ipt++)
+  {
+    // Same operations as value()
+    Real distance2 = 0.0;
+    for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      Real cur = points[ipt][idir] - center[idir];
+      distance2 += cur*cur;
+    }
+    values[ipt] = sign*(distance2 - radius2);
+  }
+}
+
+bool SphereIF::hash(GeometryHash& a_hash) const
+{
+  a_hash.add(std::string("SphereIF"));
+  a_hash.add(m_radius);
+  a_hash.add(m_center);
+  a_hash.add(m_inside);
+
+  return true;
+}
+
 BaseIF* SphereIF::newImplicitFunction() const
 {
   SphereIF* spherePtr = new SphereIF(m_radius,
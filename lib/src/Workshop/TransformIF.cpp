@@ -316,6 +316,31 @@ Real TransformIF::value(const RealVect& a_point) const
   return retval;
 }
 
+void TransformIF::values(Vector<Real>&           a_values,
+                         const Vector<RealVect>& a_points) const
+{
+  int numPts = a_points.size();
+
+  // The inverse transforms of a_points
+  Vector<RealVect> invPoints(numPts);
+  for (int ipt = 0; ipt < numPts; ipt++)
+  {
+    vectorMultiply(invPoints[ipt],m_invTransform,a_points[ipt]);
+  }
+
+  // Get the function values at invPoints
+  m_impFunc->values(a_values,invPoints);
+}
+
+bool TransformIF::hash(GeometryHash& a_hash) const
+{
+  a_hash.add(std::string("TransformIF"));
+  a_hash.add(m_transform,    sizeof(m_transform));
+  a_hash.add(m_invTransform, sizeof(m_invTransform));
+
+  return m_impFunc->hash(a_hash);
+}
+
 Real TransformIF::value(const IndexTM<Real,GLOBALDIM>& a_point) const
 {
   RealVect point;
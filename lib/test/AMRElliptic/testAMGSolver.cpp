@@ -0,0 +1,434 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+// Purpose:
+//  Check that AMGSolver solves variable coefficient VCAMRPoissonOp2 and
+//  ViscousTensorOp problems on a level, rebuilds its hierarchy when the
+//  coefficients change, and, as the bottom solver of AMRMultiGrid, gives
+//  the answer BiCGStabSolver does.
+//
+// Usage:
+//  <program-name> [-q|-v] ...
+//
+//  where:
+//    -q means run quietly (only pass/fail messages printed)
+//    -v means run verbosely (all messages printed)
+//    ... all non-option arguments are ignored (Chombo convention)
+//
+//  Default is `-q'
+//
+
+#include <cstring>
+#include <cmath>
+
+#include "parstream.H"
+#include "SPMD.H"
+#include "LoadBalance.H"
+#include "BRMeshRefine.H"
+#include "BoxIterator.H"
+#include "VCAMRPoissonOp2.H"
+#include "ViscousTensorOp.H"
+#include "AMRMultiGrid.H"
+#include "AMGSolver.H"
+#include "BCFunc.H"
+#include "BiCGStabSolver.H"
+
+#ifdef CH_MPI
+#include <mpi.h>
+#endif
+
+#include "UsingNamespace.H"
+
+using std::endl;
+
+void parseTestOptions(int argc, char* argv[]);
+
+static const char *pgmname = "testAMGSolver";
+static const char *indent = "   ";
+
+static bool verbose = false;
+
+static const int nCells = 64;
+static const Real dx = 1.0/nCells;
+
+extern "C"
+{
+  void ZeroValue(Real* pos,
+                 int* dir,
+                 Side::LoHiSide* side,
+                 Real* a_values)
+  {
+    a_values[0] = 0;
+  }
+
+  void ZeroVectorValue(Real* pos,
+                       int* dir,
+                       Side::LoHiSide* side,
+                       Real* a_values)
+  {
+    for (int comp = 0; comp < SpaceDim; comp++)
+      {
+        a_values[comp] = 0;
+      }
+  }
+}
+
+// second order Dirichlet on the faces of a_valid on the domain boundary
+static void DirichletBC(FArrayBox&           a_state,
+                        const Box&           a_valid,
+                        const ProblemDomain& a_domain,
+                        Real                 a_dx,
+                        bool                 a_homogeneous)
+{
+  const Box& domainBox = a_domain.domainBox();
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      for (SideIterator sit; sit.ok(); ++sit)
+        {
+          if (a_valid.sideEnd(sit())[idir] == domainBox.sideEnd(sit())[idir])
+            {
+              if (a_state.nComp() == 1)
+                {
+                  DiriBC(a_state, a_valid, a_dx, a_homogeneous, ZeroValue, idir, sit(), 2);
+                }
+              else
+                {
+                  DiriBC(a_state, a_valid, a_dx, a_homogeneous, ZeroVectorValue, idir, sit(), 2);
+                }
+            }
+        }
+    }
+}
+
+// a_jump on the faces and cells right of x = 1/2, 1 left of it
+static void setJumpCoefficients(LevelData<FArrayBox>& a_aCoef,
+                                LevelData<FluxBox>&   a_bCoef,
+                                Real                  a_jump)
+{
+  const int half = nCells/2;
+  for (DataIterator dit = a_aCoef.dataIterator(); dit.ok(); ++dit)
+    {
+      FArrayBox& aFab = a_aCoef[dit];
+      for (BoxIterator bit(aFab.box()); bit.ok(); ++bit)
+        {
+          aFab(bit(), 0) = (bit()[0] >= half) ? a_jump : 1.0;
+        }
+      for (int idir = 0; idir < SpaceDim; idir++)
+        {
+          FArrayBox& bFab = a_bCoef[dit][idir];
+          for (BoxIterator bit(bFab.box()); bit.ok(); ++bit)
+            {
+              bool right = (idir == 0) ? (bit()[0] > half) : (bit()[0] >= half);
+              bFab(bit(), 0) = right ? a_jump : 1.0;
+            }
+        }
+    }
+}
+
+// | rhs - L(phi) | / | rhs |
+static Real relativeResidual(LinearOp<LevelData<FArrayBox> >& a_op,
+                             const LevelData<FArrayBox>&       a_phi,
+                             const LevelData<FArrayBox>&       a_rhs)
+{
+  LevelData<FArrayBox> res;
+  a_op.create(res, a_rhs);
+  a_op.residual(res, a_phi, a_rhs, false);
+  return a_op.norm(res, 2)/a_op.norm(a_rhs, 2);
+}
+
+// variable coefficient Poisson with a coefficient jump of 1000, solved
+// again after the jump changes in place
+static int testVCAMRPoissonOp2(const DisjointBoxLayout& a_grids,
+                               const ProblemDomain&     a_domain)
+{
+  int status = 0;
+
+  RefCountedPtr<LevelData<FArrayBox> > aCoef(new LevelData<FArrayBox>(a_grids, 1));
+  RefCountedPtr<LevelData<FluxBox> > bCoef(new LevelData<FluxBox>(a_grids, 1));
+  setJumpCoefficients(*aCoef, *bCoef, 1000.0);
+
+  Vector<DisjointBoxLayout> grids(1, a_grids);
+  Vector<int> refRatios(1, 2);
+  Vector<RefCountedPtr<LevelData<FArrayBox> > > aCoefs(1, aCoef);
+  Vector<RefCountedPtr<LevelData<FluxBox> > > bCoefs(1, bCoef);
+  VCAMRPoissonOp2Factory factory;
+  factory.define(a_domain, grids, refRatios, dx, DirichletBC, 0.0, aCoefs, -1.0, bCoefs);
+  VCAMRPoissonOp2* op = dynamic_cast<VCAMRPoissonOp2*>(factory.MGnewOp(a_domain, 0, false));
+
+  LevelData<FArrayBox> phi(a_grids, 1, IntVect::Unit);
+  LevelData<FArrayBox> rhs(a_grids, 1);
+  for (DataIterator dit = a_grids.dataIterator(); dit.ok(); ++dit)
+    {
+      phi[dit].setVal(0.0);
+      rhs[dit].setVal(1.0);
+    }
+
+  AMGSolver solver;
+  solver.define(op, false);
+  solver.m_eps = 1.0e-10;
+  solver.m_verbosity = verbose ? 4 : 0;
+  solver.solve(phi, rhs);
+  Real residual = relativeResidual(*op, phi, rhs);
+  if (verbose)
+    {
+      pout() << indent << "VCAMRPoissonOp2: " << solver.numLevels() << " levels, exit status "
+             << solver.m_exitStatus << ", relative residual " << residual << endl;
+    }
+  if (solver.m_exitStatus != 1 || residual > 1.0e-9 || solver.numLevels() < 3)
+    {
+      pout() << indent << "VCAMRPoissonOp2 solve failed: " << solver.numLevels()
+             << " levels, exit status " << solver.m_exitStatus
+             << ", relative residual " << residual << endl;
+      status += 1;
+    }
+
+  // a new jump, in place: the operator tells the solver
+  setJumpCoefficients(*aCoef, *bCoef, 0.001);
+  op->resetCoefficients();
+
+  // the relaxation parameter follows the new coefficients, and a new alpha
+  // and beta, like the one of an operator built from them
+  op->resetLambda();
+  op->setAlphaAndBeta(2.0, -0.5);
+  op->resetLambda();
+  VCAMRPoissonOp2* freshOp = dynamic_cast<VCAMRPoissonOp2*>(factory.MGnewOp(a_domain, 0, false));
+  freshOp->setAlphaAndBeta(2.0, -0.5);
+  freshOp->resetLambda();
+  Real lambdaDiff = 0.0;
+  for (DataIterator dit = a_grids.dataIterator(); dit.ok(); ++dit)
+    {
+      FArrayBox diff(a_grids[dit], 1);
+      diff.copy(op->m_lambda[dit]);
+      diff.minus(freshOp->m_lambda[dit]);
+      lambdaDiff = Max(lambdaDiff, diff.norm(0));
+    }
+#ifdef CH_MPI
+  Real localDiff = lambdaDiff;
+  MPI_Allreduce(&localDiff, &lambdaDiff, 1, MPI_CH_REAL, MPI_MAX, Chombo_MPI::comm);
+#endif
+  delete freshOp;
+  if (lambdaDiff > 1.0e-12)
+    {
+      pout() << indent << "VCAMRPoissonOp2 relaxation parameter is out of date by "
+             << lambdaDiff << endl;
+      status += 100;
+    }
+  op->setAlphaAndBeta(0.0, -1.0);
+  for (DataIterator dit = a_grids.dataIterator(); dit.ok(); ++dit)
+    {
+      phi[dit].setVal(0.0);
+    }
+  solver.solve(phi, rhs);
+  residual = relativeResidual(*op, phi, rhs);
+  if (verbose)
+    {
+      pout() << indent << "VCAMRPoissonOp2, changed coefficients: exit status "
+             << solver.m_exitStatus << ", relative residual " << residual << endl;
+    }
+  if (solver.m_exitStatus != 1 || residual > 1.0e-9)
+    {
+      pout() << indent << "VCAMRPoissonOp2 solve after the coefficients changed failed: exit status "
+             << solver.m_exitStatus << ", relative residual " << residual << endl;
+      status += 10;
+    }
+
+  delete op;
+  return status;
+}
+
+// viscous tensor operator with a jump of 100 in viscosity
+static int testViscousTensorOp(const DisjointBoxLayout& a_grids,
+                               const ProblemDomain&     a_domain)
+{
+  int status = 0;
+
+  RefCountedPtr<LevelData<FArrayBox> > aCoef(new LevelData<FArrayBox>(a_grids, 1));
+  RefCountedPtr<LevelData<FluxBox> > eta(new LevelData<FluxBox>(a_grids, 1));
+  RefCountedPtr<LevelData<FluxBox> > lambda(new LevelData<FluxBox>(a_grids, 1));
+  setJumpCoefficients(*aCoef, *eta, 100.0);
+  setJumpCoefficients(*aCoef, *lambda, 100.0);
+  for (DataIterator dit = a_grids.dataIterator(); dit.ok(); ++dit)
+    {
+      (*aCoef)[dit].setVal(1.0);
+    }
+
+  BCHolder bc(DirichletBC);
+  DisjointBoxLayout noGrids;
+  ViscousTensorOp op(a_grids, noGrids, noGrids, eta, lambda, aCoef,
+                     1.0, -1.0, 2, 2, a_domain, dx, 2*dx, bc);
+
+  LevelData<FArrayBox> phi(a_grids, SpaceDim, IntVect::Unit);
+  LevelData<FArrayBox> rhs(a_grids, SpaceDim);
+  for (DataIterator dit = a_grids.dataIterator(); dit.ok(); ++dit)
+    {
+      phi[dit].setVal(0.0);
+      for (int comp = 0; comp < SpaceDim; comp++)
+        {
+          rhs[dit].setVal(1.0 + comp, comp);
+        }
+    }
+
+  AMGSolver solver;
+  solver.define(&op, false);
+  solver.m_eps = 1.0e-10;
+  solver.m_verbosity = verbose ? 4 : 0;
+  solver.solve(phi, rhs);
+  Real residual = relativeResidual(op, phi, rhs);
+  if (verbose)
+    {
+      pout() << indent << "ViscousTensorOp: " << solver.numLevels() << " levels, exit status "
+             << solver.m_exitStatus << ", relative residual " << residual << endl;
+    }
+  if (solver.m_exitStatus != 1 || residual > 1.0e-9 || solver.numLevels() < 3)
+    {
+      pout() << indent << "ViscousTensorOp solve failed: " << solver.numLevels()
+             << " levels, exit status " << solver.m_exitStatus
+             << ", relative residual " << residual << endl;
+      status += 100;
+    }
+  return status;
+}
+
+// AMRMultiGrid on a_grids with the given bottom solver
+static int solveMG(LevelData<FArrayBox>&                     a_phi,
+                   const DisjointBoxLayout&                  a_grids,
+                   const ProblemDomain&                      a_domain,
+                   LinearSolver<LevelData<FArrayBox> >*      a_bottomSolver)
+{
+  RefCountedPtr<LevelData<FArrayBox> > aCoef(new LevelData<FArrayBox>(a_grids, 1));
+  RefCountedPtr<LevelData<FluxBox> > bCoef(new LevelData<FluxBox>(a_grids, 1));
+  setJumpCoefficients(*aCoef, *bCoef, 1000.0);
+
+  Vector<DisjointBoxLayout> grids(1, a_grids);
+  Vector<int> refRatios(1, 2);
+  Vector<RefCountedPtr<LevelData<FArrayBox> > > aCoefs(1, aCoef);
+  Vector<RefCountedPtr<LevelData<FluxBox> > > bCoefs(1, bCoef);
+  VCAMRPoissonOp2Factory factory;
+  factory.define(a_domain, grids, refRatios, dx, DirichletBC, 0.0, aCoefs, -1.0, bCoefs);
+
+  Vector<LevelData<FArrayBox>* > phi(1, &a_phi), rhs(1);
+  rhs[0] = new LevelData<FArrayBox>(a_grids, 1);
+  for (DataIterator dit = a_grids.dataIterator(); dit.ok(); ++dit)
+    {
+      (*rhs[0])[dit].setVal(1.0);
+      a_phi[dit].setVal(0.0);
+    }
+
+  // a 32^SpaceDim bottom level
+  AMRMultiGrid<LevelData<FArrayBox> > solver;
+  solver.m_maxDepth = 2;
+  solver.define(a_domain, factory, a_bottomSolver, 1);
+  solver.setSolverParameters(2, 2, 2, 1, 30, 1.0e-10, 1.0e-30, 1.0e-30);
+  solver.m_verbosity = 0;
+  solver.solve(phi, rhs, 0, 0, true);
+
+  delete rhs[0];
+  return solver.m_exitStatus;
+}
+
+static int testBottomSolver(const DisjointBoxLayout& a_grids,
+                            const ProblemDomain&     a_domain)
+{
+  int status = 0;
+  LevelData<FArrayBox> phiRef(a_grids, 1, IntVect::Unit);
+  LevelData<FArrayBox> phi(a_grids, 1, IntVect::Unit);
+
+  BiCGStabSolver<LevelData<FArrayBox> > bicgstab;
+  bicgstab.m_verbosity = 0;
+  bicgstab.m_eps = 1.0e-12;
+  bicgstab.m_imax = 400;
+  int refStatus = solveMG(phiRef, a_grids, a_domain, &bicgstab);
+
+  AMGSolver amg;
+  amg.m_verbosity = 0;
+  amg.m_eps = 1.0e-12;
+  int amgStatus = solveMG(phi, a_grids, a_domain, &amg);
+
+  LevelDataOps<FArrayBox> ops;
+  LevelData<FArrayBox> diff(a_grids, 1);
+  ops.axby(diff, phi, phiRef, 1.0, -1.0);
+  Real relDiff = norm(diff, Interval(0, 0), 0)/norm(phiRef, Interval(0, 0), 0);
+
+  if (verbose)
+    {
+      pout() << indent << "AMRMultiGrid: exit status " << refStatus << " with BiCGStab, "
+             << amgStatus << " with AMG bottom solves; difference " << relDiff << endl;
+    }
+  if (refStatus != 1 || amgStatus != 1 || relDiff > 1.0e-8)
+    {
+      pout() << indent << "AMRMultiGrid with AMG bottom solves failed: exit status "
+             << refStatus << " with BiCGStab, " << amgStatus
+             << " with AMG; difference " << relDiff << endl;
+      status += 1000;
+    }
+  return status;
+}
+
+int
+main(int argc ,char* argv[])
+{
+#ifdef CH_MPI
+  MPI_Init(&argc, &argv);
+#endif
+  parseTestOptions(argc, argv);
+
+  int status = 0;
+  {
+    Box domainBox(IntVect::Zero, (nCells-1)*IntVect::Unit);
+    ProblemDomain domain(domainBox);
+    Vector<Box> boxes;
+    domainSplit(domainBox, boxes, 16, 16);
+    Vector<int> procs;
+    LoadBalance(procs, boxes);
+    DisjointBoxLayout grids(boxes, procs, domain);
+
+    status += testVCAMRPoissonOp2(grids, domain);
+    status += testViscousTensorOp(grids, domain);
+    status += testBottomSolver(grids, domain);
+  }
+
+  pout() << indent << pgmname << ": "
+         << ( (status == 0) ? "passed all tests" : "failed at least one test,")
+         << endl;
+
+#ifdef CH_MPI
+  MPI_Finalize();
+#endif
+  return status;
+}
+
+///
+// Parse the standard test options (-v -q) out of the command line.
+// Stop parsing when a non-option argument is found.
+///
+void
+parseTestOptions( int argc ,char* argv[] )
+{
+  for ( int i = 1 ; i < argc ; ++i )
+    {
+      if ( argv[i][0] == '-' ) //if it is an option
+        {
+          // compare 3 chars to differentiate -x from -xx
+          if ( strncmp( argv[i] ,"-v" ,3 ) == 0 )
+            {
+              verbose = true ;
+            }
+          else if ( strncmp( argv[i] ,"-q" ,3 ) == 0 )
+            {
+              verbose = false ;
+            }
+          else
+            {
+              break ;
+            }
+        }
+    }
+  return ;
+}
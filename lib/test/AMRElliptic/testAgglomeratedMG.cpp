@@ -0,0 +1,280 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+// Purpose:
+//  Check that AMRMultiGrid with AMRPoissonOp::s_agglomerateCells set
+//  builds a deeper multigrid hierarchy than the boxes of the level allow,
+//  runs the bottom solve on rank 0 only, and converges to the answer it
+//  gets without agglomeration.
+//
+// Usage:
+//  <program-name> [-q|-v] ...
+//
+//  where:
+//    -q means run quietly (only pass/fail messages printed)
+//    -v means run verbosely (all messages printed)
+//    ... all non-option arguments are ignored (Chombo convention)
+//
+//  Default is `-q'
+//
+
+#include <cstring>
+#include <cmath>
+
+#include "parstream.H"
+#include "SPMD.H"
+#include "LoadBalance.H"
+#include "BRMeshRefine.H"
+#include "AMRPoissonOp.H"
+#include "AMRMultiGrid.H"
+#include "BCFunc.H"
+#include "BiCGStabSolver.H"
+
+#ifdef CH_MPI
+#include <mpi.h>
+#endif
+
+#include "UsingNamespace.H"
+
+using std::endl;
+
+void parseTestOptions(int argc, char* argv[]);
+
+static const char *pgmname = "testAgglomeratedMG";
+static const char *indent = "   ";
+
+static bool verbose = false;
+
+static const int nCells = 64;
+static const Real dx = 1.0/nCells;
+
+extern "C"
+{
+  // phi = x^2 + y^2 + z^2, so Laplacian(phi) = 2*SpaceDim
+  void ParabolaValue(Real* pos,
+                     int* dir,
+                     Side::LoHiSide* side,
+                     Real* a_values)
+  {
+    a_values[0] = D_TERM(pos[0]*pos[0], +pos[1]*pos[1], +pos[2]*pos[2]);
+  }
+}
+
+// Dirichlet on the faces of a_valid on the domain boundary
+static void ParabolaBC(FArrayBox&           a_state,
+                       const Box&           a_valid,
+                       const ProblemDomain& a_domain,
+                       Real                 a_dx,
+                       bool                 a_homogeneous)
+{
+  const Box& domainBox = a_domain.domainBox();
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      for (SideIterator sit; sit.ok(); ++sit)
+        {
+          if (a_valid.sideEnd(sit())[idir] == domainBox.sideEnd(sit())[idir])
+            {
+              DiriBC(a_state, a_valid, a_dx, a_homogeneous, ParabolaValue, idir, sit());
+            }
+        }
+    }
+}
+
+// BiCGStabSolver that counts the bottom solves on this rank
+class CountingSolver : public BiCGStabSolver<LevelData<FArrayBox> >
+{
+public:
+  CountingSolver()
+    :m_solves(0)
+  {
+  }
+
+  virtual void solve(LevelData<FArrayBox>& a_phi, const LevelData<FArrayBox>& a_rhs)
+  {
+    m_solves++;
+    BiCGStabSolver<LevelData<FArrayBox> >::solve(a_phi, a_rhs);
+  }
+
+  int m_solves;
+};
+
+struct MGResult
+{
+  int m_exitStatus;
+  int m_numLevels;
+  int m_bottomSolves;
+};
+
+// AMRMultiGrid on a_grids with the given s_agglomerateCells
+static MGResult solveMG(LevelData<FArrayBox>&    a_phi,
+                        const DisjointBoxLayout& a_grids,
+                        const ProblemDomain&     a_domain,
+                        int                      a_agglomerateCells)
+{
+  AMRPoissonOp::s_agglomerateCells = a_agglomerateCells;
+
+  Vector<DisjointBoxLayout> grids(1, a_grids);
+  Vector<int> refRatios(1, 2);
+  AMRPoissonOpFactory factory;
+  factory.define(a_domain, grids, refRatios, dx, ParabolaBC);
+
+  Vector<LevelData<FArrayBox>* > phi(1, &a_phi), rhs(1);
+  rhs[0] = new LevelData<FArrayBox>(a_grids, 1);
+  for (DataIterator dit = a_grids.dataIterator(); dit.ok(); ++dit)
+    {
+      (*rhs[0])[dit].setVal(2*SpaceDim);
+      a_phi[dit].setVal(0.0);
+    }
+
+  CountingSolver bottomSolver;
+  bottomSolver.m_verbosity = 0;
+  AMRMultiGrid<LevelData<FArrayBox> > solver;
+  solver.define(a_domain, factory, &bottomSolver, 1);
+  solver.setSolverParameters(2, 2, 2, 1, 30, 1.0e-10, 1.0e-30, 1.0e-30);
+  solver.m_verbosity = 0;
+  solver.solve(phi, rhs, 0, 0, true);
+
+  MGResult result;
+  result.m_exitStatus = solver.m_exitStatus;
+  result.m_numLevels = solver.getOperatorsMG()[0].size();
+  result.m_bottomSolves = bottomSolver.m_solves;
+
+  delete rhs[0];
+  AMRPoissonOp::s_agglomerateCells = 0;
+  return result;
+}
+
+static int testAgglomeratedMG(const DisjointBoxLayout& a_grids,
+                              const ProblemDomain&     a_domain)
+{
+  int status = 0;
+  LevelData<FArrayBox> phiRef(a_grids, 1, IntVect::Unit);
+  LevelData<FArrayBox> phi(a_grids, 1, IntVect::Unit);
+
+  MGResult plain = solveMG(phiRef, a_grids, a_domain, 0);
+  // 32 cells per rank: the 8^SpaceDim level goes onto at most 2 ranks,
+  // the 4^SpaceDim one onto rank 0
+  MGResult agglomerated = solveMG(phi, a_grids, a_domain, 32);
+
+  AMRPoissonOp op;
+  op.define(a_grids, dx, a_domain, ParabolaBC);
+  LevelData<FArrayBox> diff(a_grids, 1);
+  op.axby(diff, phi, phiRef, 1.0, -1.0);
+  Real relDiff = op.norm(diff, 0)/op.norm(phiRef, 0);
+
+  if (verbose)
+    {
+      pout() << indent << "without agglomeration: exit status " << plain.m_exitStatus
+             << ", " << plain.m_numLevels << " multigrid levels, "
+             << plain.m_bottomSolves << " bottom solves on this rank" << endl;
+      pout() << indent << "with agglomeration: exit status " << agglomerated.m_exitStatus
+             << ", " << agglomerated.m_numLevels << " multigrid levels, "
+             << agglomerated.m_bottomSolves << " bottom solves on this rank" << endl;
+      pout() << indent << "difference " << relDiff << endl;
+    }
+
+  // exit status 1: converged
+  if (plain.m_exitStatus != 1 || agglomerated.m_exitStatus != 1)
+    {
+      pout() << indent << "solve failed: exit status " << plain.m_exitStatus
+             << " without agglomeration, " << agglomerated.m_exitStatus
+             << " with" << endl;
+      status += 1;
+    }
+  // 8^SpaceDim boxes stop at depth 2 on their own; agglomerated, the
+  // hierarchy goes down to a 2^SpaceDim domain
+  if (plain.m_numLevels != 3 || agglomerated.m_numLevels != 6)
+    {
+      pout() << indent << "wrong depth: " << plain.m_numLevels
+             << " levels without agglomeration, " << agglomerated.m_numLevels
+             << " with" << endl;
+      status += 10;
+    }
+  if (agglomerated.m_bottomSolves == 0 && procID() == 0 ||
+      agglomerated.m_bottomSolves != 0 && procID() != 0)
+    {
+      pout() << indent << agglomerated.m_bottomSolves
+             << " agglomerated bottom solves on rank " << procID() << endl;
+      status += 100;
+    }
+  if (relDiff > 1.0e-8)
+    {
+      pout() << indent << "solutions differ by " << relDiff << endl;
+      status += 1000;
+    }
+#ifdef CH_MPI
+  if (Chombo_MPI::comm != MPI_COMM_WORLD)
+    {
+      pout() << indent << "communicator not restored" << endl;
+      status += 10000;
+    }
+#endif
+  return status;
+}
+
+int
+main(int argc ,char* argv[])
+{
+#ifdef CH_MPI
+  MPI_Init(&argc, &argv);
+#endif
+  parseTestOptions(argc, argv);
+
+  int status = 0;
+  {
+    Box domainBox(IntVect::Zero, (nCells-1)*IntVect::Unit);
+    ProblemDomain domain(domainBox);
+    Vector<Box> boxes;
+    domainSplit(domainBox, boxes, 8, 8);
+    Vector<int> procs;
+    LoadBalance(procs, boxes);
+    DisjointBoxLayout grids(boxes, procs, domain);
+
+    status += testAgglomeratedMG(grids, domain);
+  }
+
+  pout() << indent << pgmname << ": "
+         << ( (status == 0) ? "passed all tests" : "failed at least one test,")
+         << endl;
+
+#ifdef CH_MPI
+  MPI_Finalize();
+#endif
+  return status;
+}
+
+///
+// Parse the standard test options (-v -q) out of the command line.
+// Stop parsing when a non-option argument is found.
+///
+void
+parseTestOptions( int argc ,char* argv[] )
+{
+  for ( int i = 1 ; i < argc ; ++i )
+    {
+      if ( argv[i][0] == '-' ) //if it is an option
+        {
+          // compare 3 chars to differentiate -x from -xx
+          if ( strncmp( argv[i] ,"-v" ,3 ) == 0 )
+            {
+              verbose = true ;
+            }
+          else if ( strncmp( argv[i] ,"-q" ,3 ) == 0 )
+            {
+              verbose = false ;
+            }
+          else
+            {
+              break ;
+            }
+        }
+    }
+  return ;
+}
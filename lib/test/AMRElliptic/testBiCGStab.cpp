@@ -482,6 +482,44 @@ testBiCGStab()
         pout()<<indent<<"residual norm "<<rnorm<<"   Error max norm = "<<enorm<<std::endl;
       }
 
+    // A solver that keeps its workspace gives the same answer (up to the
+    // order of the threads' sums in the norms and dot products) and, once
+    // the FArrayBox pool is warm, takes nothing more from the heap.
+    pout()<<indent2<<"BiCGStab with a kept workspace\n";
+    BiCGStabSolver<LevelData<FArrayBox> > ksolver;
+    ksolver.define(&amrop, false);
+    ksolver.m_reuseWorkspace = true;
+    ksolver.m_verbosity = 0;
+    bsolver.m_verbosity = 0;
+
+    amrop.scale(phi, 0.0);
+    bsolver.solve(phi, rhs);
+    amrop.scale(correction, 0.0);
+    ksolver.solve(correction, rhs);
+    long heapAllocs = -1;
+    PArena* pool = dynamic_cast<PArena*>(FArrayBox::arena());
+    if (pool != NULL) heapAllocs = pool->numHeapAllocs();
+    amrop.scale(correction, 0.0);
+    ksolver.solve(correction, rhs);
+    amrop.axby(error, phi, correction, 1, -1);
+    enorm = amrop.norm(error, 0);
+    pout()<<indent<<"difference from BiCGStab "<<enorm<<std::endl;
+    if (enorm > 1.0e-10*amrop.norm(phi, 0))
+      {
+        pout()<<indent<<"kept workspace changed the answer"<<std::endl;
+        return 1;
+      }
+    if (pool == NULL)
+      {
+        pout()<<indent<<"FArrayBox data does not come from a PArena"<<std::endl;
+        return 2;
+      }
+    if (pool->numHeapAllocs() != heapAllocs)
+      {
+        pout()<<indent<<"repeated solve took "<<pool->numHeapAllocs() - heapAllocs
+              <<" blocks from the heap"<<std::endl;
+        return 3;
+      }
   }
 
   return 0;
@@ -0,0 +1,391 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+// Purpose:
+//  Check that VCAMRPoissonOp2 and ViscousTensorOp relax with the
+//  coefficients they have now.  The coefficients of an operator are
+//  changed in place, the operator is told the way its documentation asks
+//  (setTime, resetCoefficients, resetLambda, setAlphaAndBeta), and its
+//  relaxation coefficient, and that of a coarser multigrid operator
+//  observing it, must be those of operators built from the new
+//  coefficients.
+//
+// Usage:
+//  <program-name> [-q|-v] ...
+//
+//  where:
+//    -q means run quietly (only pass/fail messages printed)
+//    -v means run verbosely (all messages printed)
+//    ... all non-option arguments are ignored (Chombo convention)
+//
+//  Default is `-q'
+//
+
+#include <cstring>
+#include <cmath>
+
+#include "parstream.H"
+#include "SPMD.H"
+#include "LoadBalance.H"
+#include "BRMeshRefine.H"
+#include "BoxIterator.H"
+#include "VCAMRPoissonOp2.H"
+#include "ViscousTensorOp.H"
+#include "BCFunc.H"
+
+#ifdef CH_MPI
+#include <mpi.h>
+#endif
+
+#include "UsingNamespace.H"
+
+using std::endl;
+
+void parseTestOptions(int argc, char* argv[]);
+
+static const char *pgmname = "testCoefficientChange";
+static const char *indent = "   ";
+
+static bool verbose = false;
+
+static const int nCells = 32;
+static const Real dx = 1.0/nCells;
+static const Real tolerance = 1.0e-12;
+
+extern "C"
+{
+  void ZeroValue(Real* pos,
+                 int* dir,
+                 Side::LoHiSide* side,
+                 Real* a_values)
+  {
+    a_values[0] = 0;
+  }
+
+  void ZeroVectorValue(Real* pos,
+                       int* dir,
+                       Side::LoHiSide* side,
+                       Real* a_values)
+  {
+    for (int comp = 0; comp < SpaceDim; comp++)
+      {
+        a_values[comp] = 0;
+      }
+  }
+}
+
+// second order homogeneous Dirichlet on the faces of a_valid on the
+// domain boundary
+static void DirichletBC(FArrayBox&           a_state,
+                        const Box&           a_valid,
+                        const ProblemDomain& a_domain,
+                        Real                 a_dx,
+                        bool                 a_homogeneous)
+{
+  const Box& domainBox = a_domain.domainBox();
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      for (SideIterator sit; sit.ok(); ++sit)
+        {
+          if (a_valid.sideEnd(sit())[idir] == domainBox.sideEnd(sit())[idir])
+            {
+              if (a_state.nComp() == 1)
+                {
+                  DiriBC(a_state, a_valid, a_dx, true, ZeroValue, idir, sit(), 2);
+                }
+              else
+                {
+                  DiriBC(a_state, a_valid, a_dx, true, ZeroVectorValue, idir, sit(), 2);
+                }
+            }
+        }
+    }
+}
+
+// a_scale times a function of position that is not constant on any
+// coarse cell
+static void setCellCoef(LevelData<FArrayBox>& a_coef, Real a_scale)
+{
+  for (DataIterator dit = a_coef.dataIterator(); dit.ok(); ++dit)
+    {
+      FArrayBox& fab = a_coef[dit];
+      for (BoxIterator bit(fab.box()); bit.ok(); ++bit)
+        {
+          fab(bit(), 0) = a_scale*(1.0 + bit()[0]*dx + 0.5*(bit()[SpaceDim-1] % 3));
+        }
+    }
+}
+
+static void setFaceCoef(LevelData<FluxBox>& a_coef, Real a_scale)
+{
+  for (DataIterator dit = a_coef.dataIterator(); dit.ok(); ++dit)
+    {
+      for (int idir = 0; idir < SpaceDim; idir++)
+        {
+          FArrayBox& fab = a_coef[dit][idir];
+          for (BoxIterator bit(fab.box()); bit.ok(); ++bit)
+            {
+              fab(bit(), 0) = a_scale*(2.0 + idir + bit()[SpaceDim-1]*dx + 0.25*(bit()[0] % 3));
+            }
+        }
+    }
+}
+
+// max norm of a_lhs - a_rhs on the valid cells
+static Real maxDiff(const LevelData<FArrayBox>& a_lhs,
+                    const LevelData<FArrayBox>& a_rhs)
+{
+  Real retval = 0.0;
+  const DisjointBoxLayout& grids = a_lhs.disjointBoxLayout();
+  for (DataIterator dit = grids.dataIterator(); dit.ok(); ++dit)
+    {
+      FArrayBox diff(grids[dit], a_lhs.nComp());
+      diff.copy(a_lhs[dit]);
+      diff.minus(a_rhs[dit], grids[dit], 0, 0, a_lhs.nComp());
+      retval = Max(retval, diff.norm(0));
+    }
+#ifdef CH_MPI
+  Real localDiff = retval;
+  MPI_Allreduce(&localDiff, &retval, 1, MPI_CH_REAL, MPI_MAX, Chombo_MPI::comm);
+#endif
+  return retval;
+}
+
+// the relaxation parameter of a_op, brought up to date the way a
+// smoother does it
+static const LevelData<FArrayBox>& relaxationParameter(VCAMRPoissonOp2& a_op)
+{
+  const DisjointBoxLayout& grids = a_op.m_lambda.disjointBoxLayout();
+  LevelData<FArrayBox> phi(grids, 1, IntVect::Unit);
+  LevelData<FArrayBox> rhs(grids, 1);
+  a_op.setToZero(phi);
+  a_op.setToZero(rhs);
+  a_op.preCond(phi, rhs);
+  return a_op.m_lambda;
+}
+
+// 1 if the relaxation parameter of a_op is not that of an operator the
+// factory builds at a_depth with alpha = 2, beta = -1/2
+static int checkVCOp(VCAMRPoissonOp2&        a_op,
+                     VCAMRPoissonOp2Factory& a_factory,
+                     const ProblemDomain&    a_domain,
+                     int                     a_depth,
+                     const char*             a_what)
+{
+  VCAMRPoissonOp2* freshOp =
+    dynamic_cast<VCAMRPoissonOp2*>(a_factory.MGnewOp(a_domain, a_depth, a_depth > 0));
+  freshOp->setAlphaAndBeta(2.0, -0.5);
+  Real diff = maxDiff(relaxationParameter(a_op), relaxationParameter(*freshOp));
+  delete freshOp;
+  if (verbose)
+    {
+      pout() << indent << "VCAMRPoissonOp2, " << a_what << ": difference " << diff << endl;
+    }
+  if (diff > tolerance)
+    {
+      pout() << indent << "VCAMRPoissonOp2 relaxation parameter is out of date after "
+             << a_what << " by " << diff << endl;
+      return 1;
+    }
+  return 0;
+}
+
+static int testVCAMRPoissonOp2(const DisjointBoxLayout& a_grids,
+                               const ProblemDomain&     a_domain)
+{
+  int status = 0;
+
+  RefCountedPtr<LevelData<FArrayBox> > aCoef(new LevelData<FArrayBox>(a_grids, 1));
+  RefCountedPtr<LevelData<FluxBox> > bCoef(new LevelData<FluxBox>(a_grids, 1));
+  setCellCoef(*aCoef, 1.0);
+  setFaceCoef(*bCoef, 1.0);
+
+  Vector<DisjointBoxLayout> grids(1, a_grids);
+  Vector<int> refRatios(1, 2);
+  Vector<RefCountedPtr<LevelData<FArrayBox> > > aCoefs(1, aCoef);
+  Vector<RefCountedPtr<LevelData<FluxBox> > > bCoefs(1, bCoef);
+  VCAMRPoissonOp2Factory factory;
+  factory.define(a_domain, grids, refRatios, dx, DirichletBC, 1.0, aCoefs, -1.0, bCoefs);
+
+  // an operator and the next coarser multigrid operator, which averages
+  // its coefficients when told they changed
+  VCAMRPoissonOp2* op = dynamic_cast<VCAMRPoissonOp2*>(factory.MGnewOp(a_domain, 0, false));
+  VCAMRPoissonOp2* coarOp = dynamic_cast<VCAMRPoissonOp2*>(factory.MGnewOp(a_domain, 1, true));
+  op->addCoarserObserver(coarOp, 2);
+  op->setAlphaAndBeta(2.0, -0.5);
+  coarOp->setAlphaAndBeta(2.0, -0.5);
+  relaxationParameter(*op);
+  relaxationParameter(*coarOp);
+
+  // aCoef in place, then alpha and beta set again to the same values
+  setCellCoef(*aCoef, 3.0);
+  op->setAlphaAndBeta(2.0, -0.5);
+  status += checkVCOp(*op, factory, a_domain, 0, "setAlphaAndBeta");
+
+  // bCoef in place, then the time is set: this operator and the coarser
+  // one take the new coefficients
+  setFaceCoef(*bCoef, 5.0);
+  op->setTime(1.0);
+  status += 10*checkVCOp(*op, factory, a_domain, 0, "setTime");
+  status += 10*checkVCOp(*coarOp, factory, a_domain, 1, "setTime, coarser operator");
+
+  // both in place, then resetCoefficients
+  setCellCoef(*aCoef, 0.5);
+  setFaceCoef(*bCoef, 0.25);
+  op->resetCoefficients();
+  status += 100*checkVCOp(*op, factory, a_domain, 0, "resetCoefficients");
+  status += 100*checkVCOp(*coarOp, factory, a_domain, 1, "resetCoefficients, coarser operator");
+
+  // bCoef in place, then resetLambda
+  setFaceCoef(*bCoef, 7.0);
+  op->resetLambda();
+  status += 1000*checkVCOp(*op, factory, a_domain, 0, "resetLambda");
+
+  op->removeObserver(coarOp);
+  delete coarOp;
+  delete op;
+  return status;
+}
+
+// 1 if the relaxation coefficient of a_op is not that of an operator the
+// factory builds at a_depth with alpha = 2, beta = -1/2
+static int checkViscousOp(ViscousTensorOp&        a_op,
+                          ViscousTensorOpFactory& a_factory,
+                          const ProblemDomain&    a_domain,
+                          int                     a_depth,
+                          const char*             a_what)
+{
+  ViscousTensorOp* freshOp = a_factory.MGnewOp(a_domain, a_depth, a_depth > 0);
+  freshOp->setAlphaAndBeta(2.0, -0.5);
+  Real diff = maxDiff(a_op.m_relaxCoef, freshOp->m_relaxCoef);
+  delete freshOp;
+  if (verbose)
+    {
+      pout() << indent << "ViscousTensorOp, " << a_what << ": difference " << diff << endl;
+    }
+  if (diff > tolerance)
+    {
+      pout() << indent << "ViscousTensorOp relaxation coefficient is out of date after "
+             << a_what << " by " << diff << endl;
+      return 1;
+    }
+  return 0;
+}
+
+static int testViscousTensorOp(const DisjointBoxLayout& a_grids,
+                               const ProblemDomain&     a_domain)
+{
+  int status = 0;
+
+  RefCountedPtr<LevelData<FArrayBox> > aCoef(new LevelData<FArrayBox>(a_grids, 1));
+  RefCountedPtr<LevelData<FluxBox> > eta(new LevelData<FluxBox>(a_grids, 1));
+  RefCountedPtr<LevelData<FluxBox> > lambda(new LevelData<FluxBox>(a_grids, 1));
+  setCellCoef(*aCoef, 1.0);
+  setFaceCoef(*eta, 1.0);
+  setFaceCoef(*lambda, 0.5);
+
+  Vector<DisjointBoxLayout> grids(1, a_grids);
+  Vector<int> refRatios(1, 2);
+  Vector<RefCountedPtr<LevelData<FArrayBox> > > aCoefs(1, aCoef);
+  Vector<RefCountedPtr<LevelData<FluxBox> > > etas(1, eta);
+  Vector<RefCountedPtr<LevelData<FluxBox> > > lambdas(1, lambda);
+  ViscousTensorOpFactory factory(grids, etas, lambdas, aCoefs, 1.0, -1.0,
+                                 refRatios, a_domain, dx, DirichletBC);
+
+  ViscousTensorOp* op = factory.MGnewOp(a_domain, 0, false);
+  ViscousTensorOp* coarOp = factory.MGnewOp(a_domain, 1, true);
+  op->addCoarserObserver(coarOp, 2);
+  op->setAlphaAndBeta(2.0, -0.5);
+  coarOp->setAlphaAndBeta(2.0, -0.5);
+
+  // acoef in place, then alpha and beta set again to the same values
+  setCellCoef(*aCoef, 3.0);
+  op->setAlphaAndBeta(2.0, -0.5);
+  status += checkViscousOp(*op, factory, a_domain, 0, "setAlphaAndBeta");
+
+  // all of them in place, then resetCoefficients: this operator and the
+  // coarser one take the new coefficients
+  setCellCoef(*aCoef, 0.5);
+  setFaceCoef(*eta, 5.0);
+  setFaceCoef(*lambda, 0.25);
+  op->resetCoefficients();
+  status += 10*checkViscousOp(*op, factory, a_domain, 0, "resetCoefficients");
+  status += 10*checkViscousOp(*coarOp, factory, a_domain, 1, "resetCoefficients, coarser operator");
+
+  op->removeObserver(coarOp);
+  delete coarOp;
+  delete op;
+  return 10000*status;
+}
+
+int
+main(int argc ,char* argv[])
+{
+#ifdef CH_MPI
+  MPI_Init(&argc, &argv);
+#endif
+  parseTestOptions(argc, argv);
+
+  int status = 0;
+  {
+    Box domainBox(IntVect::Zero, (nCells-1)*IntVect::Unit);
+    ProblemDomain domain(domainBox);
+    Vector<Box> boxes;
+    domainSplit(domainBox, boxes, 16, 16);
+    Vector<int> procs;
+    LoadBalance(procs, boxes);
+    DisjointBoxLayout grids(boxes, procs, domain);
+
+    status += testVCAMRPoissonOp2(grids, domain);
+    status += testViscousTensorOp(grids, domain);
+  }
+
+  pout() << indent << pgmname << ": "
+         << ( (status == 0) ? "passed all tests" : "failed at least one test,")
+         << endl;
+  if (status != 0)
+    {
+      pout() << indent << pgmname << ": status " << status << endl;
+    }
+
+#ifdef CH_MPI
+  MPI_Finalize();
+#endif
+  return status;
+}
+
+///
+// Parse the standard test options (-v -q) out of the command line.
+// Stop parsing when a non-option argument is found.
+///
+void
+parseTestOptions( int argc ,char* argv[] )
+{
+  for ( int i = 1 ; i < argc ; ++i )
+    {
+      if ( argv[i][0] == '-' ) //if it is an option
+        {
+          // compare 3 chars to differentiate -x from -xx
+          if ( strncmp( argv[i] ,"-v" ,3 ) == 0 )
+            {
+              verbose = true ;
+            }
+          else if ( strncmp( argv[i] ,"-q" ,3 ) == 0 )
+            {
+              verbose = false ;
+            }
+          else
+            {
+              break ;
+            }
+        }
+    }
+  return ;
+}
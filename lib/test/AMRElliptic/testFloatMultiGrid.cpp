@@ -0,0 +1,280 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+// Purpose:
+//  Check that AMRMultiGrid with FloatMultiGrid as its base level cycle
+//  (single precision V-cycles, double precision residuals) reaches the
+//  same tolerance and the same solution as in double precision, for
+//  Poisson and Helmholtz problems on one level and Poisson on two AMR
+//  levels.
+//
+// Usage:
+//  <program-name> [-q|-v] ...
+//
+//  where:
+//    -q means run quietly (only pass/fail messages printed)
+//    -v means run verbosely (all messages printed)
+//    ... all non-option arguments are ignored (Chombo convention)
+//
+//  Default is `-q'
+//
+
+#include <cstring>
+#include <cmath>
+
+#include "parstream.H"
+#include "SPMD.H"
+#include "LoadBalance.H"
+#include "BRMeshRefine.H"
+#include "BoxIterator.H"
+#include "AMRPoissonOp.H"
+#include "AMRMultiGrid.H"
+#include "FloatMultiGrid.H"
+#include "BCFunc.H"
+#include "BiCGStabSolver.H"
+
+#ifdef CH_MPI
+#include <mpi.h>
+#endif
+
+#include "UsingNamespace.H"
+
+using std::endl;
+
+void parseTestOptions(int argc, char* argv[]);
+
+static const char *pgmname = "testFloatMultiGrid";
+static const char *indent = "   ";
+
+static bool verbose = false;
+
+static const int nCells = 128;
+static const Real dx = 1.0/nCells;
+
+extern "C"
+{
+  void ZeroValue(Real* pos,
+                 int* dir,
+                 Side::LoHiSide* side,
+                 Real* a_values)
+  {
+    a_values[0] = 0;
+  }
+}
+
+// second order Dirichlet on the faces of a_valid on the domain boundary
+static void DirichletBC(FArrayBox&           a_state,
+                        const Box&           a_valid,
+                        const ProblemDomain& a_domain,
+                        Real                 a_dx,
+                        bool                 a_homogeneous)
+{
+  const Box& domainBox = a_domain.domainBox();
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      for (SideIterator sit; sit.ok(); ++sit)
+        {
+          if (a_valid.sideEnd(sit())[idir] == domainBox.sideEnd(sit())[idir])
+            {
+              DiriBC(a_state, a_valid, a_dx, a_homogeneous, ZeroValue, idir, sit(), 2);
+            }
+        }
+    }
+}
+
+// a product of sines, the first mode of the domain
+static void setRHS(LevelData<FArrayBox>& a_rhs, Real a_dx)
+{
+  for (DataIterator dit = a_rhs.dataIterator(); dit.ok(); ++dit)
+    {
+      FArrayBox& fab = a_rhs[dit];
+      for (BoxIterator bit(a_rhs.disjointBoxLayout()[dit]); bit.ok(); ++bit)
+        {
+          Real val = 1;
+          for (int idir = 0; idir < SpaceDim; idir++)
+            {
+              val *= sin(M_PI*(bit()[idir] + 0.5)*a_dx);
+            }
+          fab(bit(), 0) = val;
+        }
+    }
+}
+
+// AMRMultiGrid on a_grids, with a_cycle as the base level cycle if it
+// is not NULL; returns the exit status
+static int solveMG(Vector<LevelData<FArrayBox>* >&      a_phi,
+                   const Vector<DisjointBoxLayout>&     a_grids,
+                   const ProblemDomain&                 a_domain,
+                   Real                                 a_alpha,
+                   Real                                 a_beta,
+                   LinearSolver<LevelData<FArrayBox> >* a_cycle)
+{
+  int numLevels = a_grids.size();
+  Vector<int> refRatios(numLevels, 2);
+  AMRPoissonOpFactory factory;
+  factory.define(a_domain, a_grids, refRatios, dx, DirichletBC, a_alpha, a_beta);
+
+  Vector<LevelData<FArrayBox>* > rhs(numLevels);
+  Real levelDx = dx;
+  for (int ilev = 0; ilev < numLevels; ilev++)
+    {
+      rhs[ilev] = new LevelData<FArrayBox>(a_grids[ilev], 1);
+      setRHS(*rhs[ilev], levelDx);
+      levelDx /= 2;
+    }
+
+  BiCGStabSolver<LevelData<FArrayBox> > bottomSolver;
+  bottomSolver.m_verbosity = 0;
+  AMRMultiGrid<LevelData<FArrayBox> > solver;
+  solver.define(a_domain, factory, &bottomSolver, numLevels);
+  solver.setSolverParameters(2, 2, 2, 1, 30, 1.0e-10, 1.0e-30, 1.0e-30);
+  solver.m_verbosity = verbose ? 3 : 0;
+  solver.setBaseCycle(a_cycle);
+
+  solver.solve(a_phi, rhs, numLevels-1, 0, true);
+
+  for (int ilev = 0; ilev < numLevels; ilev++)
+    {
+      delete rhs[ilev];
+    }
+  return solver.m_exitStatus;
+}
+
+static int testMixedPrecision(const Vector<DisjointBoxLayout>& a_grids,
+                              const ProblemDomain&             a_domain,
+                              Real                             a_alpha,
+                              Real                             a_beta,
+                              const char*                      a_name)
+{
+  int status = 0;
+  int numLevels = a_grids.size();
+  Vector<LevelData<FArrayBox>* > phiRef(numLevels), phi(numLevels);
+  for (int ilev = 0; ilev < numLevels; ilev++)
+    {
+      phiRef[ilev] = new LevelData<FArrayBox>(a_grids[ilev], 1, IntVect::Unit);
+      phi[ilev]    = new LevelData<FArrayBox>(a_grids[ilev], 1, IntVect::Unit);
+    }
+
+  int refStatus = solveMG(phiRef, a_grids, a_domain, a_alpha, a_beta, NULL);
+  FloatMultiGrid floatCycle;
+  int floatStatus = solveMG(phi, a_grids, a_domain, a_alpha, a_beta, &floatCycle);
+
+  Real maxDiff = 0;
+  Real maxRef = 0;
+  for (int ilev = 0; ilev < numLevels; ilev++)
+    {
+      for (DataIterator dit = a_grids[ilev].dataIterator(); dit.ok(); ++dit)
+        {
+          const Box& valid = a_grids[ilev][dit];
+          FArrayBox diff(valid, 1);
+          diff.copy((*phi[ilev])[dit]);
+          diff.minus((*phiRef[ilev])[dit]);
+          maxDiff = Max(maxDiff, diff.norm(0));
+          maxRef = Max(maxRef, (*phiRef[ilev])[dit].norm(valid, 0));
+        }
+      delete phiRef[ilev];
+      delete phi[ilev];
+    }
+#ifdef CH_MPI
+  Real local[2] = {maxDiff, maxRef};
+  Real global[2];
+  MPI_Allreduce(local, global, 2, MPI_CH_REAL, MPI_MAX, Chombo_MPI::comm);
+  maxDiff = global[0];
+  maxRef = global[1];
+#endif
+  Real relDiff = maxDiff/maxRef;
+
+  if (verbose)
+    {
+      pout() << indent << a_name << ": exit status " << refStatus << " in double, "
+             << floatStatus << " mixed (" << floatCycle.numLevels()
+             << " float levels); difference " << relDiff << endl;
+    }
+  // exit status 1: the residual was reduced by the tolerance.  The two
+  // solutions differ by the iteration error left at that residual, which
+  // is larger than it for the slowly converging two level problem
+  if (refStatus != 1 || floatStatus != 1 || relDiff > 1.0e-6)
+    {
+      pout() << indent << a_name << " failed: exit status " << refStatus << " in double, "
+             << floatStatus << " mixed; difference " << relDiff << endl;
+      status = 1;
+    }
+  return status;
+}
+
+int
+main(int argc ,char* argv[])
+{
+#ifdef CH_MPI
+  MPI_Init(&argc, &argv);
+#endif
+  parseTestOptions(argc, argv);
+
+  int status = 0;
+  {
+    Box domainBox(IntVect::Zero, (nCells-1)*IntVect::Unit);
+    ProblemDomain domain(domainBox);
+    Vector<Box> boxes;
+    domainSplit(domainBox, boxes, 32, 32);
+    Vector<int> procs;
+    LoadBalance(procs, boxes);
+    Vector<DisjointBoxLayout> grids(1, DisjointBoxLayout(boxes, procs, domain));
+
+    status += testMixedPrecision(grids, domain, 0.0, 1.0, "Poisson");
+    status += 10*testMixedPrecision(grids, domain, 1.0, -100.0, "Helmholtz");
+
+    // refine the middle half of the domain
+    Box fineBox(nCells/2*IntVect::Unit, (3*nCells/2-1)*IntVect::Unit);
+    Vector<Box> fineBoxes;
+    domainSplit(fineBox, fineBoxes, 32, 32);
+    Vector<int> fineProcs;
+    LoadBalance(fineProcs, fineBoxes);
+    grids.push_back(DisjointBoxLayout(fineBoxes, fineProcs, refine(domain, 2)));
+    status += 100*testMixedPrecision(grids, domain, 0.0, 1.0, "Poisson, two levels");
+  }
+
+  pout() << indent << pgmname << ": "
+         << ( (status == 0) ? "passed all tests" : "failed at least one test,")
+         << endl;
+
+#ifdef CH_MPI
+  MPI_Finalize();
+#endif
+  return status;
+}
+
+///
+// Parse the standard test options (-v -q) out of the command line.
+// Stop parsing when a non-option argument is found.
+///
+void
+parseTestOptions( int argc ,char* argv[] )
+{
+  for ( int i = 1 ; i < argc ; ++i )
+    {
+      if ( argv[i][0] == '-' ) //if it is an option
+        {
+          // compare 3 chars to differentiate -x from -xx
+          if ( strncmp( argv[i] ,"-v" ,3 ) == 0 )
+            {
+              verbose = true ;
+            }
+          else if ( strncmp( argv[i] ,"-q" ,3 ) == 0 )
+            {
+              verbose = false ;
+            }
+          else
+            {
+              break ;
+            }
+        }
+    }
+  return ;
+}
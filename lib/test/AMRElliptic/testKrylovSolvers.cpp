@@ -0,0 +1,406 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+// Purpose:
+//  Check that PipelinedCGSolver, PipelinedBiCGStabSolver and
+//  SStepGMRESSolver solve a level Poisson problem with AMRPoissonOp to
+//  the answer BiCGStabSolver gets, and that AMRMultiGrid with each of them
+//  as its bottom solver converges to the same answer.  Prints the global
+//  reductions each solver waited on.
+//
+// Usage:
+//  <program-name> [-q|-v] ...
+//
+//  where:
+//    -q means run quietly (only pass/fail messages printed)
+//    -v means run verbosely (all messages printed)
+//    ... all non-option arguments are ignored (Chombo convention)
+//
+//  Default is `-q'
+//
+
+#include <cstring>
+#include <cmath>
+
+#include "parstream.H"
+#include "LoadBalance.H"
+#include "BRMeshRefine.H"
+#include "BoxIterator.H"
+#include "AMRPoissonOp.H"
+#include "AMRMultiGrid.H"
+#include "BCFunc.H"
+#include "BiCGStabSolver.H"
+#include "PipelinedCGSolver.H"
+#include "PipelinedBiCGStabSolver.H"
+#include "SStepGMRESSolver.H"
+
+#ifdef CH_MPI
+#include <mpi.h>
+#endif
+
+#include "UsingNamespace.H"
+
+using std::endl;
+
+void parseTestOptions(int argc, char* argv[]);
+
+static const char *pgmname = "testKrylovSolvers";
+static const char *indent = "   ";
+
+static bool verbose = false;
+
+static const int nCells = 64;
+static const Real dx = 1.0/nCells;
+
+extern "C"
+{
+  // phi = x^2 + y^2 + z^2, so Laplacian(phi) = 2*SpaceDim
+  void ParabolaValue(Real* pos,
+                     int* dir,
+                     Side::LoHiSide* side,
+                     Real* a_values)
+  {
+    a_values[0] = D_TERM(pos[0]*pos[0], +pos[1]*pos[1], +pos[2]*pos[2]);
+  }
+}
+
+// Dirichlet on the faces of a_valid on the domain boundary
+static void ParabolaBC(FArrayBox&           a_state,
+                       const Box&           a_valid,
+                       const ProblemDomain& a_domain,
+                       Real                 a_dx,
+                       bool                 a_homogeneous)
+{
+  const Box& domainBox = a_domain.domainBox();
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      for (SideIterator sit; sit.ok(); ++sit)
+        {
+          if (a_valid.sideEnd(sit())[idir] == domainBox.sideEnd(sit())[idir])
+            {
+              DiriBC(a_state, a_valid, a_dx, a_homogeneous, ParabolaValue, idir, sit());
+            }
+        }
+    }
+}
+
+// AMRPoissonOp that counts the global reductions a solver waits on
+class CountingPoissonOp : public AMRPoissonOp
+{
+public:
+  CountingPoissonOp()
+    :m_reductions(0)
+  {
+  }
+
+  virtual Real dotProduct(const LevelData<FArrayBox>& a_1,
+                          const LevelData<FArrayBox>& a_2)
+  {
+    m_reductions++;
+    return AMRPoissonOp::dotProduct(a_1, a_2);
+  }
+
+  virtual void mDotProduct(const LevelData<FArrayBox>& a_1,
+                           const int                   a_sz,
+                           const LevelData<FArrayBox>  a_2[],
+                           Real                        a_mdots[])
+  {
+    m_reductions++;
+    AMRPoissonOp::mDotProduct(a_1, a_sz, a_2, a_mdots);
+  }
+
+  virtual void mDotProductStart(const int a_sz,
+                                const LevelData<FArrayBox>* const a_1[],
+                                const LevelData<FArrayBox>* const a_2[],
+                                Real a_dots[])
+  {
+    m_reductions++;
+    AMRPoissonOp::mDotProductStart(a_sz, a_1, a_2, a_dots);
+  }
+
+  virtual Real norm(const LevelData<FArrayBox>& a_x, int a_ord)
+  {
+    m_reductions++;
+    return AMRPoissonOp::norm(a_x, a_ord);
+  }
+
+  int m_reductions;
+};
+
+enum Solver
+{
+  BiCGStab = 0,
+  PipelinedCG,
+  PipelinedBiCGStab,
+  SStepGMRES,
+  NumSolvers
+};
+
+static const char* solverNames[NumSolvers] =
+  {"BiCGStab", "PipelinedCG", "PipelinedBiCGStab", "SStepGMRES"};
+
+// a new solver of kind a_solver that solves to a_eps relative to the
+// initial residual
+static LinearSolver<LevelData<FArrayBox> >* newSolver(Solver a_solver, Real a_eps)
+{
+  typedef LevelData<FArrayBox> LD;
+  switch (a_solver)
+    {
+    case BiCGStab:
+      {
+        BiCGStabSolver<LD>* solver = new BiCGStabSolver<LD>;
+        solver->m_verbosity = 0;
+        solver->m_eps = a_eps;
+        return solver;
+      }
+    case PipelinedCG:
+      {
+        PipelinedCGSolver<LD>* solver = new PipelinedCGSolver<LD>;
+        solver->m_verbosity = 0;
+        solver->m_eps = a_eps;
+        // AMRPoissonOp::preCond is not symmetric; unpreconditioned CG
+        // needs more iterations
+        solver->m_precondition = false;
+        solver->m_imax = 400;
+        return solver;
+      }
+    case PipelinedBiCGStab:
+      {
+        PipelinedBiCGStabSolver<LD>* solver = new PipelinedBiCGStabSolver<LD>;
+        solver->m_verbosity = 0;
+        solver->m_eps = a_eps;
+        return solver;
+      }
+    case SStepGMRES:
+      {
+        SStepGMRESSolver<LD>* solver = new SStepGMRESSolver<LD>;
+        solver->m_verbosity = 0;
+        solver->m_eps = a_eps;
+        solver->m_imax = 200;
+        return solver;
+      }
+    default:
+      return NULL;
+    }
+}
+
+static int exitStatus(Solver a_solver, LinearSolver<LevelData<FArrayBox> >* a_linearSolver)
+{
+  typedef LevelData<FArrayBox> LD;
+  switch (a_solver)
+    {
+    case BiCGStab:
+      return static_cast<BiCGStabSolver<LD>*>(a_linearSolver)->m_exitStatus;
+    case PipelinedCG:
+      return static_cast<PipelinedCGSolver<LD>*>(a_linearSolver)->m_exitStatus;
+    case PipelinedBiCGStab:
+      return static_cast<PipelinedBiCGStabSolver<LD>*>(a_linearSolver)->m_exitStatus;
+    case SStepGMRES:
+      return static_cast<SStepGMRESSolver<LD>*>(a_linearSolver)->m_exitStatus;
+    default:
+      return -1;
+    }
+}
+
+static void setRhs(LevelData<FArrayBox>& a_rhs)
+{
+  for (DataIterator dit = a_rhs.dataIterator(); dit.ok(); ++dit)
+    {
+      a_rhs[dit].setVal(2*SpaceDim);
+    }
+}
+
+// max |a_phi - a_phiRef| / max |a_phiRef|
+static Real relativeDiff(AMRPoissonOp&               a_op,
+                         const LevelData<FArrayBox>& a_phi,
+                         const LevelData<FArrayBox>& a_phiRef)
+{
+  LevelData<FArrayBox> diff;
+  a_op.create(diff, a_phi);
+  a_op.axby(diff, a_phi, a_phiRef, 1.0, -1.0);
+  return a_op.norm(diff, 0)/a_op.norm(a_phiRef, 0);
+}
+
+// each solver on its own, on a level of 16^SpaceDim boxes
+static int testLevelSolve(const DisjointBoxLayout& a_grids,
+                          const ProblemDomain&     a_domain)
+{
+  int status = 0;
+  CountingPoissonOp op;
+  op.define(a_grids, dx, a_domain, ParabolaBC);
+
+  LevelData<FArrayBox> rhs(a_grids, 1);
+  LevelData<FArrayBox> res(a_grids, 1);
+  LevelData<FArrayBox> phiRef(a_grids, 1, IntVect::Unit);
+  LevelData<FArrayBox> phi(a_grids, 1, IntVect::Unit);
+  setRhs(rhs);
+  op.setToZero(phi);
+  op.residual(res, phi, rhs, false);
+  Real initialNorm = op.norm(res, 2);
+
+  const Real eps = 1.0e-10;
+  for (int isolver = 0; isolver < NumSolvers; isolver++)
+    {
+      Solver kind = (Solver)isolver;
+      LevelData<FArrayBox>& result = (kind == BiCGStab) ? phiRef : phi;
+      LinearSolver<LevelData<FArrayBox> >* solver = newSolver(kind, eps);
+      solver->define(&op, false);
+      op.setToZero(result);
+      op.m_reductions = 0;
+      solver->solve(result, rhs);
+      int reductions = op.m_reductions;
+
+      op.residual(res, result, rhs, false);
+      Real resNorm = op.norm(res, 2)/initialNorm;
+      Real diff = (kind == BiCGStab) ? 0.0 : relativeDiff(op, phi, phiRef);
+      int exit = exitStatus(kind, solver);
+      if (verbose)
+        {
+          pout() << indent << solverNames[isolver] << ": exit status " << exit
+                 << ", relative residual " << resNorm
+                 << ", difference from BiCGStab " << diff
+                 << ", " << reductions << " reductions" << endl;
+        }
+      // the recurrences of the pipelined solvers drift a little from the
+      // true residual
+      if (exit != 1 || resNorm > 100*eps || diff > 1.0e-6)
+        {
+          pout() << indent << solverNames[isolver] << " level solve failed: exit status "
+                 << exit << ", relative residual " << resNorm
+                 << ", difference " << diff << endl;
+          status |= (1 << isolver);
+        }
+      delete solver;
+    }
+  return status;
+}
+
+// AMRMultiGrid on the same level with each solver at the bottom
+static int testBottomSolve(const DisjointBoxLayout& a_grids,
+                           const ProblemDomain&     a_domain)
+{
+  int status = 0;
+  Vector<DisjointBoxLayout> grids(1, a_grids);
+  Vector<int> refRatios(1, 2);
+  AMRPoissonOpFactory factory;
+  factory.define(a_domain, grids, refRatios, dx, ParabolaBC);
+
+  Vector<LevelData<FArrayBox>* > phi(1), phiRef(1), rhs(1);
+  phi[0] = new LevelData<FArrayBox>(a_grids, 1, IntVect::Unit);
+  phiRef[0] = new LevelData<FArrayBox>(a_grids, 1, IntVect::Unit);
+  rhs[0] = new LevelData<FArrayBox>(a_grids, 1);
+  AMRPoissonOp op;
+  op.define(a_grids, dx, a_domain, ParabolaBC);
+  setRhs(*rhs[0]);
+
+  for (int isolver = 0; isolver < NumSolvers; isolver++)
+    {
+      Solver kind = (Solver)isolver;
+      Vector<LevelData<FArrayBox>* >& result = (kind == BiCGStab) ? phiRef : phi;
+      LinearSolver<LevelData<FArrayBox> >* bottomSolver = newSolver(kind, 1.0e-6);
+      AMRMultiGrid<LevelData<FArrayBox> > solver;
+      solver.define(a_domain, factory, bottomSolver, 1);
+      solver.setSolverParameters(2, 2, 2, 1, 20, 1.0e-10, 1.0e-30, 1.0e-30);
+      solver.m_verbosity = 0;
+      op.setToZero(*result[0]);
+      solver.solve(result, rhs, 0, 0, true);
+
+      Real diff = (kind == BiCGStab) ? 0.0 : relativeDiff(op, *phi[0], *phiRef[0]);
+      if (verbose)
+        {
+          pout() << indent << "AMRMultiGrid with " << solverNames[isolver]
+                 << " bottom solver: exit status " << solver.m_exitStatus
+                 << ", difference from BiCGStab " << diff << endl;
+        }
+      // exit status 1: converged
+      if (solver.m_exitStatus != 1 || diff > 1.0e-8)
+        {
+          pout() << indent << "AMRMultiGrid with " << solverNames[isolver]
+                 << " bottom solver failed: exit status " << solver.m_exitStatus
+                 << ", difference " << diff << endl;
+          status |= (1 << isolver);
+        }
+      delete bottomSolver;
+    }
+
+  delete phi[0];
+  delete phiRef[0];
+  delete rhs[0];
+  return status;
+}
+
+int
+main(int argc ,char* argv[])
+{
+#ifdef CH_MPI
+  MPI_Init(&argc, &argv);
+#endif
+  parseTestOptions(argc, argv);
+
+  int status = 0;
+  {
+    Box domainBox(IntVect::Zero, (nCells-1)*IntVect::Unit);
+    ProblemDomain domain(domainBox);
+    Vector<Box> boxes;
+    domainSplit(domainBox, boxes, 16, 16);
+    Vector<int> procs;
+    LoadBalance(procs, boxes);
+    DisjointBoxLayout grids(boxes, procs);
+
+    if (verbose)
+      {
+        pout() << indent << "level solve" << endl;
+      }
+    status += testLevelSolve(grids, domain);
+    if (verbose)
+      {
+        pout() << indent << "bottom solve" << endl;
+      }
+    status += 100*testBottomSolve(grids, domain);
+  }
+
+  pout() << indent << pgmname << ": "
+         << ( (status == 0) ? "passed all tests" : "failed at least one test,")
+         << endl;
+
+#ifdef CH_MPI
+  MPI_Finalize();
+#endif
+  return status;
+}
+
+///
+// Parse the standard test options (-v -q) out of the command line.
+// Stop parsing when a non-option argument is found.
+///
+void
+parseTestOptions( int argc ,char* argv[] )
+{
+  for ( int i = 1 ; i < argc ; ++i )
+    {
+      if ( argv[i][0] == '-' ) //if it is an option
+        {
+          // compare 3 chars to differentiate -x from -xx
+          if ( strncmp( argv[i] ,"-v" ,3 ) == 0 )
+            {
+              verbose = true ;
+            }
+          else if ( strncmp( argv[i] ,"-q" ,3 ) == 0 )
+            {
+              verbose = false ;
+            }
+          else
+            {
+              break ;
+            }
+        }
+    }
+  return ;
+}
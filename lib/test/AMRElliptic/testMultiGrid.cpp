@@ -9,6 +9,7 @@
 #endif
 
 #include <iostream>
+#include <sys/time.h>
 using std::endl;
 
 #include "BRMeshRefine.H"
@@ -21,6 +22,7 @@ using std::endl;
 
 #include "NewPoissonOp.H"
 #include "AMRPoissonOp.H"
+#include "VCAMRPoissonOp2.H"
 #include "BCFunc.H"
 #include "BiCGStabSolver.H"
 #include "CH_Timer.H"
@@ -82,6 +84,18 @@ static Real xshift = 0.0;
 int
 testMultiGrid();
 
+int
+testRelaxModes();
+
+int
+testFusedVCycle();
+
+int
+testFullMultiGrid();
+
+int
+testBatchedSolve();
+
 int
 main(int argc ,char* argv[])
 {
@@ -114,6 +128,54 @@ main(int argc ,char* argv[])
     pout() << indent << pgmname << " failed with return code " << status << endl ;
   }
 
+  status = testRelaxModes();
+
+  if ( status == 0 )
+  {
+    pout() << indent << pgmname << " relaxation modes passed." << endl ;
+  }
+  else
+  {
+    overallStatus = 1;
+    pout() << indent << pgmname << " relaxation modes failed with return code " << status << endl ;
+  }
+
+  status = testFusedVCycle();
+
+  if ( status == 0 )
+  {
+    pout() << indent << pgmname << " fused AMR V-cycle passed." << endl ;
+  }
+  else
+  {
+    overallStatus = 1;
+    pout() << indent << pgmname << " fused AMR V-cycle failed with return code " << status << endl ;
+  }
+
+  status = testFullMultiGrid();
+
+  if ( status == 0 )
+  {
+    pout() << indent << pgmname << " full multigrid passed." << endl ;
+  }
+  else
+  {
+    overallStatus = 1;
+    pout() << indent << pgmname << " full multigrid failed with return code " << status << endl ;
+  }
+
+  status = testBatchedSolve();
+
+  if ( status == 0 )
+  {
+    pout() << indent << pgmname << " batched solve passed." << endl ;
+  }
+  else
+  {
+    overallStatus = 1;
+    pout() << indent << pgmname << " batched solve failed with return code " << status << endl ;
+  }
+
   xshift = 0.2;
   blockingFactor = 4;
   CH_TIMER_REPORT();
@@ -222,6 +284,26 @@ extern "C"
   }
 }
 
+// DirParabolaBC on the faces of a_valid on the domain boundary only
+void DirParabolaDomainBC(FArrayBox& a_state,
+                         const Box& a_valid,
+                         const ProblemDomain& a_domain,
+                         Real a_dx,
+                         bool a_homogeneous)
+{
+  const Box& domainBox = a_domain.domainBox();
+  for (int i=0; i<CH_SPACEDIM; ++i)
+    {
+      for (SideIterator sit; sit.ok(); ++sit)
+        {
+          if (a_valid.sideEnd(sit())[i] == domainBox.sideEnd(sit())[i])
+            {
+              DiriBC(a_state, a_valid, a_dx, a_homogeneous, Parabola_diri, i, sit());
+            }
+        }
+    }
+}
+
 static BCValueFunc pointFunc = Parabola_diri;
 
 void parabola(const Box& box, int comps, FArrayBox& t)
@@ -432,3 +514,725 @@ testMultiGrid()
 
   return 0;
 }
+
+static double wallTime()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + 1.0e-6*tv.tv_usec;
+}
+
+// levelGSRBDeep (mode 6) gives the same answer as levelGSRB, and every
+// relaxation mode gets MultiGrid to converge on a level that covers the
+// domain; prints the cycles and time each one takes.
+int
+testRelaxModes()
+{
+  int status = 0;
+  int saveMode = AMRPoissonOp::s_relaxMode;
+  ProblemDomain regularDomain(domain);
+  Vector<Box> boxes;
+  domainSplit(domain, boxes, 32, 32);
+  Vector<int> procs;
+  LoadBalance(procs, boxes);
+  DisjointBoxLayout dbl(boxes, procs);
+
+  LevelData<FArrayBox> rhs(dbl, 1);
+  LevelData<FArrayBox> phi(dbl, 1, IntVect::Unit);
+  LevelData<FArrayBox> phiDeep(dbl, 1, IntVect::Unit);
+  setvalue::val = 2*CH_SPACEDIM;
+  rhs.apply(setvalue::setFunc);
+
+  // Poisson and Helmholtz, whole sweeps and a left-over one
+  Real alpha[2] = {0.0, 1.0};
+  Real beta[2]  = {1.0, -dx};
+  int iters[2]  = {4, 3};
+  for (int icase = 0; icase < 2; icase++)
+    {
+      AMRPoissonOpFactory opFactory;
+      opFactory.define(regularDomain, dbl, dx, DirParabolaDomainBC, -1,
+                       alpha[icase], beta[icase]);
+      MGLevelOp<LevelData<FArrayBox> >* op = opFactory.MGnewOp(regularDomain, 0);
+
+      phi.apply(parabola);
+      phiDeep.apply(parabola);
+      AMRPoissonOp::s_relaxMode = 1;
+      op->relax(phi, rhs, iters[icase]);
+      AMRPoissonOp::s_relaxMode = 6;
+      op->relax(phiDeep, rhs, iters[icase]);
+
+      Real diff = 0;
+      for (DataIterator dit = dbl.dataIterator(); dit.ok(); ++dit)
+        {
+          FArrayBox d(dbl[dit], 1);
+          d.copy(phi[dit]);
+          d.minus(phiDeep[dit]);
+          diff = Max(diff, d.norm(0));
+        }
+#ifdef CH_MPI
+      Real recv;
+      MPI_Allreduce(&diff, &recv, 1, MPI_CH_REAL, MPI_MAX, Chombo_MPI::comm);
+      diff = recv;
+#endif
+      if (diff > 1.0e-10)
+        {
+          pout() << indent << "levelGSRBDeep differs from levelGSRB by "
+                 << diff << endl;
+          status |= 1;
+        }
+      delete op;
+    }
+
+  // time to solution, homogeneous MultiGrid cycles as in testMultiGrid
+  AMRPoissonOpFactory opFactory;
+  opFactory.define(regularDomain, dbl, dx, DirParabolaDomainBC);
+  AMRLevelOpFactory<LevelData<FArrayBox> >& castFact  =
+    (AMRLevelOpFactory<LevelData<FArrayBox> >&)opFactory;
+  LevelData<FArrayBox> correction(dbl, 1, IntVect::Unit);
+  LevelData<FArrayBox> residual(dbl, 1);
+  if (verbose)
+    {
+      pout() << "\n relaxation modes \n";
+    }
+  for (int mode = 0; mode <= 7; mode++)
+    {
+      AMRPoissonOp::s_relaxMode = mode;
+      MultiGrid<LevelData<FArrayBox> > solver;
+      BiCGStabSolver<LevelData<FArrayBox> > bottomSolver;
+      bottomSolver.m_verbosity = 0;
+      MGLevelOp<LevelData<FArrayBox> >* op = castFact.MGnewOp(regularDomain, 0);
+      solver.define(castFact, &bottomSolver, regularDomain);
+
+      setvalue::val = 0;
+      phi.apply(setvalue::setFunc);
+      op->residual(residual, phi, rhs, false);
+      Real rnorm0 = op->norm(residual, 0);
+      Real rnorm = rnorm0;
+      int cycles = 0;
+      double t0 = wallTime();
+      solver.init(correction, residual);
+      while (rnorm > 1.0e-10*rnorm0 && cycles < 40)
+        {
+          op->scale(correction, 0.0);
+          solver.oneCycle(correction, residual);
+          op->incr(phi, correction, 1.0);
+          op->residual(residual, phi, rhs, false);
+          rnorm = op->norm(residual, 0);
+          cycles++;
+        }
+      double t = wallTime() - t0;
+      if (verbose)
+        {
+          pout() << indent << "mode " << mode << ": " << cycles
+                 << " cycles, " << t << " s, residual " << rnorm << endl;
+        }
+      if (rnorm > 1.0e-10*rnorm0)
+        {
+          pout() << indent << "relaxation mode " << mode
+                 << " did not converge" << endl;
+          status |= 2;
+        }
+      delete op;
+    }
+
+  AMRPoissonOp::s_relaxMode = saveMode;
+  return status;
+}
+
+// three levels, refined by 2 and then by 4, of 32^SpaceDim boxes; a_grids[0]
+// covers a_coarseDomain
+static void makeHierarchy(Vector<DisjointBoxLayout>& a_grids,
+                          Vector<int>&               a_refRatios,
+                          const Box&                 a_coarseDomain)
+{
+  a_refRatios.resize(3);
+  a_refRatios[0] = 2;
+  a_refRatios[1] = 4;
+  a_refRatios[2] = 2;
+  a_grids.resize(3);
+  int n = a_coarseDomain.size(0);
+  // the middle half of each level, so every level is properly nested
+  Box levelBox = a_coarseDomain;
+  for (int ilev = 0; ilev < 3; ilev++)
+    {
+      if (ilev > 0)
+        {
+          Box inner(levelBox.smallEnd() + (n/4)*IntVect::Unit,
+                    levelBox.smallEnd() + (3*n/4 - 1)*IntVect::Unit);
+          levelBox = refine(inner, a_refRatios[ilev-1]);
+          n = levelBox.size(0);
+        }
+      Vector<Box> boxes;
+      domainSplit(levelBox, boxes, 32, 32);
+      Vector<int> procs;
+      LoadBalance(procs, boxes);
+      a_grids[ilev].define(boxes, procs);
+    }
+}
+
+// max over the levels of |a_phi - a_phiRef| / max |a_phiRef|
+static Real relativeDiff(const Vector<LevelData<FArrayBox>* >& a_phi,
+                         const Vector<LevelData<FArrayBox>* >& a_phiRef)
+{
+  Real diff = 0, norm = 0;
+  for (int ilev = 0; ilev < a_phi.size(); ilev++)
+    {
+      for (DataIterator dit = a_phi[ilev]->dataIterator(); dit.ok(); ++dit)
+        {
+          const Box& valid = a_phi[ilev]->disjointBoxLayout()[dit];
+          FArrayBox d(valid, 1);
+          d.copy((*a_phi[ilev])[dit]);
+          d.minus((*a_phiRef[ilev])[dit]);
+          diff = Max(diff, d.norm(0));
+          norm = Max(norm, (*a_phiRef[ilev])[dit].norm(valid, 0));
+        }
+    }
+#ifdef CH_MPI
+  Real recv;
+  MPI_Allreduce(&diff, &recv, 1, MPI_CH_REAL, MPI_MAX, Chombo_MPI::comm);
+  diff = recv;
+  MPI_Allreduce(&norm, &recv, 1, MPI_CH_REAL, MPI_MAX, Chombo_MPI::comm);
+  norm = recv;
+#endif
+  return diff/norm;
+}
+
+// The same number of AMRMultiGrid V-cycles with AMRPoissonOp::s_fusedVCycle
+// on and off give the same answer, for AMRPoissonOp and VCAMRPoissonOp2;
+// prints the time each takes.
+int
+testFusedVCycle()
+{
+  int status = 0;
+  bool saveFused = AMRPoissonOp::s_fusedVCycle;
+  int saveMode = AMRPoissonOp::s_relaxMode;
+  AMRPoissonOp::s_relaxMode = 1;
+
+  Box coarseDomain(IntVect::Zero, 63*IntVect::Unit);
+  ProblemDomain domain0(coarseDomain);
+  Real dx0 = 1.0/64;
+  Vector<DisjointBoxLayout> grids;
+  Vector<int> refRatios;
+  makeHierarchy(grids, refRatios, coarseDomain);
+  int nlevels = grids.size();
+
+  Vector<LevelData<FArrayBox>* > phi(nlevels), phiRef(nlevels), rhs(nlevels);
+  Vector<RefCountedPtr<LevelData<FArrayBox> > > aCoef(nlevels);
+  Vector<RefCountedPtr<LevelData<FluxBox> > > bCoef(nlevels);
+  Real dxLev = dx0;
+  for (int ilev = 0; ilev < nlevels; ilev++)
+    {
+      phi[ilev] = new LevelData<FArrayBox>(grids[ilev], 1, IntVect::Unit);
+      phiRef[ilev] = new LevelData<FArrayBox>(grids[ilev], 1, IntVect::Unit);
+      rhs[ilev] = new LevelData<FArrayBox>(grids[ilev], 1);
+      setvalue::val = 2*CH_SPACEDIM;
+      rhs[ilev]->apply(setvalue::setFunc);
+
+      // a = 1 + x, b = 1 + y/2 on the faces
+      aCoef[ilev] = RefCountedPtr<LevelData<FArrayBox> >(new LevelData<FArrayBox>(grids[ilev], 1));
+      bCoef[ilev] = RefCountedPtr<LevelData<FluxBox> >(new LevelData<FluxBox>(grids[ilev], 1));
+      for (DataIterator dit = grids[ilev].dataIterator(); dit.ok(); ++dit)
+        {
+          FArrayBox& a = (*aCoef[ilev])[dit];
+          for (BoxIterator bit(a.box()); bit.ok(); ++bit)
+            {
+              a(bit(), 0) = 1.0 + dxLev*(bit()[0] + 0.5);
+            }
+          for (int idir = 0; idir < SpaceDim; idir++)
+            {
+              FArrayBox& b = (*bCoef[ilev])[dit][idir];
+              for (BoxIterator bit(b.box()); bit.ok(); ++bit)
+                {
+                  Real y = (SpaceDim > 1) ? dxLev*(bit()[SpaceDim-1] + 0.5) : 0.0;
+                  b(bit(), 0) = 1.0 + 0.5*y;
+                }
+            }
+        }
+      if (ilev < nlevels - 1) dxLev /= refRatios[ilev];
+    }
+
+  const char* names[2] = {"AMRPoissonOp", "VCAMRPoissonOp2"};
+  if (verbose)
+    {
+      pout() << "\n fused AMR V-cycle \n";
+    }
+  for (int iop = 0; iop < 2; iop++)
+    {
+      AMRPoissonOpFactory poissonFactory;
+      VCAMRPoissonOp2Factory vcFactory;
+      AMRLevelOpFactory<LevelData<FArrayBox> >* factory;
+      if (iop == 0)
+        {
+          poissonFactory.define(domain0, grids, refRatios, dx0, DirParabolaDomainBC);
+          factory = &poissonFactory;
+        }
+      else
+        {
+          vcFactory.define(domain0, grids, refRatios, dx0, DirParabolaDomainBC,
+                           1.0, aCoef, -1.0, bCoef);
+          factory = &vcFactory;
+        }
+
+      double t[2];
+      for (int fused = 1; fused >= 0; fused--)
+        {
+          AMRPoissonOp::s_fusedVCycle = (fused == 1);
+          AMRMultiGrid<LevelData<FArrayBox> > solver;
+          BiCGStabSolver<LevelData<FArrayBox> > bottomSolver;
+          bottomSolver.m_verbosity = 0;
+          solver.define(domain0, *factory, &bottomSolver, nlevels);
+          solver.setSolverParameters(2, 2, 2, 1, 6, 1.0e-30, 1.0e-30, 1.0e-30);
+          solver.m_verbosity = 0;
+
+          Vector<LevelData<FArrayBox>* >& result = fused ? phi : phiRef;
+          double t0 = wallTime();
+          solver.solve(result, rhs, nlevels - 1, 0, true);
+          t[fused] = wallTime() - t0;
+        }
+
+      Real diff = relativeDiff(phi, phiRef);
+      if (verbose)
+        {
+          pout() << indent << names[iop] << ": fused " << t[1]
+                 << " s, separate passes " << t[0]
+                 << " s, relative difference " << diff << endl;
+        }
+      if (diff > 1.0e-10)
+        {
+          pout() << indent << names[iop] << " fused V-cycle differs by "
+                 << diff << endl;
+          status |= (1 << iop);
+        }
+    }
+
+  for (int ilev = 0; ilev < nlevels; ilev++)
+    {
+      delete phi[ilev];
+      delete phiRef[ilev];
+      delete rhs[ilev];
+    }
+  AMRPoissonOp::s_fusedVCycle = saveFused;
+  AMRPoissonOp::s_relaxMode = saveMode;
+  return status;
+}
+
+
+extern "C"
+{
+  void Sine_diri(Real* pos,
+                 int* dir,
+                 Side::LoHiSide* side,
+                 Real* a_values)
+  {
+    a_values[0] = 0;
+  }
+}
+
+// u = prod sin(pi*x) is zero on the boundary of the unit domain
+void DirSineDomainBC(FArrayBox& a_state,
+                     const Box& a_valid,
+                     const ProblemDomain& a_domain,
+                     Real a_dx,
+                     bool a_homogeneous)
+{
+  const Box& domainBox = a_domain.domainBox();
+  for (int i=0; i<CH_SPACEDIM; ++i)
+    {
+      for (SideIterator sit; sit.ok(); ++sit)
+        {
+          if (a_valid.sideEnd(sit())[i] == domainBox.sideEnd(sit())[i])
+            {
+              DiriBC(a_state, a_valid, a_dx, a_homogeneous, Sine_diri, i, sit(), 2);
+            }
+        }
+    }
+}
+
+// counts the iterations of AMRMultiGrid::solve
+class IterationCounter : public AMRMultiGridInspector<LevelData<FArrayBox> >
+{
+public:
+  IterationCounter()
+    : m_count(0)
+  {
+  }
+
+  virtual void recordResiduals(const Vector<LevelData<FArrayBox>*>& a_residuals,
+                               int a_minLevel, int a_maxLevel, int a_iter)
+  {
+    m_count++;
+  }
+
+  virtual void recordCorrections(const Vector<LevelData<FArrayBox>*>& a_corrections,
+                                 int a_minLevel, int a_maxLevel, int a_iter)
+  {
+  }
+
+  int m_count;
+};
+
+// max over the cells not covered by a finer level of |a_phi - a_phiRef|,
+// or of |a_phi - u|, u = prod sin(pi*x), if a_phiRef is empty
+static Real compositeDiff(const Vector<LevelData<FArrayBox>* >& a_phi,
+                          const Vector<LevelData<FArrayBox>* >& a_phiRef,
+                          const Vector<int>&                    a_refRatios,
+                          Real                                  a_dx0)
+{
+  Real diff = 0;
+  Real dxLev = a_dx0;
+  int nlevels = a_phi.size();
+  for (int ilev = 0; ilev < nlevels; ilev++)
+    {
+      const DisjointBoxLayout& grids = a_phi[ilev]->disjointBoxLayout();
+      for (DataIterator dit = grids.dataIterator(); dit.ok(); ++dit)
+        {
+          IntVectSet ivs(grids[dit]);
+          if (ilev < nlevels - 1)
+            {
+              const DisjointBoxLayout& fineGrids = a_phi[ilev+1]->disjointBoxLayout();
+              for (LayoutIterator lit = fineGrids.layoutIterator(); lit.ok(); ++lit)
+                {
+                  ivs -= coarsen(fineGrids[lit], a_refRatios[ilev]);
+                }
+            }
+          const FArrayBox& phi = (*a_phi[ilev])[dit];
+          for (IVSIterator it(ivs); it.ok(); ++it)
+            {
+              Real ref;
+              if (a_phiRef.size() > 0)
+                {
+                  ref = (*a_phiRef[ilev])[dit](it(), 0);
+                }
+              else
+                {
+                  ref = 1;
+                  for (int idir = 0; idir < SpaceDim; idir++)
+                    {
+                      ref *= sin(M_PI*dxLev*(it()[idir] + 0.5));
+                    }
+                }
+              diff = Max(diff, Abs(phi(it(), 0) - ref));
+            }
+        }
+      if (ilev < nlevels - 1) dxLev /= a_refRatios[ilev];
+    }
+#ifdef CH_MPI
+  Real recv;
+  MPI_Allreduce(&diff, &recv, 1, MPI_CH_REAL, MPI_MAX, Chombo_MPI::comm);
+  diff = recv;
+#endif
+  return diff;
+}
+
+// Full multigrid (AMRMultiGrid::m_fmgCycles) on the three level hierarchy
+// of testFusedVCycle, for AMRPoissonOp and VCAMRPoissonOp2: its initial
+// guess alone is within 10% of the discretization error, and
+// iterating from it converges to the solution of the iteration from zero
+// in fewer V-cycles; prints the cycles and time each one takes.
+int
+testFullMultiGrid()
+{
+  int status = 0;
+  int saveMode = AMRPoissonOp::s_relaxMode;
+  AMRPoissonOp::s_relaxMode = 1;
+
+  Box coarseDomain(IntVect::Zero, 63*IntVect::Unit);
+  ProblemDomain domain0(coarseDomain);
+  Real dx0 = 1.0/64;
+  Vector<DisjointBoxLayout> grids;
+  Vector<int> refRatios;
+  makeHierarchy(grids, refRatios, coarseDomain);
+  int nlevels = grids.size();
+
+  // L(u) = -SpaceDim*pi^2*u
+  Vector<LevelData<FArrayBox>* > phi(nlevels), phiRef(nlevels), rhs(nlevels);
+  Vector<RefCountedPtr<LevelData<FArrayBox> > > aCoef(nlevels);
+  Vector<RefCountedPtr<LevelData<FluxBox> > > bCoef(nlevels);
+  Real dxLev = dx0;
+  for (int ilev = 0; ilev < nlevels; ilev++)
+    {
+      phi[ilev] = new LevelData<FArrayBox>(grids[ilev], 1, IntVect::Unit);
+      phiRef[ilev] = new LevelData<FArrayBox>(grids[ilev], 1, IntVect::Unit);
+      rhs[ilev] = new LevelData<FArrayBox>(grids[ilev], 1);
+      aCoef[ilev] = RefCountedPtr<LevelData<FArrayBox> >(new LevelData<FArrayBox>(grids[ilev], 1));
+      bCoef[ilev] = RefCountedPtr<LevelData<FluxBox> >(new LevelData<FluxBox>(grids[ilev], 1));
+      for (DataIterator dit = grids[ilev].dataIterator(); dit.ok(); ++dit)
+        {
+          FArrayBox& r = (*rhs[ilev])[dit];
+          for (BoxIterator bit(r.box()); bit.ok(); ++bit)
+            {
+              Real u = 1;
+              for (int idir = 0; idir < SpaceDim; idir++)
+                {
+                  u *= sin(M_PI*dxLev*(bit()[idir] + 0.5));
+                }
+              r(bit(), 0) = -SpaceDim*M_PI*M_PI*u;
+            }
+          (*aCoef[ilev])[dit].setVal(1.0);
+          (*bCoef[ilev])[dit].setVal(1.0);
+        }
+      if (ilev < nlevels - 1) dxLev /= refRatios[ilev];
+    }
+
+  const char* names[2] = {"AMRPoissonOp", "VCAMRPoissonOp2"};
+  if (verbose)
+    {
+      pout() << "\n full multigrid \n";
+    }
+  for (int iop = 0; iop < 2; iop++)
+    {
+      AMRPoissonOpFactory poissonFactory;
+      VCAMRPoissonOp2Factory vcFactory;
+      AMRLevelOpFactory<LevelData<FArrayBox> >* factory;
+      if (iop == 0)
+        {
+          poissonFactory.define(domain0, grids, refRatios, dx0, DirSineDomainBC);
+          factory = &poissonFactory;
+        }
+      else
+        {
+          vcFactory.define(domain0, grids, refRatios, dx0, DirSineDomainBC,
+                           0.0, aCoef, -1.0, bCoef);
+          factory = &vcFactory;
+        }
+
+      // 0: from zero to the tolerance, 1: the FMG guess alone, 2: from the
+      // FMG guess to the tolerance
+      int cycles[3];
+      double t[3];
+      Real err[3];
+      for (int irun = 0; irun < 3; irun++)
+        {
+          AMRMultiGrid<LevelData<FArrayBox> > solver;
+          BiCGStabSolver<LevelData<FArrayBox> > bottomSolver;
+          bottomSolver.m_verbosity = 0;
+          solver.define(domain0, *factory, &bottomSolver, nlevels);
+          int iterMax = (irun == 1) ? 0 : 30;
+          solver.setSolverParameters(2, 2, 2, 1, iterMax, 1.0e-10, 1.0e-30, 1.0e-30);
+          solver.m_verbosity = 0;
+          solver.m_fmgCycles = (irun == 0) ? 0 : 2;
+          IterationCounter* counter = new IterationCounter;
+          RefCountedPtr<AMRMultiGridInspector<LevelData<FArrayBox> > > inspector(counter);
+          solver.addInspector(inspector);
+
+          Vector<LevelData<FArrayBox>* >& result = (irun == 0) ? phiRef : phi;
+          double t0 = wallTime();
+          solver.solve(result, rhs, nlevels - 1, 0, true);
+          t[irun] = wallTime() - t0;
+          cycles[irun] = counter->m_count;
+          err[irun] = compositeDiff(result, Vector<LevelData<FArrayBox>* >(), refRatios, dx0);
+          if (irun != 1 && solver.m_exitStatus != 1)
+            {
+              pout() << indent << names[iop] << " did not converge, exit status "
+                     << solver.m_exitStatus << endl;
+              status |= (1 << iop);
+            }
+        }
+
+      // max |u| = 1
+      Real diff = compositeDiff(phi, phiRef, refRatios, dx0);
+      if (verbose)
+        {
+          pout() << indent << names[iop] << ": from zero " << cycles[0] << " cycles, "
+                 << t[0] << " s, error " << err[0] << endl;
+          pout() << indent << names[iop] << ": full multigrid guess " << t[1]
+                 << " s, error " << err[1] << endl;
+          pout() << indent << names[iop] << ": from the guess " << cycles[2] << " cycles, "
+                 << t[2] << " s, error " << err[2] << ", relative difference "
+                 << diff << endl;
+        }
+      if (err[1] > 1.1*err[0] || cycles[2] >= cycles[0] || diff > 1.0e-8)
+        {
+          pout() << indent << names[iop] << " full multigrid: guess error " << err[1]
+                 << ", discretization error " << err[0] << ", " << cycles[2]
+                 << " cycles instead of " << cycles[0] << ", relative difference "
+                 << diff << endl;
+          status |= (4 << iop);
+        }
+    }
+
+  for (int ilev = 0; ilev < nlevels; ilev++)
+    {
+      delete phi[ilev];
+      delete phiRef[ilev];
+      delete rhs[ilev];
+    }
+  AMRPoissonOp::s_relaxMode = saveMode;
+  return status;
+}
+
+// One AMRMultiGrid solve of two components with AMRMultiGrid::
+// m_componentwiseConvergence, the parabola with DirParabolaDomainBC and
+// 1e-3 times the sine with DirSineDomainBC (ComponentBC), gives the
+// solutions of two separate solves, for AMRPoissonOp and for
+// VCAMRPoissonOp2 with a varying one-component bCoef that both components
+// share; prints the time each takes.
+int
+testBatchedSolve()
+{
+  int status = 0;
+  int saveMode = AMRPoissonOp::s_relaxMode;
+  AMRPoissonOp::s_relaxMode = 1;
+
+  Box coarseDomain(IntVect::Zero, 63*IntVect::Unit);
+  ProblemDomain domain0(coarseDomain);
+  Real dx0 = 1.0/64;
+  Vector<DisjointBoxLayout> grids;
+  Vector<int> refRatios;
+  makeHierarchy(grids, refRatios, coarseDomain);
+  int nlevels = grids.size();
+
+  // component 0: L(u) = 2*SpaceDim, component 1: L(u) = -1e-3*SpaceDim*pi^2*sin
+  const int ncomp = 2;
+  const Real scale[ncomp] = {1.0, 1.0e-3};
+  Vector<LevelData<FArrayBox>* > phi(nlevels), rhs(nlevels);
+  Vector<Vector<LevelData<FArrayBox>* > > phiSep(ncomp, Vector<LevelData<FArrayBox>* >(nlevels));
+  Vector<Vector<LevelData<FArrayBox>* > > rhsSep(ncomp, Vector<LevelData<FArrayBox>* >(nlevels));
+  Vector<RefCountedPtr<LevelData<FArrayBox> > > aCoef(nlevels);
+  Vector<RefCountedPtr<LevelData<FluxBox> > > bCoef(nlevels);
+  Real dxLev = dx0;
+  for (int ilev = 0; ilev < nlevels; ilev++)
+    {
+      phi[ilev] = new LevelData<FArrayBox>(grids[ilev], ncomp, IntVect::Unit);
+      rhs[ilev] = new LevelData<FArrayBox>(grids[ilev], ncomp);
+      aCoef[ilev] = RefCountedPtr<LevelData<FArrayBox> >(new LevelData<FArrayBox>(grids[ilev], 1));
+      bCoef[ilev] = RefCountedPtr<LevelData<FluxBox> >(new LevelData<FluxBox>(grids[ilev], 1));
+      for (DataIterator dit = grids[ilev].dataIterator(); dit.ok(); ++dit)
+        {
+          FArrayBox& r = (*rhs[ilev])[dit];
+          r.setVal(2*CH_SPACEDIM, 0);
+          for (BoxIterator bit(r.box()); bit.ok(); ++bit)
+            {
+              Real u = 1;
+              for (int idir = 0; idir < SpaceDim; idir++)
+                {
+                  u *= sin(M_PI*dxLev*(bit()[idir] + 0.5));
+                }
+              r(bit(), 1) = -scale[1]*SpaceDim*M_PI*M_PI*u;
+            }
+          (*aCoef[ilev])[dit].setVal(1.0);
+          // b = 1 + x/2 on the faces
+          for (int idir = 0; idir < SpaceDim; idir++)
+            {
+              FArrayBox& b = (*bCoef[ilev])[dit][idir];
+              for (BoxIterator bit(b.box()); bit.ok(); ++bit)
+                {
+                  Real x = dxLev*(bit()[0] + ((idir == 0) ? 0.0 : 0.5));
+                  b(bit(), 0) = 1.0 + 0.5*x;
+                }
+            }
+        }
+      for (int icomp = 0; icomp < ncomp; icomp++)
+        {
+          phiSep[icomp][ilev] = new LevelData<FArrayBox>(grids[ilev], 1, IntVect::Unit);
+          rhsSep[icomp][ilev] = new LevelData<FArrayBox>(grids[ilev], 1);
+          rhs[ilev]->copyTo(Interval(icomp, icomp), *rhsSep[icomp][ilev], Interval(0, 0));
+        }
+      if (ilev < nlevels - 1) dxLev /= refRatios[ilev];
+    }
+
+  Vector<BCHolder> bcs(ncomp);
+  bcs[0] = BCHolder(DirParabolaDomainBC);
+  bcs[1] = BCHolder(DirSineDomainBC);
+
+  Vector<LevelData<FArrayBox>* > phiComp(nlevels);
+  for (int ilev = 0; ilev < nlevels; ilev++)
+    {
+      phiComp[ilev] = new LevelData<FArrayBox>(grids[ilev], 1, IntVect::Unit);
+    }
+
+  const char* names[2] = {"AMRPoissonOp", "VCAMRPoissonOp2"};
+  if (verbose)
+    {
+      pout() << "\n batched solve \n";
+    }
+  for (int iop = 0; iop < 2; iop++)
+    {
+      // the separate solves, then the batched one
+      double tSep = 0;
+      double tBatched = 0;
+      for (int isolve = 0; isolve <= ncomp; isolve++)
+        {
+          BCHolder bc = (isolve < ncomp) ? bcs[isolve] : BCHolder(ComponentBC(bcs));
+          AMRPoissonOpFactory poissonFactory;
+          VCAMRPoissonOp2Factory vcFactory;
+          AMRLevelOpFactory<LevelData<FArrayBox> >* factory;
+          if (iop == 0)
+            {
+              poissonFactory.define(domain0, grids, refRatios, dx0, bc);
+              factory = &poissonFactory;
+            }
+          else
+            {
+              vcFactory.define(domain0, grids, refRatios, dx0, bc,
+                               0.0, aCoef, -1.0, bCoef);
+              factory = &vcFactory;
+            }
+          AMRMultiGrid<LevelData<FArrayBox> > solver;
+          BiCGStabSolver<LevelData<FArrayBox> > bottomSolver;
+          bottomSolver.m_verbosity = 0;
+          solver.define(domain0, *factory, &bottomSolver, nlevels);
+          solver.setSolverParameters(2, 2, 2, 1, 40, 1.0e-10, 1.0e-30, 1.0e-30);
+          solver.m_verbosity = 0;
+          solver.m_componentwiseConvergence = true;
+
+          double t0 = wallTime();
+          if (isolve < ncomp)
+            {
+              solver.solve(phiSep[isolve], rhsSep[isolve], nlevels - 1, 0, true);
+              tSep += wallTime() - t0;
+            }
+          else
+            {
+              solver.solve(phi, rhs, nlevels - 1, 0, true);
+              tBatched = wallTime() - t0;
+            }
+          if (solver.m_exitStatus != 1)
+            {
+              pout() << indent << names[iop] << " solve " << isolve
+                     << " did not converge, exit status " << solver.m_exitStatus << endl;
+              status |= (1 << iop);
+            }
+        }
+
+      // the parabola is about 1 and the sine 1e-3
+      for (int icomp = 0; icomp < ncomp; icomp++)
+        {
+          for (int ilev = 0; ilev < nlevels; ilev++)
+            {
+              phi[ilev]->copyTo(Interval(icomp, icomp), *phiComp[ilev], Interval(0, 0));
+            }
+          Real diff = compositeDiff(phiComp, phiSep[icomp], refRatios, dx0)/scale[icomp];
+          if (verbose)
+            {
+              pout() << indent << names[iop] << " component " << icomp
+                     << ": relative difference " << diff << endl;
+            }
+          if (diff > 1.0e-8)
+            {
+              pout() << indent << names[iop] << " batched component " << icomp
+                     << " differs by " << diff << endl;
+              status |= (4 << iop);
+            }
+        }
+      if (verbose)
+        {
+          pout() << indent << names[iop] << ": separate solves " << tSep
+                 << " s, batched " << tBatched << " s" << endl;
+        }
+    }
+
+  for (int ilev = 0; ilev < nlevels; ilev++)
+    {
+      delete phi[ilev];
+      delete rhs[ilev];
+      delete phiComp[ilev];
+      for (int icomp = 0; icomp < ncomp; icomp++)
+        {
+          delete phiSep[icomp][ilev];
+          delete rhsSep[icomp][ilev];
+        }
+    }
+  AMRPoissonOp::s_relaxMode = saveMode;
+  return status;
+}
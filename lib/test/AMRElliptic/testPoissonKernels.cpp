@@ -0,0 +1,354 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+// Purpose:
+//  Check that the AMRPoissonOpKernels GSRB, Jacobi, residual and
+//  restriction agree with the AMRPoissonOpF kernels, for the Laplacian
+//  and a Helmholtz operator, on regions that start on even and on odd
+//  cells.  With -b, times both versions on a larger box and prints the
+//  GFlop/s and the bytes per cell each has to move.
+//
+// Usage:
+//  <program-name> [-q|-v|-b] ...
+//
+//  where:
+//    -q means run quietly (only pass/fail messages printed)
+//    -v means run verbosely (all messages printed)
+//    -b also runs the benchmark
+//    ... all non-option arguments are ignored (Chombo convention)
+//
+//  Default is `-q'
+//
+
+#include <cstring>
+#include <cmath>
+#include <sys/time.h>
+
+#include "parstream.H"
+#include "FArrayBox.H"
+#include "BoxIterator.H"
+#include "AMRPoissonOpKernels.H"
+#include "AMRPoissonOpF_F.H"
+
+#ifdef CH_MPI
+#include <mpi.h>
+#endif
+
+#include "UsingNamespace.H"
+
+using std::endl;
+
+void parseTestOptions(int argc, char* argv[]);
+
+static const char *pgmname = "testPoissonKernels";
+static const char *indent = "   ";
+
+static bool verbose = false;
+static bool benchmark = false;
+
+static const char* kernelNames[AMRPoissonOpKernels::NumKernels] =
+  {"GSRB", "Jacobi", "Residual", "RestrictResidual"};
+
+static double wallTime()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + 1.0e-6*tv.tv_usec;
+}
+
+// smooth data that is not a polynomial, so no stencil is exact
+static void setData(FArrayBox& a_fab, Real a_shift)
+{
+  for (BoxIterator bit(a_fab.box()); bit.ok(); ++bit)
+    {
+      const IntVect& iv = bit();
+      Real val = a_shift;
+      for (int idir = 0; idir < SpaceDim; idir++)
+        {
+          val += sin(0.37*(idir + 1)*iv[idir] + a_shift);
+        }
+      for (int n = 0; n < a_fab.nComp(); n++)
+        {
+          a_fab(iv, n) = val + n;
+        }
+    }
+}
+
+static Real maxDiff(const FArrayBox& a_1, const FArrayBox& a_2, const Box& a_region)
+{
+  FArrayBox diff(a_region, a_1.nComp());
+  diff.copy(a_1);
+  diff.minus(a_2, a_region, 0, 0, a_1.nComp());
+  Real scale = Max(a_1.norm(a_region, 0, 0, a_1.nComp()), (Real)1.0);
+  return diff.norm(0, 0, a_1.nComp())/scale;
+}
+
+// one kernel of either version on a_region; a_phi needs a ghost cell
+static void runKernel(AMRPoissonOpKernels::Kernel a_kernel,
+                      bool                        a_fortran,
+                      FArrayBox&                  a_out,
+                      FArrayBox&                  a_phi,
+                      const FArrayBox&            a_rhs,
+                      const Box&                  a_region,
+                      Real                        a_dx,
+                      Real                        a_alpha,
+                      Real                        a_beta)
+{
+  const Real weight = 0.666;
+  switch (a_kernel)
+    {
+    case AMRPoissonOpKernels::GSRB:
+      for (int whichPass = 0; whichPass <= 1; whichPass++)
+        {
+          if (!a_fortran)
+            {
+              AMRPoissonOpKernels::gsrb(a_phi, a_rhs, a_region, a_dx,
+                                        a_alpha, a_beta, whichPass);
+            }
+          else if (a_alpha == 0.0 && a_beta == 1.0)
+            {
+              FORT_GSRBLAPLACIAN(CHF_FRA(a_phi), CHF_CONST_FRA(a_rhs),
+                                 CHF_BOX(a_region), CHF_CONST_REAL(a_dx),
+                                 CHF_CONST_INT(whichPass));
+            }
+          else
+            {
+              FORT_GSRBHELMHOLTZ(CHF_FRA(a_phi), CHF_CONST_FRA(a_rhs),
+                                 CHF_BOX(a_region), CHF_CONST_REAL(a_dx),
+                                 CHF_CONST_REAL(a_alpha), CHF_CONST_REAL(a_beta),
+                                 CHF_CONST_INT(whichPass));
+            }
+        }
+      a_out.copy(a_phi);
+      break;
+    case AMRPoissonOpKernels::Jacobi:
+      if (a_fortran)
+        {
+          // what AMRPoissonOp::levelJacobi does with the Fortran kernels
+          Real diag = a_alpha - 2.0*SpaceDim*a_beta/(a_dx*a_dx);
+          FORT_OPERATORLAPRES(CHF_FRA(a_out), CHF_CONST_FRA(a_phi),
+                              CHF_CONST_FRA(a_rhs), CHF_BOX(a_region),
+                              CHF_CONST_REAL(a_dx), CHF_CONST_REAL(a_alpha),
+                              CHF_CONST_REAL(a_beta));
+          a_out.mult(weight/diag, a_region, 0, a_out.nComp());
+          a_out.plus(a_phi, a_region, a_region, 1.0, 0, 0, a_out.nComp());
+        }
+      else
+        {
+          AMRPoissonOpKernels::jacobi(a_out, a_phi, a_rhs, a_region, a_dx,
+                                      a_alpha, a_beta, weight);
+        }
+      break;
+    case AMRPoissonOpKernels::Residual:
+      if (a_fortran)
+        {
+          FORT_OPERATORLAPRES(CHF_FRA(a_out), CHF_CONST_FRA(a_phi),
+                              CHF_CONST_FRA(a_rhs), CHF_BOX(a_region),
+                              CHF_CONST_REAL(a_dx), CHF_CONST_REAL(a_alpha),
+                              CHF_CONST_REAL(a_beta));
+        }
+      else
+        {
+          AMRPoissonOpKernels::residual(a_out, a_phi, a_rhs, a_region, a_dx,
+                                        a_alpha, a_beta);
+        }
+      break;
+    case AMRPoissonOpKernels::RestrictResidual:
+      a_out.setVal(0.0);
+      if (a_fortran)
+        {
+          // as in AMRPoissonOp::restrictResidual, shifted to an even origin
+          IntVect iv = coarsen(a_phi.box().smallEnd(), 2);
+          iv *= 2;
+          IntVect civ = coarsen(iv, 2);
+          FORT_RESTRICTRES(CHF_FRA_SHIFT(a_out, civ),
+                           CHF_CONST_FRA_SHIFT(a_phi, iv),
+                           CHF_CONST_FRA_SHIFT(a_rhs, iv),
+                           CHF_CONST_REAL(a_alpha),
+                           CHF_CONST_REAL(a_beta),
+                           CHF_BOX_SHIFT(a_region, iv),
+                           CHF_CONST_REAL(a_dx));
+        }
+      else
+        {
+          AMRPoissonOpKernels::restrictResidual(a_out, a_phi, a_rhs, a_region,
+                                                a_dx, a_alpha, a_beta);
+        }
+      break;
+    default:
+      break;
+    }
+}
+
+// C++ against Fortran for every kernel on a_region of a box with a ghost cell
+static int compareKernels(const Box& a_valid,
+                          const Box& a_region,
+                          int        a_ncomp,
+                          Real       a_alpha,
+                          Real       a_beta)
+{
+  int status = 0;
+  const Real dx = 1.0/64;
+  Box ghosted = grow(a_valid, 1);
+  FArrayBox rhs(a_valid, a_ncomp);
+  setData(rhs, 0.5);
+
+  for (int k = 0; k < AMRPoissonOpKernels::NumKernels; k++)
+    {
+      AMRPoissonOpKernels::Kernel kernel = (AMRPoissonOpKernels::Kernel)k;
+      Box outBox = (kernel == AMRPoissonOpKernels::RestrictResidual) ?
+        coarsen(a_valid, 2) : a_valid;
+      Box compareBox = (kernel == AMRPoissonOpKernels::RestrictResidual) ?
+        coarsen(a_region, 2) : a_region;
+      FArrayBox phiF(ghosted, a_ncomp), phiC(ghosted, a_ncomp);
+      FArrayBox outF(outBox, a_ncomp), outC(outBox, a_ncomp);
+      setData(phiF, 0.0);
+      setData(phiC, 0.0);
+      outF.setVal(0.0);
+      outC.setVal(0.0);
+      runKernel(kernel, true,  outF, phiF, rhs, a_region, dx, a_alpha, a_beta);
+      runKernel(kernel, false, outC, phiC, rhs, a_region, dx, a_alpha, a_beta);
+      Real diff = maxDiff(outF, outC, compareBox);
+      if (verbose)
+        {
+          pout() << indent << kernelNames[k] << " on " << a_region
+                 << " alpha = " << a_alpha << " beta = " << a_beta
+                 << ": relative difference " << diff << endl;
+        }
+      if (diff > 1.0e-12)
+        {
+          pout() << indent << kernelNames[k] << " differs from Fortran by "
+                 << diff << " on " << a_region << endl;
+          status |= (1 << k);
+        }
+    }
+
+  // AMRPoissonOp::AMRUpdateResidual computes the residual in place
+  {
+    FArrayBox phi(ghosted, a_ncomp), outF(a_valid, a_ncomp), outC(a_valid, a_ncomp);
+    setData(phi, 0.0);
+    runKernel(AMRPoissonOpKernels::Residual, true, outF, phi, rhs, a_region, dx,
+              a_alpha, a_beta);
+    outC.copy(rhs);
+    AMRPoissonOpKernels::residual(outC, phi, outC, a_region, dx, a_alpha, a_beta);
+    Real diff = maxDiff(outF, outC, a_region);
+    if (diff > 1.0e-12)
+      {
+        pout() << indent << "in-place residual differs from Fortran by "
+               << diff << " on " << a_region << endl;
+        status |= (1 << AMRPoissonOpKernels::NumKernels);
+      }
+  }
+  return status;
+}
+
+static void benchmarkKernels(Real a_alpha, Real a_beta)
+{
+  const int n = (SpaceDim == 3) ? 128 : 1024;
+  const Real dx = 1.0/n;
+  Box valid(IntVect::Zero, (n-1)*IntVect::Unit);
+  Box ghosted = grow(valid, 1);
+  FArrayBox phi(ghosted, 1), rhs(valid, 1), out(valid, 1), resc(coarsen(valid, 2), 1);
+  setData(phi, 0.0);
+  setData(rhs, 0.5);
+  const double cells = valid.numPts();
+  const int reps = 10;
+
+  pout() << indent << "alpha = " << a_alpha << " beta = " << a_beta
+         << ", " << n << "^" << SpaceDim << " cells" << endl;
+  for (int k = 0; k < AMRPoissonOpKernels::NumKernels; k++)
+    {
+      AMRPoissonOpKernels::Kernel kernel = (AMRPoissonOpKernels::Kernel)k;
+      FArrayBox& dest = (kernel == AMRPoissonOpKernels::RestrictResidual) ? resc : out;
+      double best[2] = {1.0e30, 1.0e30};
+      for (int it = 0; it <= reps; it++)
+        {
+          for (int version = 0; version < 2; version++)
+            {
+              double t0 = wallTime();
+              runKernel(kernel, version == 0, dest, phi, rhs, valid, dx, a_alpha, a_beta);
+              double t = wallTime() - t0;
+              if (it > 0 && t < best[version]) best[version] = t;
+            }
+        }
+      double flops = cells*AMRPoissonOpKernels::flopsPerCell(kernel, a_alpha, a_beta);
+      int bytes = AMRPoissonOpKernels::bytesPerCell(kernel);
+      pout() << indent << indent << kernelNames[k] << ": Fortran "
+             << 1.0e-9*flops/best[0] << " GFlop/s, C++ "
+             << 1.0e-9*flops/best[1] << " GFlop/s, "
+             << bytes << " bytes/cell, C++ "
+             << 1.0e-9*bytes*cells/best[1] << " GB/s" << endl;
+    }
+}
+
+int
+main(int argc ,char* argv[])
+{
+#ifdef CH_MPI
+  MPI_Init(&argc, &argv);
+#endif
+  parseTestOptions(argc, argv);
+
+  Box valid(IntVect::Zero, 31*IntVect::Unit);
+  Box odd(IntVect::Unit, 30*IntVect::Unit);
+  int status = 0;
+  status += compareKernels(valid, valid, 1, 0.0, 1.0);
+  status += 100*compareKernels(valid, valid, 2, 0.5, -0.3);
+  status += 10000*compareKernels(valid, odd, 1, 0.0, 1.0);
+  status += 1000000*compareKernels(valid, odd, 1, 0.5, -0.3);
+
+  if (benchmark)
+    {
+      benchmarkKernels(0.0, 1.0);
+      benchmarkKernels(0.5, -0.3);
+    }
+
+  pout() << indent << pgmname << ": "
+         << ( (status == 0) ? "passed all tests" : "failed at least one test,")
+         << endl;
+
+#ifdef CH_MPI
+  MPI_Finalize();
+#endif
+  return status;
+}
+
+///
+// Parse the standard test options (-v -q) and -b out of the command line.
+// Stop parsing when a non-option argument is found.
+///
+void
+parseTestOptions( int argc ,char* argv[] )
+{
+  for ( int i = 1 ; i < argc ; ++i )
+    {
+      if ( argv[i][0] == '-' ) //if it is an option
+        {
+          // compare 3 chars to differentiate -x from -xx
+          if ( strncmp( argv[i] ,"-v" ,3 ) == 0 )
+            {
+              verbose = true ;
+            }
+          else if ( strncmp( argv[i] ,"-q" ,3 ) == 0 )
+            {
+              verbose = false ;
+            }
+          else if ( strncmp( argv[i] ,"-b" ,3 ) == 0 )
+            {
+              benchmark = true ;
+            }
+          else
+            {
+              break ;
+            }
+        }
+    }
+  return ;
+}
@@ -211,9 +211,16 @@ AMRDerivedClass::advance ()
 {
   if ( verbose ) pout () << "AMRDerivedClass::advance " << m_level << " at " << m_time << endl;
 
-  m_state_new.copyTo ( m_state_new.interval (),
-                       m_state_old,
-                       m_state_old.interval () );
+  // time the per-box work so AMR can balance on it at the next regrid
+  const DisjointBoxLayout& grids = m_state_new.disjointBoxLayout ();
+  TimedDataIterator dit = grids.timedDataIterator ();
+  dit.clearTime ();
+  dit.enableTime ();
+  for (dit.begin (); dit.ok (); ++dit)
+  {
+    m_state_old[dit ()].copy ( m_state_new[dit ()], grids[dit ()] );
+  }
+  measuredCosts ( dit );
 
 // blahblahblah.step(...)
 
@@ -304,7 +311,7 @@ AMRDerivedClass::loadBalance(const Vector<Box>& a_grids)
   Vector<int> proc_map;
   if (procID () == uniqueProc (SerialTask::compute) )
   {
-    LoadBalance (proc_map, a_grids);
+    loadBalanceGrids (proc_map, a_grids);
   }
   broadcast (proc_map, uniqueProc (SerialTask::compute) );
 
@@ -727,6 +734,9 @@ AMRDerivedClassFactory::new_amrlevel() const
 int
 testAMR();
 
+int
+testAMRHierarchyBalance();
+
 void
 parseTestOptions(int argc ,char* argv[]) ;
 
@@ -741,6 +751,8 @@ main(int argc ,char* argv[])
     pout () << indent2 << "Beginning " << pgmname << " ..." << endl ;
 
   int status = testAMR();
+  if ( status == 0 )
+    status = testAMRHierarchyBalance();
 
   if ( status == 0 )
     pout() << indent << pgmname << " passed." << endl ;
@@ -778,6 +790,47 @@ testAMR ()
   return 0 ;
 }
 
+// same run with AMR balancing the whole hierarchy on measured costs
+int
+testAMRHierarchyBalance ()
+{
+  Box prob_domain (IntVect::Zero,
+                   3 * IntVect::Unit );
+
+  int max_level = 3;
+  Vector<int> ref_ratioes (max_level+1, 2);
+  AMRDerivedClassFactory amrd_fact;
+
+  AMR amr;
+  amr.define(max_level, ref_ratioes, prob_domain, &amrd_fact);
+
+  amr.checkpointInterval(2);
+  amr.loadBalanceMode(LB_GRAPH);
+  amr.loadBalanceOnMeasuredCost(true);
+
+  amr.setupForNewAMRRun();
+
+  amr.run(8., 8);
+
+  // every level took its processors from the hierarchy assignment (on
+  // the processor that balances, see AMRDerivedClass::loadBalance)
+  Vector<AMRLevel*> levels = amr.getAMRLevels();
+  for (int ilev = 0; ilev < levels.size(); ilev++)
+    {
+      if (procID () == uniqueProc (SerialTask::compute) &&
+          !levels[ilev]->usedHierarchyProcs())
+        {
+          pout() << indent2 << "level " << ilev
+                 << " did not use the hierarchy assignment" << endl;
+          return 1;
+        }
+    }
+
+  amr.conclude();
+
+  return 0 ;
+}
+
 ///
 // Parse the standard test options (-v -q) out of the command line.
 ///
@@ -0,0 +1,218 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+// Purpose:
+//  Check that a PArena reuses freed blocks of the same size class, goes to
+//  the heap otherwise, and keeps no more than maxCached() bytes, also when
+//  several threads allocate and free.
+//
+// Usage:
+//  <program-name> [-q|-v] ...
+//
+//  where:
+//    -q means run quietly (only pass/fail messages printed)
+//    -v means run verbosely (all messages printed)
+//    ... all non-option arguments are ignored (Chombo convention)
+//
+//  Default is `-v'
+//
+
+#include <cstring>
+
+#include "Arena.H"
+#include "parstream.H"
+#ifdef CH_MPI
+#include <mpi.h>
+#endif
+#include "UsingBaseNamespace.H"
+
+using std::endl;
+
+/// Prototypes:
+
+void
+parseTestOptions( int argc ,char* argv[] ) ;
+
+int
+testPArena();
+
+/// Global variables for handling output:
+static const char *pgmname = "testPArena" ;
+static const char *indent = "   ", *indent2 = "      " ;
+static bool verbose = true ;
+
+/// Code:
+
+int
+main(int argc, char* argv[])
+{
+#ifdef CH_MPI
+  MPI_Init(&argc, &argv);
+#endif
+  parseTestOptions( argc ,argv ) ;
+
+  if ( verbose )
+    pout() << indent2 << "Beginning " << pgmname << " ..." << endl ;
+
+  int ret = testPArena() ;
+
+  if ( ret == 0 )
+    {
+      pout() << indent << pgmname << " passed." << endl ;
+    }
+  else
+    {
+      pout() << indent << pgmname << " failed with return code " << ret << endl ;
+    }
+
+#ifdef CH_MPI
+  MPI_Finalize();
+#endif
+  return ret;
+}
+
+int
+testPArena()
+{
+  int ret = 0;
+  PArena arena("testPArena", 4096);
+
+  // first allocations come from the heap
+  double* a = static_cast<double*>(arena.alloc(100*sizeof(double)));
+  double* b = static_cast<double*>(arena.alloc(100*sizeof(double)));
+  for (int i = 0; i < 100; i++)
+    {
+      a[i] = i;
+      b[i] = -i;
+    }
+  if (arena.numAllocs() != 2 || arena.numHeapAllocs() != 2)
+    {
+      if (verbose) pout() << indent << "expected 2 heap allocations, got "
+                          << arena.numHeapAllocs() << endl;
+      ret |= 1;
+    }
+
+  // blocks keep ClassSize alignment, huge-page backed ones too
+  PArena hugeArena("testPArenaHuge", 0);
+  hugeArena.hugePages(1);
+  void* h = hugeArena.alloc(100*sizeof(double));
+  if ((size_t)a % PArena::ClassSize != 0 || (size_t)b % PArena::ClassSize != 0 ||
+      (size_t)h % PArena::ClassSize != 0)
+    {
+      if (verbose) pout() << indent << "block not aligned to " << (int)PArena::ClassSize
+                          << " bytes" << endl;
+      ret |= 64;
+    }
+  hugeArena.free(h);
+
+  // a freed block is reused for a request of the same size class
+  arena.free(a);
+  if (arena.cachedBytes() < 100*sizeof(double))
+    {
+      if (verbose) pout() << indent << "freed block not kept" << endl;
+      ret |= 2;
+    }
+  void* c = arena.alloc(99*sizeof(double));
+  if (c != a || arena.numHeapAllocs() != 2 || arena.cachedBytes() != 0)
+    {
+      if (verbose) pout() << indent << "freed block not reused" << endl;
+      ret |= 4;
+    }
+
+  // but not for a much smaller one
+  arena.free(c);
+  void* d = arena.alloc(10*sizeof(double));
+  if (d == a || arena.numHeapAllocs() != 3)
+    {
+      if (verbose) pout() << indent << "small request took a large block" << endl;
+      ret |= 8;
+    }
+
+  // nothing past maxCached() is kept
+  void* e = arena.alloc(8192);
+  arena.free(e);
+  if (arena.cachedBytes() > arena.maxCached())
+    {
+      if (verbose) pout() << indent << "kept " << arena.cachedBytes()
+                          << " bytes, more than " << arena.maxCached() << endl;
+      ret |= 16;
+    }
+
+  arena.free(b);
+  arena.free(d);
+  arena.release();
+  if (arena.cachedBytes() != 0)
+    {
+      if (verbose) pout() << indent << "release() kept blocks" << endl;
+      ret |= 32;
+    }
+
+  // every thread reuses the blocks it freed, so a second pass over the
+  // same allocations takes nothing more from the heap
+  PArena threadArena("testPArenaThreads");
+  long heapAllocs = 0;
+  for (int pass = 0; pass < 2; pass++)
+    {
+#pragma omp parallel for schedule(static)
+      for (int i = 0; i < 64; i++)
+        {
+          double* x = static_cast<double*>(threadArena.alloc((i + 1)*sizeof(double)));
+          x[i] = i;
+          threadArena.free(x);
+        }
+      if (pass == 0)
+        {
+          heapAllocs = threadArena.numHeapAllocs();
+        }
+    }
+  if (threadArena.numAllocs() != 128 || threadArena.numHeapAllocs() != heapAllocs)
+    {
+      if (verbose) pout() << indent << "threads took "
+                          << threadArena.numHeapAllocs() - heapAllocs
+                          << " more blocks from the heap on the second pass" << endl;
+      ret |= 128;
+    }
+
+  if (verbose)
+    {
+      pout() << indent << arena.numAllocs() << " allocations, "
+             << arena.numHeapAllocs() << " from the heap" << endl;
+    }
+  return ret;
+}
+
+///
+// Parse the standard test options (-v -q) out of the command line.
+// Stop parsing when a non-option argument is found.
+///
+void
+parseTestOptions( int argc ,char* argv[] )
+{
+  for ( int i = 1 ; i < argc ; ++i )
+    {
+      if ( argv[i][0] == '-' ) //if it is an option
+        {
+          // compare 3 chars to differentiate -x from -xx
+          if ( strncmp( argv[i] ,"-v" ,3 ) == 0 )
+            {
+              verbose = true ;
+            }
+          else if ( strncmp( argv[i] ,"-q" ,3 ) == 0 )
+            {
+              verbose = false ;
+            }
+          else
+            {
+              break ;
+            }
+        }
+    }
+  return ;
+}
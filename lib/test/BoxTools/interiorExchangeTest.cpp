@@ -34,6 +34,10 @@ parseTestOptions( int argc ,char* argv[] );
 
 int testExchange(void);
 
+int checkExchange(const LevelData< BaseFab<int> >& a_data,
+                  const ProblemDomain& a_domain,
+                  int a_midpt);
+
 /// Global variables for handling output:
 static const char *pgmname = "interiorExchangeTest";
 static const char *indent2 = "      ";
@@ -115,6 +119,42 @@ int testExchange(void)
     }
   //exchange the data to fill the ghost cells
   data.exchange();
+  int eekflag = checkExchange(data, baseLevelDomain, midpt);
+  if (eekflag != 0)
+    {
+      return eekflag;
+    }
+
+  //wipe the ghost cells and refill them one component at a time
+  //with the split-phase exchange
+  Copier exchangeCopier(grids, grids, nghost*IntVect::Unit, true);
+  for (DataIterator dit = grids.dataIterator(); dit.ok(); ++dit)
+    {
+      BaseFab<int> valid(grids[dit()], SpaceDim);
+      valid.copy(data[dit()]);
+      data[dit()].setVal(0);
+      data[dit()].copy(valid);
+    }
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      Interval comps(idir, idir);
+      data.exchangeBegin(comps, exchangeCopier);
+      data.exchangeProgress();
+      data.exchangeEnd(comps);
+    }
+  eekflag = checkExchange(data, baseLevelDomain, midpt);
+  if (eekflag != 0)
+    {
+      return eekflag;
+    }
+  return 0;
+}
+
+int checkExchange(const LevelData< BaseFab<int> >& data,
+                  const ProblemDomain& baseLevelDomain,
+                  int midpt)
+{
+  const DisjointBoxLayout& grids = data.getBoxes();
   //check the answer
   for (DataIterator dit = grids.dataIterator(); dit.ok(); ++dit)
     {
@@ -0,0 +1,243 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+// Purpose:
+//  Run many exchanges through one Copier.  With MPI, the second and later
+//  exchanges restart the persistent requests the first one made; an
+//  exchange of a different number of components lays the buffers out
+//  again.  Every exchange must fill the ghost cells with the current data.
+
+#include <cstring>
+
+#include "REAL.H"
+#include "Vector.H"
+#include "DataIterator.H"
+#include "DisjointBoxLayout.H"
+#include "ProblemDomain.H"
+#include "BRMeshRefine.H"
+#include "LoadBalance.H"
+#include "BoxIterator.H"
+#include "LevelData.H"
+#include "FArrayBox.H"
+#include "Copier.H"
+
+#ifdef CH_MPI
+#include <mpi.h>
+#endif
+#include "UsingNamespace.H"
+
+/// Prototypes:
+void
+parseTestOptions( int argc ,char* argv[] );
+
+int testRepeatedExchange(void);
+
+/// Global variables for handling output:
+static const char *pgmname = "repeatedExchangeTest";
+static const char *indent2 = "      ";
+static bool verbose = true;
+
+static const int domsize = 32;
+static const int nghost  = 2;
+static const int ncomp   = 3;
+
+/// Code:
+int main(int argc, char* argv[])
+{
+#ifdef CH_MPI
+  MPI_Init(&argc, &argv);
+#endif
+  parseTestOptions(argc,argv);
+
+  if ( verbose ) pout() << indent2 << "Beginning " << pgmname << " ..." << endl;
+
+  int ret = testRepeatedExchange();
+  if (ret == 0)
+    {
+      pout() << indent2 << pgmname << " passed" << endl;
+    }
+  else
+    {
+      pout() << indent2 << pgmname << " failed with code " << ret << endl;
+    }
+#ifdef CH_MPI
+  MPI_Finalize();
+#endif
+
+  return ret;
+}
+
+// the value of component a_comp at a_iv after the a_iter'th fill
+Real exactValue(const IntVect& a_iv, int a_comp, int a_iter)
+{
+  Real retval = 1000*a_iter + 100*a_comp;
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      retval += (idir + 1)*a_iv[idir];
+    }
+  return retval;
+}
+
+// set the valid cells to the a_iter'th values and the ghost cells to -1
+void fillValid(LevelData<FArrayBox>& a_data, int a_iter)
+{
+  const DisjointBoxLayout& grids = a_data.getBoxes();
+  for (DataIterator dit = grids.dataIterator(); dit.ok(); ++dit)
+    {
+      FArrayBox& fab = a_data[dit()];
+      fab.setVal(-1.0);
+      for (BoxIterator bit(grids[dit()]); bit.ok(); ++bit)
+        {
+          for (int icomp = 0; icomp < fab.nComp(); icomp++)
+            {
+              fab(bit(), icomp) = exactValue(bit(), icomp, a_iter);
+            }
+        }
+    }
+}
+
+// number of cells of the domain, valid or ghost, where the components
+// a_comps do not hold the a_iter'th values
+int countWrong(const LevelData<FArrayBox>& a_data,
+               const ProblemDomain&        a_domain,
+               const Interval&             a_comps,
+               int                         a_iter)
+{
+  int retval = 0;
+  const DisjointBoxLayout& grids = a_data.getBoxes();
+  for (DataIterator dit = grids.dataIterator(); dit.ok(); ++dit)
+    {
+      Box grownBox = a_data[dit()].box();
+      grownBox &= a_domain;
+      for (BoxIterator bit(grownBox); bit.ok(); ++bit)
+        {
+          for (int icomp = a_comps.begin(); icomp <= a_comps.end(); icomp++)
+            {
+              if (a_data[dit()](bit(), icomp) != exactValue(bit(), icomp, a_iter))
+                {
+                  retval++;
+                }
+            }
+        }
+    }
+  return retval;
+}
+
+int testRepeatedExchange(void)
+{
+  Box bigBox = Box(IntVect::Zero, (domsize-1)*IntVect::Unit);
+  ProblemDomain domain(bigBox);
+  Vector<Box> boxes;
+  domainSplit(domain, boxes, domsize/4, domsize/4);
+  Vector<int> ranks;
+  LoadBalance(ranks, boxes);
+  DisjointBoxLayout grids(boxes, ranks, domain);
+
+  LevelData<FArrayBox> data(grids, ncomp, nghost*IntVect::Unit);
+  Copier exchangeCopier;
+  exchangeCopier.exchangeDefine(grids, nghost*IntVect::Unit);
+  Interval allComps(0, ncomp-1);
+
+  int iter = 0;
+  // blocking exchanges, then split-phase ones, all through the same Copier
+  for (int i = 0; i < 4; i++, iter++)
+    {
+      fillValid(data, iter);
+      data.exchange(exchangeCopier);
+      if (countWrong(data, domain, allComps, iter) != 0)
+        {
+          pout() << "exchange " << iter << " left wrong ghost cells" << endl;
+          return 1;
+        }
+    }
+  for (int i = 0; i < 3; i++, iter++)
+    {
+      fillValid(data, iter);
+      data.exchangeBegin(exchangeCopier);
+      data.exchangeEnd();
+      if (countWrong(data, domain, allComps, iter) != 0)
+        {
+          pout() << "split-phase exchange " << iter << " left wrong ghost cells" << endl;
+          return 2;
+        }
+    }
+
+  // one component lays the buffers out again; the others keep -1 in
+  // their ghost cells
+  Interval oneComp(1, 1);
+  for (int i = 0; i < 2; i++, iter++)
+    {
+      fillValid(data, iter);
+      data.exchange(oneComp, exchangeCopier);
+      if (countWrong(data, domain, oneComp, iter) != 0)
+        {
+          pout() << "one-component exchange " << iter << " left wrong ghost cells" << endl;
+          return 3;
+        }
+      for (DataIterator dit = grids.dataIterator(); dit.ok(); ++dit)
+        {
+          Box ghostBox = data[dit()].box();
+          ghostBox &= domain;
+          for (BoxIterator bit(ghostBox); bit.ok(); ++bit)
+            {
+              if (!grids[dit()].contains(bit()) && (data[dit()](bit(), 0) != -1.0))
+                {
+                  pout() << "one-component exchange " << iter << " wrote component 0" << endl;
+                  return 4;
+                }
+            }
+        }
+    }
+
+  // and back to all of them
+  for (int i = 0; i < 3; i++, iter++)
+    {
+      fillValid(data, iter);
+      data.exchange(exchangeCopier);
+      if (countWrong(data, domain, allComps, iter) != 0)
+        {
+          pout() << "exchange " << iter << " after relayout left wrong ghost cells" << endl;
+          return 5;
+        }
+    }
+
+  return 0;
+}
+
+///
+// Parse the standard test options (-v -q) out of the command line.
+// Stop parsing when a non-option argument is found.
+///
+void
+parseTestOptions( int argc ,char* argv[] )
+{
+  for ( int i = 1 ; i < argc ; ++i )
+  {
+    if ( argv[i][0] == '-' ) //if it is an option
+    {
+      // compare 3 chars to differentiate -x from -xx
+      if ( strncmp( argv[i] ,"-v" ,3 ) == 0 )
+      {
+        verbose = true ;
+        // argv[i] = "" ;
+      }
+      else if ( strncmp( argv[i] ,"-q" ,3 ) == 0 )
+      {
+        verbose = false ;
+        // argv[i] = "" ;
+      }
+      else
+      {
+        break ;
+      }
+    }
+  }
+  return ;
+}
@@ -0,0 +1,317 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+// Purpose:
+//  Check the Copier and neighbor lists built with the BoxLayout spatial
+//  index against brute-force counts, check the index itself on boxes of
+//  very different sizes, and time Copier::define as the number of boxes
+//  grows.
+//
+// Usage:
+//  <program-name> [-q|-v|-b] ...
+//
+//  where:
+//    -q means run quietly (only pass/fail messages printed)
+//    -v means run verbosely (all messages printed)
+//    -b also runs the large layouts and prints define time per box count
+//    ... all non-option arguments are ignored (Chombo convention)
+//
+//  Default is `-q'
+//
+
+#include <cstring>
+#include <sys/time.h>
+
+#include "parstream.H"
+#include "LoadBalance.H"
+#include "DisjointBoxLayout.H"
+#include "DataIterator.H"
+#include "LayoutIterator.H"
+#include "Copier.H"
+#include "NeighborIterator.H"
+#include "BoxBinIndex.H"
+#include "BoxIterator.H"
+#include "SPMD.H"
+
+#ifdef CH_MPI
+#include <mpi.h>
+#endif
+
+#include "UsingNamespace.H"
+
+using std::endl;
+
+void parseTestOptions(int argc, char* argv[]);
+
+static const char *pgmname = "testCopierDefine";
+static const char *indent = "   ";
+
+static bool verbose = false;
+static bool benchmark = false;
+
+static double wallTime()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + 1.0e-6*tv.tv_usec;
+}
+
+// a_nbox^SpaceDim boxes of a_bsize^SpaceDim cells tiling the domain
+static void makeGrids(DisjointBoxLayout&   a_grids,
+                      const ProblemDomain& a_domain,
+                      int                  a_nbox,
+                      int                  a_bsize)
+{
+  Vector<Box> boxes;
+  Box coarse(IntVect::Zero, (a_nbox-1)*IntVect::Unit);
+  for (BoxIterator bit(coarse); bit.ok(); ++bit)
+    {
+      Box b(bit()*a_bsize, bit()*a_bsize + (a_bsize-1)*IntVect::Unit);
+      boxes.push_back(b);
+    }
+  Vector<int> procs;
+  LoadBalance(procs, boxes);
+  a_grids.define(boxes, procs, a_domain);
+  a_grids.close();
+}
+
+static int receivedCells(const Copier& a_copier)
+{
+  return a_copier.numLocalCellsToCopy() + a_copier.numToCellsToCopy();
+}
+
+// ghost cells of the local boxes that an exchange must fill
+static int exchangeCells(const DisjointBoxLayout& a_grids,
+                         const ProblemDomain&     a_domain,
+                         const IntVect&           a_ghost)
+{
+  int count = 0;
+  for (DataIterator dit = a_grids.dataIterator(); dit.ok(); ++dit)
+    {
+      Box b = a_grids[dit];
+      Box g = grow(b, a_ghost);
+      g &= a_domain;
+      count += g.numPts() - b.numPts();
+    }
+  return count;
+}
+
+// brute-force neighbor count of a_box, periodic images included
+static int neighborCount(const DisjointBoxLayout& a_grids,
+                         const ProblemDomain&     a_domain,
+                         const LayoutIndex&       a_self)
+{
+  Box gbox = grow(a_grids[a_self], 1);
+  int count = 0;
+  ShiftIterator shiftIt = a_domain.shiftIterator();
+  for (LayoutIterator lit = a_grids.layoutIterator(); lit.ok(); ++lit)
+    {
+      const Box& b = a_grids[lit];
+      if (lit() != a_self && gbox.intersectsNotEmpty(b)) count++;
+      for (shiftIt.begin(); shiftIt.ok(); ++shiftIt)
+        {
+          Box sb(b);
+          a_domain.shiftIt(sb, shiftIt.index());
+          if (gbox.intersectsNotEmpty(sb)) count++;
+        }
+    }
+  return count;
+}
+
+int checkLayouts(int a_nbox, int a_bsize)
+{
+  int status = 0;
+  IntVect ghost = 2*IntVect::Unit;
+  Box domBox(IntVect::Zero, (a_nbox*a_bsize-1)*IntVect::Unit);
+  ProblemDomain domain(domBox);
+  bool isPeriodic[SpaceDim];
+  for (int dir=0; dir<SpaceDim; dir++) isPeriodic[dir] = true;
+  ProblemDomain periodicDomain(domBox, isPeriodic);
+
+  DisjointBoxLayout grids, periodicGrids, fineSplit;
+  makeGrids(grids, domain, a_nbox, a_bsize);
+  makeGrids(periodicGrids, periodicDomain, a_nbox, a_bsize);
+  makeGrids(fineSplit, domain, 2*a_nbox, a_bsize/2);
+
+  Copier exchangeCopier(grids, grids, domain, ghost, true);
+  if (receivedCells(exchangeCopier) != exchangeCells(grids, domain, ghost))
+    {
+      if (verbose) pout() << indent << "bad exchange copier, nbox = " << a_nbox << endl;
+      status += 1;
+    }
+
+  Copier periodicCopier(periodicGrids, periodicGrids, periodicDomain, ghost, true);
+  int expected = exchangeCells(periodicGrids, periodicDomain, ghost);
+  if (receivedCells(periodicCopier) != expected)
+    {
+      if (verbose) pout() << indent << "bad periodic copier, nbox = " << a_nbox << endl;
+      status += 10;
+    }
+
+  Copier neighborCopier;
+  neighborCopier.exchangeDefine(periodicGrids, ghost);
+  if (receivedCells(neighborCopier) != expected)
+    {
+      if (verbose) pout() << indent << "bad exchangeDefine copier, nbox = " << a_nbox << endl;
+      status += 100;
+    }
+
+  Copier copyCopier(grids, fineSplit, domain);
+  int fineCells = 0;
+  for (DataIterator dit = fineSplit.dataIterator(); dit.ok(); ++dit)
+    {
+      fineCells += fineSplit[dit].numPts();
+    }
+  if (receivedCells(copyCopier) != fineCells)
+    {
+      if (verbose) pout() << indent << "bad copy copier, nbox = " << a_nbox << endl;
+      status += 1000;
+    }
+
+  for (DataIterator dit = periodicGrids.dataIterator(); dit.ok(); ++dit)
+    {
+      int count = 0;
+      NeighborIterator nit(periodicGrids);
+      for (nit.begin(dit()); nit.ok(); ++nit)
+        {
+          count++;
+        }
+      if (count != neighborCount(periodicGrids, periodicDomain, dit()))
+        {
+          if (verbose) pout() << indent << "bad neighbor list for " << periodicGrids[dit] << endl;
+          status += 10000;
+          break;
+        }
+    }
+  return status;
+}
+
+// one box as large as a quarter of the domain among a_nbox^SpaceDim small
+// ones: every query must find what a box-by-box search finds
+int checkMixedSizes(int a_nbox, int a_bsize)
+{
+  Vector<Box> boxes;
+  int half = a_nbox*a_bsize/2;
+  Box big(IntVect::Zero, (half-1)*IntVect::Unit);
+  boxes.push_back(big);
+  Box coarse(IntVect::Zero, (a_nbox-1)*IntVect::Unit);
+  for (BoxIterator bit(coarse); bit.ok(); ++bit)
+    {
+      Box b(bit()*a_bsize, bit()*a_bsize + (a_bsize-1)*IntVect::Unit);
+      if (!b.intersectsNotEmpty(big)) boxes.push_back(b);
+    }
+
+  BoxBinIndex index(boxes);
+  Vector<int> ids;
+  Box queries(-IntVect::Unit, a_nbox*IntVect::Unit);
+  for (BoxIterator bit(queries); bit.ok(); ++bit)
+    {
+      Box region(bit()*a_bsize - IntVect::Unit, bit()*a_bsize + a_bsize*IntVect::Unit);
+      index.intersecting(ids, region);
+      Vector<int> expected;
+      for (int i = 0; i < boxes.size(); i++)
+        {
+          if (boxes[i].intersectsNotEmpty(region)) expected.push_back(i);
+        }
+      if (ids.stdVector() != expected.stdVector())
+        {
+          if (verbose) pout() << indent << "bad index query " << region << endl;
+          return 100000;
+        }
+    }
+  return 0;
+}
+
+void timeLayouts(int a_nbox, int a_bsize)
+{
+  IntVect ghost = IntVect::Unit;
+  Box domBox(IntVect::Zero, (a_nbox*a_bsize-1)*IntVect::Unit);
+  bool isPeriodic[SpaceDim];
+  for (int dir=0; dir<SpaceDim; dir++) isPeriodic[dir] = true;
+  ProblemDomain domain(domBox, isPeriodic);
+
+  double t0 = wallTime();
+  DisjointBoxLayout grids;
+  makeGrids(grids, domain, a_nbox, a_bsize);
+  double t1 = wallTime();
+  Copier copier(grids, grids, domain, ghost, true);
+  double t2 = wallTime();
+
+  pout() << indent << "boxes = " << grids.size()
+         << "  layout+neighbors = " << t1 - t0 << " s"
+         << "  Copier::define = " << t2 - t1 << " s" << endl;
+}
+
+int
+main(int argc ,char* argv[])
+{
+#ifdef CH_MPI
+  MPI_Init(&argc, &argv);
+#endif
+  parseTestOptions(argc, argv);
+
+  int status = 0;
+  for (int nbox = 4; nbox <= 16; nbox *= 2)
+    {
+      status += checkLayouts(nbox, 8);
+      status += checkMixedSizes(nbox, 8);
+    }
+
+  if (benchmark)
+    {
+      int maxBox = (SpaceDim == 3) ? 32 : 256;
+      for (int nbox = 8; nbox <= maxBox; nbox *= 2)
+        {
+          timeLayouts(nbox, 8);
+        }
+    }
+
+  pout() << indent << pgmname << ": "
+         << ( (status == 0) ? "passed all tests" : "failed at least one test,")
+         << endl;
+
+#ifdef CH_MPI
+  MPI_Finalize();
+#endif
+  return status;
+}
+
+///
+// Parse the standard test options (-v -q) and -b out of the command line.
+// Stop parsing when a non-option argument is found.
+///
+void
+parseTestOptions( int argc ,char* argv[] )
+{
+  for ( int i = 1 ; i < argc ; ++i )
+    {
+      if ( argv[i][0] == '-' ) //if it is an option
+        {
+          // compare 3 chars to differentiate -x from -xx
+          if ( strncmp( argv[i] ,"-v" ,3 ) == 0 )
+            {
+              verbose = true ;
+            }
+          else if ( strncmp( argv[i] ,"-q" ,3 ) == 0 )
+            {
+              verbose = false ;
+            }
+          else if ( strncmp( argv[i] ,"-b" ,3 ) == 0 )
+            {
+              benchmark = true ;
+            }
+          else
+            {
+              break ;
+            }
+        }
+    }
+  return ;
+}
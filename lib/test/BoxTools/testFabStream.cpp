@@ -0,0 +1,305 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+// Purpose:
+//  STREAM-like copy, scale, add and triad over LevelData<FArrayBox>, run
+//  with the FArrayBox arena's placement policies off, with first touch,
+//  and with first touch and huge pages.  Checks the results of every
+//  policy and, with -b, times a large problem and prints the bandwidth.
+//
+//  The data is initialized in a serial loop, as code that does a setVal
+//  over the DataIterator after define would; without first touch this
+//  leaves every page with the thread (and socket) that ran that loop.
+//  Run with OMP_NUM_THREADS set to the cores of both sockets to see the
+//  difference.
+//
+// Usage:
+//  <program-name> [-q|-v|-b] ...
+//
+//  where:
+//    -q means run quietly (only pass/fail messages printed)
+//    -v means run verbosely (all messages printed)
+//    -b also runs the large problem and prints the bandwidth of each kernel
+//    ... all non-option arguments are ignored (Chombo convention)
+//
+//  Default is `-q'
+//
+
+#include <cstring>
+#include <cmath>
+#include <sys/time.h>
+
+#include "parstream.H"
+#include "LoadBalance.H"
+#include "BRMeshRefine.H"
+#include "DisjointBoxLayout.H"
+#include "LevelData.H"
+#include "FArrayBox.H"
+#include "Arena.H"
+#include "SPMD.H"
+
+#ifdef CH_MPI
+#include <mpi.h>
+#endif
+
+#include "UsingNamespace.H"
+
+using std::endl;
+
+void parseTestOptions(int argc, char* argv[]);
+
+static const char *pgmname = "testFabStream";
+static const char *indent = "   ";
+
+static bool verbose = false;
+static bool benchmark = false;
+
+static const Real s_scalar = 3.0;
+
+static double wallTime()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + 1.0e-6*tv.tv_usec;
+}
+
+// a_nbox^SpaceDim boxes of a_bsize^SpaceDim cells
+static void makeGrids(DisjointBoxLayout& a_grids,
+                      int                a_nbox,
+                      int                a_bsize)
+{
+  Box domain(IntVect::Zero, (a_nbox*a_bsize-1)*IntVect::Unit);
+  Vector<Box> boxes;
+  domainSplit(domain, boxes, a_bsize, a_bsize);
+  Vector<int> procs;
+  LoadBalance(procs, boxes);
+  a_grids.define(boxes, procs);
+}
+
+enum Kernel
+{
+  Copy = 0,
+  Scale,
+  Add,
+  Triad,
+  NumKernels
+};
+
+static const char* kernelNames[NumKernels] = {"Copy", "Scale", "Add", "Triad"};
+// arrays each kernel reads or writes
+static const int kernelArrays[NumKernels] = {2, 2, 3, 3};
+
+// one STREAM kernel over every box, threaded over boxes like the solvers
+static void runKernel(Kernel                a_kernel,
+                      LevelData<FArrayBox>& a_a,
+                      LevelData<FArrayBox>& a_b,
+                      LevelData<FArrayBox>& a_c)
+{
+  DataIterator dit = a_a.dataIterator();
+  int nbox = dit.size();
+#pragma omp parallel for
+  for (int ibox = 0; ibox < nbox; ibox++)
+    {
+      Real* a = a_a[dit[ibox]].dataPtr();
+      Real* b = a_b[dit[ibox]].dataPtr();
+      Real* c = a_c[dit[ibox]].dataPtr();
+      long n = a_a[dit[ibox]].box().numPts()*a_a.nComp();
+      switch (a_kernel)
+        {
+        case Copy:
+          for (long i = 0; i < n; i++) c[i] = a[i];
+          break;
+        case Scale:
+          for (long i = 0; i < n; i++) b[i] = s_scalar*c[i];
+          break;
+        case Add:
+          for (long i = 0; i < n; i++) c[i] = a[i] + b[i];
+          break;
+        case Triad:
+          for (long i = 0; i < n; i++) a[i] = b[i] + s_scalar*c[i];
+          break;
+        default:
+          break;
+        }
+    }
+}
+
+// max over all cells of |a_data - a_value|
+static Real maxError(const LevelData<FArrayBox>& a_data, Real a_value)
+{
+  Real err = 0;
+  for (DataIterator dit = a_data.dataIterator(); dit.ok(); ++dit)
+    {
+      const FArrayBox& fab = a_data[dit];
+      err = Max(err, Abs(fab.max() - a_value));
+      err = Max(err, Abs(fab.min() - a_value));
+    }
+  return err;
+}
+
+// set the arena's policy, run a_ntimes rounds of the four kernels and
+// check the result; with a_report, print the best bandwidth of each
+static int runStream(const DisjointBoxLayout& a_grids,
+                     bool                     a_firstTouch,
+                     size_t                   a_hugePages,
+                     int                      a_ntimes,
+                     bool                     a_report)
+{
+  PArena* fabArena = dynamic_cast<PArena*>(FArrayBox::arena());
+  if (fabArena == NULL)
+    {
+      pout() << indent << "FArrayBox data does not come from a PArena" << endl;
+      return 1;
+    }
+  // new blocks for every policy
+  fabArena->release();
+  fabArena->firstTouch(a_firstTouch);
+  fabArena->hugePages(a_hugePages);
+
+  int status = 0;
+  {
+    LevelData<FArrayBox> a(a_grids, 1);
+    LevelData<FArrayBox> b(a_grids, 1);
+    LevelData<FArrayBox> c(a_grids, 1);
+    for (DataIterator dit = a_grids.dataIterator(); dit.ok(); ++dit)
+      {
+        a[dit].setVal(1.0);
+        b[dit].setVal(2.0);
+        c[dit].setVal(0.0);
+      }
+
+    double best[NumKernels];
+    for (int k = 0; k < NumKernels; k++) best[k] = 1.0e30;
+    Real aj = 1.0, bj = 2.0, cj = 0.0;
+    for (int it = 0; it < a_ntimes; it++)
+      {
+        for (int k = 0; k < NumKernels; k++)
+          {
+            double t0 = wallTime();
+            runKernel((Kernel)k, a, b, c);
+            double t = wallTime() - t0;
+            if (it > 0 && t < best[k]) best[k] = t;
+          }
+        cj = aj;
+        bj = s_scalar*cj;
+        cj = aj + bj;
+        aj = bj + s_scalar*cj;
+      }
+
+    Real tol = 1.0e-12*Abs(aj);
+    Real err = Max(maxError(a, aj), Max(maxError(b, bj), maxError(c, cj)));
+    if (err > tol)
+      {
+        if (verbose) pout() << indent << "firstTouch = " << a_firstTouch
+                            << " hugePages = " << a_hugePages
+                            << ": error " << err << endl;
+        status = 1;
+      }
+
+    if (a_report)
+      {
+        long cells = 0;
+        for (DataIterator dit = a_grids.dataIterator(); dit.ok(); ++dit)
+          {
+            cells += a_grids[dit].numPts();
+          }
+        pout() << indent << "firstTouch = " << a_firstTouch
+               << "  hugePages = " << (a_hugePages > 0) << endl;
+        for (int k = 0; k < NumKernels; k++)
+          {
+            double bytes = kernelArrays[k]*sizeof(Real)*(double)cells;
+            pout() << indent << indent << kernelNames[k] << ": "
+                   << 1.0e-9*bytes/best[k] << " GB/s" << endl;
+          }
+      }
+  }
+
+  fabArena->firstTouch(false);
+  fabArena->hugePages(0);
+  return status;
+}
+
+int
+main(int argc ,char* argv[])
+{
+#ifdef CH_MPI
+  MPI_Init(&argc, &argv);
+#endif
+  parseTestOptions(argc, argv);
+
+  int status = 0;
+  {
+    DisjointBoxLayout grids;
+    makeGrids(grids, 4, 16);
+    status += runStream(grids, false, 0, 3, verbose);
+    status += 10*runStream(grids, true, 0, 3, verbose);
+    // small huge-page threshold so the small test takes that path too
+    status += 100*runStream(grids, true, 1024, 3, verbose);
+  }
+
+  if (benchmark)
+    {
+      // about 32MB per array
+      DisjointBoxLayout grids;
+      if (SpaceDim == 3)
+        {
+          makeGrids(grids, 5, 32);
+        }
+      else
+        {
+          makeGrids(grids, 32, 64);
+        }
+      runStream(grids, false, 0, 10, true);
+      runStream(grids, true, 0, 10, true);
+      runStream(grids, true, PArena::HugePageSize, 10, true);
+    }
+
+  pout() << indent << pgmname << ": "
+         << ( (status == 0) ? "passed all tests" : "failed at least one test,")
+         << endl;
+
+#ifdef CH_MPI
+  MPI_Finalize();
+#endif
+  return status;
+}
+
+///
+// Parse the standard test options (-v -q) and -b out of the command line.
+// Stop parsing when a non-option argument is found.
+///
+void
+parseTestOptions( int argc ,char* argv[] )
+{
+  for ( int i = 1 ; i < argc ; ++i )
+    {
+      if ( argv[i][0] == '-' ) //if it is an option
+        {
+          // compare 3 chars to differentiate -x from -xx
+          if ( strncmp( argv[i] ,"-v" ,3 ) == 0 )
+            {
+              verbose = true ;
+            }
+          else if ( strncmp( argv[i] ,"-q" ,3 ) == 0 )
+            {
+              verbose = false ;
+            }
+          else if ( strncmp( argv[i] ,"-b" ,3 ) == 0 )
+            {
+              benchmark = true ;
+            }
+          else
+            {
+              break ;
+            }
+        }
+    }
+  return ;
+}
@@ -15,6 +15,7 @@
 // Test 1: single level, small number of loads.
 // Test 2: single level, large number of loads.
 // Test 3: single level, loads from Brian's HDF test code
+// Test 5: two levels, space-filling-curve and graph modes against greedy
 
 #include <limits.h>
 
@@ -22,6 +23,7 @@
 
 #include "SPMD.H"  // to get num_procs global variable
 #include "LoadBalance.H"
+#include "BoxIterator.H"
 #include "Misc.H"
 #include "parstream.H"
 #include "UsingNamespace.H"
@@ -35,6 +37,10 @@ int
 testLB3(void);
 int
 testLB4(void);
+int
+testLB5(void);
+int
+testLB6(void);
 
 using std::endl;
 
@@ -107,6 +113,30 @@ main(int argc ,char* argv[])
     stat_all = status ;
   }
 
+  status = testLB5();
+
+  if ( status == 0 )
+  {
+    if ( verbose ) pout() << indent << pgmname << " passed test 5." << endl ;
+  }
+  else
+  {
+    pout() << indent << pgmname << " failed test 5 with return code " << status << endl ;
+    stat_all = status ;
+  }
+
+  status = testLB6();
+
+  if ( status == 0 )
+  {
+    if ( verbose ) pout() << indent << pgmname << " passed test 6." << endl ;
+  }
+  else
+  {
+    pout() << indent << pgmname << " failed test 6 with return code " << status << endl ;
+    stat_all = status ;
+  }
+
   if ( stat_all == 0 )
     pout() << indent << pgmname << ": passed all tests." << endl ;
   else
@@ -997,6 +1027,189 @@ testLB4()
   return 0 ;
 }
 
+int
+testLB5()
+{
+  // level 0: 16x16 boxes of 8^D cells; level 1: the refined middle half,
+  // in boxes of 16^D fine cells
+  const int numProcs = 8 ;
+  Vector<Vector<Box> > grids( 2 ) ;
+  Box coarse( IntVect::Zero ,15*IntVect::Unit ) ;
+  for ( BoxIterator bit( coarse ) ; bit.ok() ; ++bit )
+    {
+      grids[0].push_back( Box( bit()*8 ,bit()*8 + 7*IntVect::Unit ) ) ;
+    }
+  Box fine( IntVect::Zero ,7*IntVect::Unit ) ;
+  for ( BoxIterator bit( fine ) ; bit.ok() ; ++bit )
+    {
+      IntVect lo = 64*IntVect::Unit + bit()*16 ;
+      grids[1].push_back( Box( lo ,lo + 15*IntVect::Unit ) ) ;
+    }
+  Vector<Vector<long> > loads( 2 ) ;
+  for ( int lvl=0 ; lvl<2 ; ++lvl )
+    {
+      for ( int i=0 ; i<grids[lvl].size() ; ++i )
+        {
+          loads[lvl].push_back( grids[lvl][i].numPts() ) ;
+        }
+    }
+  Vector<int> refratios( 2 ,2 ) ;
+
+  const LoadBalanceMode modes[4] = { LB_GREEDY ,LB_MORTON ,LB_HILBERT ,LB_GRAPH } ;
+  const char* names[4] = { "greedy" ,"morton" ,"hilbert" ,"graph" } ;
+  long long cut[4] ;
+  for ( int m=0 ; m<4 ; ++m )
+    {
+      Vector<Vector<int> > assignments ;
+      Real eff_ratio ;
+      int status = LoadBalance( assignments ,eff_ratio ,cut[m] ,grids ,loads ,refratios
+                                ,modes[m] ,1 ,numProcs ) ;
+      if ( status != 0 ) return status ;
+      if ( verbose )
+        pout() << indent2 << "test5: " << names[m] << ", efficiency "
+               << (int)(eff_ratio*100.0) << "%, edge cut " << cut[m] << endl ;
+      for ( int lvl=0 ; lvl<2 ; ++lvl )
+        {
+          for ( int i=0 ; i<grids[lvl].size() ; ++i )
+            {
+              if ( assignments[lvl][i] < 0 || assignments[lvl][i] >= numProcs )
+                return -521 ;
+            }
+        }
+      if ( cut[m] != LoadBalanceEdgeCut( assignments ,grids ,refratios ,1 ) )
+        return -522 ;
+      if ( eff_ratio < 0.9 )
+        return -523 ;
+    }
+  // the curve orderings should beat the locality-blind greedy assignment,
+  // and graph refinement should not make the Hilbert partition worse
+  if ( cut[2] >= cut[0] ) return -524 ;
+  if ( cut[3] >  cut[2] ) return -525 ;
+
+  // level 0 fixed on an assignment of its own: only level 1 is balanced,
+  // and the edge cut is that of the assignment level 0 really has
+  for ( int m=0 ; m<4 ; ++m )
+    {
+      Vector<Vector<int> > assignments( 1 ) ;
+      for ( int i=0 ; i<grids[0].size() ; ++i )
+        {
+          assignments[0].push_back( (i/7) % numProcs ) ;
+        }
+      Vector<int> fixed = assignments[0] ;
+      Real eff_ratio ;
+      long long fixedCut ;
+      int status = LoadBalance( assignments ,eff_ratio ,fixedCut ,grids ,loads ,refratios
+                                ,modes[m] ,1 ,numProcs ,1 ) ;
+      if ( status != 0 ) return status ;
+      if ( assignments.size() != 2 || assignments[0].stdVector() != fixed.stdVector() ) return -526 ;
+      for ( int i=0 ; i<grids[1].size() ; ++i )
+        {
+          if ( assignments[1][i] < 0 || assignments[1][i] >= numProcs )
+            return -527 ;
+        }
+      if ( fixedCut != LoadBalanceEdgeCut( assignments ,grids ,refratios ,1 ) )
+        return -528 ;
+      if ( eff_ratio < 0.9 )
+        return -529 ;
+    }
+  Vector<Vector<int> > assignments ;
+  Real eff_ratio ;
+  long long fixedCut ;
+  if ( LoadBalance( assignments ,eff_ratio ,fixedCut ,grids ,loads ,refratios
+                    ,LB_GRAPH ,1 ,numProcs ,1 ) != -1014 )
+    return -530 ;
+
+  return 0 ;
+}
+
+// largest total of a_costs over the boxes assigned to one processor
+static double
+maxProcCost( const Vector<int>& a_procs ,const Vector<double>& a_costs ,int a_numProcs )
+{
+  Vector<double> total( a_numProcs ,0.0 ) ;
+  for ( int i=0 ; i<a_procs.size() ; ++i )
+    {
+      total[a_procs[i]] += a_costs[i] ;
+    }
+  double maxCost = 0 ;
+  for ( int p=0 ; p<a_numProcs ; ++p )
+    {
+      maxCost = Max( maxCost ,total[p] ) ;
+    }
+  return maxCost ;
+}
+
+int
+testLB6()
+{
+  // measured on 2^D old boxes of 16^D cells, the first 10 times as
+  // expensive per cell as the others; mapped onto 4^D new boxes of 8^D
+  // cells over the same region plus one box nothing was measured on
+  const int numProcs = 4 ;
+  const long cells = Box( IntVect::Zero ,15*IntVect::Unit ).numPts() ;
+  Vector<Box> oldBoxes ;
+  Vector<unsigned long long> oldCosts ;
+  Box coarse( IntVect::Zero ,IntVect::Unit ) ;
+  for ( BoxIterator bit( coarse ) ; bit.ok() ; ++bit )
+    {
+      oldBoxes.push_back( Box( bit()*16 ,bit()*16 + 15*IntVect::Unit ) ) ;
+      oldCosts.push_back( (oldBoxes.size() == 1 ? 10 : 1)*100*cells ) ;
+    }
+  Vector<Box> newBoxes ;
+  Box fine( IntVect::Zero ,3*IntVect::Unit ) ;
+  for ( BoxIterator bit( fine ) ; bit.ok() ; ++bit )
+    {
+      newBoxes.push_back( Box( bit()*8 ,bit()*8 + 7*IntVect::Unit ) ) ;
+    }
+  newBoxes.push_back( Box( 32*IntVect::Unit ,39*IntVect::Unit ) ) ;
+
+  Vector<long> loads ;
+  LoadBalanceMeasuredLoads( loads ,newBoxes ,oldBoxes ,oldCosts ) ;
+  if ( loads.size() != newBoxes.size() ) return -611 ;
+
+  // the mean density is (10 + 2^D - 1)/2^D times a cheap cell's
+  double mean = (10.0 + oldBoxes.size() - 1)/oldBoxes.size() ;
+  Vector<double> trueCosts( newBoxes.size() ) ;
+  for ( int i=0 ; i<newBoxes.size() ; ++i )
+    {
+      double expected = newBoxes[i].numPts() ;
+      if ( oldBoxes[0].contains( newBoxes[i] ) )
+        expected *= 10.0/mean ;
+      else if ( i < newBoxes.size()-1 )
+        expected *= 1.0/mean ;
+      trueCosts[i] = expected ;
+      if ( Abs( loads[i] - expected ) > 1.0 )
+        {
+          if ( verbose )
+            pout() << indent2 << "test6: load " << loads[i] << " for " << newBoxes[i]
+                   << ", expected " << expected << endl ;
+          return -612 ;
+        }
+    }
+
+  // balancing on the mapped loads must beat balancing on cell counts
+  Vector<int> measuredProcs ,cellProcs ;
+  int status = LoadBalance( measuredProcs ,loads ,newBoxes ,numProcs ) ;
+  if ( status != 0 ) return status ;
+  status = LoadBalance( cellProcs ,newBoxes ,numProcs ) ;
+  if ( status != 0 ) return status ;
+  double measuredMax = maxProcCost( measuredProcs ,trueCosts ,numProcs ) ;
+  double cellMax = maxProcCost( cellProcs ,trueCosts ,numProcs ) ;
+  if ( verbose )
+    pout() << indent2 << "test6: max cost per processor " << measuredMax
+           << " balanced on measured cost, " << cellMax << " on cells" << endl ;
+  if ( measuredMax >= cellMax ) return -613 ;
+
+  // nothing measured: loads are cell counts
+  LoadBalanceMeasuredLoads( loads ,newBoxes ,oldBoxes ,Vector<unsigned long long>( oldBoxes.size() ,0 ) ) ;
+  for ( int i=0 ; i<newBoxes.size() ; ++i )
+    {
+      if ( loads[i] != newBoxes[i].numPts() ) return -614 ;
+    }
+
+  return 0 ;
+}
+
 ///
 // Parse the standard test options (-v -q) out of the command line.
 ///
@@ -0,0 +1,272 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+// Purpose:
+//  Check BRMeshRefine with distributed tags (MeshRefine::setDistributedTags)
+//  against the default gather-everything regrid, and time both.  The tags
+//  are the finest-level boxes saved in meshRefineTest.<DIM>d.H5 (or a ring
+//  of tags if HDF5 is not available), tiled over the domain and spread
+//  over the processors.
+//
+// Usage:
+//  <program-name> [-q|-v|-b] ...
+//
+//  where:
+//    -q means run quietly (only pass/fail messages printed)
+//    -v means run verbosely (all messages printed)
+//    -b also tiles the tags over larger domains and prints regrid times
+//    ... all non-option arguments are ignored (Chombo convention)
+//
+//  Default is `-q'
+//
+
+#include <cstring>
+#include <cstdio>
+#include <sys/time.h>
+
+#include "parstream.H"
+#include "BRMeshRefine.H"
+#include "BoxBinIndex.H"
+#include "BoxIterator.H"
+#include "SPMD.H"
+#include "CH_HDF5.H"
+
+#ifdef CH_MPI
+#include <mpi.h>
+#endif
+
+#include "UsingNamespace.H"
+
+using std::endl;
+
+void parseTestOptions(int argc, char* argv[]);
+
+static const char *pgmname = "testMeshRefineDistributed";
+static const char *indent = "   ";
+
+static bool verbose = false;
+static bool benchmark = false;
+
+static double wallTime()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + 1.0e-6*tv.tv_usec;
+}
+
+// the tag pattern: boxes of the finest level in the saved meshRefineTest file
+static void patternBoxes(Vector<Box>& a_pattern)
+{
+  a_pattern.resize(0);
+#ifdef CH_USE_HDF5
+  char fileName[100];
+#ifdef CH_USE_FLOAT
+  sprintf(fileName, "meshRefineTest.%dd.FLOAT.H5", SpaceDim);
+#else
+  sprintf(fileName, "meshRefineTest.%dd.H5", SpaceDim);
+#endif
+  FILE* test = fopen(fileName, "r");
+  if (test != NULL)
+    {
+      fclose(test);
+      HDF5Handle handle;
+      if (handle.open(fileName, HDF5Handle::OPEN_RDONLY) == 0)
+        {
+          Vector<Vector<Box> > levels;
+          readBoxes(handle, levels);
+          handle.close();
+          if (levels.size() > 0) a_pattern = levels[levels.size()-1];
+        }
+    }
+#endif
+  if (a_pattern.size() == 0)
+    {
+      // a ring of thickness 2 and radius 6 around (10,10,...)
+      for (BoxIterator bit(Box(IntVect::Zero, 19*IntVect::Unit)); bit.ok(); ++bit)
+        {
+          IntVect d = bit() - 10*IntVect::Unit;
+          int r2 = 0;
+          for (int idir = 0; idir < SpaceDim; idir++) r2 += d[idir]*d[idir];
+          if (r2 >= 25 && r2 <= 49) a_pattern.push_back(Box(bit(), bit()));
+        }
+    }
+}
+
+// the pattern tiled a_ntile times in each direction; each processor gets
+// the tags of every numProc()-th pattern box
+static void makeTags(IntVectSet&        a_localTags,
+                     IntVectSet&        a_allTags,
+                     Box&               a_domain,
+                     const Vector<Box>& a_pattern,
+                     int                a_ntile)
+{
+  int hi = 0;
+  for (int i = 0; i < a_pattern.size(); i++)
+    {
+      for (int idir = 0; idir < SpaceDim; idir++) hi = Max(hi, a_pattern[i].bigEnd(idir));
+    }
+  int period = 8*(hi/8 + 2);
+  a_domain = Box(IntVect::Zero, (a_ntile*period - 1)*IntVect::Unit);
+
+  a_localTags.makeEmpty();
+  a_allTags.makeEmpty();
+  int ibox = 0;
+  for (BoxIterator tit(Box(IntVect::Zero, (a_ntile-1)*IntVect::Unit)); tit.ok(); ++tit)
+    {
+      for (int i = 0; i < a_pattern.size(); i++, ibox++)
+        {
+          Box b = a_pattern[i] + tit()*period;
+          b &= a_domain;
+          if (ibox % numProc() == procID()) a_localTags |= b;
+          a_allTags |= b;
+        }
+    }
+}
+
+static int regridTags(Vector<Box>&      a_boxes,
+                      double&           a_time,
+                      const IntVectSet& a_localTags,
+                      const Box&        a_domain,
+                      bool              a_distributed)
+{
+  Vector<int> refRatios(2, 2);
+  BRMeshRefine meshRefine(a_domain, refRatios, 0.75, 2, 1, 32);
+  meshRefine.setDistributedTags(a_distributed);
+
+  Vector<Vector<Box> > oldMeshes(2);
+  oldMeshes[0].push_back(a_domain);
+  oldMeshes[1].push_back(refine(a_domain, 2));
+  Vector<IntVectSet> tags(1, a_localTags);
+  Vector<Vector<Box> > newMeshes;
+#ifdef CH_MPI
+  MPI_Barrier(Chombo_MPI::comm);
+#endif
+  double t0 = wallTime();
+  int finest = meshRefine.regrid(newMeshes, tags, 0, 0, oldMeshes);
+  a_time = wallTime() - t0;
+  a_boxes.resize(0);
+  if (finest == 1) a_boxes = newMeshes[1];
+  return finest;
+}
+
+// every tag is covered and no two boxes overlap
+static int checkBoxes(const Vector<Box>& a_boxes, const IntVectSet& a_allTags)
+{
+  BoxBinIndex index(a_boxes);
+  Vector<int> ids;
+  for (int i = 0; i < a_boxes.size(); i++)
+    {
+      index.intersecting(ids, a_boxes[i]);
+      if (ids.size() != 1) return 1;
+    }
+  Vector<Box> coarse(a_boxes);
+  for (int i = 0; i < coarse.size(); i++) coarse[i].coarsen(2);
+  BoxBinIndex coarseIndex(coarse);
+  for (IVSIterator it(a_allTags); it.ok(); ++it)
+    {
+      coarseIndex.intersecting(ids, Box(it(), it()));
+      if (ids.size() == 0) return 2;
+    }
+  return 0;
+}
+
+int
+main(int argc ,char* argv[])
+{
+#ifdef CH_MPI
+  MPI_Init(&argc, &argv);
+#endif
+  parseTestOptions(argc, argv);
+
+  int status = 0;
+  Vector<Box> pattern;
+  patternBoxes(pattern);
+
+  int maxTile = benchmark ? ((SpaceDim == 3) ? 8 : 32) : 2;
+  for (int ntile = 1; ntile <= maxTile; ntile *= 2)
+    {
+      IntVectSet localTags, allTags;
+      Box domain;
+      makeTags(localTags, allTags, domain, pattern, ntile);
+
+      Vector<Box> gathered, distributed;
+      double tGathered, tDistributed;
+      regridTags(gathered, tGathered, localTags, domain, false);
+      regridTags(distributed, tDistributed, localTags, domain, true);
+
+      int err = checkBoxes(distributed, allTags);
+      if (err != 0)
+        {
+          if (verbose) pout() << indent << "bad distributed boxes (" << err
+                              << "), tiles = " << ntile << endl;
+          status += 10*err;
+        }
+      bool same = (distributed.size() == gathered.size());
+      for (int i = 0; same && i < gathered.size(); i++)
+        {
+          same = (distributed[i] == gathered[i]);
+        }
+      if (numProc() == 1 && !same)
+        {
+          if (verbose) pout() << indent << "serial distributed boxes differ, tiles = "
+                              << ntile << endl;
+          status += 100;
+        }
+      if (verbose || benchmark)
+        {
+          pout() << indent << "tags = " << allTags.numPts()
+                 << "  gathered: " << gathered.size() << " boxes, " << tGathered << " s"
+                 << "  distributed: " << distributed.size() << " boxes, " << tDistributed << " s"
+                 << endl;
+        }
+    }
+
+  pout() << indent << pgmname << ": "
+         << ( (status == 0) ? "passed all tests" : "failed at least one test,")
+         << endl;
+
+#ifdef CH_MPI
+  MPI_Finalize();
+#endif
+  return status;
+}
+
+///
+// Parse the standard test options (-v -q) and -b out of the command line.
+// Stop parsing when a non-option argument is found.
+///
+void
+parseTestOptions( int argc ,char* argv[] )
+{
+  for ( int i = 1 ; i < argc ; ++i )
+    {
+      if ( argv[i][0] == '-' ) //if it is an option
+        {
+          // compare 3 chars to differentiate -x from -xx
+          if ( strncmp( argv[i] ,"-v" ,3 ) == 0 )
+            {
+              verbose = true ;
+            }
+          else if ( strncmp( argv[i] ,"-q" ,3 ) == 0 )
+            {
+              verbose = false ;
+            }
+          else if ( strncmp( argv[i] ,"-b" ,3 ) == 0 )
+            {
+              benchmark = true ;
+            }
+          else
+            {
+              break ;
+            }
+        }
+    }
+  return ;
+}
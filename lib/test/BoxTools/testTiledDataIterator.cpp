@@ -0,0 +1,169 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+// Purpose:
+//  Check that the tiles of a TiledDataIterator cover each local box (grown
+//  by the ghost vector) exactly once, are no larger than the tile size and
+//  start at the box's low corner plus multiples of the tile size.
+//
+// Usage:
+//  <program-name> [-q|-v] ...
+//
+//  where:
+//    -q means run quietly (only pass/fail messages printed)
+//    -v means run verbosely (all messages printed)
+//    ... all non-option arguments are ignored (Chombo convention)
+//
+//  Default is `-q'
+//
+
+#include <cstring>
+
+#include "parstream.H"
+#include "LoadBalance.H"
+#include "DisjointBoxLayout.H"
+#include "LevelData.H"
+#include "FArrayBox.H"
+#include "TiledDataIterator.H"
+#include "BoxIterator.H"
+#include "SPMD.H"
+
+#ifdef CH_MPI
+#include <mpi.h>
+#endif
+
+#include "UsingNamespace.H"
+
+using std::endl;
+
+void parseTestOptions(int argc, char* argv[]);
+
+static const char *pgmname = "testTiledDataIterator";
+static const char *indent = "   ";
+
+static bool verbose = false;
+
+int checkTiles(const DisjointBoxLayout& a_grids,
+               const IntVect&           a_ghost,
+               const IntVect&           a_tileSize)
+{
+  int status = 0;
+  LevelData<FArrayBox> count(a_grids, 1, a_ghost);
+  for (DataIterator dit = a_grids.dataIterator(); dit.ok(); ++dit)
+    {
+      count[dit].setVal(0.0);
+    }
+
+  TiledDataIterator tit(a_grids, a_ghost, a_tileSize);
+  for (tit.begin(); tit.ok(); ++tit)
+    {
+      const Box& tile = tit.tile();
+      Box grown = grow(a_grids[tit()], a_ghost);
+      if (!grown.contains(tile))
+        {
+          if (verbose) pout() << indent << "tile " << tile << " outside " << grown << endl;
+          status |= 1;
+          continue;
+        }
+      for (int idir = 0; idir < SpaceDim; idir++)
+        {
+          if (tile.size(idir) > a_tileSize[idir] ||
+              (tile.smallEnd(idir) - grown.smallEnd(idir)) % a_tileSize[idir] != 0)
+            {
+              if (verbose) pout() << indent << "bad tile " << tile << " of " << grown << endl;
+              status |= 2;
+            }
+        }
+      count[tit()].plus(1.0, tile, 0, 1);
+    }
+
+  for (DataIterator dit = a_grids.dataIterator(); dit.ok(); ++dit)
+    {
+      const FArrayBox& fab = count[dit];
+      if (fab.min() != 1.0 || fab.max() != 1.0)
+        {
+          if (verbose) pout() << indent << "tiles do not cover " << fab.box() << " once" << endl;
+          status |= 4;
+        }
+    }
+
+  // tiles by position are the tiles by iteration
+  int i = 0;
+  for (tit.begin(); tit.ok(); ++tit, ++i)
+    {
+      if (tit[i] != tit() || tit.tile(i) != tit.tile()) status |= 8;
+    }
+  if (i != tit.size()) status |= 8;
+
+  return status;
+}
+
+int
+main(int argc ,char* argv[])
+{
+#ifdef CH_MPI
+  MPI_Init(&argc, &argv);
+#endif
+  parseTestOptions(argc, argv);
+
+  // boxes of several sizes, some not multiples of the tile size
+  Vector<Box> boxes;
+  boxes.push_back(Box(IntVect::Zero, 31*IntVect::Unit));
+  boxes.push_back(Box(32*BASISV(0), 32*BASISV(0) + 12*IntVect::Unit));
+  boxes.push_back(Box(64*BASISV(0), 64*BASISV(0) + 4*IntVect::Unit));
+  boxes.push_back(Box(96*BASISV(0) + 3*IntVect::Unit, 96*BASISV(0) + 40*IntVect::Unit));
+  Vector<int> procs;
+  LoadBalance(procs, boxes);
+  DisjointBoxLayout grids(boxes, procs);
+
+  int status = 0;
+  status += checkTiles(grids, IntVect::Zero, TiledDataIterator::s_tileSize);
+  status += 10*checkTiles(grids, IntVect::Unit, TiledDataIterator::s_tileSize);
+  status += 100*checkTiles(grids, 2*IntVect::Unit, 4*IntVect::Unit);
+  status += 1000*checkTiles(grids, IntVect::Zero, 7*IntVect::Unit);
+
+  pout() << indent << pgmname << ": "
+         << ( (status == 0) ? "passed all tests" : "failed at least one test,")
+         << endl;
+
+#ifdef CH_MPI
+  MPI_Finalize();
+#endif
+  return status;
+}
+
+///
+// Parse the standard test options (-v -q) out of the command line.
+// Stop parsing when a non-option argument is found.
+///
+void
+parseTestOptions( int argc ,char* argv[] )
+{
+  for ( int i = 1 ; i < argc ; ++i )
+    {
+      if ( argv[i][0] == '-' ) //if it is an option
+        {
+          // compare 3 chars to differentiate -x from -xx
+          if ( strncmp( argv[i] ,"-v" ,3 ) == 0 )
+            {
+              verbose = true ;
+            }
+          else if ( strncmp( argv[i] ,"-q" ,3 ) == 0 )
+            {
+              verbose = false ;
+            }
+          else
+            {
+              break ;
+            }
+        }
+    }
+  return ;
+}
@@ -0,0 +1,327 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+// Purpose:
+//  Check EBStencilCache through EBAMRPoissonOp: a second operator on the
+//  same grids builds no stencils, an operator after a regrid builds only
+//  the stencils of the boxes that changed, operators that take their
+//  stencils from the cache apply and relax exactly as operators that
+//  build them, and clearing the index space drops its entries.  Also
+//  check that keys with the same hash but different versions do not
+//  match, and that the cache keeps under s_maxBytes.
+
+#include <cmath>
+
+#include "EBIndexSpace.H"
+#include "EBISLayout.H"
+#include "EBCellFAB.H"
+#include "EBCellFactory.H"
+#include "EBLevelGrid.H"
+#include "EBStencilCache.H"
+#include "BoxIterator.H"
+#include "VoFIterator.H"
+#include "GeometryShop.H"
+#include "SphereIF.H"
+#include "BRMeshRefine.H"
+#include "LoadBalance.H"
+#include "DirichletPoissonDomainBC.H"
+#include "DirichletPoissonEBBC.H"
+#include "EBAMRPoissonOp.H"
+#include "EBAMRPoissonOpFactory.H"
+#include "GeometryHash.H"
+
+#include "UsingNamespace.H"
+
+static const int nCells = 32;
+static const int maxBoxSize = 8;
+
+// a smooth value for every vof
+Real vofValue(const VolIndex& a_vof)
+{
+  const IntVect& iv = a_vof.gridIndex();
+  Real retval = 0.25*a_vof.cellIndex();
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      retval += sin(0.2*(idir + 1)*iv[idir]);
+    }
+  return retval;
+}
+
+// the grids of a_boxes on the finest level of a_ebis
+EBLevelGrid makeLevelGrid(const Vector<Box>&  a_boxes,
+                          const EBIndexSpace& a_ebis)
+{
+  ProblemDomain domain = a_ebis.getBox(0);
+  Vector<int> procs;
+  LoadBalance(procs, a_boxes);
+  DisjointBoxLayout grids(a_boxes, procs, domain);
+  return EBLevelGrid(grids, domain, 4, &a_ebis);
+}
+
+// apply a new operator on a_eblg to the vof values and relax with it.
+// returns the number of cache misses its definition made.
+long applyAndRelax(LevelData<EBCellFAB>& a_lph,
+                   LevelData<EBCellFAB>& a_phi,
+                   const EBLevelGrid&    a_eblg)
+{
+  const DisjointBoxLayout& grids = a_eblg.getDBL();
+  Real dx = 1.0/nCells;
+  Vector<EBLevelGrid> eblgs(1, a_eblg);
+  Vector<int> refRatio(1, 2);
+  Vector<RefCountedPtr<EBQuadCFInterp> > quadCFI(1);
+
+  DirichletPoissonDomainBCFactory* domDirBC = new DirichletPoissonDomainBCFactory();
+  domDirBC->setValue(1.0);
+  RefCountedPtr<BaseDomainBCFactory> domBC(domDirBC);
+  DirichletPoissonEBBCFactory* ebDirBC = new DirichletPoissonEBBCFactory();
+  ebDirBC->setValue(2.0);
+  RefCountedPtr<BaseEBBCFactory> ebBC(ebDirBC);
+
+  int relaxType = 1;
+  EBAMRPoissonOpFactory opFact(eblgs, refRatio, quadCFI, dx*RealVect::Unit, RealVect::Zero,
+                               4, relaxType, domBC, ebBC, 0.0, 1.0, 0.0,
+                               IntVect::Unit, IntVect::Zero);
+
+  long missesBefore = EBStencilCache::numMisses();
+  EBAMRPoissonOp* opPtr = opFact.AMRnewOp(a_eblg.getDomain());
+  long misses = EBStencilCache::numMisses() - missesBefore;
+
+  EBCellFactory fact(a_eblg.getEBISL());
+  a_phi.define(grids, 1, IntVect::Unit, fact);
+  a_lph.define(grids, 1, IntVect::Zero, fact);
+  for (DataIterator dit = grids.dataIterator(); dit.ok(); ++dit)
+    {
+      const EBISBox& ebisBox = a_eblg.getEBISL()[dit()];
+      IntVectSet ivs(grids[dit()]);
+      for (VoFIterator vofit(ivs, ebisBox.getEBGraph()); vofit.ok(); ++vofit)
+        {
+          a_phi[dit()](vofit(), 0) = vofValue(vofit());
+        }
+    }
+
+  opPtr->applyOp(a_lph, a_phi, NULL, false, true);
+  opPtr->relax(a_phi, a_lph, 2);
+
+  delete opPtr;
+  return misses;
+}
+
+// number of vofs of the grids at which a_data1 and a_data2 differ
+int countDiffs(const LevelData<EBCellFAB>& a_data1,
+               const LevelData<EBCellFAB>& a_data2,
+               const EBLevelGrid&          a_eblg)
+{
+  int retval = 0;
+  const DisjointBoxLayout& grids = a_eblg.getDBL();
+  for (DataIterator dit = grids.dataIterator(); dit.ok(); ++dit)
+    {
+      const EBISBox& ebisBox = a_eblg.getEBISL()[dit()];
+      IntVectSet ivs(grids[dit()]);
+      for (VoFIterator vofit(ivs, ebisBox.getEBGraph()); vofit.ok(); ++vofit)
+        {
+          if (a_data1[dit()](vofit(), 0) != a_data2[dit()](vofit(), 0))
+            {
+              retval++;
+            }
+        }
+    }
+  return retval;
+}
+
+// an entry that holds nothing
+class TestEntry : public EBStencilCache::Entry
+{
+public:
+  virtual long memUsage() const
+  {
+    return sizeof(TestEntry);
+  }
+};
+
+// a key that hashes like another must still match it in full
+int checkCollision(const EBIndexSpace& a_ebis)
+{
+  ProblemDomain domain = a_ebis.getBox(0);
+  GeometryHash version(true);
+  version.add(1.0);
+  EBStencilCache::Key key(&a_ebis, domain, 4, domain.domainBox(), "test", version);
+  EBStencilCache::insert(key, RefCountedPtr<EBStencilCache::Entry>(new TestEntry()));
+
+  GeometryHash otherVersion(true);
+  otherVersion.add(2.0);
+  EBStencilCache::Key collision(&a_ebis, domain, 4, domain.domainBox(), "test", otherVersion);
+  collision.m_version = key.m_version;
+
+  int retval = 0;
+  if (EBStencilCache::find(key).isNull())
+    {
+      pout() << "an entry was not found by its own key" << endl;
+      retval = 1;
+    }
+  if (!EBStencilCache::find(collision).isNull())
+    {
+      pout() << "a key with the same hash but another version found an entry" << endl;
+      retval = 1;
+    }
+  EBStencilCache::clear(&a_ebis);
+  return retval;
+}
+
+// compare what operators defined with the cache and without it give
+int checkAgainstUncached(const LevelData<EBCellFAB>& a_lph,
+                         const LevelData<EBCellFAB>& a_phi,
+                         const EBLevelGrid&          a_eblg,
+                         const std::string&          a_what)
+{
+  LevelData<EBCellFAB> lph, phi;
+  EBStencilCache::s_enabled = false;
+  applyAndRelax(lph, phi, a_eblg);
+  EBStencilCache::s_enabled = true;
+
+  int diffLph = countDiffs(a_lph, lph, a_eblg);
+  int diffPhi = countDiffs(a_phi, phi, a_eblg);
+  if ((diffLph != 0) || (diffPhi != 0))
+    {
+      pout() << a_what << ": applyOp differs at " << diffLph
+             << " vofs, relax at " << diffPhi << " vofs" << endl;
+      return 1;
+    }
+  return 0;
+}
+
+int main(int argc, char* argv[])
+{
+#ifdef CH_MPI
+  MPI_Init(&argc, &argv);
+#endif
+
+  int eekflag = 0;
+  {
+    Box domainBox(IntVect::Zero, (nCells-1)*IntVect::Unit);
+    ProblemDomain domain(domainBox);
+    Real dx = 1.0/nCells;
+
+    // a sphere cut by the low side of the domain, so that irregular
+    // cells touch the domain boundary
+    RealVect center = 0.5*RealVect::Unit;
+    center[0] = 0.15;
+    SphereIF sphere(0.3, center, false);
+    GeometryShop shop(sphere, 0, dx*RealVect::Unit);
+    EBIndexSpace ebis;
+    ebis.define(domain, RealVect::Zero, dx, shop, maxBoxSize);
+
+    Vector<Box> boxes;
+    domainSplit(domain, boxes, maxBoxSize);
+    EBLevelGrid eblg = makeLevelGrid(boxes, ebis);
+
+    // after the regrid, the first box with irregular cells is cut in two
+    IntVectSet irregCells = ebis.irregCells(0);
+    Vector<Box> boxesRegrid;
+    bool cut = false;
+    for (int ibox = 0; ibox < boxes.size(); ibox++)
+      {
+        Box box = boxes[ibox];
+        IntVectSet irregBox = irregCells;
+        irregBox &= box;
+        if (!cut && !irregBox.isEmpty())
+          {
+            Box boxHi = box.chop(0, box.smallEnd(0) + maxBoxSize/2);
+            boxesRegrid.push_back(boxHi);
+            cut = true;
+          }
+        boxesRegrid.push_back(box);
+      }
+    EBLevelGrid eblgRegrid = makeLevelGrid(boxesRegrid, ebis);
+
+    EBStencilCache::clear();
+    EBStencilCache::s_enabled = true;
+
+    eekflag += checkCollision(ebis);
+
+    LevelData<EBCellFAB> lph, phi;
+    long missesFirst = applyAndRelax(lph, phi, eblg);
+    if (missesFirst == 0)
+      {
+        pout() << "the first operator found its stencils in an empty cache" << endl;
+        eekflag += 1;
+      }
+
+    long hitsBefore = EBStencilCache::numHits();
+    LevelData<EBCellFAB> lphAgain, phiAgain;
+    long missesAgain = applyAndRelax(lphAgain, phiAgain, eblg);
+    if ((missesAgain != 0) || (EBStencilCache::numHits() == hitsBefore))
+      {
+        pout() << "the second operator on the same grids made " << missesAgain
+               << " cache misses" << endl;
+        eekflag += 1;
+      }
+    eekflag += checkAgainstUncached(lphAgain, phiAgain, eblg, "same grids");
+
+    LevelData<EBCellFAB> lphRegrid, phiRegrid;
+    long missesRegrid = applyAndRelax(lphRegrid, phiRegrid, eblgRegrid);
+    if ((missesRegrid == 0) || (missesRegrid >= missesFirst))
+      {
+        pout() << "after the regrid the operator made " << missesRegrid
+               << " cache misses, the first one " << missesFirst << endl;
+        eekflag += 1;
+      }
+    eekflag += checkAgainstUncached(lphRegrid, phiRegrid, eblgRegrid, "regrid");
+
+    if ((EBStencilCache::size() == 0) || (EBStencilCache::bytes() <= 0))
+      {
+        pout() << "nothing was cached" << endl;
+        eekflag += 1;
+      }
+
+    // with room for about a third of what was cached, an operator that
+    // fills the cache again makes it drop the least recently used entries
+    long maxBytesSave = EBStencilCache::s_maxBytes;
+    EBStencilCache::s_maxBytes = EBStencilCache::bytes()/3;
+    EBStencilCache::clear();
+    LevelData<EBCellFAB> lphSmall, phiSmall;
+    applyAndRelax(lphSmall, phiSmall, eblgRegrid);
+    if (EBStencilCache::bytes() > EBStencilCache::s_maxBytes)
+      {
+        pout() << "the cache holds " << EBStencilCache::bytes() << " bytes, more than "
+               << EBStencilCache::s_maxBytes << endl;
+        eekflag += 1;
+      }
+    eekflag += checkAgainstUncached(lphSmall, phiSmall, eblgRegrid, "small cache");
+    EBStencilCache::s_maxBytes = maxBytesSave;
+
+    ebis.clear();
+    if (EBStencilCache::size() != 0)
+      {
+        pout() << EBStencilCache::size() << " entries left after clearing the index space" << endl;
+        eekflag += 1;
+      }
+    if (EBStencilCache::bytes() != 0)
+      {
+        pout() << EBStencilCache::bytes() << " bytes left after clearing the index space" << endl;
+        eekflag += 1;
+      }
+    EBStencilCache::s_enabled = false;
+  }
+
+  if (eekflag == 0)
+    {
+      pout() << "ebStencilCacheTest passed" << endl;
+    }
+  else
+    {
+      pout() << "ebStencilCacheTest failed" << endl;
+    }
+
+#ifdef CH_MPI
+  MPI_Finalize();
+#endif
+
+  return eekflag;
+}
@@ -0,0 +1,335 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+// Purpose:
+//  Check EBStencil and AggStencil against the VoFStencils they are made of:
+//  the applies, relax and relaxClone of an EBStencil and the apply of an
+//  AggStencil give what evaluating the stencils vof by vof gives, for rows
+//  of the unrolled widths and of other widths, multi-valued cells
+//  included, run serially and over threads.
+
+#include <cmath>
+
+#include "EBIndexSpace.H"
+#include "EBISLayout.H"
+#include "EBCellFAB.H"
+#include "EBStencil.H"
+#include "AggStencil.H"
+#include "BoxIterator.H"
+#include "VoFIterator.H"
+#include "GeometryShop.H"
+#include "SphereIF.H"
+#include "UnionIF.H"
+#include "BRMeshRefine.H"
+
+#include "UsingNamespace.H"
+
+static const int nCells = 64;
+static const Real tolerance = 1.0e-12;
+
+// a value for every vof, different for the vofs of a multi-valued cell
+Real vofValue(const VolIndex& a_vof, Real a_shift)
+{
+  const IntVect& iv = a_vof.gridIndex();
+  Real retval = a_shift + 0.5*a_vof.cellIndex();
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      retval += sin(0.3*(idir + 1)*iv[idir] + a_shift);
+    }
+  return retval;
+}
+
+// the stencil of a_vof: the vofs of the star around it, of the whole
+// 3^SpaceDim box around it, or of the star less one cell, by cell
+VoFStencil makeStencil(const VolIndex& a_vof,
+                       const EBISBox&  a_ebisBox,
+                       const Box&      a_phiBox)
+{
+  const IntVect& iv = a_vof.gridIndex();
+  int kind = (iv[0] + 2*iv[1]) % 3;
+  Box neighbors(iv - IntVect::Unit, iv + IntVect::Unit);
+  neighbors &= a_phiBox;
+  neighbors &= a_ebisBox.getDomain();
+  VoFStencil sten;
+  int iterm = 0;
+  for (BoxIterator bit(neighbors); bit.ok(); ++bit)
+    {
+      IntVect diff = bit() - iv;
+      int dist = 0;
+      for (int idir = 0; idir < SpaceDim; idir++)
+        {
+          dist += Abs(diff[idir]);
+        }
+      if ((kind != 1) && (dist > 1))
+        {
+          continue;
+        }
+      if ((kind == 2) && (diff == BASISV(0)))
+        {
+          continue;
+        }
+      Vector<VolIndex> vofs = a_ebisBox.getVoFs(bit());
+      for (int ivof = 0; ivof < vofs.size(); ivof++)
+        {
+          sten.add(vofs[ivof], 1.0 + 0.1*iterm - 0.02*ivof);
+          iterm++;
+        }
+    }
+  return sten;
+}
+
+// a_stencil applied to a_phi at a_vof, term by term
+Real stencilValue(const VoFStencil& a_stencil,
+                  const EBCellFAB&  a_phi)
+{
+  Real retval = 0;
+  for (int isten = 0; isten < a_stencil.size(); isten++)
+    {
+      retval += a_stencil.weight(isten)*a_phi(a_stencil.vof(isten), 0);
+    }
+  return retval;
+}
+
+// a_fab1 against a_fab2 at the vofs of a_vofs
+int compareVoFs(const EBCellFAB&        a_fab1,
+                const EBCellFAB&        a_fab2,
+                const Vector<VolIndex>& a_vofs,
+                const char*             a_what)
+{
+  for (int ivof = 0; ivof < a_vofs.size(); ivof++)
+    {
+      Real val1 = a_fab1(a_vofs[ivof], 0);
+      Real val2 = a_fab2(a_vofs[ivof], 0);
+      if (Abs(val1 - val2) > tolerance*(1.0 + Abs(val2)))
+        {
+          pout() << a_what << " differs at " << a_vofs[ivof].gridIndex()
+                 << ": " << val1 << " and " << val2 << endl;
+          return 1;
+        }
+    }
+  return 0;
+}
+
+// every apply and relaxation of the stencils of the irregular vofs of a_box
+int checkBox(const Box&     a_box,
+             const EBISBox& a_ebisBox,
+             int            a_nghost)
+{
+  Box phiBox = grow(a_box, a_nghost);
+  IntVectSet ivsIrreg = a_ebisBox.getIrregIVS(a_box);
+  const EBGraph& graph = a_ebisBox.getEBGraph();
+
+  Vector<VolIndex> srcVoFs;
+  for (VoFIterator vofit(ivsIrreg, graph); vofit.ok(); ++vofit)
+    {
+      srcVoFs.push_back(vofit());
+    }
+  BaseIVFAB<VoFStencil> stencils(ivsIrreg, graph, 1);
+  Vector<VoFStencil> stencilVec(srcVoFs.size());
+  Vector<RefCountedPtr<BaseIndex> >   dstIndex(srcVoFs.size());
+  Vector<RefCountedPtr<BaseStencil> > dstStencil(srcVoFs.size());
+  for (int ivof = 0; ivof < srcVoFs.size(); ivof++)
+    {
+      stencilVec[ivof] = makeStencil(srcVoFs[ivof], a_ebisBox, phiBox);
+      stencils(srcVoFs[ivof], 0) = stencilVec[ivof];
+      dstIndex[ivof]   = RefCountedPtr<BaseIndex>(new VolIndex(srcVoFs[ivof]));
+      dstStencil[ivof] = RefCountedPtr<BaseStencil>(new VoFStencil(stencilVec[ivof]));
+    }
+
+  BaseIVFAB<Real> alphaWeight(ivsIrreg, graph, 1);
+  BaseIVFAB<Real>  betaWeight(ivsIrreg, graph, 1);
+  for (int ivof = 0; ivof < srcVoFs.size(); ivof++)
+    {
+      alphaWeight(srcVoFs[ivof], 0) = 1.0 + 0.1*vofValue(srcVoFs[ivof], 2.0);
+      betaWeight(srcVoFs[ivof], 0)  = -4.0 - 0.1*vofValue(srcVoFs[ivof], 3.0);
+    }
+  Real alpha = 0.7;
+  Real beta  = 1.3;
+  Real safety = 0.9;
+
+  EBCellFAB phi(a_ebisBox, phiBox, 1);
+  EBCellFAB rhs(a_ebisBox, a_box, 1);
+  EBCellFAB lph(a_ebisBox, a_box, 1);
+  EBCellFAB ref(a_ebisBox, a_box, 1);
+  IntVectSet ivsPhi(phiBox & a_ebisBox.getDomain());
+  for (VoFIterator vofit(ivsPhi, graph); vofit.ok(); ++vofit)
+    {
+      phi(vofit(), 0) = vofValue(vofit(), 0.0);
+    }
+  IntVectSet ivsBox(a_box);
+  for (VoFIterator vofit(ivsBox, graph); vofit.ok(); ++vofit)
+    {
+      rhs(vofit(), 0) = vofValue(vofit(), 1.0);
+    }
+
+  EBStencil ebstencil(srcVoFs, stencils, a_box, a_ebisBox,
+                      a_nghost*IntVect::Unit, IntVect::Zero, 0, true);
+  AggStencil<EBCellFAB, EBCellFAB> aggstencil(dstIndex, dstStencil, phi, lph);
+
+  // apply, setting and incrementing
+  lph.setVal(0.5);
+  ebstencil.apply(lph, phi);
+  for (int ivof = 0; ivof < srcVoFs.size(); ivof++)
+    {
+      ref(srcVoFs[ivof], 0) = stencilValue(stencilVec[ivof], phi);
+    }
+  if (compareVoFs(lph, ref, srcVoFs, "apply") != 0)
+    {
+      return 1;
+    }
+  ebstencil.apply(lph, phi, true);
+  for (int ivof = 0; ivof < srcVoFs.size(); ivof++)
+    {
+      ref(srcVoFs[ivof], 0) *= 2.0;
+    }
+  if (compareVoFs(lph, ref, srcVoFs, "incrementing apply") != 0)
+    {
+      return 1;
+    }
+
+  // apply with alpha and beta
+  lph.setVal(0.5);
+  ebstencil.apply(lph, phi, alphaWeight, alpha, beta);
+  for (int ivof = 0; ivof < srcVoFs.size(); ivof++)
+    {
+      const VolIndex& vof = srcVoFs[ivof];
+      ref(vof, 0) = alpha*alphaWeight(vof, 0)*phi(vof, 0) + beta*stencilValue(stencilVec[ivof], phi);
+    }
+  if (compareVoFs(lph, ref, srcVoFs, "alpha-beta apply") != 0)
+    {
+      return 1;
+    }
+
+  // the aggregated stencil
+  lph.setVal(0.5);
+  aggstencil.apply(lph, phi, 0, false);
+  for (int ivof = 0; ivof < srcVoFs.size(); ivof++)
+    {
+      ref(srcVoFs[ivof], 0) = stencilValue(stencilVec[ivof], phi);
+    }
+  if (compareVoFs(lph, ref, srcVoFs, "aggregated apply") != 0)
+    {
+      return 1;
+    }
+
+  // relaxClone, from phi into a copy of it
+  EBCellFAB phiNew(a_ebisBox, phiBox, 1);
+  EBCellFAB phiRef(a_ebisBox, phiBox, 1);
+  phiNew.copy(phi);
+  phiRef.copy(phi);
+  ebstencil.relaxClone(phiNew, phi, rhs, alphaWeight, betaWeight, alpha, beta, safety);
+  for (int ivof = 0; ivof < srcVoFs.size(); ivof++)
+    {
+      const VolIndex& vof = srcVoFs[ivof];
+      Real lambda = safety/(alpha*alphaWeight(vof, 0) + beta*betaWeight(vof, 0));
+      Real lphi = alpha*alphaWeight(vof, 0)*phi(vof, 0) + beta*stencilValue(stencilVec[ivof], phi);
+      phiRef(vof, 0) = phi(vof, 0) + lambda*(rhs(vof, 0) - lphi);
+    }
+  if (compareVoFs(phiNew, phiRef, srcVoFs, "relaxClone") != 0)
+    {
+      return 1;
+    }
+
+  // relax, in place and in the order of the source vofs
+  phiNew.copy(phi);
+  phiRef.copy(phi);
+  ebstencil.relax(phiNew, rhs, alphaWeight, betaWeight, alpha, beta, safety);
+  for (int ivof = 0; ivof < srcVoFs.size(); ivof++)
+    {
+      const VolIndex& vof = srcVoFs[ivof];
+      Real lambda = safety/(alpha*alphaWeight(vof, 0) + beta*betaWeight(vof, 0));
+      Real lphi = alpha*alphaWeight(vof, 0)*phiRef(vof, 0) + beta*stencilValue(stencilVec[ivof], phiRef);
+      phiRef(vof, 0) += lambda*(rhs(vof, 0) - lphi);
+    }
+  if (compareVoFs(phiNew, phiRef, srcVoFs, "relax") != 0)
+    {
+      return 1;
+    }
+  return 0;
+}
+
+int main(int argc, char* argv[])
+{
+#ifdef CH_MPI
+  MPI_Init(&argc, &argv);
+#endif
+
+  int eekflag = 0;
+  {
+    Box domainBox(IntVect::Zero, (nCells-1)*IntVect::Unit);
+    ProblemDomain domain(domainBox);
+    Real dx = 1.0/nCells;
+    RealVect origin = RealVect::Zero;
+
+    // fluid in two spheres close enough to make multi-valued cells on
+    // coarse levels
+    RealVect center1 = 0.3*RealVect::Unit;
+    RealVect center2 = 0.7*RealVect::Unit;
+    SphereIF sphere1(0.25, center1, true);
+    SphereIF sphere2(0.3,  center2, true);
+    UnionIF spheres(sphere1, sphere2);
+    GeometryShop shop(spheres, 0, dx*RealVect::Unit);
+    int nCellMax = 16;
+    EBIndexSpace ebis;
+    ebis.define(domain, origin, dx, shop, nCellMax);
+
+    int nghost = 1;
+    int numMulti = 0;
+    for (int ithread = 0; ithread < 2; ithread++)
+      {
+        // the second time through, every stencil is applied over threads
+        int minThreadRows = (ithread == 0) ? 1024 : 0;
+        EBStencil::s_minThreadRows = minThreadRows;
+        AggStencil<EBCellFAB, EBCellFAB>::s_minThreadRows = minThreadRows;
+        for (int ilev = 0; ilev < Min(3, ebis.numLevels()); ilev++)
+          {
+            const ProblemDomain& domLev = ebis.getBox(ilev);
+            Vector<Box> boxes;
+            domainSplit(domLev, boxes, nCellMax);
+            Vector<int> procs;
+            LoadBalance(procs, boxes);
+            DisjointBoxLayout grids(boxes, procs, domLev);
+            EBISLayout ebisl;
+            ebis.fillEBISLayout(ebisl, grids, domLev, nghost + 1);
+            for (DataIterator dit = grids.dataIterator(); dit.ok(); ++dit)
+              {
+                numMulti += ebisl[dit()].getMultiCells(grids[dit()]).numPts();
+                if (checkBox(grids[dit()], ebisl[dit()], nghost) != 0)
+                  {
+                    pout() << "on level " << ilev << endl;
+                    eekflag += 1;
+                  }
+              }
+          }
+      }
+    if (numMulti == 0)
+      {
+        pout() << "no multi-valued cells" << endl;
+        eekflag += 1;
+      }
+    EBStencil::s_minThreadRows = 1024;
+    AggStencil<EBCellFAB, EBCellFAB>::s_minThreadRows = 1024;
+  }
+
+  if (eekflag == 0)
+    {
+      pout() << "ebStencilTest passed" << endl;
+    }
+  else
+    {
+      pout() << "ebStencilTest failed" << endl;
+    }
+
+#ifdef CH_MPI
+  MPI_Finalize();
+#endif
+
+  return eekflag;
+}
@@ -0,0 +1,303 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+// Purpose:
+//  Check that BaseIF::values returns what BaseIF::value does, point by
+//  point, for the implicit functions that override it, and that the
+//  tiled (and, with OpenMP, threaded) GeometryShop::fillGraph and
+//  NewGeometryShop::fillGraph classify cells as InsideOutside does and
+//  make the same nodes with one thread as with several.
+
+#include <cmath>
+
+#include "BoxIterator.H"
+#include "IrregNode.H"
+#include "GeometryShop.H"
+#include "NewGeometryShop.H"
+
+#include "SphereIF.H"
+#include "PlaneIF.H"
+#include "UnionIF.H"
+#include "IntersectionIF.H"
+#include "ComplementIF.H"
+#include "TransformIF.H"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "UsingNamespace.H"
+
+static const int nCells = 64;
+
+// a sphere with the partial derivatives NewGeometryShop needs:
+// |x - center|^2 - radius^2, positive inside
+class DerivSphereIF: public BaseIF
+{
+public:
+  DerivSphereIF(const Real& a_radius, const RealVect& a_center)
+    :m_radius(a_radius), m_center(a_center)
+  {
+  }
+
+  virtual Real value(const RealVect& a_point) const
+  {
+    Real dist2 = 0.0;
+    for (int idir = 0; idir < SpaceDim; idir++)
+      {
+        dist2 += (a_point[idir] - m_center[idir])*(a_point[idir] - m_center[idir]);
+      }
+    return m_radius*m_radius - dist2;
+  }
+
+  virtual Real value(const IndexTM<Real,GLOBALDIM>& a_point) const
+  {
+    return value(IndexTM<int,GLOBALDIM>::Zero, a_point);
+  }
+
+  virtual Real value(const IndexTM<int,GLOBALDIM> & a_partialDerivative,
+                     const IndexTM<Real,GLOBALDIM>& a_point) const
+  {
+    RealVect point;
+    for (int idir = 0; idir < SpaceDim; idir++)
+      {
+        point[idir] = a_point[idir];
+      }
+    int order = a_partialDerivative.sum();
+    if (order == 0)
+      {
+        return value(point);
+      }
+    int dir = 0;
+    while (a_partialDerivative[dir] == 0)
+      {
+        dir++;
+      }
+    if (order == 1)
+      {
+        return -2.0*(point[dir] - m_center[dir]);
+      }
+    if (order == 2 && a_partialDerivative[dir] == 2)
+      {
+        return -2.0;
+      }
+    return 0.0;
+  }
+
+  virtual BaseIF* newImplicitFunction() const
+  {
+    return new DerivSphereIF(m_radius, m_center);
+  }
+
+protected:
+  Real     m_radius;
+  RealVect m_center;
+};
+
+// values() against value() at the nodes of a grid that covers the
+// implicit function's zero set, bit for bit
+int checkValues(const BaseIF& a_if, const char* a_name)
+{
+  Vector<RealVect> points;
+  Box nodes(IntVect::Zero, nCells*IntVect::Unit);
+  Real h = 1.0/nCells;
+  for (BoxIterator bit(nodes); bit.ok(); ++bit)
+    {
+      points.push_back(h*RealVect(bit()));
+    }
+
+  Vector<Real> values;
+  a_if.values(values, points);
+  if (values.size() != points.size())
+    {
+      pout() << a_name << ": values returned " << values.size()
+             << " values for " << points.size() << " points" << endl;
+      return 1;
+    }
+
+  int numDiff = 0;
+  for (int ipt = 0; ipt < points.size(); ipt++)
+    {
+      Real val = a_if.value(points[ipt]);
+      if (val != values[ipt] || signbit(val) != signbit(values[ipt]))
+        {
+          numDiff++;
+        }
+    }
+  if (numDiff > 0)
+    {
+      pout() << a_name << ": values differs from value at " << numDiff
+             << " points" << endl;
+      return 1;
+    }
+  return 0;
+}
+
+bool sameNodes(const Vector<IrregNode>& a_nodes1,
+               const Vector<IrregNode>& a_nodes2)
+{
+  if (a_nodes1.size() != a_nodes2.size())
+    {
+      return false;
+    }
+  for (int inode = 0; inode < a_nodes1.size(); inode++)
+    {
+      const IrregNode& n1 = a_nodes1[inode];
+      const IrregNode& n2 = a_nodes2[inode];
+      if (n1.m_cell != n2.m_cell ||
+          n1.m_volFrac != n2.m_volFrac ||
+          n1.m_volCentroid != n2.m_volCentroid ||
+          n1.m_bndryCentroid != n2.m_bndryCentroid)
+        {
+          return false;
+        }
+      for (int iface = 0; iface < 2*SpaceDim; iface++)
+        {
+          if (n1.m_arc[iface].constStdVector() != n2.m_arc[iface].constStdVector() ||
+              n1.m_areaFrac[iface].constStdVector() != n2.m_areaFrac[iface].constStdVector())
+            {
+              return false;
+            }
+        }
+    }
+  return true;
+}
+
+// fillGraph of the whole domain against InsideOutside cell by cell and,
+// with OpenMP, against itself on one thread
+int checkGraph(const GeometryService& a_shop, const char* a_name)
+{
+  Box domainBox(IntVect::Zero, (nCells-1)*IntVect::Unit);
+  ProblemDomain domain(domainBox);
+  Real dx = 1.0/nCells;
+  RealVect origin = RealVect::Zero;
+
+  BaseFab<int> regIrregCovered(domainBox, 1);
+  Vector<IrregNode> nodes;
+  a_shop.fillGraph(regIrregCovered, nodes, domainBox, domainBox,
+                   domain, origin, dx);
+
+  int numIrreg = 0;
+  int numDiff = 0;
+  for (BoxIterator bit(domainBox); bit.ok(); ++bit)
+    {
+      GeometryService::InOut inout =
+        a_shop.InsideOutside(Box(bit(), bit()), domain, origin, dx);
+      int expected = (inout == GeometryService::Regular) ? 1 :
+        ((inout == GeometryService::Covered) ? -1 : 0);
+      if (regIrregCovered(bit(), 0) != expected)
+        {
+          numDiff++;
+        }
+      if (expected == 0)
+        {
+          numIrreg++;
+        }
+    }
+  if (numDiff > 0)
+    {
+      pout() << a_name << ": fillGraph and InsideOutside disagree on "
+             << numDiff << " cells" << endl;
+      return 1;
+    }
+  if (numIrreg == 0 || nodes.size() == 0)
+    {
+      pout() << a_name << ": no irregular cells" << endl;
+      return 1;
+    }
+
+#ifdef _OPENMP
+  int numThreads = omp_get_max_threads();
+  omp_set_num_threads(1);
+  BaseFab<int> regIrregCovered1(domainBox, 1);
+  Vector<IrregNode> nodes1;
+  a_shop.fillGraph(regIrregCovered1, nodes1, domainBox, domainBox,
+                   domain, origin, dx);
+  omp_set_num_threads(numThreads);
+
+  for (BoxIterator bit(domainBox); bit.ok(); ++bit)
+    {
+      if (regIrregCovered(bit(), 0) != regIrregCovered1(bit(), 0))
+        {
+          pout() << a_name << ": cells differ with " << numThreads
+                 << " threads and one" << endl;
+          return 1;
+        }
+    }
+  if (!sameNodes(nodes, nodes1))
+    {
+      pout() << a_name << ": nodes differ with " << numThreads
+             << " threads and one" << endl;
+      return 1;
+    }
+#endif
+  return 0;
+}
+
+int main(int argc, char* argv[])
+{
+#ifdef CH_MPI
+  MPI_Init(&argc, &argv);
+#endif
+
+  int eekflag = 0;
+  {
+    RealVect center = 0.5*RealVect::Unit;
+    SphereIF sphere(0.3, center, false);
+    PlaneIF plane(BASISREALV(0), 0.6*RealVect::Unit, true);
+    UnionIF sphereOrPlane(sphere, plane);
+    IntersectionIF sphereAndPlane(sphere, plane);
+    ComplementIF notSphere(sphere, true);
+    // rotated and moved, so that no fast intersection test applies
+    TransformIF transformed(sphereOrPlane);
+    transformed.rotate(0.3, center);
+    transformed.translate(0.01*RealVect::Unit);
+
+    eekflag += checkValues(sphere,         "SphereIF");
+    eekflag += checkValues(plane,          "PlaneIF");
+    eekflag += checkValues(sphereOrPlane,  "UnionIF");
+    eekflag += checkValues(sphereAndPlane, "IntersectionIF");
+    eekflag += checkValues(notSphere,      "ComplementIF");
+    eekflag += checkValues(transformed,    "TransformIF");
+
+    // small tiles, so that every box is cut into several
+    GeometryService::s_tileSize = 8;
+
+    GeometryShop sphereShop(sphere, 0, RealVect::Zero);
+    eekflag += checkGraph(sphereShop, "GeometryShop, SphereIF");
+
+    GeometryShop transformedShop(transformed, 0, RealVect::Zero);
+    eekflag += checkGraph(transformedShop, "GeometryShop, TransformIF");
+
+    // NewGeometryShop needs derivatives
+    DerivSphereIF derivSphere(0.3, center);
+
+    Real dx = 1.0/nCells;
+    Box domainBox(IntVect::Zero, (nCells-1)*IntVect::Unit);
+    NewGeometryShop newShop(derivSphere, RealVect::Zero, dx*RealVect::Unit,
+                            ProblemDomain(domainBox));
+    eekflag += checkGraph(newShop, "NewGeometryShop, sphere");
+  }
+
+  if (eekflag == 0)
+    {
+      pout() << "batchedIFTest passed" << endl;
+    }
+  else
+    {
+      pout() << "batchedIFTest failed" << endl;
+    }
+
+#ifdef CH_MPI
+  MPI_Finalize();
+#endif
+
+  return eekflag;
+}
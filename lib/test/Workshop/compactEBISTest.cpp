@@ -0,0 +1,297 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+// Purpose:
+//  Check EBIndexSpace::s_compactStorage: an index space defined with it
+//  answers every query of its EBISLayouts (graph, moments, phase faces,
+//  faces) as one defined without it, on every level, multi-valued cells
+//  included, reading it leaves it compact, and its compacted graphs and
+//  data linearize to what reads back as the same data.
+
+#include "EBIndexSpace.H"
+#include "EBISLayout.H"
+#include "BoxIterator.H"
+#include "VoFIterator.H"
+#include "FaceIterator.H"
+#include "GeometryShop.H"
+#include "SphereIF.H"
+#include "UnionIF.H"
+#include "BRMeshRefine.H"
+
+#include "UsingNamespace.H"
+
+static const int nCells = 64;
+
+// the graphs of every cell of a_box
+int compareGraph(const EBGraph& a_graph1,
+                 const EBGraph& a_graph2,
+                 const Box&     a_box)
+{
+  for (BoxIterator bit(a_box); bit.ok(); ++bit)
+    {
+      const IntVect& iv = bit();
+      if ((a_graph1.isRegular(iv) != a_graph2.isRegular(iv)) ||
+          (a_graph1.isCovered(iv) != a_graph2.isCovered(iv)) ||
+          (a_graph1.numVoFs(iv)   != a_graph2.numVoFs(iv)))
+        {
+          pout() << "graphs differ at " << iv << endl;
+          return 1;
+        }
+      Vector<VolIndex> vofs = a_graph1.getVoFs(iv);
+      for (int ivof = 0; ivof < vofs.size(); ivof++)
+        {
+          for (int idir = 0; idir < SpaceDim; idir++)
+            {
+              for (SideIterator sit; sit.ok(); ++sit)
+                {
+                  Vector<FaceIndex> faces1 = a_graph1.getFaces(vofs[ivof], idir, sit());
+                  Vector<FaceIndex> faces2 = a_graph2.getFaces(vofs[ivof], idir, sit());
+                  if (faces1.size() != faces2.size())
+                    {
+                      pout() << "faces differ at " << iv << endl;
+                      return 1;
+                    }
+                  for (int iface = 0; iface < faces1.size(); iface++)
+                    {
+                      if (!(faces1[iface] == faces2[iface]))
+                        {
+                          pout() << "faces differ at " << iv << endl;
+                          return 1;
+                        }
+                    }
+                }
+            }
+        }
+    }
+  return 0;
+}
+
+// the data of every irregular vof of a_box and of its faces
+int compareData(const EBGraph& a_graph,
+                const EBData&  a_data1,
+                const EBData&  a_data2,
+                const Box&     a_box)
+{
+  IntVectSet ivsIrreg = a_graph.getIrregCells(a_box);
+  for (VoFIterator vofit(ivsIrreg, a_graph); vofit.ok(); ++vofit)
+    {
+      const VolIndex& vof = vofit();
+      if ((a_data1.volFrac(vof)       != a_data2.volFrac(vof))       ||
+          (a_data1.bndryArea(vof)     != a_data2.bndryArea(vof))     ||
+          (a_data1.centroid(vof)      != a_data2.centroid(vof))      ||
+          (a_data1.bndryCentroid(vof) != a_data2.bndryCentroid(vof)) ||
+          (a_data1.normal(vof)        != a_data2.normal(vof))        ||
+          (a_data1.numFacePhase(vof)  != a_data2.numFacePhase(vof)))
+        {
+          pout() << "moments differ at " << vof.gridIndex() << endl;
+          return 1;
+        }
+      VolData vol1 = a_data1.volData(vof);
+      VolData vol2 = a_data2.volData(vof);
+      if ((vol1.m_volFrac                   != vol2.m_volFrac)                   ||
+          (vol1.m_volCentroid               != vol2.m_volCentroid)               ||
+          (vol1.m_averageFace.m_bndryArea   != vol2.m_averageFace.m_bndryArea)   ||
+          (vol1.m_averageFace.m_normal      != vol2.m_averageFace.m_normal)      ||
+          !(vol1.m_averageFace.m_volIndex   == vol2.m_averageFace.m_volIndex)    ||
+          (vol1.m_phaseFaces.size()         != vol2.m_phaseFaces.size()))
+        {
+          pout() << "vof data differ at " << vof.gridIndex() << endl;
+          return 1;
+        }
+      for (int iface = 0; iface < a_data1.numFacePhase(vof); iface++)
+        {
+          if ((a_data1.bndryArea(vof, iface)     != a_data2.bndryArea(vof, iface))     ||
+              (a_data1.bndryCentroid(vof, iface) != a_data2.bndryCentroid(vof, iface)) ||
+              (a_data1.normal(vof, iface)        != a_data2.normal(vof, iface))        ||
+              (a_data1.facePhase(vof, iface)     != a_data2.facePhase(vof, iface))     ||
+              !(a_data1.faceIndex(vof, iface)    == a_data2.faceIndex(vof, iface)))
+            {
+              pout() << "phase faces differ at " << vof.gridIndex() << endl;
+              return 1;
+            }
+        }
+    }
+  for (int idir = 0; idir < SpaceDim; idir++)
+    {
+      for (FaceIterator faceit(ivsIrreg, a_graph, idir, FaceStop::SurroundingWithBoundary);
+           faceit.ok(); ++faceit)
+        {
+          const FaceIndex& face = faceit();
+          if ((a_data1.areaFrac(face) != a_data2.areaFrac(face)) ||
+              (a_data1.centroid(face) != a_data2.centroid(face)))
+            {
+              pout() << "face data differ at " << face.gridIndex(Side::Hi)
+                     << " in direction " << idir << endl;
+              return 1;
+            }
+        }
+    }
+  return 0;
+}
+
+// a_graph and a_data written and read back into uncompacted ones
+int compareLinearization(const EBGraph&       a_graph,
+                         const EBData&        a_data,
+                         const EBGraph&       a_refGraph,
+                         const EBData&        a_refData,
+                         const Box&           a_box,
+                         const ProblemDomain& a_domain)
+{
+  Interval interv(0, 0);
+  if ((a_graph.size(a_box, interv) != a_refGraph.size(a_box, interv)) ||
+      (a_data.size(a_box, interv)  != a_refData.size(a_box, interv)))
+    {
+      pout() << "linear sizes differ in " << a_box << endl;
+      return 1;
+    }
+
+  Vector<char> graphBuf(a_graph.size(a_box, interv));
+  a_graph.linearOut(&graphBuf[0], a_box, interv);
+  EBGraph graphIn(a_refGraph.getRegion());
+  graphIn.setDomain(a_domain);
+  graphIn.linearIn(&graphBuf[0], a_box, interv);
+  if (compareGraph(a_refGraph, graphIn, a_box) != 0)
+    {
+      pout() << "graph read back differs in " << a_box << endl;
+      return 1;
+    }
+
+  Vector<char> dataBuf(a_data.size(a_box, interv));
+  a_data.linearOut(&dataBuf[0], a_box, interv);
+  EBData dataIn;
+  dataIn.defineVoFData(a_refGraph, a_box);
+  dataIn.defineFaceData(a_refGraph, a_box);
+  dataIn.linearIn(&dataBuf[0], a_box, interv);
+  if (compareData(a_refGraph, a_refData, dataIn, a_box) != 0)
+    {
+      pout() << "data read back differs in " << a_box << endl;
+      return 1;
+    }
+  return 0;
+}
+
+int main(int argc, char* argv[])
+{
+#ifdef CH_MPI
+  MPI_Init(&argc, &argv);
+#endif
+
+  int eekflag = 0;
+  {
+    Box domainBox(IntVect::Zero, (nCells-1)*IntVect::Unit);
+    ProblemDomain domain(domainBox);
+    Real dx = 1.0/nCells;
+    RealVect origin = RealVect::Zero;
+
+    // fluid in two spheres close enough to make multi-valued cells on
+    // coarse levels
+    RealVect center1 = 0.3*RealVect::Unit;
+    RealVect center2 = 0.7*RealVect::Unit;
+    SphereIF sphere1(0.25, center1, true);
+    SphereIF sphere2(0.3,  center2, true);
+    UnionIF spheres(sphere1, sphere2);
+    GeometryShop shop(spheres, 0, dx*RealVect::Unit);
+    int nCellMax = 16;
+
+    EBIndexSpace::s_compactStorage = false;
+    EBIndexSpace reference;
+    reference.define(domain, origin, dx, shop, nCellMax);
+
+    EBIndexSpace::s_compactStorage = true;
+    EBIndexSpace compacted;
+    compacted.define(domain, origin, dx, shop, nCellMax);
+
+    int numCompacted = 0;
+    int numMulti = 0;
+    int nghost = 2;
+    for (int ilev = 0; ilev < reference.numLevels(); ilev++)
+      {
+        const ProblemDomain& domLev = reference.getBox(ilev);
+        Vector<Box> boxes;
+        domainSplit(domLev, boxes, nCellMax);
+        Vector<int> procs;
+        LoadBalance(procs, boxes);
+        DisjointBoxLayout grids(boxes, procs, domLev);
+        EBISLayout ebisl1, ebisl2;
+        EBIndexSpace::s_compactStorage = false;
+        reference.fillEBISLayout(ebisl1, grids, domLev, nghost);
+        EBIndexSpace::s_compactStorage = true;
+        compacted.fillEBISLayout(ebisl2, grids, domLev, nghost);
+        for (DataIterator dit = grids.dataIterator(); dit.ok(); ++dit)
+          {
+            const EBISBox& ebisBox1 = ebisl1[dit()];
+            const EBISBox& ebisBox2 = ebisl2[dit()];
+            const EBGraph& graph1 = ebisBox1.getEBGraph();
+            const EBGraph& graph2 = ebisBox2.getEBGraph();
+            const EBData&  data1  = ebisBox1.getEBData();
+            const EBData&  data2  = ebisBox2.getEBData();
+            if (graph1.isCompact() || data1.isCompact())
+              {
+                pout() << "reference is compact on level " << ilev << endl;
+                eekflag += 1;
+              }
+            bool wasCompact = data2.isCompact();
+            if (wasCompact)
+              {
+                numCompacted++;
+              }
+            Box ghostBox = grow(grids[dit()], nghost) & domLev;
+            numMulti += graph1.getMultiCells(ghostBox).numPts();
+            if (compareGraph(graph1, graph2, ghostBox) != 0)
+              {
+                pout() << "on level " << ilev << endl;
+                eekflag += 1;
+              }
+            else if (compareData(graph1, data1, data2, ghostBox) != 0)
+              {
+                pout() << "on level " << ilev << endl;
+                eekflag += 1;
+              }
+            else if (compareLinearization(graph2, data2, graph1, data1, grids[dit()], domLev) != 0)
+              {
+                pout() << "on level " << ilev << endl;
+                eekflag += 1;
+              }
+            if (wasCompact && !data2.isCompact())
+              {
+                pout() << "queries expanded the data on level " << ilev << endl;
+                eekflag += 1;
+              }
+          }
+      }
+    if (numCompacted == 0)
+      {
+        pout() << "no compacted data" << endl;
+        eekflag += 1;
+      }
+    if (numMulti == 0)
+      {
+        pout() << "no multi-valued cells" << endl;
+        eekflag += 1;
+      }
+
+    EBIndexSpace::s_compactStorage = false;
+  }
+
+  if (eekflag == 0)
+    {
+      pout() << "compactEBISTest passed" << endl;
+    }
+  else
+    {
+      pout() << "compactEBISTest failed" << endl;
+    }
+
+#ifdef CH_MPI
+  MPI_Finalize();
+#endif
+
+  return eekflag;
+}
@@ -0,0 +1,326 @@
+#ifdef CH_LANG_CC
+/*
+ *      _______              __
+ *     / ___/ /  ___  __ _  / /  ___
+ *    / /__/ _ \/ _ \/  V \/ _ \/ _ \
+ *    \___/_//_/\___/_/_/_/_.__/\___/
+ *    Please refer to Copyright.txt, in Chombo's root directory.
+ */
+#endif
+
+// Purpose:
+//  Check the cache of EBIndexSpace::s_cacheDirectory: the first define of
+//  a geometry writes a file, the second reads it back instead of
+//  generating the index space and gets the same index space on every
+//  level, a file of another layout version is written again, another
+//  geometry gets another file, and a geometry that cannot be hashed is
+//  not cached.
+
+#include <cstdio>
+#include <string>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <unistd.h>
+
+#include "EBIndexSpace.H"
+#include "EBISLayout.H"
+#include "BoxIterator.H"
+#include "VoFIterator.H"
+#include "GeometryShop.H"
+#include "SphereIF.H"
+#include "PlaneIF.H"
+#include "UnionIF.H"
+#include "TransformIF.H"
+
+#include "UsingNamespace.H"
+
+static const int nCells = 64;
+static const char* cacheDir = "ebisCacheTest.cache";
+
+// a plane that does not hash itself
+class UnhashedPlaneIF: public PlaneIF
+{
+public:
+  UnhashedPlaneIF(const RealVect& a_normal,
+                  const RealVect& a_point)
+    :PlaneIF(a_normal, a_point, true)
+  {
+  }
+
+  virtual bool hash(GeometryHash& a_hash) const
+  {
+    return false;
+  }
+
+  virtual BaseIF* newImplicitFunction() const
+  {
+    return new UnhashedPlaneIF(m_normal, m_point);
+  }
+};
+
+// names of the files in the cache directory
+Vector<std::string> cacheFiles()
+{
+  Vector<std::string> files;
+  DIR* dir = opendir(cacheDir);
+  if (dir != NULL)
+    {
+      struct dirent* entry;
+      while ((entry = readdir(dir)) != NULL)
+        {
+          std::string name(entry->d_name);
+          if (name != "." && name != "..")
+            {
+              files.push_back(std::string(cacheDir) + "/" + name);
+            }
+        }
+      closedir(dir);
+    }
+  return files;
+}
+
+// a new file of the same name has a new inode
+long fileInode(const std::string& a_file)
+{
+  struct stat buf;
+  if (stat(a_file.c_str(), &buf) != 0)
+    {
+      return -1;
+    }
+  return long(buf.st_ino);
+}
+
+// every level of a_ebis2 against a_ebis1, bit for bit
+int compareEBIS(const EBIndexSpace& a_ebis1,
+                const EBIndexSpace& a_ebis2)
+{
+  if (a_ebis1.numLevels() != a_ebis2.numLevels())
+    {
+      pout() << "number of levels differs: " << a_ebis1.numLevels()
+             << " and " << a_ebis2.numLevels() << endl;
+      return 1;
+    }
+  for (int ilev = 0; ilev < a_ebis1.numLevels(); ilev++)
+    {
+      const ProblemDomain& domain = a_ebis1.getBox(ilev);
+      if (a_ebis2.getBox(ilev).domainBox() != domain.domainBox())
+        {
+          pout() << "domains differ on level " << ilev << endl;
+          return 1;
+        }
+      Vector<Box> boxes(1, domain.domainBox());
+      Vector<int> procs(1, 0);
+      DisjointBoxLayout grids(boxes, procs, domain);
+      EBISLayout ebisl1, ebisl2;
+      a_ebis1.fillEBISLayout(ebisl1, grids, domain, 0);
+      a_ebis2.fillEBISLayout(ebisl2, grids, domain, 0);
+      for (DataIterator dit = grids.dataIterator(); dit.ok(); ++dit)
+        {
+          const Box& box = grids[dit()];
+          const EBISBox& ebisBox1 = ebisl1[dit()];
+          const EBISBox& ebisBox2 = ebisl2[dit()];
+          IntVectSet irreg1 = ebisBox1.getIrregIVS(box);
+          IntVectSet irreg2 = ebisBox2.getIrregIVS(box);
+          if (!(irreg1 == irreg2))
+            {
+              pout() << "irregular cells differ on level " << ilev << endl;
+              return 1;
+            }
+          for (BoxIterator bit(box); bit.ok(); ++bit)
+            {
+              if (ebisBox1.isCovered(bit()) != ebisBox2.isCovered(bit()))
+                {
+                  pout() << "covered cells differ on level " << ilev << endl;
+                  return 1;
+                }
+            }
+          for (VoFIterator vofit(irreg1, ebisBox1.getEBGraph()); vofit.ok(); ++vofit)
+            {
+              const VolIndex& vof = vofit();
+              if (ebisBox1.volFrac(vof)       != ebisBox2.volFrac(vof)   ||
+                  ebisBox1.bndryArea(vof)     != ebisBox2.bndryArea(vof) ||
+                  ebisBox1.centroid(vof)      != ebisBox2.centroid(vof)  ||
+                  ebisBox1.bndryCentroid(vof) != ebisBox2.bndryCentroid(vof))
+                {
+                  pout() << "moments differ on level " << ilev
+                         << " at " << vof.gridIndex() << endl;
+                  return 1;
+                }
+              for (int idir = 0; idir < SpaceDim; idir++)
+                {
+                  for (SideIterator sit; sit.ok(); ++sit)
+                    {
+                      Vector<FaceIndex> faces1 = ebisBox1.getFaces(vof, idir, sit());
+                      Vector<FaceIndex> faces2 = ebisBox2.getFaces(vof, idir, sit());
+                      if (faces1.size() != faces2.size())
+                        {
+                          pout() << "faces differ on level " << ilev
+                                 << " at " << vof.gridIndex() << endl;
+                          return 1;
+                        }
+                      for (int iface = 0; iface < faces1.size(); iface++)
+                        {
+                          if (!(faces1[iface] == faces2[iface]) ||
+                              ebisBox1.areaFrac(faces1[iface]) != ebisBox2.areaFrac(faces2[iface]))
+                            {
+                              pout() << "area fractions differ on level " << ilev
+                                     << " at " << vof.gridIndex() << endl;
+                              return 1;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+  return 0;
+}
+
+int main(int argc, char* argv[])
+{
+#ifdef CH_MPI
+  MPI_Init(&argc, &argv);
+#endif
+
+  int eekflag = 0;
+#ifdef CH_USE_HDF5
+  {
+    Box domainBox(IntVect::Zero, (nCells-1)*IntVect::Unit);
+    ProblemDomain domain(domainBox);
+    Real dx = 1.0/nCells;
+    RealVect origin = RealVect::Zero;
+
+    RealVect center = 0.5*RealVect::Unit;
+    SphereIF sphere(0.3, center, false);
+    PlaneIF plane(BASISREALV(0), 0.6*RealVect::Unit, true);
+    UnionIF sphereOrPlane(sphere, plane);
+    TransformIF transformed(sphereOrPlane);
+    transformed.rotate(0.3, center);
+    GeometryShop shop(transformed, 0, dx*RealVect::Unit);
+
+    // the index space generated without a cache
+    EBIndexSpace::s_cacheDirectory = "";
+    EBIndexSpace reference;
+    reference.define(domain, origin, dx, shop);
+
+    if (procID() == 0)
+      {
+        mkdir(cacheDir, 0755);
+        Vector<std::string> stale = cacheFiles();
+        for (int ifile = 0; ifile < stale.size(); ifile++)
+          {
+            remove(stale[ifile].c_str());
+          }
+      }
+    barrier();
+    EBIndexSpace::s_cacheDirectory = cacheDir;
+
+    // generated and written
+    EBIndexSpace written;
+    written.define(domain, origin, dx, shop);
+    Vector<std::string> files = cacheFiles();
+    if (files.size() != 1)
+      {
+        pout() << "first define left " << files.size() << " cache files" << endl;
+        eekflag += 1;
+      }
+    else
+      {
+        long inode = fileInode(files[0]);
+
+        // read back, not generated and written again
+        EBIndexSpace read;
+        read.define(domain, origin, dx, shop);
+        if (cacheFiles().size() != 1 || fileInode(files[0]) != inode)
+          {
+            pout() << "second define did not read the cache file" << endl;
+            eekflag += 1;
+          }
+        if (compareEBIS(reference, read) != 0)
+          {
+            pout() << "index space read from the cache differs" << endl;
+            eekflag += 1;
+          }
+
+        // a file of another layout version is generated and written again
+        HDF5Handle handle(files[0], HDF5Handle::OPEN_RDWR);
+        HDF5HeaderData header;
+        header.readFromFile(handle);
+        header.m_int["EBIS_cacheVersion"] = -1;
+        header.writeToFile(handle);
+        handle.close();
+        EBIndexSpace regenerated;
+        regenerated.define(domain, origin, dx, shop);
+        if (cacheFiles().size() != 1 || fileInode(files[0]) == inode)
+          {
+            pout() << "a cache file of another version was read" << endl;
+            eekflag += 1;
+          }
+        if (compareEBIS(reference, regenerated) != 0)
+          {
+            pout() << "index space regenerated over the cache differs" << endl;
+            eekflag += 1;
+          }
+      }
+
+    // another sphere, another file
+    SphereIF otherSphere(0.31, center, false);
+    GeometryShop otherShop(otherSphere, 0, dx*RealVect::Unit);
+    EBIndexSpace other;
+    other.define(domain, origin, dx, otherShop);
+    if (cacheFiles().size() != 2)
+      {
+        pout() << "another geometry did not get another cache file" << endl;
+        eekflag += 1;
+      }
+
+    // the same geometry at another resolution, another file
+    GeometryShop coarseShop(transformed, 0, 2*dx*RealVect::Unit);
+    EBIndexSpace coarse;
+    coarse.define(coarsen(domain, 2), origin, 2*dx, coarseShop);
+    if (cacheFiles().size() != 3)
+      {
+        pout() << "another resolution did not get another cache file" << endl;
+        eekflag += 1;
+      }
+
+    // not hashed, not cached
+    UnhashedPlaneIF unhashed(BASISREALV(0), 0.6*RealVect::Unit);
+    GeometryShop unhashedShop(unhashed, 0, dx*RealVect::Unit);
+    EBIndexSpace notCached;
+    notCached.define(domain, origin, dx, unhashedShop);
+    if (cacheFiles().size() != 3)
+      {
+        pout() << "a geometry that cannot be hashed was cached" << endl;
+        eekflag += 1;
+      }
+
+    EBIndexSpace::s_cacheDirectory = "";
+    barrier();
+    if (procID() == 0)
+      {
+        files = cacheFiles();
+        for (int ifile = 0; ifile < files.size(); ifile++)
+          {
+            remove(files[ifile].c_str());
+          }
+        rmdir(cacheDir);
+      }
+  }
+#endif
+
+  if (eekflag == 0)
+    {
+      pout() << "ebisCacheTest passed" << endl;
+    }
+  else
+    {
+      pout() << "ebisCacheTest failed" << endl;
+    }
+
+#ifdef CH_MPI
+  MPI_Finalize();
+#endif
+
+  return eekflag;
+}
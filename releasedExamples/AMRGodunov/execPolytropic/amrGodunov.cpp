@@ -67,8 +67,10 @@ void setupFixedGrids(Vector<Vector<Box> >& a_amrGrids,
 int main(int a_argc, char* a_argv[])
 {
 #ifdef CH_MPI
-  // Start MPI
-  MPI_Init(&a_argc,&a_argv);
+  // Start MPI; the task scheduling of LevelGodunov drives the progress of
+  // its exchanges from whichever OpenMP thread is waiting for them
+  int threadSupport;
+  MPI_Init_thread(&a_argc,&a_argv,MPI_THREAD_SERIALIZED,&threadSupport);
 #ifdef CH_AIX
   H5dont_atexit();
 #endif
@@ -274,6 +276,11 @@ void amrGodunov()
   ppgodunov.query("high_order_limiter", inHighOrderLimiter);
   highOrderLimiter = (inHighOrderLimiter == 1);
 
+  // Schedule the patch updates as tasks overlapping the ghost cell exchange?
+  int inTaskScheduling = 0;
+  ppgodunov.query("task_scheduling", inTaskScheduling);
+  bool taskScheduling = (inTaskScheduling == 1);
+
   // Set up checkpointing
   int checkpointInterval = 0;
   ppgodunov.query("checkpoint_interval",checkpointInterval);
@@ -642,6 +649,7 @@ void amrGodunov()
                     useSourceTerm,
                     sourceTermScaling,
                     highOrderLimiter);
+  amrGodFact.taskScheduling(taskScheduling);
 
   AMR amr;
 
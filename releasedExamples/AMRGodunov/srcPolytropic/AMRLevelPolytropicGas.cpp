@@ -35,6 +35,7 @@ AMRLevelPolytropicGas::AMRLevelPolytropicGas()
     }
 
   m_gdnvPhysics = NULL;
+  m_taskScheduling = false;
   m_paramsDefined = false;
 }
 
@@ -122,6 +123,11 @@ void AMRLevelPolytropicGas::defineParams(const Real&                 a_cfl,
   m_paramsDefined = true;
 }
 
+void AMRLevelPolytropicGas::taskScheduling(bool a_taskScheduling)
+{
+  m_taskScheduling = a_taskScheduling;
+}
+
 // This instance should never get called - historical
 void AMRLevelPolytropicGas::define(AMRLevel*  a_coarserLevelPtr,
                                    const Box& a_problemDomain,
@@ -1227,6 +1233,7 @@ void AMRLevelPolytropicGas::levelSetup()
                             m_hasCoarser,
                             m_hasFiner);
       m_levelGodunov.highOrderLimiter(m_highOrderLimiter);
+      m_levelGodunov.taskScheduling(m_taskScheduling);
 
       // This may look twisted but you have to do this this way because the
       // coarser levels get setup before the finer levels so, since a flux
@@ -1260,6 +1267,7 @@ void AMRLevelPolytropicGas::levelSetup()
                             m_hasCoarser,
                             m_hasFiner);
       m_levelGodunov.highOrderLimiter(m_highOrderLimiter);
+      m_levelGodunov.taskScheduling(m_taskScheduling);
     }
 }
 
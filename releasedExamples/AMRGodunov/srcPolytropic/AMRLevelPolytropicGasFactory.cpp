@@ -18,6 +18,7 @@
 AMRLevelPolytropicGasFactory::AMRLevelPolytropicGasFactory()
 {
   m_godunovPhysics = NULL;
+  m_taskScheduling = false;
   m_isDefined = false;
 }
 
@@ -106,6 +107,11 @@ void AMRLevelPolytropicGasFactory::define(const Real&                 a_cfl,
   m_isDefined = true;
 }
 
+void AMRLevelPolytropicGasFactory::taskScheduling(bool a_taskScheduling)
+{
+  m_taskScheduling = a_taskScheduling;
+}
+
 // Virtual constructor
 AMRLevel* AMRLevelPolytropicGasFactory::new_amrlevel() const
 {
@@ -133,6 +139,7 @@ AMRLevel* AMRLevelPolytropicGasFactory::new_amrlevel() const
                           m_useSourceTerm,
                           m_sourceTermScaling,
                           m_highOrderLimiter);
+  amrGodPtr->taskScheduling(m_taskScheduling);
 
   // Return it
   return (static_cast <AMRLevel*> (amrGodPtr));
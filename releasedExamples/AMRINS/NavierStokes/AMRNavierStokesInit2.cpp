@@ -390,15 +390,16 @@ void AMRNavierStokes::defineViscousMGSolver(const DisjointBoxLayout& a_grids,
                                             const DisjointBoxLayout* a_crseGridsPtr,
                                             int                      a_refCrse)
 {
-  Tuple< RefCountedPtr<AMRLevelOpFactory< LevelData<FArrayBox> > >, SpaceDim>
-    velTGAOpFactoryPtrs;
+  // separate velTGAOpFactory just to hold s_nu to be sent to LevelTGA;
+  // it solves for all of the velocity components at once
+  RefCountedPtr<AMRLevelOpFactory< LevelData<FArrayBox> > >
+    velTGAOpFactoryPtr((AMRLevelOpFactory<LevelData<FArrayBox> >*)
+                       (new AMRPoissonOpFactory()));
+  // the BC of each direction on its velocity component
+  Vector<BCHolder> viscousBCs(SpaceDim);
   for (int idir = 0; idir < SpaceDim; idir++)
     {
-      // separate velTGAOpFactory just to hold s_nu to be sent to LevelTGA
-      velTGAOpFactoryPtrs[idir] =
-        RefCountedPtr<AMRLevelOpFactory<LevelData<FArrayBox> > >
-        ((AMRLevelOpFactory<LevelData<FArrayBox> >*)
-         (new AMRPoissonOpFactory()));
+      viscousBCs[idir] = m_physBCPtr->viscousSolveFuncBC(idir);
     }
 
   Vector< RefCountedPtr<AMRLevelOpFactory< LevelData<FArrayBox> > > >
@@ -429,17 +430,14 @@ void AMRNavierStokes::defineViscousMGSolver(const DisjointBoxLayout& a_grids,
       allGrids[0] = *a_crseGridsPtr;
       allGrids[1] = a_grids;
       Real dxCrse = a_refCrse * m_dx;
-      for (int idir = 0; idir < SpaceDim; idir++)
-        {
-          AMRPoissonOpFactory& velTGAOpFactoryDir =
-            (AMRPoissonOpFactory&)(*velTGAOpFactoryPtrs[idir]);
-          velTGAOpFactoryDir.define(baseDomain,
-                                    allGrids,
-                                    refRatios,
-                                    dxCrse,
-                                    m_physBCPtr->viscousSolveFuncBC(idir),
-                                    alpha, s_nu);
-        }
+      AMRPoissonOpFactory& velTGAOpFactory =
+        (AMRPoissonOpFactory&)(*velTGAOpFactoryPtr);
+      velTGAOpFactory.define(baseDomain,
+                             allGrids,
+                             refRatios,
+                             dxCrse,
+                             BCHolder(ComponentBC(viscousBCs)),
+                             alpha, s_nu);
       for (int comp=0; comp<s_num_scal_comps; comp++)
         {
           AMRPoissonOpFactory& scalTGAOpFactoryComp =
@@ -455,17 +453,14 @@ void AMRNavierStokes::defineViscousMGSolver(const DisjointBoxLayout& a_grids,
   else
     { // no coarser level:  define solver on only one level
       allGrids[0] = a_grids;
-      for (int idir = 0; idir < SpaceDim; idir++)
-        {
-          AMRPoissonOpFactory& velTGAOpFactoryDir =
-            (AMRPoissonOpFactory&)(*velTGAOpFactoryPtrs[idir]);
-          velTGAOpFactoryDir.define(baseDomain,
-                                    a_grids,
-                                    m_dx,
-                                    m_physBCPtr->viscousSolveFuncBC(idir),
-                                    -1, // max depth, unused
-                                    alpha, s_nu);
-        }
+      AMRPoissonOpFactory& velTGAOpFactory =
+        (AMRPoissonOpFactory&)(*velTGAOpFactoryPtr);
+      velTGAOpFactory.define(baseDomain,
+                             a_grids,
+                             m_dx,
+                             BCHolder(ComponentBC(viscousBCs)),
+                             -1, // max depth, unused
+                             alpha, s_nu);
       for (int comp=0; comp<s_num_scal_comps; comp++)
         {
           AMRPoissonOpFactory& scalTGAOpFactoryComp =
@@ -494,24 +489,23 @@ void AMRNavierStokes::defineViscousMGSolver(const DisjointBoxLayout& a_grids,
   newBottomSolverPtr->m_verbosity = s_verbosity;
   m_bottomSolver = newBottomSolverPtr;
   
-  for (int idir = 0; idir < SpaceDim; idir++)
-    {
-      m_velMGsolverPtrs[idir] =
-        RefCountedPtr< AMRMultiGrid<LevelData<FArrayBox> > >
-        (new AMRMultiGrid<LevelData<FArrayBox> >() );
-      m_velMGsolverPtrs[idir]->define(baseDomain, // on either this level or coarser level
-                                      *velTGAOpFactoryPtrs[idir],
-                                      m_bottomSolver, 
-                                      numSolverLevels);
-      m_velMGsolverPtrs[idir]->m_verbosity = s_verbosity;
-      m_velMGsolverPtrs[idir]->m_eps = s_viscous_solver_tol;
-      m_velMGsolverPtrs[idir]->m_pre = s_viscous_num_smooth_down;
-      m_velMGsolverPtrs[idir]->m_post = s_viscous_num_smooth_up;
-
-      m_TGAsolverPtrs[idir] = RefCountedPtr<LevelTGA>
-        (new LevelTGA(allGrids, refRatios, baseDomain,
-                      velTGAOpFactoryPtrs[idir], m_velMGsolverPtrs[idir]));
-    }
+  m_velMGsolverPtr =
+    RefCountedPtr< AMRMultiGrid<LevelData<FArrayBox> > >
+    (new AMRMultiGrid<LevelData<FArrayBox> >() );
+  m_velMGsolverPtr->define(baseDomain, // on either this level or coarser level
+                           *velTGAOpFactoryPtr,
+                           m_bottomSolver,
+                           numSolverLevels);
+  m_velMGsolverPtr->m_verbosity = s_verbosity;
+  m_velMGsolverPtr->m_eps = s_viscous_solver_tol;
+  m_velMGsolverPtr->m_pre = s_viscous_num_smooth_down;
+  m_velMGsolverPtr->m_post = s_viscous_num_smooth_up;
+  // each component converges as its own solve did
+  m_velMGsolverPtr->m_componentwiseConvergence = true;
+
+  m_TGAsolverPtr = RefCountedPtr<LevelTGA>
+    (new LevelTGA(allGrids, refRatios, baseDomain,
+                  velTGAOpFactoryPtr, m_velMGsolverPtr));
 
   if (s_num_scal_comps > 0)
     {
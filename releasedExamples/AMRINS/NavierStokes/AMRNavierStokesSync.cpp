@@ -420,10 +420,6 @@ AMRNavierStokes::postTimeStep()
               // loop over levels and compute RHS
               Vector<LevelData<FArrayBox>* > refluxRHS(finest_level+1,NULL);
               Vector<LevelData<FArrayBox>* > refluxCorr(finest_level+1,NULL);
-              // this is necessary because while solver only can do
-              // one component, levelfluxRegister::reflux can only
-              // do all of them at once.
-              Vector<LevelData<FArrayBox>* > tempRefluxData(finest_level+1,NULL);
               // loop over levels, allocate storage, set up for AMRMultiGrid
               // solve
               thisNSPtr = this;
@@ -437,19 +433,17 @@ AMRNavierStokes::postTimeStep()
               for (int lev=startLev; lev<=finest_level; lev++)
                 {
                   const DisjointBoxLayout& levelGrids = thisNSPtr->newVel().getBoxes();
-                  // recall that AMRMultiGrid can only do one component
+                  // one solve for all of the velocity components
                   // rhs has no ghost cells
-                  refluxRHS[lev] = new LevelData<FArrayBox>(levelGrids, 1);
-                  tempRefluxData[lev] = new LevelData<FArrayBox>(levelGrids,
-                                                                 SpaceDim);
+                  refluxRHS[lev] = new LevelData<FArrayBox>(levelGrids, SpaceDim);
                   //soln has one layer of ghost cells
                   IntVect ghostVect(D_DECL(1,1,1));
-                  refluxCorr[lev] = new LevelData<FArrayBox>(levelGrids,1,
+                  refluxCorr[lev] = new LevelData<FArrayBox>(levelGrids,SpaceDim,
                                                              ghostVect);
 
                   // initialize rhs to 0
-                  DataIterator levelDit = tempRefluxData[lev]->dataIterator();
-                  LevelData<FArrayBox>& levelRefluxData = *(tempRefluxData[lev]);
+                  DataIterator levelDit = refluxRHS[lev]->dataIterator();
+                  LevelData<FArrayBox>& levelRefluxData = *(refluxRHS[lev]);
                   for (levelDit.reset(); levelDit.ok(); ++levelDit)
                     {
                       levelRefluxData[levelDit()].setVal(0.0);
@@ -501,83 +495,79 @@ AMRNavierStokes::postTimeStep()
               Real velNorm = computeNorm(vectVel, AmrRefRatios,
                                          m_dx, allVelComps, normType, m_level);
 
-              // now loop over directions
-              Interval solverComps(0,0);
-              for (int dir=0; dir<SpaceDim; dir++)
+              // initial guess for correction is RHS.
+              for (int lev=m_level; lev<=finest_level; ++lev)
                 {
-                  Interval velComps(dir,dir);
-                  for (int lev=m_level; lev<=finest_level; ++lev)
+                  LevelData<FArrayBox>& levelCorr = *(refluxCorr[lev]);
+                  DataIterator levelDit = levelCorr.dataIterator();
+                  for (levelDit.reset(); levelDit.ok(); ++levelDit)
                     {
-                      // copy rhs to single-component holder
-                      tempRefluxData[lev]->copyTo(velComps,*(refluxRHS[lev]),
-                                                  solverComps);
-                      // initial guess for correction is RHS.
-                      LevelData<FArrayBox>& levelCorr = *(refluxCorr[lev]);
-                      DataIterator levelDit = levelCorr.dataIterator();
-                      for (levelDit.reset(); levelDit.ok(); ++levelDit)
-                        {
-                          levelCorr[levelDit()].setVal(0.0);
-                        }
-                      refluxRHS[lev]->copyTo(solverComps,*(refluxCorr[lev]),
-                                             solverComps);
-                    } // end set initial guess
-
-                  // now set up solver
-                  int numLevels = finest_level+1;
-
-                  // This is a Helmholtz operator
-                  Real alpha = 1.0;
-                  Real beta = -s_nu*m_dt;
-
-                  AMRPoissonOpFactory viscousOpFactory;
-                  viscousOpFactory.define(baseDomain,
-                                          AmrGrids,
-                                          AmrRefRatios,
-                                          AmrDx[0],
-                                          m_physBCPtr->viscousRefluxBC(dir),
-                                          alpha,
-                                          beta);
-
-                  RelaxSolver<LevelData<FArrayBox> > bottomSolver;
-                  bottomSolver.m_verbosity = s_verbosity;
-
-                  AMRMultiGrid<LevelData<FArrayBox> > viscousSolver;
-                  AMRLevelOpFactory<LevelData<FArrayBox> >& viscCastFact = (AMRLevelOpFactory<LevelData<FArrayBox> >&) viscousOpFactory;
-                  viscousSolver.define(baseDomain,
-                                       viscCastFact,
-                                       &bottomSolver,
-                                       numLevels);
-
-                  viscousSolver.m_verbosity = s_verbosity;
-
-                  viscousSolver.m_eps = s_viscous_solver_tol;
-
-                  viscousSolver.m_pre  = s_viscous_num_smooth_down;
-                  viscousSolver.m_post = s_viscous_num_smooth_up;
-
-                  // This needs to be fixed when AMRMultiGrid has this
-                  // capability.
-                  //
-                  // viscousSolver.setConvergenceMetric(velNorm, 0);
-                  viscousSolver.m_convergenceMetric = velNorm;
-
-                  // now solve
-                  viscousSolver.solve(refluxCorr, refluxRHS,
-                                      finest_level, m_level,
-                                      false); // don't initialize to zero
-
-                  // now increment velocity with reflux correction
-                  for (int lev=m_level; lev<=finest_level; ++lev)
+                      levelCorr[levelDit()].setVal(0.0);
+                    }
+                  refluxRHS[lev]->copyTo(allVelComps,*(refluxCorr[lev]),
+                                         allVelComps);
+                } // end set initial guess
+
+              // now set up solver
+              int numLevels = finest_level+1;
+
+              // This is a Helmholtz operator
+              Real alpha = 1.0;
+              Real beta = -s_nu*m_dt;
+
+              // the BC of each direction on its velocity component
+              Vector<BCHolder> refluxBCs(SpaceDim);
+              for (int dir=0; dir<SpaceDim; dir++)
+                {
+                  refluxBCs[dir] = m_physBCPtr->viscousRefluxBC(dir);
+                }
+
+              AMRPoissonOpFactory viscousOpFactory;
+              viscousOpFactory.define(baseDomain,
+                                      AmrGrids,
+                                      AmrRefRatios,
+                                      AmrDx[0],
+                                      BCHolder(ComponentBC(refluxBCs)),
+                                      alpha,
+                                      beta);
+
+              RelaxSolver<LevelData<FArrayBox> > bottomSolver;
+              bottomSolver.m_verbosity = s_verbosity;
+
+              AMRMultiGrid<LevelData<FArrayBox> > viscousSolver;
+              AMRLevelOpFactory<LevelData<FArrayBox> >& viscCastFact = (AMRLevelOpFactory<LevelData<FArrayBox> >&) viscousOpFactory;
+              viscousSolver.define(baseDomain,
+                                   viscCastFact,
+                                   &bottomSolver,
+                                   numLevels);
+
+              viscousSolver.m_verbosity = s_verbosity;
+
+              viscousSolver.m_eps = s_viscous_solver_tol;
+
+              viscousSolver.m_pre  = s_viscous_num_smooth_down;
+              viscousSolver.m_post = s_viscous_num_smooth_up;
+
+              // each component converges as its own solve did
+              viscousSolver.m_componentwiseConvergence = true;
+              viscousSolver.m_convergenceMetric = velNorm;
+
+              // now solve
+              viscousSolver.solve(refluxCorr, refluxRHS,
+                                  finest_level, m_level,
+                                  false); // don't initialize to zero
+
+              // now increment velocity with reflux correction
+              for (int lev=m_level; lev<=finest_level; ++lev)
+                {
+                  LevelData<FArrayBox>& levelVel = *(compVel[lev]);
+                  LevelData<FArrayBox>& levelCorr = *(refluxCorr[lev]);
+                  DataIterator levelDit = levelCorr.dataIterator();
+                  for (levelDit.reset(); levelDit.ok(); ++levelDit)
                     {
-                      LevelData<FArrayBox>& levelVel = *(compVel[lev]);
-                      LevelData<FArrayBox>& levelCorr = *(refluxCorr[lev]);
-                      DataIterator levelDit = levelCorr.dataIterator();
-                      for (levelDit.reset(); levelDit.ok(); ++levelDit)
-                        {
-                          levelVel[levelDit()].plus(levelCorr[levelDit()],0,dir,1);
-                        }
+                      levelVel[levelDit()].plus(levelCorr[levelDit()],0,0,SpaceDim);
                     }
-                } // end loop over directions
+                }
 
               // clean up storage
               for (int lev=startLev; lev<=finest_level; lev++)
@@ -593,12 +583,6 @@ AMRNavierStokes::postTimeStep()
                       delete refluxCorr[lev];
                       refluxCorr[lev] = NULL;
                     }
-
-                  if (tempRefluxData[lev] != NULL)
-                    {
-                      delete tempRefluxData[lev];
-                      tempRefluxData[lev] = NULL;
-                    }
                 }
             } // end implicit reflux
 
@@ -355,55 +355,41 @@ AMRNavierStokes::computeUStar(LevelData<FArrayBox>& a_uStar)
                        false); // not homogeneous
       }
 
+      // set convergence metric of each component to be the norm of
+      // that component of the velocity field
+      int normType = 0;
+      Vector<Real> velNorms(SpaceDim);
       for (int comp = 0; comp < SpaceDim; comp++)
         {
           Interval intvl(comp, comp);
+          velNorms[comp] = norm(oldVel(), intvl, normType);
+        }
+      // m_velMGsolverPtr should be passed into LevelTGA
+      m_velMGsolverPtr->m_componentConvergenceMetrics = velNorms;
 
-          // set convergence metric to be norm of velocity field
-          int normType = 0;
-          Real velNorm = norm(oldVel(), intvl, normType);
-          // m_velMGsolverPtr should be passed into LevelTGA
-          m_velMGsolverPtrs[comp]->m_convergenceMetric = velNorm;
-
-          LevelData<FArrayBox> compNewVelocity;
-          aliasLevelData(compNewVelocity, &a_uStar, intvl);
-
-          LevelData<FArrayBox> compOldVelocity;
-          aliasLevelData(compOldVelocity, &oldVelocity, intvl);
-
-          LevelData<FArrayBox> compSrc;
-          aliasLevelData(compSrc, &src, intvl);
-
-          pout() << "calling updateSoln on component " << comp << endl;
-          if (numberMGlevels == 0)
-            {
-              m_TGAsolverPtrs[comp]->updateSoln(compNewVelocity,
-                                                compOldVelocity,
-                                                compSrc,
-                                                fineFluxRegisterPtr, NULL,
-                                                NULL, NULL,
-                                                old_time, crseOldTime, crseNewTime, m_dt,
-                                                numberMGlevels, false, comp); // do not initialize to zero
-            }
-          else // numberMGlevels == 1
-            {
-              LevelData<FArrayBox> compCrseOldVel;
-              LevelData<FArrayBox> compCrseNewVel;
-              aliasLevelData(compCrseOldVel,
-                             crseNSPtr()->m_vel_old_ptr, intvl);
-
-              aliasLevelData(compCrseNewVel,
-                             crseNSPtr()->m_vel_new_ptr, intvl);
-              m_TGAsolverPtrs[comp]->updateSoln(compNewVelocity,
-                                                compOldVelocity,
-                                                compSrc,
-                                                fineFluxRegisterPtr,
-                                                &(crseNSPtr()->m_flux_register),
-                                                &compCrseOldVel,
-                                                &compCrseNewVel,
-                                                old_time, crseOldTime, crseNewTime, m_dt,
-                                                numberMGlevels, false, comp); // do not initialize to zero
-            }
+      // one solve for all of the velocity components
+      pout() << "calling updateSoln on all velocity components" << endl;
+      if (numberMGlevels == 0)
+        {
+          m_TGAsolverPtr->updateSoln(a_uStar,
+                                     oldVelocity,
+                                     src,
+                                     fineFluxRegisterPtr, NULL,
+                                     NULL, NULL,
+                                     old_time, crseOldTime, crseNewTime, m_dt,
+                                     numberMGlevels, false); // do not initialize to zero
+        }
+      else // numberMGlevels == 1
+        {
+          m_TGAsolverPtr->updateSoln(a_uStar,
+                                     oldVelocity,
+                                     src,
+                                     fineFluxRegisterPtr,
+                                     &(crseNSPtr()->m_flux_register),
+                                     crseNSPtr()->m_vel_old_ptr,
+                                     crseNSPtr()->m_vel_new_ptr,
+                                     old_time, crseOldTime, crseNewTime, m_dt,
+                                     numberMGlevels, false); // do not initialize to zero
         }
 
       // final thing to do -- subtract off dt*gradPi term